@@ -498,6 +498,36 @@ public:
                    const char *retry_config, int timeout_millisec,
                    TessResultRenderer *renderer);
 
+  /**
+   * Streaming recognition of a single text line with the LSTM, for line
+   * images that arrive a few columns at a time, such as from a camera.
+   * Call BeginStreamingLine, then AddStreamingLineColumns with each chunk of
+   * columns, left to right and all of the same height, and finally
+   * EndStreamingLine. Meanwhile, GetStreamingLineText returns the start of
+   * the text that can no longer change, so it can be shown before the end
+   * of the line has even been captured.
+   * lookahead is the number of network timesteps (columns of the input,
+   * scaled to the model height, divided by the x reduction of the network)
+   * that wait for the columns to their right before being decoded, and that
+   * are kept as left context. Larger values give results
+   * closer to those of recognizing the whole line, smaller ones less delay.
+   * The streaming line is independent of SetImage and Recognize.
+   * Returns false if no LSTM model is loaded.
+   */
+  bool BeginStreamingLine(int lookahead);
+  /** Adds the next columns of the streaming line. Returns false on error. */
+  bool AddStreamingLineColumns(Pix *columns);
+  /**
+   * Returns the start of the text of the streaming line that can no longer
+   * change, as UTF8, which must be freed with the delete [] operator.
+   */
+  char *GetStreamingLineText();
+  /**
+   * Finishes the streaming line and returns its whole text, as UTF8, which
+   * must be freed with the delete [] operator.
+   */
+  char *EndStreamingLine();
+
   /**
    * Get a reading-order iterator to the results of LayoutAnalysis and/or
    * Recognize. The returned iterator must be deleted after use.
@@ -668,9 +698,9 @@ public:
   /**
    * Clear any library-level memory caches.
    * There are a variety of expensive-to-load constant data structures (mostly
-   * language dictionaries) that are cached globally -- surviving the Init()
-   * and End() of individual TessBaseAPI's.  This function allows the clearing
-   * of these caches.
+   * language dictionaries and LSTM models) that are cached globally --
+   * surviving the Init() and End() of individual TessBaseAPI's.  This
+   * function allows the clearing of these caches.
    **/
   static void ClearPersistentCache();
 
@@ -321,6 +321,13 @@ TESS_API TessMutableIterator *TessBaseAPIGetMutableIterator(
     TessBaseAPI *handle);
 
 TESS_API char *TessBaseAPIGetUTF8Text(TessBaseAPI *handle);
+
+TESS_API BOOL TessBaseAPIBeginStreamingLine(TessBaseAPI *handle,
+                                            int lookahead);
+TESS_API BOOL TessBaseAPIAddStreamingLineColumns(TessBaseAPI *handle,
+                                                 struct Pix *columns);
+TESS_API char *TessBaseAPIGetStreamingLineText(TessBaseAPI *handle);
+TESS_API char *TessBaseAPIEndStreamingLine(TessBaseAPI *handle);
 TESS_API char *TessBaseAPIGetHOCRText(TessBaseAPI *handle, int page_number);
 
 TESS_API char *TessBaseAPIGetAltoText(TessBaseAPI *handle, int page_number);
@@ -39,6 +39,8 @@
 #ifndef DISABLED_LEGACY_ENGINE
 #  include "intfx.h" // for INT_FX_RESULT_STRUCT
 #endif
+#include "lstmrecognizer.h"  // for LSTMRecognizer
+#include "object_cache.h"    // for ObjectCache
 #include "mutableiterator.h" // for MutableIterator
 #include "normalis.h"        // for kBlnBaselineOffset, kBlnXHeight
 #include "pageres.h"         // for PAGE_RES_IT, WERD_RES, PAGE_RES, CR_DE...
@@ -1266,6 +1268,32 @@ LTRResultIterator *TessBaseAPI::GetLTRIterator() {
                                rect_width_, rect_height_);
 }
 
+/** Starts the streaming recognition of a single text line with the LSTM. */
+bool TessBaseAPI::BeginStreamingLine(int lookahead) {
+  return tesseract_ != nullptr && tesseract_->LSTMBeginStreamingLine(lookahead);
+}
+
+/** Adds the next columns of the streaming line. */
+bool TessBaseAPI::AddStreamingLineColumns(Pix *columns) {
+  return tesseract_ != nullptr && tesseract_->LSTMAddStreamingColumns(columns);
+}
+
+/** Returns the start of the text of the streaming line that can't change. */
+char *TessBaseAPI::GetStreamingLineText() {
+  if (tesseract_ == nullptr) {
+    return nullptr;
+  }
+  return copy_string(tesseract_->LSTMStreamingLineText());
+}
+
+/** Finishes the streaming line and returns its whole text. */
+char *TessBaseAPI::EndStreamingLine() {
+  if (tesseract_ == nullptr) {
+    return nullptr;
+  }
+  return copy_string(tesseract_->LSTMEndStreamingLine());
+}
+
 /**
  * Get a reading-order iterator to the results of LayoutAnalysis and/or
  * Recognize. The returned iterator must be deleted after use.
@@ -1894,6 +1922,7 @@ void TessBaseAPI::End() {
 // of these caches.
 void TessBaseAPI::ClearPersistentCache() {
   Dict::GlobalDawgCache()->DeleteUnusedDawgs();
+  LSTMRecognizer::GlobalModelCache()->DeleteUnusedObjects();
 }
 
 /**
@@ -2018,7 +2047,11 @@ bool TessBaseAPI::Threshold(Pix **pix) {
 
   auto thresholding_method = static_cast<ThresholdMethod>(static_cast<int>(tesseract_->thresholding_method));
 
-  if (thresholding_method == ThresholdMethod::Otsu) {
+  if (thresholding_method == ThresholdMethod::Otsu ||
+      thresholding_method == ThresholdMethod::TiledOtsu) {
+    thresholder_->SetThresholdThreads(thresholding_method == ThresholdMethod::TiledOtsu
+                                          ? static_cast<int>(tesseract_->thresholding_threads)
+                                          : 1);
     Image pix_binary(*pix);
     if (!thresholder_->ThresholdToPix(&pix_binary)) {
       return false;
@@ -420,6 +420,22 @@ char *TessBaseAPIGetUTF8Text(TessBaseAPI *handle) {
   return handle->GetUTF8Text();
 }
 
+BOOL TessBaseAPIBeginStreamingLine(TessBaseAPI *handle, int lookahead) {
+  return static_cast<int>(handle->BeginStreamingLine(lookahead));
+}
+
+BOOL TessBaseAPIAddStreamingLineColumns(TessBaseAPI *handle, struct Pix *columns) {
+  return static_cast<int>(handle->AddStreamingLineColumns(columns));
+}
+
+char *TessBaseAPIGetStreamingLineText(TessBaseAPI *handle) {
+  return handle->GetStreamingLineText();
+}
+
+char *TessBaseAPIEndStreamingLine(TessBaseAPI *handle) {
+  return handle->EndStreamingLine();
+}
+
 char *TessBaseAPIGetHOCRText(TessBaseAPI *handle, int page_number) {
   return handle->GetHOCRText(nullptr, page_number);
 }
@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classpruner.h
+// Description: Vectorized class counts of the legacy class pruner.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_CLASSPRUNER_H_
+#define TESSERACT_ARCH_CLASSPRUNER_H_
+
+#include <cstdint>
+
+namespace tesseract {
+
+// Adds up the class pruner weights of the features for each of the
+// num_pruners class pruners. pruners[p] points to the words of pruner p, and
+// the vector for feature f starts at word offsets[f]. Each vector is two
+// words, with the 2 bit weights of 32 classes, lowest bits first. The sum
+// for class c of pruner p is added to counts[32 * p + c]. The counts of each
+// pruner are kept in registers over all the features, and added to counts
+// just once.
+void ClassPrunerCountsAVX2(const uint32_t *const *pruners, int num_pruners, const int *offsets,
+                           int num_features, int *counts);
+void ClassPrunerCountsNEON(const uint32_t *const *pruners, int num_pruners, const int *offsets,
+                           int num_features, int *counts);
+
+} // namespace tesseract.
+
+#endif // TESSERACT_ARCH_CLASSPRUNER_H_
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classpruneravx2.cpp
+// Description: Vectorized class counts of the legacy class pruner for avx2.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX2 capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "classpruner.h"
+
+namespace tesseract {
+
+void ClassPrunerCountsAVX2(const uint32_t *const *pruners, int num_pruners, const int *offsets,
+                           int num_features, int *counts) {
+  // Each word is broadcast to all the lanes, and shifted by a different
+  // amount in each, so the weights of 8 classes line up with 8 counts.
+  const __m256i low_shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+  const __m256i high_shifts = _mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30);
+  const __m256i mask = _mm256_set1_epi32(3);
+  for (int p = 0; p < num_pruners; ++p) {
+    const uint32_t *words = pruners[p];
+    __m256i count0 = _mm256_setzero_si256();
+    __m256i count1 = _mm256_setzero_si256();
+    __m256i count2 = _mm256_setzero_si256();
+    __m256i count3 = _mm256_setzero_si256();
+    for (int f = 0; f < num_features; ++f) {
+      const uint32_t *vector = words + offsets[f];
+      __m256i word0 = _mm256_set1_epi32(static_cast<int>(vector[0]));
+      __m256i word1 = _mm256_set1_epi32(static_cast<int>(vector[1]));
+      count0 =
+          _mm256_add_epi32(count0, _mm256_and_si256(_mm256_srlv_epi32(word0, low_shifts), mask));
+      count1 =
+          _mm256_add_epi32(count1, _mm256_and_si256(_mm256_srlv_epi32(word0, high_shifts), mask));
+      count2 =
+          _mm256_add_epi32(count2, _mm256_and_si256(_mm256_srlv_epi32(word1, low_shifts), mask));
+      count3 =
+          _mm256_add_epi32(count3, _mm256_and_si256(_mm256_srlv_epi32(word1, high_shifts), mask));
+    }
+    auto *out = reinterpret_cast<__m256i *>(counts + 32 * p);
+    _mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), count0));
+    _mm256_storeu_si256(out + 1, _mm256_add_epi32(_mm256_loadu_si256(out + 1), count1));
+    _mm256_storeu_si256(out + 2, _mm256_add_epi32(_mm256_loadu_si256(out + 2), count2));
+    _mm256_storeu_si256(out + 3, _mm256_add_epi32(_mm256_loadu_si256(out + 3), count3));
+  }
+}
+
+} // namespace tesseract.
+
+#endif
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classprunerneon.cpp
+// Description: Vectorized class counts of the legacy class pruner for neon.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+// Only for 64 bit ARM, which has the 32 registers needed for the counts.
+#if defined(__ARM_NEON) && defined(__aarch64__)
+
+#  include <arm_neon.h>
+#  include "classpruner.h"
+
+namespace tesseract {
+
+void ClassPrunerCountsNEON(const uint32_t *const *pruners, int num_pruners, const int *offsets,
+                           int num_features, int *counts) {
+  // Each word is duplicated to all the lanes, and shifted right (by a
+  // negative left shift) by a different amount in each, so the weights of 4
+  // classes line up with 4 counts.
+  int32x4_t shifts[4];
+  for (int i = 0; i < 4; ++i) {
+    const int32_t s[4] = {-8 * i, -8 * i - 2, -8 * i - 4, -8 * i - 6};
+    shifts[i] = vld1q_s32(s);
+  }
+  const uint32x4_t mask = vdupq_n_u32(3);
+  for (int p = 0; p < num_pruners; ++p) {
+    const uint32_t *words = pruners[p];
+    uint32x4_t sums[8];
+    for (auto &sum : sums) {
+      sum = vdupq_n_u32(0);
+    }
+    for (int f = 0; f < num_features; ++f) {
+      const uint32_t *vector = words + offsets[f];
+      for (int w = 0; w < 2; ++w) {
+        uint32x4_t word = vdupq_n_u32(vector[w]);
+        for (int i = 0; i < 4; ++i) {
+          sums[4 * w + i] = vaddq_u32(sums[4 * w + i], vandq_u32(vshlq_u32(word, shifts[i]), mask));
+        }
+      }
+    }
+    int *out = counts + 32 * p;
+    for (int i = 0; i < 8; ++i) {
+      vst1q_s32(out + 4 * i, vaddq_s32(vld1q_s32(out + 4 * i), vreinterpretq_s32_u32(sums[i])));
+    }
+  }
+}
+
+} // namespace tesseract.
+
+#endif
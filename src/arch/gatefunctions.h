@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////
+// File:        gatefunctions.h
+// Description: Vectorized nonlinearities of the LSTM gates.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_GATEFUNCTIONS_H_
+#define TESSERACT_ARCH_GATEFUNCTIONS_H_
+
+#include "tesstypes.h"
+
+namespace tesseract {
+
+// The SIMD gate functions compute tanh as a rational function instead of
+// interpolating in the tables of lstm/functions.h, as table lookups don't
+// vectorize. tanh(x) is approximated by x * P(x^2) / Q(x^2) with x clipped to
+// +/-kTanhClip, which is within 3e-7 of tanh for all x, and the logistic
+// function by 0.5 + 0.5 * tanh(x / 2). The results are within 2e-6 of the
+// table interpolation (whose own error is up to 1.5e-6).
+constexpr TFloat kTanhClip = 7.90531110763549805;
+// Coefficients of P, lowest power first.
+constexpr TFloat kTanhNumerator[] = {4.89352455891786e-03,  6.37261928875436e-04,
+                                     1.48572235717979e-05,  5.12229709037114e-08,
+                                     -8.60467152213735e-11, 2.00018790482477e-13,
+                                     -2.76076847742355e-16};
+// Coefficients of Q, lowest power first.
+constexpr TFloat kTanhDenominator[] = {4.89352518554385e-03, 2.26843463243900e-03,
+                                       1.18534705686654e-04, 1.19825839466702e-06};
+
+// Scalar version of the rational tanh, used for the elements that don't fill
+// a SIMD register, so that all the elements of a vector get the same function.
+// Static, as it is compiled with different SIMD flags in each file.
+static inline TFloat TanhRational(TFloat x) {
+  x = x < -kTanhClip ? -kTanhClip : (x > kTanhClip ? kTanhClip : x);
+  TFloat x2 = x * x;
+  TFloat p = kTanhNumerator[6];
+  for (int i = 5; i >= 0; --i) {
+    p = p * x2 + kTanhNumerator[i];
+  }
+  TFloat q = kTanhDenominator[3];
+  for (int i = 2; i >= 0; --i) {
+    q = q * x2 + kTanhDenominator[i];
+  }
+  return x * p / q;
+}
+
+// Replaces each of the n elements of inout with its tanh.
+void TanhVectorAVX2(int n, TFloat *inout);
+void TanhVectorAVX512F(int n, TFloat *inout);
+void TanhVectorNEON(int n, TFloat *inout);
+
+// Replaces each of the n elements of inout with its logistic function.
+void LogisticVectorAVX2(int n, TFloat *inout);
+void LogisticVectorAVX512F(int n, TFloat *inout);
+void LogisticVectorNEON(int n, TFloat *inout);
+
+// Adds (1 - tanh(u[i])^2) * v[i] * w[i] to product[i] for each of the n
+// elements, as NetworkIO::FuncMultiply3Add<HPrime>, which back propagates
+// the errors through the output nonlinearity of the LSTM state.
+void TanhPrimeMultiply3AddAVX2(int n, const float *u, const float *v, const TFloat *w,
+                               TFloat *product);
+void TanhPrimeMultiply3AddAVX512F(int n, const float *u, const float *v, const TFloat *w,
+                                  TFloat *product);
+void TanhPrimeMultiply3AddNEON(int n, const float *u, const float *v, const TFloat *w,
+                               TFloat *product);
+
+// Updates the n states of an LSTM cell from its gates and computes its
+// outputs, in a single pass:
+// state = clip(ci * gi + (gfs != nullptr && gf1 < gfs ? gfs * stepped_state
+//                                                     : gf1 * state))
+// output = tanh(state) * go
+// where clip limits to +/-state_clip, gfs and stepped_state are the forget
+// gate and the previous state of the second dimension of a 2-D LSTM, or
+// nullptr if there is none.
+void LSTMCellAVX2(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf1,
+                  const TFloat *gfs, const TFloat *stepped_state, const TFloat *go,
+                  TFloat state_clip, TFloat *state, TFloat *output);
+void LSTMCellAVX512F(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf1,
+                     const TFloat *gfs, const TFloat *stepped_state, const TFloat *go,
+                     TFloat state_clip, TFloat *state, TFloat *output);
+void LSTMCellNEON(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf1,
+                  const TFloat *gfs, const TFloat *stepped_state, const TFloat *go,
+                  TFloat state_clip, TFloat *state, TFloat *output);
+
+} // namespace tesseract.
+
+#endif // TESSERACT_ARCH_GATEFUNCTIONS_H_
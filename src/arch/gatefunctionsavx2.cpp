@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////
+// File:        gatefunctionsavx2.cpp
+// Description: Vectorized gate functions for avx2.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX2 capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "gatefunctionsimpl.h"
+
+namespace tesseract {
+
+namespace {
+
+#  if defined(FAST_FLOAT)
+struct Simd {
+  using Vec = __m256;
+  static constexpr int kWidth = 8;
+  static Vec Set1(TFloat x) {
+    return _mm256_set1_ps(x);
+  }
+  static Vec Load(const float *p) {
+    return _mm256_loadu_ps(p);
+  }
+  static Vec LoadFloats(const float *p) {
+    return _mm256_loadu_ps(p);
+  }
+  static void Store(float *p, Vec x) {
+    _mm256_storeu_ps(p, x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm256_add_ps(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm256_sub_ps(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm256_mul_ps(a, b);
+  }
+  static Vec Div(Vec a, Vec b) {
+    return _mm256_div_ps(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm256_min_ps(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm256_max_ps(a, b);
+  }
+  static Vec SelectLess(Vec a, Vec b, Vec x, Vec y) {
+    return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_LT_OQ));
+  }
+};
+#  else
+struct Simd {
+  using Vec = __m256d;
+  static constexpr int kWidth = 4;
+  static Vec Set1(TFloat x) {
+    return _mm256_set1_pd(x);
+  }
+  static Vec Load(const double *p) {
+    return _mm256_loadu_pd(p);
+  }
+  static Vec LoadFloats(const float *p) {
+    return _mm256_cvtps_pd(_mm_loadu_ps(p));
+  }
+  static void Store(double *p, Vec x) {
+    _mm256_storeu_pd(p, x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm256_add_pd(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm256_sub_pd(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm256_mul_pd(a, b);
+  }
+  static Vec Div(Vec a, Vec b) {
+    return _mm256_div_pd(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm256_min_pd(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm256_max_pd(a, b);
+  }
+  static Vec SelectLess(Vec a, Vec b, Vec x, Vec y) {
+    return _mm256_blendv_pd(y, x, _mm256_cmp_pd(a, b, _CMP_LT_OQ));
+  }
+};
+#  endif
+
+} // namespace
+
+void TanhVectorAVX2(int n, TFloat *inout) {
+  TanhVectorSimd<Simd>(n, inout);
+}
+
+void LogisticVectorAVX2(int n, TFloat *inout) {
+  LogisticVectorSimd<Simd>(n, inout);
+}
+
+void TanhPrimeMultiply3AddAVX2(int n, const float *u, const float *v, const TFloat *w,
+                               TFloat *product) {
+  TanhPrimeMultiply3AddSimd<Simd>(n, u, v, w, product);
+}
+
+void LSTMCellAVX2(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf1,
+                  const TFloat *gfs, const TFloat *stepped_state, const TFloat *go,
+                  TFloat state_clip, TFloat *state, TFloat *output) {
+  LSTMCellSimd<Simd>(n, ci, gi, gf1, gfs, stepped_state, go, state_clip, state, output);
+}
+
+} // namespace tesseract.
+
+#endif
@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////
+// File:        gatefunctionsavx512.cpp
+// Description: Vectorized gate functions for avx512f.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX512F__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX512F capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "gatefunctionsimpl.h"
+
+namespace tesseract {
+
+namespace {
+
+#  if defined(FAST_FLOAT)
+struct Simd {
+  using Vec = __m512;
+  static constexpr int kWidth = 16;
+  static Vec Set1(TFloat x) {
+    return _mm512_set1_ps(x);
+  }
+  static Vec Load(const float *p) {
+    return _mm512_loadu_ps(p);
+  }
+  static Vec LoadFloats(const float *p) {
+    return _mm512_loadu_ps(p);
+  }
+  static void Store(float *p, Vec x) {
+    _mm512_storeu_ps(p, x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm512_add_ps(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm512_sub_ps(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm512_mul_ps(a, b);
+  }
+  static Vec Div(Vec a, Vec b) {
+    return _mm512_div_ps(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm512_min_ps(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm512_max_ps(a, b);
+  }
+  static Vec SelectLess(Vec a, Vec b, Vec x, Vec y) {
+    return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ), y, x);
+  }
+};
+#  else
+struct Simd {
+  using Vec = __m512d;
+  static constexpr int kWidth = 8;
+  static Vec Set1(TFloat x) {
+    return _mm512_set1_pd(x);
+  }
+  static Vec Load(const double *p) {
+    return _mm512_loadu_pd(p);
+  }
+  static Vec LoadFloats(const float *p) {
+    return _mm512_cvtps_pd(_mm256_loadu_ps(p));
+  }
+  static void Store(double *p, Vec x) {
+    _mm512_storeu_pd(p, x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return _mm512_add_pd(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return _mm512_sub_pd(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return _mm512_mul_pd(a, b);
+  }
+  static Vec Div(Vec a, Vec b) {
+    return _mm512_div_pd(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return _mm512_min_pd(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm512_max_pd(a, b);
+  }
+  static Vec SelectLess(Vec a, Vec b, Vec x, Vec y) {
+    return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a, b, _CMP_LT_OQ), y, x);
+  }
+};
+#  endif
+
+} // namespace
+
+void TanhVectorAVX512F(int n, TFloat *inout) {
+  TanhVectorSimd<Simd>(n, inout);
+}
+
+void LogisticVectorAVX512F(int n, TFloat *inout) {
+  LogisticVectorSimd<Simd>(n, inout);
+}
+
+void TanhPrimeMultiply3AddAVX512F(int n, const float *u, const float *v, const TFloat *w,
+                                  TFloat *product) {
+  TanhPrimeMultiply3AddSimd<Simd>(n, u, v, w, product);
+}
+
+void LSTMCellAVX512F(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf1,
+                     const TFloat *gfs, const TFloat *stepped_state, const TFloat *go,
+                     TFloat state_clip, TFloat *state, TFloat *output) {
+  LSTMCellSimd<Simd>(n, ci, gi, gf1, gfs, stepped_state, go, state_clip, state, output);
+}
+
+} // namespace tesseract.
+
+#endif
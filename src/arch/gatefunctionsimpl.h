@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////
+// File:        gatefunctionsimpl.h
+// Description: Implementation of the vectorized gate functions, shared by
+//              the architecture-specific gatefunctions*.cpp files.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_GATEFUNCTIONSIMPL_H_
+#define TESSERACT_ARCH_GATEFUNCTIONSIMPL_H_
+
+#include "gatefunctions.h"
+
+namespace tesseract {
+
+// The functions are templates on a class Simd, defined in an anonymous
+// namespace by each file that includes this, which provides the register
+// type Vec of kWidth TFloats and the operations on it:
+// Set1, Load, LoadFloats (which converts from float), Store, Add, Sub, Mul,
+// Div, Min, Max and SelectLess(a, b, x, y), which is a < b ? x : y.
+
+// Computes the rational tanh of each element of x.
+template <class Simd>
+static inline typename Simd::Vec TanhSimd(typename Simd::Vec x) {
+  x = Simd::Min(Simd::Max(x, Simd::Set1(-kTanhClip)), Simd::Set1(kTanhClip));
+  auto x2 = Simd::Mul(x, x);
+  auto p = Simd::Set1(kTanhNumerator[6]);
+  for (int i = 5; i >= 0; --i) {
+    p = Simd::Add(Simd::Mul(p, x2), Simd::Set1(kTanhNumerator[i]));
+  }
+  auto q = Simd::Set1(kTanhDenominator[3]);
+  for (int i = 2; i >= 0; --i) {
+    q = Simd::Add(Simd::Mul(q, x2), Simd::Set1(kTanhDenominator[i]));
+  }
+  return Simd::Div(Simd::Mul(x, p), q);
+}
+
+template <class Simd>
+static void TanhVectorSimd(int n, TFloat *inout) {
+  int i = 0;
+  for (; i + Simd::kWidth <= n; i += Simd::kWidth) {
+    Simd::Store(inout + i, TanhSimd<Simd>(Simd::Load(inout + i)));
+  }
+  for (; i < n; ++i) {
+    inout[i] = TanhRational(inout[i]);
+  }
+}
+
+template <class Simd>
+static void LogisticVectorSimd(int n, TFloat *inout) {
+  const auto half = Simd::Set1(0.5);
+  int i = 0;
+  for (; i + Simd::kWidth <= n; i += Simd::kWidth) {
+    auto x = Simd::Load(inout + i);
+    Simd::Store(inout + i, Simd::Add(half, Simd::Mul(half, TanhSimd<Simd>(Simd::Mul(half, x)))));
+  }
+  for (; i < n; ++i) {
+    inout[i] = 0.5 + 0.5 * TanhRational(0.5 * inout[i]);
+  }
+}
+
+template <class Simd>
+static void TanhPrimeMultiply3AddSimd(int n, const float *u, const float *v, const TFloat *w,
+                                      TFloat *product) {
+  const auto one = Simd::Set1(1.0);
+  int i = 0;
+  for (; i + Simd::kWidth <= n; i += Simd::kWidth) {
+    auto tanh = TanhSimd<Simd>(Simd::LoadFloats(u + i));
+    auto prime = Simd::Sub(one, Simd::Mul(tanh, tanh));
+    auto sum = Simd::Mul(Simd::Mul(prime, Simd::LoadFloats(v + i)), Simd::Load(w + i));
+    Simd::Store(product + i, Simd::Add(Simd::Load(product + i), sum));
+  }
+  for (; i < n; ++i) {
+    TFloat tanh = TanhRational(u[i]);
+    product[i] += (1 - tanh * tanh) * v[i] * w[i];
+  }
+}
+
+template <class Simd>
+static void LSTMCellSimd(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf1,
+                         const TFloat *gfs, const TFloat *stepped_state, const TFloat *go,
+                         TFloat state_clip, TFloat *state, TFloat *output) {
+  const auto lower = Simd::Set1(-state_clip);
+  const auto upper = Simd::Set1(state_clip);
+  int i = 0;
+  for (; i + Simd::kWidth <= n; i += Simd::kWidth) {
+    auto forget = Simd::Load(gf1 + i);
+    auto s = Simd::Mul(Simd::Load(state + i), forget);
+    if (gfs != nullptr) {
+      auto forget2 = Simd::Load(gfs + i);
+      s = Simd::SelectLess(forget, forget2, Simd::Mul(forget2, Simd::Load(stepped_state + i)), s);
+    }
+    s = Simd::Add(s, Simd::Mul(Simd::Load(ci + i), Simd::Load(gi + i)));
+    s = Simd::Min(Simd::Max(s, lower), upper);
+    Simd::Store(state + i, s);
+    Simd::Store(output + i, Simd::Mul(TanhSimd<Simd>(s), Simd::Load(go + i)));
+  }
+  for (; i < n; ++i) {
+    TFloat s = state[i] * gf1[i];
+    if (gfs != nullptr && gf1[i] < gfs[i]) {
+      s = gfs[i] * stepped_state[i];
+    }
+    s += ci[i] * gi[i];
+    s = s < -state_clip ? -state_clip : (s > state_clip ? state_clip : s);
+    state[i] = s;
+    output[i] = TanhRational(s) * go[i];
+  }
+}
+
+} // namespace tesseract.
+
+#endif // TESSERACT_ARCH_GATEFUNCTIONSIMPL_H_
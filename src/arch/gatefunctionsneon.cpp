@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////
+// File:        gatefunctionsneon.cpp
+// Description: Vectorized gate functions for neon.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+// Only for 64 bit ARM, as 32 bit NEON has neither doubles nor division.
+#if defined(__ARM_NEON) && defined(__aarch64__)
+
+#  include <arm_neon.h>
+#  include "gatefunctionsimpl.h"
+
+namespace tesseract {
+
+namespace {
+
+#  if defined(FAST_FLOAT)
+struct Simd {
+  using Vec = float32x4_t;
+  static constexpr int kWidth = 4;
+  static Vec Set1(TFloat x) {
+    return vdupq_n_f32(x);
+  }
+  static Vec Load(const float *p) {
+    return vld1q_f32(p);
+  }
+  static Vec LoadFloats(const float *p) {
+    return vld1q_f32(p);
+  }
+  static void Store(float *p, Vec x) {
+    vst1q_f32(p, x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return vaddq_f32(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return vsubq_f32(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return vmulq_f32(a, b);
+  }
+  static Vec Div(Vec a, Vec b) {
+    return vdivq_f32(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return vminq_f32(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return vmaxq_f32(a, b);
+  }
+  static Vec SelectLess(Vec a, Vec b, Vec x, Vec y) {
+    return vbslq_f32(vcltq_f32(a, b), x, y);
+  }
+};
+#  else
+struct Simd {
+  using Vec = float64x2_t;
+  static constexpr int kWidth = 2;
+  static Vec Set1(TFloat x) {
+    return vdupq_n_f64(x);
+  }
+  static Vec Load(const double *p) {
+    return vld1q_f64(p);
+  }
+  static Vec LoadFloats(const float *p) {
+    return vcvt_f64_f32(vld1_f32(p));
+  }
+  static void Store(double *p, Vec x) {
+    vst1q_f64(p, x);
+  }
+  static Vec Add(Vec a, Vec b) {
+    return vaddq_f64(a, b);
+  }
+  static Vec Sub(Vec a, Vec b) {
+    return vsubq_f64(a, b);
+  }
+  static Vec Mul(Vec a, Vec b) {
+    return vmulq_f64(a, b);
+  }
+  static Vec Div(Vec a, Vec b) {
+    return vdivq_f64(a, b);
+  }
+  static Vec Min(Vec a, Vec b) {
+    return vminq_f64(a, b);
+  }
+  static Vec Max(Vec a, Vec b) {
+    return vmaxq_f64(a, b);
+  }
+  static Vec SelectLess(Vec a, Vec b, Vec x, Vec y) {
+    return vbslq_f64(vcltq_f64(a, b), x, y);
+  }
+};
+#  endif
+
+} // namespace
+
+void TanhVectorNEON(int n, TFloat *inout) {
+  TanhVectorSimd<Simd>(n, inout);
+}
+
+void LogisticVectorNEON(int n, TFloat *inout) {
+  LogisticVectorSimd<Simd>(n, inout);
+}
+
+void TanhPrimeMultiply3AddNEON(int n, const float *u, const float *v, const TFloat *w,
+                               TFloat *product) {
+  TanhPrimeMultiply3AddSimd<Simd>(n, u, v, w, product);
+}
+
+void LSTMCellNEON(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf1,
+                  const TFloat *gfs, const TFloat *stepped_state, const TFloat *go,
+                  TFloat state_clip, TFloat *state, TFloat *output) {
+  LSTMCellSimd<Simd>(n, ci, gi, gf1, gfs, stepped_state, go, state_clip, state, output);
+}
+
+} // namespace tesseract.
+
+#endif
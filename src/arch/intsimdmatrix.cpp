@@ -19,6 +19,8 @@
 #include "matrix.h"     // for GENERIC_2D_ARRAY
 #include "simddetect.h" // for SIMDDetect
 
+#include <cstring> // for memcpy, memset
+
 namespace tesseract {
 
 const IntSimdMatrix *IntSimdMatrix::intSimdMatrix = nullptr;
@@ -71,6 +73,67 @@ void IntSimdMatrix::Init(const GENERIC_2D_ARRAY<int8_t> &w, std::vector<int8_t>
   }
 }
 
+// Splits weights reshaped by Init by input column, without reshaping them.
+bool IntSimdMatrix::SplitInputs(const std::vector<int8_t> &shaped_w, int num_out, int num_in,
+                                int num_first, std::vector<int8_t> &first,
+                                std::vector<int8_t> &rest) const {
+  if (num_first % num_inputs_per_group_ != 0) {
+    return false;
+  }
+  // As the inputs of the first part end on a group boundary, each register
+  // set of Init is the groups of the first part, followed by the groups of
+  // the rest, including its zero padding, followed by the biases.
+  const int num_groups = Roundup(num_in, num_inputs_per_group_) / num_inputs_per_group_;
+  const int first_groups = num_first / num_inputs_per_group_;
+  const int rest_groups = num_groups - first_groups;
+  const int rounded_num_out = RoundOutputs(num_out);
+  first.resize((first_groups * num_inputs_per_group_ + 1) * rounded_num_out);
+  rest.resize((rest_groups * num_inputs_per_group_ + 1) * rounded_num_out);
+  const int8_t *src = &shaped_w[0];
+  int8_t *first_dst = &first[0];
+  int8_t *rest_dst = &rest[0];
+  int output = 0;
+  for (int num_registers = max_output_registers_; num_registers >= 1; num_registers /= 2) {
+    int num_outputs_per_register_set = num_registers * num_outputs_per_register_;
+    int group_size = num_outputs_per_register_set * num_inputs_per_group_;
+    while (output + num_outputs_per_register_set <= rounded_num_out) {
+      memcpy(first_dst, src, first_groups * group_size);
+      first_dst += first_groups * group_size;
+      src += first_groups * group_size;
+      memcpy(rest_dst, src, rest_groups * group_size);
+      rest_dst += rest_groups * group_size;
+      src += rest_groups * group_size;
+      memcpy(first_dst, src, num_outputs_per_register_set);
+      first_dst += num_outputs_per_register_set;
+      src += num_outputs_per_register_set;
+      memset(rest_dst, 0, num_outputs_per_register_set);
+      rest_dst += num_outputs_per_register_set;
+      output += num_outputs_per_register_set;
+    }
+  }
+  return true;
+}
+
+// Returns the shape of the named implementation. The shapes must match those
+// of the implementations in the intsimdmatrix*.cpp files, which are not all
+// compiled on every architecture.
+const IntSimdMatrix *IntSimdMatrix::ShapeForName(const std::string &name) {
+  static const IntSimdMatrix kShapeAVX2 = {nullptr, 8, 8, 32, 4, nullptr};
+  static const IntSimdMatrix kShapeAVX512VNNI = {nullptr, 16, 8, 64, 4, nullptr};
+  static const IntSimdMatrix kShapeSSE = {nullptr, 1, 1, 1, 1, nullptr};
+  static const IntSimdMatrix kShapeNEON = {nullptr, 8, 1, 8, 8, nullptr};
+  if (name == "avx2" || name == "avxvnni" || name == "avx512f") {
+    return &kShapeAVX2;
+  } else if (name == "avx512vnni") {
+    return &kShapeAVX512VNNI;
+  } else if (name == "sse" || name == "avx") {
+    return &kShapeSSE;
+  } else if (name == "neon") {
+    return &kShapeNEON;
+  }
+  return nullptr;
+}
+
 // Computes matrix.vector v = Wu.
 // u is of size W.dim2() - 1 and the output v is of size W.dim1().
 // u is imagined to have an extra element at the end with value 1, to
@@ -116,4 +179,27 @@ void IntSimdMatrix::MatrixDotVector(const GENERIC_2D_ARRAY<int8_t> &w,
   }
 }
 
+// Computes matrix.matrix v[c] = Wu[c] for each of the num_vectors input
+// vectors u[c].
+void IntSimdMatrix::MatrixDotMatrix(const GENERIC_2D_ARRAY<int8_t> &w,
+                                    const std::vector<TFloat> &scales, int num_vectors,
+                                    const int8_t *const *u, TFloat *const *v) {
+  int num_out = w.dim1();
+  int num_in = w.dim2() - 1;
+  // Base implementation. Each row of weights is used for all the vectors
+  // while it is still in the cache.
+  for (int i = 0; i < num_out; ++i) {
+    const int8_t *wi = w[i];
+    for (int c = 0; c < num_vectors; ++c) {
+      const int8_t *uc = u[c];
+      int total = 0;
+      for (int j = 0; j < num_in; ++j) {
+        total += wi[j] * uc[j];
+      }
+      // Add in the bias and correct for integer values.
+      v[c][i] = (total + wi[num_in] * INT8_MAX) * scales[i];
+    }
+  }
+}
+
 } // namespace tesseract
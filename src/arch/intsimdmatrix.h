@@ -21,6 +21,7 @@
 #include <tesseract/export.h>
 
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "tesstypes.h"
@@ -66,6 +67,30 @@ struct TESS_API IntSimdMatrix {
   void Init(const GENERIC_2D_ARRAY<int8_t> &w, std::vector<int8_t> &shaped_w,
             int32_t &rounded_num_out) const;
 
+  // Splits weights reshaped by Init from a matrix with num_out outputs and
+  // num_in inputs by input column, as WeightMatrix::SplitInputs, into the
+  // reshaped weights of the first num_first inputs with the biases and of the
+  // remaining inputs with zero biases, without reshaping them again.
+  // Returns false if num_first is not a multiple of num_inputs_per_group_, in
+  // which case the parts must be reshaped from the unshaped weights.
+  bool SplitInputs(const std::vector<int8_t> &shaped_w, int num_out, int num_in, int num_first,
+                   std::vector<int8_t> &first, std::vector<int8_t> &rest) const;
+
+  // Returns true if the weights reshaped by Init of other have the same
+  // layout as those reshaped by this.
+  bool SameShape(const IntSimdMatrix &other) const {
+    return num_outputs_per_register_ == other.num_outputs_per_register_ &&
+           max_output_registers_ == other.max_output_registers_ &&
+           num_inputs_per_register_ == other.num_inputs_per_register_ &&
+           num_inputs_per_group_ == other.num_inputs_per_group_;
+  }
+
+  // Returns the shape of the named implementation (as for the dotproduct
+  // parameter, e.g. "avx2"), without any functions, for reshaping weights
+  // with Init for machines other than this one, or nullptr if the name
+  // is unknown.
+  static const IntSimdMatrix *ShapeForName(const std::string &name);
+
   // Rounds the size up to a multiple of the input register size (in int8_t).
   int RoundInputs(int size) const {
     return Roundup(size, num_inputs_per_register_);
@@ -83,6 +108,12 @@ struct TESS_API IntSimdMatrix {
   static void MatrixDotVector(const GENERIC_2D_ARRAY<int8_t> &w, const std::vector<TFloat> &scales,
                               const int8_t *u, TFloat *v);
 
+  // Computes matrix.matrix v[c] = Wu[c] for each of the num_vectors input
+  // vectors u[c], with the same conventions as MatrixDotVector.
+  // Computes the base C++ implementation.
+  static void MatrixDotMatrix(const GENERIC_2D_ARRAY<int8_t> &w, const std::vector<TFloat> &scales,
+                              int num_vectors, const int8_t *const *u, TFloat *const *v);
+
   // Rounds the input up to a multiple of the given factor.
   static int Roundup(int input, int factor) {
     return (input + factor - 1) / factor * factor;
@@ -112,12 +143,28 @@ struct TESS_API IntSimdMatrix {
   // Number of groups of inputs to be broadcast.
   // num_input_groups_ = num_inputs_per_register_ / num_inputs_per_group_
 
+  // Computes matrix.matrix v[c] = Wu[c] for each of the num_vectors input
+  // vectors u[c], with the same requirements on the weights, the padding of
+  // each u[c] and the size of each v[c] as matrixDotVectorFunction.
+  // Each block of weights is multiplied by several input vectors while it is
+  // in registers, so the weights are read from memory far fewer times than
+  // by calling matrixDotVectorFunction for each vector.
+  // May be nullptr, in which case callers fall back to
+  // matrixDotVectorFunction.
+  using MatrixDotMatrixFunction = void (*)(int, int, const int8_t *, const TFloat *, int,
+                                           const int8_t *const *, TFloat *const *);
+  MatrixDotMatrixFunction matrixDotMatrixFunction;
+
   static const IntSimdMatrix *intSimdMatrix;
   // Only available with NEON.
   static const IntSimdMatrix intSimdMatrixNEON;
   // Only available with AVX2 / AVX / FMA / SSE.
   static const IntSimdMatrix intSimdMatrixAVX2;
   static const IntSimdMatrix intSimdMatrixSSE;
+  // Only available with AVX512 VNNI (and AVX512 BW).
+  static const IntSimdMatrix intSimdMatrixAVX512VNNI;
+  // Only available with AVX VNNI (and AVX2).
+  static const IntSimdMatrix intSimdMatrixAVXVNNI;
 };
 
 } // namespace tesseract
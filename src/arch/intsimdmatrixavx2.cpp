@@ -25,6 +25,7 @@
 #  include <immintrin.h>
 #  include <algorithm>
 #  include <cstdint>
+#  include <cstring>
 #  include <vector>
 
 #  if defined(_MSC_VER) && _MSC_VER >= 1925 && _MSC_VER <= 1929 && \
@@ -575,6 +576,126 @@ static void matrixDotVector(int dim1, int dim2, const int8_t *wi, const double *
 }
 #endif
 
+// The loops over registers and vectors in PartialMatrixDotMatrix must be
+// fully unrolled for the results to be kept in registers, which gcc only
+// does by default with -O3.
+#  if defined(__GNUC__)
+#    define UNROLL_LOOP _Pragma("GCC unroll 8")
+#  else
+#    define UNROLL_LOOP
+#  endif
+
+// Number of result registers per input vector used by PartialMatrixDotMatrix.
+constexpr int kNumMatrixRegisters = 2;
+// Number of input vectors multiplied by each block of weights at once.
+constexpr int kNumMatrixVectors = 4;
+
+// Computes part of matrix.matrix v[c] = Wu[c] for kNumVectors input vectors.
+// Computes kNumRegs registers of results for each vector, starting at
+// register first_reg of a register set of num_regs registers, whose weights
+// and biases are at wi, arranged as for PartialMatrixDotVector64 with
+// N = num_regs * kNumOutputsPerRegister. Each block of weights is loaded once
+// and multiplied by all the input vectors, which are broadcast a group of
+// kNumInputsPerGroup at a time directly from memory.
+// The results are written to v[c] + output + first_reg * kNumOutputsPerRegister.
+template <int kNumRegs, int kNumVectors>
+static inline void PartialMatrixDotMatrix(const int8_t *wi, const TFloat *scales,
+                                          const int8_t *const *u, int num_in, int num_regs,
+                                          int first_reg, int output, TFloat *const *v) {
+  // Register containing 16-bit ones for horizontal add with 16->32 bit
+  // conversion.
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i results[kNumVectors][kNumRegs];
+  UNROLL_LOOP
+  for (int c = 0; c < kNumVectors; ++c) {
+    UNROLL_LOOP
+    for (int r = 0; r < kNumRegs; ++r) {
+      results[c][r] = _mm256_setzero_si256();
+    }
+  }
+  const int w_step = num_regs * kNumInputsPerRegister;
+  const int8_t *w = wi + first_reg * kNumInputsPerRegister;
+  for (int j = 0; j < num_in; j += kNumInputsPerGroup, w += w_step) {
+    __m256i rep_inputs[kNumVectors];
+    UNROLL_LOOP
+    for (int c = 0; c < kNumVectors; ++c) {
+      int32_t group;
+      std::memcpy(&group, u[c] + j, sizeof(group));
+      rep_inputs[c] = _mm256_set1_epi32(group);
+    }
+    UNROLL_LOOP
+    for (int r = 0; r < kNumRegs; ++r) {
+      __m256i weights =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(w + r * kNumInputsPerRegister));
+      // Normalize the signs as in MultiplyGroup, so weights is always +ve.
+      __m256i abs_weights = _mm256_sign_epi8(weights, weights);
+      UNROLL_LOOP
+      for (int c = 0; c < kNumVectors; ++c) {
+        __m256i reps = _mm256_sign_epi8(rep_inputs[c], weights);
+        reps = _mm256_maddubs_epi16(abs_weights, reps);
+        reps = _mm256_madd_epi16(reps, ones);
+        results[c][r] = _mm256_add_epi32(results[c][r], reps);
+      }
+    }
+  }
+  // The biases follow the weights of the whole register set.
+  const int8_t *bias = wi + num_in * num_regs * kNumOutputsPerRegister;
+  UNROLL_LOOP
+  for (int r = 0; r < kNumRegs; ++r) {
+    const int offset = (first_reg + r) * kNumOutputsPerRegister;
+    UNROLL_LOOP
+    for (int c = 0; c < kNumVectors; ++c) {
+      ExtractResults8(results[c][r], bias + offset, scales + offset, v[c] + output + offset);
+    }
+  }
+}
+
+// Computes all the results of one register set of num_regs registers for
+// all num_vectors input vectors.
+template <int kNumRegs>
+static void PartialMatrixDotMatrixSet(const int8_t *wi, const TFloat *scales,
+                                      int num_vectors, const int8_t *const *u, int num_in,
+                                      int num_regs, int output, TFloat *const *v) {
+  for (int first_reg = 0; first_reg < num_regs; first_reg += kNumRegs) {
+    int c = 0;
+    for (; c + kNumMatrixVectors <= num_vectors; c += kNumMatrixVectors) {
+      PartialMatrixDotMatrix<kNumRegs, kNumMatrixVectors>(wi, scales, u + c, num_in, num_regs,
+                                                          first_reg, output, v + c);
+    }
+    for (; c < num_vectors; ++c) {
+      PartialMatrixDotMatrix<kNumRegs, 1>(wi, scales, u + c, num_in, num_regs, first_reg,
+                                          output, v + c);
+    }
+  }
+}
+
+static void matrixDotMatrix(int dim1, int dim2, const int8_t *wi, const TFloat *scales,
+                            int num_vectors, const int8_t *const *u, TFloat *const *v) {
+  const int num_out = dim1;
+  const int num_in = dim2 - 1;
+  const int rounded_num_in = IntSimdMatrix::Roundup(num_in, kNumInputsPerGroup);
+  const int rounded_num_out = IntSimdMatrix::Roundup(num_out, kNumOutputsPerRegister);
+  int output = 0;
+  // Step through the register sets in the same order as matrixDotVector.
+  for (int num_regs = kMaxOutputRegisters; num_regs >= 1; num_regs /= 2) {
+    const int group_size = num_regs * kNumOutputsPerRegister;
+    const int w_step = (rounded_num_in + 1) * group_size;
+    for (; output + group_size <= rounded_num_out; output += group_size) {
+      if (num_regs >= kNumMatrixRegisters) {
+        PartialMatrixDotMatrixSet<kNumMatrixRegisters>(wi, scales, num_vectors, u,
+                                                       rounded_num_in, num_regs, output, v);
+      } else {
+        PartialMatrixDotMatrixSet<1>(wi, scales, num_vectors, u, rounded_num_in, num_regs,
+                                     output, v);
+      }
+      wi += w_step;
+      scales += group_size;
+    }
+  }
+}
+
+#  undef UNROLL_LOOP
+
 const IntSimdMatrix IntSimdMatrix::intSimdMatrixAVX2 = {
     // Function.
     matrixDotVector,
@@ -585,7 +706,9 @@ const IntSimdMatrix IntSimdMatrix::intSimdMatrixAVX2 = {
     // Number of 8 bit inputs in the inputs register.
     kNumInputsPerRegister,
     // Number of inputs in each weight group.
-    kNumInputsPerGroup
+    kNumInputsPerGroup,
+    // Matrix.matrix function.
+    matrixDotMatrix
 };
 
 } // namespace tesseract.
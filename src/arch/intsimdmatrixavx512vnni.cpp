@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intsimdmatrixavx512vnni.cpp
+// Description: matrix-vector product for 8-bit data on avx512 vnni.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "intsimdmatrix.h"
+
+#if !defined(__AVX512VNNI__) || !defined(__AVX512BW__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX512VNNI capable architectures
+#  endif
+#else
+#  include <immintrin.h>
+#  include <cstdint>
+#  include <cstring>
+
+namespace tesseract {
+
+// Number of outputs held in each register. 16 x 32 bit ints.
+constexpr int kNumOutputsPerRegister = 16;
+// Maximum number of registers that we will use.
+constexpr int kMaxOutputRegisters = 8;
+// Number of inputs in the inputs register.
+constexpr int kNumInputsPerRegister = 64;
+// Number of inputs in each weight group.
+constexpr int kNumInputsPerGroup = 4;
+// Number of result registers per input vector used by matrixDotMatrix.
+constexpr int kNumMatrixRegisters = 4;
+// Number of input vectors multiplied by each block of weights at once.
+constexpr int kNumMatrixVectors = 4;
+
+// The loops over registers and vectors in PartialMatrixDotMatrix must be
+// fully unrolled for the results to be kept in registers, which gcc only
+// does by default with -O3.
+#  if defined(__GNUC__)
+#    define UNROLL_LOOP _Pragma("GCC unroll 8")
+#  else
+#    define UNROLL_LOOP
+#  endif
+
+// Adds the 16 bias weights at wi, scaled to match the integer inputs, to
+// result and writes the results, multiplied by scales, to v.
+static inline void ExtractResults16(__m512i result, const int8_t *wi, const TFloat *scales,
+                                    TFloat *v) {
+  __m512i bias = _mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(wi)));
+  bias = _mm512_mullo_epi32(bias, _mm512_set1_epi32(INT8_MAX));
+  result = _mm512_add_epi32(result, bias);
+#  if defined(FAST_FLOAT)
+  __m512 res = _mm512_cvtepi32_ps(result);
+  _mm512_storeu_ps(v, _mm512_mul_ps(res, _mm512_loadu_ps(scales)));
+#  else
+  __m512d res0 = _mm512_cvtepi32_pd(_mm512_castsi512_si256(result));
+  __m512d res1 = _mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(result, 1));
+  _mm512_storeu_pd(v, _mm512_mul_pd(res0, _mm512_loadu_pd(scales)));
+  _mm512_storeu_pd(v + 8, _mm512_mul_pd(res1, _mm512_loadu_pd(scales + 8)));
+#  endif
+}
+
+// Computes part of matrix.matrix v[c] = Wu[c] for kNumVectors input vectors.
+// Computes kNumRegs registers of results for each vector, starting at
+// register first_reg of a register set of num_regs registers, whose weights
+// and biases are at wi. The weights are arranged as (num_in /
+// kNumInputsPerGroup groups of (N output dim groups of (kNumInputsPerGroup
+// inputs))), followed by N biases, where N = num_regs * 16.
+// vpdpbusd multiplies unsigned bytes by signed bytes, so each block of
+// weights is made positive, with its signs moved to the inputs, then
+// multiplied by all the input vectors, broadcast a group at a time.
+// The results are written to v[c] + output + first_reg * 16.
+template <int kNumRegs, int kNumVectors>
+static inline void PartialMatrixDotMatrix(const int8_t *wi, const TFloat *scales,
+                                          const int8_t *const *u, int num_in, int num_regs,
+                                          int first_reg, int output, TFloat *const *v) {
+  const __m512i zero = _mm512_setzero_si512();
+  __m512i results[kNumVectors][kNumRegs];
+  UNROLL_LOOP
+  for (int c = 0; c < kNumVectors; ++c) {
+    UNROLL_LOOP
+    for (int r = 0; r < kNumRegs; ++r) {
+      results[c][r] = zero;
+    }
+  }
+  const int w_step = num_regs * kNumInputsPerRegister;
+  const int8_t *w = wi + first_reg * kNumInputsPerRegister;
+  for (int j = 0; j < num_in; j += kNumInputsPerGroup, w += w_step) {
+    __m512i rep_inputs[kNumVectors];
+    UNROLL_LOOP
+    for (int c = 0; c < kNumVectors; ++c) {
+      int32_t group;
+      std::memcpy(&group, u[c] + j, sizeof(group));
+      rep_inputs[c] = _mm512_set1_epi32(group);
+    }
+    UNROLL_LOOP
+    for (int r = 0; r < kNumRegs; ++r) {
+      __m512i weights = _mm512_loadu_si512(w + r * kNumInputsPerRegister);
+      __m512i abs_weights = _mm512_abs_epi8(weights);
+      __mmask64 negative = _mm512_movepi8_mask(weights);
+      UNROLL_LOOP
+      for (int c = 0; c < kNumVectors; ++c) {
+        __m512i reps = _mm512_mask_sub_epi8(rep_inputs[c], negative, zero, rep_inputs[c]);
+        results[c][r] = _mm512_dpbusd_epi32(results[c][r], abs_weights, reps);
+      }
+    }
+  }
+  // The biases follow the weights of the whole register set.
+  const int8_t *bias = wi + num_in * num_regs * kNumOutputsPerRegister;
+  UNROLL_LOOP
+  for (int r = 0; r < kNumRegs; ++r) {
+    const int offset = (first_reg + r) * kNumOutputsPerRegister;
+    UNROLL_LOOP
+    for (int c = 0; c < kNumVectors; ++c) {
+      ExtractResults16(results[c][r], bias + offset, scales + offset, v[c] + output + offset);
+    }
+  }
+}
+
+static void matrixDotVector(int dim1, int dim2, const int8_t *wi, const TFloat *scales,
+                            const int8_t *u, TFloat *v) {
+  const int num_out = dim1;
+  const int num_in = dim2 - 1;
+  const int rounded_num_in = IntSimdMatrix::Roundup(num_in, kNumInputsPerGroup);
+  const int rounded_num_out = IntSimdMatrix::Roundup(num_out, kNumOutputsPerRegister);
+  const int8_t *const inputs[] = {u};
+  TFloat *const outputs[] = {v};
+  int output = 0;
+  // Run with the largest register set that fits, then switch to smaller sets.
+  for (int num_regs = kMaxOutputRegisters; num_regs >= 1; num_regs /= 2) {
+    const int group_size = num_regs * kNumOutputsPerRegister;
+    const int w_step = (rounded_num_in + 1) * group_size;
+    for (; output + group_size <= rounded_num_out; output += group_size) {
+      switch (num_regs) {
+        case 8:
+          PartialMatrixDotMatrix<8, 1>(wi, scales, inputs, rounded_num_in, 8, 0, output, outputs);
+          break;
+        case 4:
+          PartialMatrixDotMatrix<4, 1>(wi, scales, inputs, rounded_num_in, 4, 0, output, outputs);
+          break;
+        case 2:
+          PartialMatrixDotMatrix<2, 1>(wi, scales, inputs, rounded_num_in, 2, 0, output, outputs);
+          break;
+        default:
+          PartialMatrixDotMatrix<1, 1>(wi, scales, inputs, rounded_num_in, 1, 0, output, outputs);
+          break;
+      }
+      wi += w_step;
+      scales += group_size;
+    }
+  }
+}
+
+// Computes all the results of one register set of num_regs registers for
+// all num_vectors input vectors.
+template <int kNumRegs>
+static void PartialMatrixDotMatrixSet(const int8_t *wi, const TFloat *scales,
+                                      int num_vectors, const int8_t *const *u, int num_in,
+                                      int num_regs, int output, TFloat *const *v) {
+  for (int first_reg = 0; first_reg < num_regs; first_reg += kNumRegs) {
+    int c = 0;
+    for (; c + kNumMatrixVectors <= num_vectors; c += kNumMatrixVectors) {
+      PartialMatrixDotMatrix<kNumRegs, kNumMatrixVectors>(wi, scales, u + c, num_in, num_regs,
+                                                          first_reg, output, v + c);
+    }
+    for (; c < num_vectors; ++c) {
+      PartialMatrixDotMatrix<kNumRegs, 1>(wi, scales, u + c, num_in, num_regs, first_reg,
+                                          output, v + c);
+    }
+  }
+}
+
+static void matrixDotMatrix(int dim1, int dim2, const int8_t *wi, const TFloat *scales,
+                            int num_vectors, const int8_t *const *u, TFloat *const *v) {
+  const int num_out = dim1;
+  const int num_in = dim2 - 1;
+  const int rounded_num_in = IntSimdMatrix::Roundup(num_in, kNumInputsPerGroup);
+  const int rounded_num_out = IntSimdMatrix::Roundup(num_out, kNumOutputsPerRegister);
+  int output = 0;
+  // Step through the register sets in the same order as matrixDotVector.
+  for (int num_regs = kMaxOutputRegisters; num_regs >= 1; num_regs /= 2) {
+    const int group_size = num_regs * kNumOutputsPerRegister;
+    const int w_step = (rounded_num_in + 1) * group_size;
+    for (; output + group_size <= rounded_num_out; output += group_size) {
+      if (num_regs >= kNumMatrixRegisters) {
+        PartialMatrixDotMatrixSet<kNumMatrixRegisters>(wi, scales, num_vectors, u,
+                                                       rounded_num_in, num_regs, output, v);
+      } else if (num_regs == 2) {
+        PartialMatrixDotMatrixSet<2>(wi, scales, num_vectors, u, rounded_num_in, num_regs,
+                                     output, v);
+      } else {
+        PartialMatrixDotMatrixSet<1>(wi, scales, num_vectors, u, rounded_num_in, num_regs,
+                                     output, v);
+      }
+      wi += w_step;
+      scales += group_size;
+    }
+  }
+}
+
+#  undef UNROLL_LOOP
+
+const IntSimdMatrix IntSimdMatrix::intSimdMatrixAVX512VNNI = {
+    // Function.
+    matrixDotVector,
+    // Number of 32 bit outputs held in each register.
+    kNumOutputsPerRegister,
+    // Maximum number of registers that we will use to hold outputs.
+    kMaxOutputRegisters,
+    // Number of 8 bit inputs in the inputs register.
+    kNumInputsPerRegister,
+    // Number of inputs in each weight group.
+    kNumInputsPerGroup,
+    // Matrix.matrix function.
+    matrixDotMatrix
+};
+
+} // namespace tesseract.
+
+#endif
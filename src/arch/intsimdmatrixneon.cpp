@@ -45,6 +45,107 @@ constexpr int kNumInputsPerGroup = 8;
 // The amount of w and scales consumed is fixed and not available to the
 // caller.
 
+// Computes the 8 products of the 8 inputs vu with each of the 8 rows of
+// 8 weights in vw01, vw23, vw45, vw67, adding the 8 sums to result0123 and
+// result4567.
+static inline void MultiplyGroup8(int8x16_t vw01, int8x16_t vw23, int8x16_t vw45, int8x16_t vw67,
+                                  int8x8_t vu, int32x4_t &result0123, int32x4_t &result4567) {
+  int16x8_t vrow0q = vmull_s8(vget_low_s8(vw01), vu); // vrow0q = vw00.u0 w01.u1 w02.u2
+                                                      // w03.u3 vw04.u4 w05.u5 w06.u6 w07.u7
+  int16x8_t vrow1q = vmull_s8(vget_high_s8(vw01),
+                              vu);                    // vrow1q = vw10.u0 w11.u1 w12.u2 w13.u3
+                                                      // vw14.u4 w15.u5 w16.u6 w17.u7
+  int16x8_t vrow2q = vmull_s8(vget_low_s8(vw23), vu); // vrow2q = vw20.u0 w21.u1 w22.u2
+                                                      // w23.u3 vw24.u4 w25.u5 w26.u6 w27.u7
+  int16x8_t vrow3q = vmull_s8(vget_high_s8(vw23),
+                              vu);                    // vrow3q = vw30.u0 w31.u1 w32.u2 w33.u3
+                                                      // vw34.u4 w35.u5 w36.u6 w37.u7
+  int16x8_t vrow4q = vmull_s8(vget_low_s8(vw45), vu); // vrow4q = vw40.u0 w41.u1 w42.u2
+                                                      // w43.u3 vw44.u4 w45.u5 w46.u6 w47.u7
+  int16x8_t vrow5q = vmull_s8(vget_high_s8(vw45),
+                              vu);                    // vrow5q = vw50.u0 w51.u1 w52.u2 w53.u3
+                                                      // vw54.u4 w55.u5 w56.u6 w57.u7
+  int16x8_t vrow6q = vmull_s8(vget_low_s8(vw67), vu); // vrow6q = vw60.u0 w61.u1 w62.u2
+                                                      // w63.u3 vw64.u4 w65.u5 w66.u6 w67.u7
+  int16x8_t vrow7q = vmull_s8(vget_high_s8(vw67),
+                              vu); // vrow7q = vw70.u0 w71.u1 w72.u2 w73.u3
+                                   // vw74.u4 w75.u5 w76.u6 w77.u7
+
+  int32x4_t vrow0q2 = vpaddlq_s16(vrow0q); // vrow0q2 = vw00.u0+w01.u1 w02.u2+w03.u3
+                                           // vw04.u4+w05.u5 w06.u6+w07.u7
+  int32x4_t vrow1q2 = vpaddlq_s16(vrow1q); // vrow1q2 = vw10.u0+w11.u1 w12.u2+w13.u3
+                                           // vw14.u4+w15.u5 w16.u6+w17.u7
+  int32x4_t vrow2q2 = vpaddlq_s16(vrow2q); // vrow2q2 = vw20.u0+w21.u1 w22.u2+w23.u3
+                                           // vw24.u4+w25.u5 w26.u6+w27.u7
+  int32x4_t vrow3q2 = vpaddlq_s16(vrow3q); // vrow3q2 = vw30.u0+w31.u1 w32.u2+w33.u3
+                                           // vw34.u4+w35.u5 w36.u6+w37.u7
+  int32x4_t vrow4q2 = vpaddlq_s16(vrow4q); // vrow4q2 = vw40.u0+w41.u1 w42.u2+w43.u3
+                                           // vw44.u4+w45.u5 w46.u6+w47.u7
+  int32x4_t vrow5q2 = vpaddlq_s16(vrow5q); // vrow5q2 = vw50.u0+w51.u1 w52.u2+w53.u3
+                                           // vw54.u4+w55.u5 w56.u6+w57.u7
+  int32x4_t vrow6q2 = vpaddlq_s16(vrow6q); // vrow6q2 = vw60.u0+w61.u1 w62.u2+w63.u3
+                                           // vw64.u4+w65.u5 w66.u6+w67.u7
+  int32x4_t vrow7q2 = vpaddlq_s16(vrow7q); // vrow7q2 = vw70.u0+w71.u1 w72.u2+w73.u3
+                                           // vw74.u4+w75.u5 w76.u6+w77.u7
+
+  vrow0q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow0q2), vget_high_s32(vrow0q2)),
+                         vpadd_s32(vget_low_s32(vrow1q2), vget_high_s32(vrow1q2)));
+  // vrow0q2 = vw00.u0+...+w03.u3 vw04.u4+...+w07.u7 vw10.u0+...+w13.u3
+  // vw14.u4+...+w17.u7
+  vrow2q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow2q2), vget_high_s32(vrow2q2)),
+                         vpadd_s32(vget_low_s32(vrow3q2), vget_high_s32(vrow3q2)));
+  // vrow0q2 = vw20.u0+...+w23.u3 vw24.u4+...+w27.u7 vw30.u0+...+w33.u3
+  // vw34.u4+...+w37.u7
+  vrow4q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow4q2), vget_high_s32(vrow4q2)),
+                         vpadd_s32(vget_low_s32(vrow5q2), vget_high_s32(vrow5q2)));
+  // vrow0q2 = vw40.u0+...+w43.u3 vw44.u4+...+w47.u7 vw50.u0+...+w53.u3
+  // vw54.u4+...+w57.u7
+  vrow6q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow6q2), vget_high_s32(vrow6q2)),
+                         vpadd_s32(vget_low_s32(vrow7q2), vget_high_s32(vrow7q2)));
+  // vrow0q2 = vw60.u0+...+w63.u3 vw64.u4+...+w67.u7 vw70.u0+...+w73.u3
+  // vw74.u4+...+w77.u7
+
+  vrow0q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow0q2), vget_high_s32(vrow0q2)),
+                         vpadd_s32(vget_low_s32(vrow2q2), vget_high_s32(vrow2q2)));
+  // vrow0q2 = vw00.u0+...+w07.u7 vw10.u0+...+w17.u7 vw20.u0+...+w27.u7
+  // vw30.u0+...+w37.u7
+  vrow4q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow4q2), vget_high_s32(vrow4q2)),
+                         vpadd_s32(vget_low_s32(vrow6q2), vget_high_s32(vrow6q2)));
+  // vrow0q2 = vw40.u0+...+w47.u7 vw50.u0+...+w57.u7 vw60.u0+...+w67.u7
+  // vw70.u0+...+w77.u7
+
+  result0123 = vaddq_s32(result0123, vrow0q2);
+  result4567 = vaddq_s32(result4567, vrow4q2);
+}
+
+// Adds the 8 bias weights at wi, scaled to match the integer inputs, to
+// result0123 and result4567 and writes the first num_out of the results,
+// multiplied by scales, to v.
+static inline void ExtractResults8(int32x4_t result0123, int32x4_t result4567,
+                                   const int8_t *wi, const TFloat *scales, TFloat *v,
+                                   int num_out) {
+  int8x8_t bias_scale = {127, 127, 127, 127, 127, 127, 127, 127};
+  int8x8_t bias = vld1_s8(wi); // vw0    = b0  b1  b2  b3  b4  b5  b6  b7
+  int16x8_t scaled_bias = vmull_s8(bias, bias_scale);
+  result0123 = vaddw_s16(result0123, vget_low_s16(scaled_bias));
+  result4567 = vaddw_s16(result4567, vget_high_s16(scaled_bias));
+  *v++ = vget_lane_s32(vget_low_s32(result0123), 0) * *scales++;
+  if (num_out > 1)
+    *v++ = vget_lane_s32(vget_low_s32(result0123), 1) * *scales++;
+  if (num_out > 2)
+    *v++ = vget_lane_s32(vget_high_s32(result0123), 0) * *scales++;
+  if (num_out > 3)
+    *v++ = vget_lane_s32(vget_high_s32(result0123), 1) * *scales++;
+  if (num_out > 4)
+    *v++ = vget_lane_s32(vget_low_s32(result4567), 0) * *scales++;
+  if (num_out > 5)
+    *v++ = vget_lane_s32(vget_low_s32(result4567), 1) * *scales++;
+  if (num_out > 6)
+    *v++ = vget_lane_s32(vget_high_s32(result4567), 0) * *scales++;
+  if (num_out > 7)
+    *v = vget_lane_s32(vget_high_s32(result4567), 1) * *scales;
+}
+
 // Computes part of matrix.vector v = Wu. Computes N=8 results.
 // The weights *must* be arranged so that consecutive reads from wi
 // provides (num_in/kNumInputsPerGroup groups of (N output dim groups of
@@ -59,7 +160,6 @@ static inline void PartialMatrixDotVector8(const int8_t *__restrict wi,
   // Initialize all the results to 0.
   int32x4_t result0123 = {0, 0, 0, 0};
   int32x4_t result4567 = {0, 0, 0, 0};
-  int8x8_t bias_scale = {127, 127, 127, 127, 127, 127, 127, 127};
   // Iterate over the input (u), one registerful at a time.
   for (int j = 0; j < num_in; j += 8) {
     int8x8_t vu = vld1_s8(u);              // vu     = u0  u1  u2  u3  u4  u5  u6  u7
@@ -72,96 +172,11 @@ static inline void PartialMatrixDotVector8(const int8_t *__restrict wi,
     int8x16_t vw67 = vld1q_s8(wi + 8 * 6); // vw6    = w60 w61 w62 w63 w64 w65 w66 w67 w70
                                            // w71 w72 w73 w74 w75 w76 w77
 
-    int16x8_t vrow0q = vmull_s8(vget_low_s8(vw01), vu); // vrow0q = vw00.u0 w01.u1 w02.u2
-                                                        // w03.u3 vw04.u4 w05.u5 w06.u6 w07.u7
-    int16x8_t vrow1q = vmull_s8(vget_high_s8(vw01),
-                                vu);                    // vrow1q = vw10.u0 w11.u1 w12.u2 w13.u3
-                                                        // vw14.u4 w15.u5 w16.u6 w17.u7
-    int16x8_t vrow2q = vmull_s8(vget_low_s8(vw23), vu); // vrow2q = vw20.u0 w21.u1 w22.u2
-                                                        // w23.u3 vw24.u4 w25.u5 w26.u6 w27.u7
-    int16x8_t vrow3q = vmull_s8(vget_high_s8(vw23),
-                                vu);                    // vrow3q = vw30.u0 w31.u1 w32.u2 w33.u3
-                                                        // vw34.u4 w35.u5 w36.u6 w37.u7
-    int16x8_t vrow4q = vmull_s8(vget_low_s8(vw45), vu); // vrow4q = vw40.u0 w41.u1 w42.u2
-                                                        // w43.u3 vw44.u4 w45.u5 w46.u6 w47.u7
-    int16x8_t vrow5q = vmull_s8(vget_high_s8(vw45),
-                                vu);                    // vrow5q = vw50.u0 w51.u1 w52.u2 w53.u3
-                                                        // vw54.u4 w55.u5 w56.u6 w57.u7
-    int16x8_t vrow6q = vmull_s8(vget_low_s8(vw67), vu); // vrow6q = vw60.u0 w61.u1 w62.u2
-                                                        // w63.u3 vw64.u4 w65.u5 w66.u6 w67.u7
-    int16x8_t vrow7q = vmull_s8(vget_high_s8(vw67),
-                                vu); // vrow7q = vw70.u0 w71.u1 w72.u2 w73.u3
-                                     // vw74.u4 w75.u5 w76.u6 w77.u7
-
-    int32x4_t vrow0q2 = vpaddlq_s16(vrow0q); // vrow0q2 = vw00.u0+w01.u1 w02.u2+w03.u3
-                                             // vw04.u4+w05.u5 w06.u6+w07.u7
-    int32x4_t vrow1q2 = vpaddlq_s16(vrow1q); // vrow1q2 = vw10.u0+w11.u1 w12.u2+w13.u3
-                                             // vw14.u4+w15.u5 w16.u6+w17.u7
-    int32x4_t vrow2q2 = vpaddlq_s16(vrow2q); // vrow2q2 = vw20.u0+w21.u1 w22.u2+w23.u3
-                                             // vw24.u4+w25.u5 w26.u6+w27.u7
-    int32x4_t vrow3q2 = vpaddlq_s16(vrow3q); // vrow3q2 = vw30.u0+w31.u1 w32.u2+w33.u3
-                                             // vw34.u4+w35.u5 w36.u6+w37.u7
-    int32x4_t vrow4q2 = vpaddlq_s16(vrow4q); // vrow4q2 = vw40.u0+w41.u1 w42.u2+w43.u3
-                                             // vw44.u4+w45.u5 w46.u6+w47.u7
-    int32x4_t vrow5q2 = vpaddlq_s16(vrow5q); // vrow5q2 = vw50.u0+w51.u1 w52.u2+w53.u3
-                                             // vw54.u4+w55.u5 w56.u6+w57.u7
-    int32x4_t vrow6q2 = vpaddlq_s16(vrow6q); // vrow6q2 = vw60.u0+w61.u1 w62.u2+w63.u3
-                                             // vw64.u4+w65.u5 w66.u6+w67.u7
-    int32x4_t vrow7q2 = vpaddlq_s16(vrow7q); // vrow7q2 = vw70.u0+w71.u1 w72.u2+w73.u3
-                                             // vw74.u4+w75.u5 w76.u6+w77.u7
-
-    vrow0q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow0q2), vget_high_s32(vrow0q2)),
-                           vpadd_s32(vget_low_s32(vrow1q2), vget_high_s32(vrow1q2)));
-    // vrow0q2 = vw00.u0+...+w03.u3 vw04.u4+...+w07.u7 vw10.u0+...+w13.u3
-    // vw14.u4+...+w17.u7
-    vrow2q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow2q2), vget_high_s32(vrow2q2)),
-                           vpadd_s32(vget_low_s32(vrow3q2), vget_high_s32(vrow3q2)));
-    // vrow0q2 = vw20.u0+...+w23.u3 vw24.u4+...+w27.u7 vw30.u0+...+w33.u3
-    // vw34.u4+...+w37.u7
-    vrow4q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow4q2), vget_high_s32(vrow4q2)),
-                           vpadd_s32(vget_low_s32(vrow5q2), vget_high_s32(vrow5q2)));
-    // vrow0q2 = vw40.u0+...+w43.u3 vw44.u4+...+w47.u7 vw50.u0+...+w53.u3
-    // vw54.u4+...+w57.u7
-    vrow6q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow6q2), vget_high_s32(vrow6q2)),
-                           vpadd_s32(vget_low_s32(vrow7q2), vget_high_s32(vrow7q2)));
-    // vrow0q2 = vw60.u0+...+w63.u3 vw64.u4+...+w67.u7 vw70.u0+...+w73.u3
-    // vw74.u4+...+w77.u7
-
-    vrow0q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow0q2), vget_high_s32(vrow0q2)),
-                           vpadd_s32(vget_low_s32(vrow2q2), vget_high_s32(vrow2q2)));
-    // vrow0q2 = vw00.u0+...+w07.u7 vw10.u0+...+w17.u7 vw20.u0+...+w27.u7
-    // vw30.u0+...+w37.u7
-    vrow4q2 = vcombine_s32(vpadd_s32(vget_low_s32(vrow4q2), vget_high_s32(vrow4q2)),
-                           vpadd_s32(vget_low_s32(vrow6q2), vget_high_s32(vrow6q2)));
-    // vrow0q2 = vw40.u0+...+w47.u7 vw50.u0+...+w57.u7 vw60.u0+...+w67.u7
-    // vw70.u0+...+w77.u7
-
-    result0123 = vaddq_s32(result0123, vrow0q2);
-    result4567 = vaddq_s32(result4567, vrow4q2);
+    MultiplyGroup8(vw01, vw23, vw45, vw67, vu, result0123, result4567);
     u += 8;
     wi += 64;
   }
-  {
-    int8x8_t bias = vld1_s8(wi); // vw0    = b0  b1  b2  b3  b4  b5  b6  b7
-    int16x8_t scaled_bias = vmull_s8(bias, bias_scale);
-    result0123 = vaddw_s16(result0123, vget_low_s16(scaled_bias));
-    result4567 = vaddw_s16(result4567, vget_high_s16(scaled_bias));
-    *v++ = vget_lane_s32(vget_low_s32(result0123), 0) * *scales++;
-    if (num_out > 1)
-      *v++ = vget_lane_s32(vget_low_s32(result0123), 1) * *scales++;
-    if (num_out > 2)
-      *v++ = vget_lane_s32(vget_high_s32(result0123), 0) * *scales++;
-    if (num_out > 3)
-      *v++ = vget_lane_s32(vget_high_s32(result0123), 1) * *scales++;
-    if (num_out > 4)
-      *v++ = vget_lane_s32(vget_low_s32(result4567), 0) * *scales++;
-    if (num_out > 5)
-      *v++ = vget_lane_s32(vget_low_s32(result4567), 1) * *scales++;
-    if (num_out > 6)
-      *v++ = vget_lane_s32(vget_high_s32(result4567), 0) * *scales++;
-    if (num_out > 7)
-      *v = vget_lane_s32(vget_high_s32(result4567), 1) * *scales;
-  }
+  ExtractResults8(result0123, result4567, wi, scales, v, num_out);
 }
 
 static void matrixDotVector(int dim1, int dim2, const int8_t *wi, const TFloat *scales,
@@ -187,6 +202,63 @@ static void matrixDotVector(int dim1, int dim2, const int8_t *wi, const TFloat *
                             num_out & (kNumOutputsPerRegister - 1));
 }
 
+// Computes part of matrix.matrix v[c] = Wu[c] for kNumVectors input vectors.
+// Computes N=8 results for each vector, with the weights arranged as for
+// PartialMatrixDotVector8. Each block of weights is loaded once and
+// multiplied by all the input vectors.
+template <int kNumVectors>
+static inline void PartialMatrixDotMatrix8(const int8_t *__restrict wi,
+                                           const TFloat *__restrict scales,
+                                           const int8_t *const *u, int num_in, int output,
+                                           TFloat *const *v, int num_out) {
+  int32x4_t result0123[kNumVectors];
+  int32x4_t result4567[kNumVectors];
+  for (int c = 0; c < kNumVectors; ++c) {
+    result0123[c] = vdupq_n_s32(0);
+    result4567[c] = vdupq_n_s32(0);
+  }
+  for (int j = 0; j < num_in; j += 8) {
+    int8x16_t vw01 = vld1q_s8(wi);
+    int8x16_t vw23 = vld1q_s8(wi + 8 * 2);
+    int8x16_t vw45 = vld1q_s8(wi + 8 * 4);
+    int8x16_t vw67 = vld1q_s8(wi + 8 * 6);
+    for (int c = 0; c < kNumVectors; ++c) {
+      int8x8_t vu = vld1_s8(u[c] + j);
+      MultiplyGroup8(vw01, vw23, vw45, vw67, vu, result0123[c], result4567[c]);
+    }
+    wi += 64;
+  }
+  for (int c = 0; c < kNumVectors; ++c) {
+    ExtractResults8(result0123[c], result4567[c], wi, scales, v[c] + output, num_out);
+  }
+}
+
+static void matrixDotMatrix(int dim1, int dim2, const int8_t *wi, const TFloat *scales,
+                            int num_vectors, const int8_t *const *u, TFloat *const *v) {
+  // Number of input vectors multiplied by each block of weights at once.
+  constexpr int kNumVectors = 4;
+  const int num_out = dim1;
+  const int num_in = dim2 - 1;
+  const int rounded_num_in = IntSimdMatrix::Roundup(num_in, kNumInputsPerGroup);
+  const int group_size = kNumOutputsPerRegister * kMaxOutputRegisters;
+  const int w_step = (rounded_num_in + 1) * group_size;
+
+  for (int output = 0; output < num_out; output += group_size) {
+    int num_results = std::min(group_size, num_out - output);
+    int c = 0;
+    for (; c + kNumVectors <= num_vectors; c += kNumVectors) {
+      PartialMatrixDotMatrix8<kNumVectors>(wi, scales, u + c, rounded_num_in, output, v + c,
+                                           num_results);
+    }
+    for (; c < num_vectors; ++c) {
+      PartialMatrixDotMatrix8<1>(wi, scales, u + c, rounded_num_in, output, v + c,
+                                 num_results);
+    }
+    wi += w_step;
+    scales += group_size;
+  }
+}
+
 const IntSimdMatrix IntSimdMatrix::intSimdMatrixNEON = {
     // Function.
     matrixDotVector,
@@ -197,7 +269,9 @@ const IntSimdMatrix IntSimdMatrix::intSimdMatrixNEON = {
     // Number of 8 bit inputs in the inputs register.
     kNumInputsPerRegister,
     // Number of inputs in each weight group.
-    kNumInputsPerGroup
+    kNumInputsPerGroup,
+    // Matrix.matrix function.
+    matrixDotMatrix
 };
 
 } // namespace tesseract.
@@ -90,6 +90,72 @@ static void matrixDotVector(int dim1, int dim2, const int8_t *wi, const TFloat *
   }
 }
 
+// Computes the dot products of the n-vector w with each of the kNumVectors
+// n-vectors u[c], loading each part of w only once.
+template <int kNumVectors>
+static inline void IntDotProductsSSE(const int8_t *w, const int8_t *const *u, int n,
+                                     int32_t *results) {
+  int max_offset = n - 8;
+  int offset = 0;
+  __m128i sums[kNumVectors];
+  for (int c = 0; c < kNumVectors; ++c) {
+    sums[c] = _mm_setzero_si128();
+  }
+  for (; offset <= max_offset; offset += 8) {
+    __m128i weights = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(w + offset));
+    weights = _mm_cvtepi8_epi16(weights);
+    for (int c = 0; c < kNumVectors; ++c) {
+      __m128i inputs = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(u[c] + offset));
+      inputs = _mm_cvtepi8_epi16(inputs);
+      sums[c] = _mm_add_epi32(sums[c], _mm_madd_epi16(weights, inputs));
+    }
+  }
+  for (int c = 0; c < kNumVectors; ++c) {
+    // Sum the 4 packed 32 bit sums and extract the low result.
+    __m128i sum = _mm_hadd_epi32(sums[c], sums[c]);
+    sum = _mm_hadd_epi32(sum, sum);
+    int32_t result = _mm_cvtsi128_si32(sum);
+    for (int i = offset; i < n; ++i) {
+      result += w[i] * u[c][i];
+    }
+    results[c] = result;
+  }
+}
+
+// Computes part of matrix.matrix v[c] = Wu[c]. Computes 1 result for each
+// of kNumVectors input vectors, writing them to v[c][output].
+template <int kNumVectors>
+static inline void PartialMatrixDotMatrix1(const int8_t *wi, const TFloat *scales,
+                                           const int8_t *const *u, int num_in, int output,
+                                           TFloat *const *v) {
+  int32_t totals[kNumVectors];
+  IntDotProductsSSE<kNumVectors>(wi, u, num_in, totals);
+  for (int c = 0; c < kNumVectors; ++c) {
+    TFloat total = totals[c];
+    // Add in the bias and correct for integer values.
+    v[c][output] = (total + wi[num_in] * INT8_MAX) * *scales;
+  }
+}
+
+static void matrixDotMatrix(int dim1, int dim2, const int8_t *wi, const TFloat *scales,
+                            int num_vectors, const int8_t *const *u, TFloat *const *v) {
+  // Number of input vectors multiplied by each row of weights at once.
+  constexpr int kNumVectors = 4;
+  const int num_out = dim1;
+  const int num_in = dim2 - 1;
+  for (int output = 0; output < num_out; output++) {
+    int c = 0;
+    for (; c + kNumVectors <= num_vectors; c += kNumVectors) {
+      PartialMatrixDotMatrix1<kNumVectors>(wi, scales, u + c, num_in, output, v + c);
+    }
+    for (; c < num_vectors; ++c) {
+      PartialMatrixDotMatrix1<1>(wi, scales, u + c, num_in, output, v + c);
+    }
+    wi += dim2;
+    scales++;
+  }
+}
+
 const IntSimdMatrix IntSimdMatrix::intSimdMatrixSSE = {
     matrixDotVector,
     // Number of 32 bit outputs held in each register.
@@ -99,7 +165,9 @@ const IntSimdMatrix IntSimdMatrix::intSimdMatrixSSE = {
     // Number of 8 bit inputs in the inputs register.
     1,
     // Number of inputs in each weight group.
-    1
+    1,
+    // Matrix.matrix function.
+    matrixDotMatrix
 };
 
 } // namespace tesseract.
@@ -19,11 +19,14 @@
 #  include "config_auto.h" // for HAVE_AVX, ...
 #endif
 #include <numeric> // for std::inner_product
+#include "classpruner.h"
 #include "dotproduct.h"
+#include "gatefunctions.h"
 #include "intsimdmatrix.h" // for IntSimdMatrix
 #include "params.h"        // for STRING_VAR
 #include "simddetect.h"
 #include "tprintf.h" // for tprintf
+#include "vectorsearch.h"
 
 #if !defined(__clang__) && defined(__GNUC__) && (__GNUC__ < 12)
 // The GNU compiler g++ fails to compile with the Accelerate framework
@@ -78,6 +81,12 @@ namespace tesseract {
 // bandwidth constrained and could benefit from holding the reused vector
 // in AVX registers.
 DotProductFunction DotProduct;
+VectorFunction TanhVector;
+VectorFunction LogisticVector;
+TanhPrimeMultiply3AddFunction TanhPrimeMultiply3Add;
+LSTMCellFunction LSTMCell;
+FirstAboveFunction FirstAbove;
+ClassPrunerCountsFunction ClassPrunerCounts;
 
 static STRING_VAR(dotproduct, "auto", "Function used for calculation of dot product");
 
@@ -96,6 +105,7 @@ bool SIMDDetect::avx2_available_;
 bool SIMDDetect::avx512F_available_;
 bool SIMDDetect::avx512BW_available_;
 bool SIMDDetect::avx512VNNI_available_;
+bool SIMDDetect::avxvnni_available_;
 // If true, then FMA has been detected.
 bool SIMDDetect::fma_available_;
 // If true, then SSe4.1 has been detected.
@@ -129,11 +139,57 @@ static TFloat DotProductStdInnerProduct(const TFloat *u, const TFloat *v, int n)
   return std::inner_product(u, u + n, v, static_cast<TFloat>(0));
 }
 
+// Returns the index of the first of the n values that is greater than
+// threshold, or n if there is none.
+static int FirstAboveGeneric(const float *values, int n, float threshold) {
+  int i = 0;
+  while (i < n && !(values[i] > threshold)) {
+    ++i;
+  }
+  return i;
+}
+
+// Adds up the class pruner weights of the features for each of the
+// num_pruners class pruners into counts.
+static void ClassPrunerCountsGeneric(const uint32_t *const *pruners, int num_pruners,
+                                     const int *offsets, int num_features, int *counts) {
+  for (int p = 0; p < num_pruners; ++p) {
+    for (int f = 0; f < num_features; ++f) {
+      const uint32_t *vector = pruners[p] + offsets[f];
+      int *class_count = counts + 32 * p;
+      for (int word = 0; word < 2; ++word) {
+        uint32_t weights = vector[word];
+        for (int c = 0; c < 16; ++c) {
+          *class_count++ += weights & 3;
+          weights >>= 2;
+        }
+      }
+    }
+  }
+}
+
 static void SetDotProduct(DotProductFunction f, const IntSimdMatrix *m = nullptr) {
   DotProduct = f;
   IntSimdMatrix::intSimdMatrix = m;
 }
 
+static void SetGateFunctions(VectorFunction tanh, VectorFunction logistic,
+                             TanhPrimeMultiply3AddFunction tanh_prime_multiply3_add,
+                             LSTMCellFunction lstm_cell) {
+  TanhVector = tanh;
+  LogisticVector = logistic;
+  TanhPrimeMultiply3Add = tanh_prime_multiply3_add;
+  LSTMCell = lstm_cell;
+}
+
+static void SetVectorSearch(FirstAboveFunction first_above) {
+  FirstAbove = first_above;
+}
+
+static void SetClassPruner(ClassPrunerCountsFunction class_pruner_counts) {
+  ClassPrunerCounts = class_pruner_counts;
+}
+
 // Constructor.
 // Tests the architecture in a system-dependent way to detect AVX, SSE and
 // any other available SIMD equipment.
@@ -142,6 +198,8 @@ static void SetDotProduct(DotProductFunction f, const IntSimdMatrix *m = nullptr
 SIMDDetect::SIMDDetect() {
   // The fallback is a generic dot product calculation.
   SetDotProduct(DotProductGeneric);
+  SetVectorSearch(FirstAboveGeneric);
+  SetClassPruner(ClassPrunerCountsGeneric);
 
 #if defined(HAS_CPUID)
 #  if defined(__GNUC__)
@@ -171,9 +229,14 @@ SIMDDetect::SIMDDetect() {
         // be used inside an if.
         __cpuid_count(7, 0, eax, ebx, ecx, edx);
         avx2_available_ = (ebx & 0x00000020) != 0;
-        avx512F_available_ = (ebx & 0x00010000) != 0;
-        avx512BW_available_ = (ebx & 0x40000000) != 0;
-        avx512VNNI_available_ = (ecx & 0x00000800) != 0;
+        // AVX512 also needs the OS to save the opmask and ZMM state.
+        if ((xgetbv() & 0xe0) == 0xe0) {
+          avx512F_available_ = (ebx & 0x00010000) != 0;
+          avx512BW_available_ = (ebx & 0x40000000) != 0;
+          avx512VNNI_available_ = (ecx & 0x00000800) != 0;
+        }
+        __cpuid_count(7, 1, eax, ebx, ecx, edx);
+        avxvnni_available_ = (eax & 0x00000010) != 0;
       }
 #      endif
     }
@@ -202,9 +265,14 @@ SIMDDetect::SIMDDetect() {
       if (max_function_id >= 7) {
         __cpuid(cpuInfo, 7);
         avx2_available_ = (cpuInfo[1] & 0x00000020) != 0;
-        avx512F_available_ = (cpuInfo[1] & 0x00010000) != 0;
-        avx512BW_available_ = (cpuInfo[1] & 0x40000000) != 0;
-        avx512VNNI_available_ = (cpuInfo[2] & 0x00000800) != 0;
+        // AVX512 also needs the OS to save the opmask and ZMM state.
+        if ((_xgetbv(0) & 0xe0) == 0xe0) {
+          avx512F_available_ = (cpuInfo[1] & 0x00010000) != 0;
+          avx512BW_available_ = (cpuInfo[1] & 0x40000000) != 0;
+          avx512VNNI_available_ = (cpuInfo[2] & 0x00000800) != 0;
+        }
+        __cpuidex(cpuInfo, 7, 1);
+        avxvnni_available_ = (cpuInfo[0] & 0x00000010) != 0;
       }
 #      endif
     }
@@ -234,11 +302,21 @@ SIMDDetect::SIMDDetect() {
   // Select code for calculation of dot product based on autodetection.
   if (false) {
     // This is a dummy to support conditional compilation.
+#if defined(HAVE_AVX512VNNI) && defined(HAVE_AVX512F)
+  } else if (avx512VNNI_available_ && avx512BW_available_) {
+    // AVX512 VNNI detected.
+    SetDotProduct(DotProductAVX512F, &IntSimdMatrix::intSimdMatrixAVX512VNNI);
+#endif
 #if defined(HAVE_AVX512F)
   } else if (avx512F_available_) {
     // AVX512F detected.
     SetDotProduct(DotProductAVX512F, &IntSimdMatrix::intSimdMatrixAVX2);
 #endif
+#if defined(HAVE_AVXVNNI)
+  } else if (avxvnni_available_ && avx2_available_) {
+    // AVX VNNI detected.
+    SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixAVXVNNI);
+#endif
 #if defined(HAVE_AVX2)
   } else if (avx2_available_) {
     // AVX2 detected.
@@ -261,6 +339,42 @@ SIMDDetect::SIMDDetect() {
 #endif
   }
 
+  // Select code for the gate functions based on autodetection.
+  if (false) {
+    // This is a dummy to support conditional compilation.
+#if defined(HAVE_AVX512F)
+  } else if (avx512F_available_) {
+    SetGateFunctions(TanhVectorAVX512F, LogisticVectorAVX512F, TanhPrimeMultiply3AddAVX512F,
+                     LSTMCellAVX512F);
+    SetVectorSearch(FirstAboveAVX512F);
+#endif
+#if defined(HAVE_AVX2)
+  } else if (avx2_available_) {
+    SetGateFunctions(TanhVectorAVX2, LogisticVectorAVX2, TanhPrimeMultiply3AddAVX2,
+                     LSTMCellAVX2);
+    SetVectorSearch(FirstAboveAVX2);
+#endif
+#if defined(__aarch64__)
+  } else if (neon_available_) {
+    SetGateFunctions(TanhVectorNEON, LogisticVectorNEON, TanhPrimeMultiply3AddNEON,
+                     LSTMCellNEON);
+    SetVectorSearch(FirstAboveNEON);
+#endif
+  }
+
+  // Select code for the class pruner based on autodetection.
+  if (false) {
+    // This is a dummy to support conditional compilation.
+#if defined(HAVE_AVX2)
+  } else if (avx2_available_) {
+    SetClassPruner(ClassPrunerCountsAVX2);
+#endif
+#if defined(__aarch64__)
+  } else if (neon_available_) {
+    SetClassPruner(ClassPrunerCountsNEON);
+#endif
+  }
+
   const char *dotproduct_env = getenv("DOTPRODUCT");
   if (dotproduct_env != nullptr) {
     // Override automatic settings by value from environment variable.
@@ -278,11 +392,26 @@ void SIMDDetect::Update() {
   } else if (dotproduct == "generic") {
     // Generic code selected by config variable.
     SetDotProduct(DotProductGeneric);
+    SetGateFunctions(nullptr, nullptr, nullptr, nullptr);
+    SetVectorSearch(FirstAboveGeneric);
+    SetClassPruner(ClassPrunerCountsGeneric);
     dotproduct_method = "generic";
   } else if (dotproduct == "native") {
     // Native optimized code selected by config variable.
     SetDotProduct(DotProductNative, IntSimdMatrix::intSimdMatrix);
     dotproduct_method = "native";
+#if defined(HAVE_AVX512VNNI) && defined(HAVE_AVX512F)
+  } else if (dotproduct == "avx512vnni") {
+    // AVX512 VNNI selected by config variable.
+    SetDotProduct(DotProductAVX512F, &IntSimdMatrix::intSimdMatrixAVX512VNNI);
+    dotproduct_method = "avx512vnni";
+#endif
+#if defined(HAVE_AVXVNNI)
+  } else if (dotproduct == "avxvnni") {
+    // AVX VNNI selected by config variable.
+    SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixAVXVNNI);
+    dotproduct_method = "avxvnni";
+#endif
 #if defined(HAVE_AVX2)
   } else if (dotproduct == "avx2") {
     // AVX2 selected by config variable.
@@ -327,6 +456,12 @@ void SIMDDetect::Update() {
             dotproduct.c_str());
     tprintf(
         "Supported values for dotproduct: auto generic native"
+#if defined(HAVE_AVX512VNNI) && defined(HAVE_AVX512F)
+        " avx512vnni"
+#endif
+#if defined(HAVE_AVXVNNI)
+        " avxvnni"
+#endif
 #if defined(HAVE_AVX2)
         " avx2"
 #endif
@@ -20,12 +20,38 @@
 #include <tesseract/export.h>
 #include "tesstypes.h"
 
+#include <cstdint>
+
 namespace tesseract {
 
 // Function pointer for best calculation of dot product.
 using DotProductFunction = TFloat (*)(const TFloat *, const TFloat *, int);
 extern DotProductFunction DotProduct;
 
+// Function pointers for the vectorized nonlinearities of the LSTM gates (see
+// gatefunctions.h), or nullptr if there are none for this machine, in which
+// case the table-based functions of lstm/functions.h are used.
+using VectorFunction = void (*)(int, TFloat *);
+extern VectorFunction TanhVector;
+extern VectorFunction LogisticVector;
+using TanhPrimeMultiply3AddFunction = void (*)(int, const float *, const float *, const TFloat *,
+                                               TFloat *);
+extern TanhPrimeMultiply3AddFunction TanhPrimeMultiply3Add;
+using LSTMCellFunction = void (*)(int, const TFloat *, const TFloat *, const TFloat *,
+                                  const TFloat *, const TFloat *, const TFloat *, TFloat, TFloat *,
+                                  TFloat *);
+extern LSTMCellFunction LSTMCell;
+
+// Function pointer for the best search of the first of n floats that is
+// greater than a threshold (see vectorsearch.h).
+using FirstAboveFunction = int (*)(const float *, int, float);
+extern FirstAboveFunction FirstAbove;
+
+// Function pointer for the best sum of the class pruner weights of the
+// features of a blob (see classpruner.h).
+using ClassPrunerCountsFunction = void (*)(const uint32_t *const *, int, const int *, int, int *);
+extern ClassPrunerCountsFunction ClassPrunerCounts;
+
 // Architecture detector. Add code here to detect any other architectures for
 // SIMD-based faster dot product functions. Intended to be a single static
 // object, but it does no real harm to have more than one.
@@ -51,6 +77,11 @@ public:
   static inline bool IsAVX512VNNIAvailable() {
     return detector.avx512VNNI_available_;
   }
+  // Returns true if the 256 bit AVX Vector Neural Network Instructions are
+  // available.
+  static inline bool IsAVXVNNIAvailable() {
+    return detector.avxvnni_available_;
+  }
   // Returns true if FMA is available on this system.
   static inline bool IsFMAAvailable() {
     return detector.fma_available_;
@@ -80,6 +111,7 @@ private:
   static TESS_API bool avx512F_available_;
   static TESS_API bool avx512BW_available_;
   static TESS_API bool avx512VNNI_available_;
+  static TESS_API bool avxvnni_available_;
   // If true, then FMA has been detected.
   static TESS_API bool fma_available_;
   // If true, then SSe4.1 has been detected.
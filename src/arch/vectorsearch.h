@@ -0,0 +1,30 @@
+///////////////////////////////////////////////////////////////////////
+// File:        vectorsearch.h
+// Description: Vectorized searches of float vectors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_VECTORSEARCH_H_
+#define TESSERACT_ARCH_VECTORSEARCH_H_
+
+namespace tesseract {
+
+// Returns the index of the first of the n values that is greater than
+// threshold, or n if there is none. Used to skip the bulk of the outputs of
+// the network that can't make the top-n of the beam search.
+int FirstAboveAVX2(const float *values, int n, float threshold);
+int FirstAboveAVX512F(const float *values, int n, float threshold);
+int FirstAboveNEON(const float *values, int n, float threshold);
+
+} // namespace tesseract.
+
+#endif // TESSERACT_ARCH_VECTORSEARCH_H_
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////
+// File:        vectorsearchavx2.cpp
+// Description: Vectorized searches of float vectors for avx2.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX2 capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "vectorsearch.h"
+
+namespace tesseract {
+
+int FirstAboveAVX2(const float *values, int n, float threshold) {
+  const __m256 t = _mm256_set1_ps(threshold);
+  int i = 0;
+  // Test 4 registers at a time, as almost all of them fail.
+  for (; i + 32 <= n; i += 32) {
+    __m256 above0 = _mm256_cmp_ps(_mm256_loadu_ps(values + i), t, _CMP_GT_OQ);
+    __m256 above1 = _mm256_cmp_ps(_mm256_loadu_ps(values + i + 8), t, _CMP_GT_OQ);
+    __m256 above2 = _mm256_cmp_ps(_mm256_loadu_ps(values + i + 16), t, _CMP_GT_OQ);
+    __m256 above3 = _mm256_cmp_ps(_mm256_loadu_ps(values + i + 24), t, _CMP_GT_OQ);
+    __m256 above = _mm256_or_ps(_mm256_or_ps(above0, above1), _mm256_or_ps(above2, above3));
+    if (_mm256_movemask_ps(above) != 0) {
+      break;
+    }
+  }
+  for (; i + 8 <= n; i += 8) {
+    if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), t, _CMP_GT_OQ)) != 0) {
+      break;
+    }
+  }
+  for (; i < n && !(values[i] > threshold); ++i) {
+  }
+  return i;
+}
+
+} // namespace tesseract.
+
+#endif
@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////
+// File:        vectorsearchavx512.cpp
+// Description: Vectorized searches of float vectors for avx512.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX512F__)
+#  if defined(__i686__) || defined(__x86_64__)
+#    error Implementation only for AVX512F capable architectures
+#  endif
+#else
+
+#  include <immintrin.h>
+#  include "vectorsearch.h"
+
+namespace tesseract {
+
+int FirstAboveAVX512F(const float *values, int n, float threshold) {
+  const __m512 t = _mm512_set1_ps(threshold);
+  int i = 0;
+  // Test 4 registers at a time, as almost all of them fail.
+  for (; i + 64 <= n; i += 64) {
+    __mmask16 above = _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i), t, _CMP_GT_OQ) |
+                      _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i + 16), t, _CMP_GT_OQ) |
+                      _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i + 32), t, _CMP_GT_OQ) |
+                      _mm512_cmp_ps_mask(_mm512_loadu_ps(values + i + 48), t, _CMP_GT_OQ);
+    if (above != 0) {
+      break;
+    }
+  }
+  for (; i + 16 <= n; i += 16) {
+    if (_mm512_cmp_ps_mask(_mm512_loadu_ps(values + i), t, _CMP_GT_OQ) != 0) {
+      break;
+    }
+  }
+  for (; i < n && !(values[i] > threshold); ++i) {
+  }
+  return i;
+}
+
+} // namespace tesseract.
+
+#endif
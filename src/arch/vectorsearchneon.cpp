@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////
+// File:        vectorsearchneon.cpp
+// Description: Vectorized searches of float vectors for neon.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+// Only for 64 bit ARM, which has the horizontal max.
+#if defined(__ARM_NEON) && defined(__aarch64__)
+
+#  include <arm_neon.h>
+#  include "vectorsearch.h"
+
+namespace tesseract {
+
+int FirstAboveNEON(const float *values, int n, float threshold) {
+  const float32x4_t t = vdupq_n_f32(threshold);
+  int i = 0;
+  // Test 4 registers at a time, as almost all of them fail.
+  for (; i + 16 <= n; i += 16) {
+    uint32x4_t above = vorrq_u32(vorrq_u32(vcgtq_f32(vld1q_f32(values + i), t),
+                                           vcgtq_f32(vld1q_f32(values + i + 4), t)),
+                                 vorrq_u32(vcgtq_f32(vld1q_f32(values + i + 8), t),
+                                           vcgtq_f32(vld1q_f32(values + i + 12), t)));
+    if (vmaxvq_u32(above) != 0) {
+      break;
+    }
+  }
+  for (; i + 4 <= n; i += 4) {
+    if (vmaxvq_u32(vcgtq_f32(vld1q_f32(values + i), t)) != 0) {
+      break;
+    }
+  }
+  for (; i < n && !(values[i] > threshold); ++i) {
+  }
+  return i;
+}
+
+} // namespace tesseract.
+
+#endif
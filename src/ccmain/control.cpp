@@ -205,6 +205,15 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC *monitor, PAGE_RES_IT
   // added. The results will be significantly different with adaption on, and
   // deterioration will need investigation.
   pr_it->restart_page();
+  // LSTM-only recognition of a single language can recognize the words on
+  // several threads, or run the lines through the network in batches, ahead
+  // of the words being classified. Recognizer debug output needs the serial
+  // path.
+  const bool lstm_only = pass_n == 1 && lstm_recognizer_ != nullptr &&
+                         tessedit_ocr_engine_mode == OEM_LSTM_ONLY && sub_langs_.empty();
+  const bool parallel_lstm = lstm_only && lstm_word_threads > 1 && classify_debug_level == 0;
+  const bool batch_lstm = lstm_only && !parallel_lstm && lstm_batch_size > 1;
+  unsigned next_batch_word = 0;
   for (unsigned w = 0; w < words->size(); ++w) {
     WordData *word = &(*words)[w];
     if (w > 0) {
@@ -227,6 +236,8 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC *monitor, PAGE_RES_IT
         for (; w < words->size(); ++w) {
           (*words)[w].word->SetupFake(unicharset);
         }
+        lstm_batch_outputs_.clear();
+        lstm_parallel_words_.clear();
         return false;
       }
     }
@@ -252,6 +263,11 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC *monitor, PAGE_RES_IT
     }
 #endif // ndef DISABLED_LEGACY_ENGINE
 
+    if (parallel_lstm && w >= next_batch_word) {
+      next_batch_word = LSTMRecognizeWordsParallel(*words, w);
+    } else if (batch_lstm && w >= next_batch_word) {
+      next_batch_word = LSTMRecognizeWordBatch(*words, w);
+    }
     classify_word_and_language(pass_n, pr_it, word);
     if (tessedit_dump_choices || debug_noise_removal) {
       tprintf("Pass%d: %s [%s]\n", pass_n, word->word->best_choice->unichar_string().c_str(),
@@ -262,6 +278,9 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC *monitor, PAGE_RES_IT
       pr_it->MakeCurrentWordFuzzy();
     }
   }
+  // Drop any outputs of words that didn't get as far as the LSTM.
+  lstm_batch_outputs_.clear();
+  lstm_parallel_words_.clear();
   return true;
 }
 
@@ -33,6 +33,9 @@ namespace tesseract {
 const float kCertaintyScale = 7.0f;
 // Worst acceptable certainty for a dictionary word.
 const float kWorstDictCertainty = -25.0f;
+// Number of batches worth of words from which to pick words of similar
+// widths to batch together.
+const int kBatchWindowFactor = 4;
 
 // Generates training data for training a line recognizer, eg LSTM.
 // Breaks the page into lines, according to the boxes, and writes them to a
@@ -225,26 +228,58 @@ ImageData *Tesseract::GetRectImage(const TBOX &box, const BLOCK &block, int padd
   return new ImageData(vertical_text, box_pix);
 }
 
-// Recognizes a word or group of words, converting to WERD_RES in *words.
-// Analogous to classify_word_pass1, but can handle a group of words as well.
-void Tesseract::LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
-                                  PointerVector<WERD_RES> *words) {
-  TBOX word_box = word->word->bounding_box();
+// Helper gets the image of a word (or group of words) for the LSTM, with
+// the box extended to the ascenders and descenders of the row.
+ImageData *Tesseract::GetLSTMWordImage(const BLOCK &block, ROW *row, const WERD_RES *word,
+                                       TBOX *word_box) const {
+  *word_box = word->word->bounding_box();
   // Get the word image - no frills.
   if (tessedit_pageseg_mode == PSM_SINGLE_WORD || tessedit_pageseg_mode == PSM_RAW_LINE) {
     // In single word mode, use the whole image without any other row/word
     // interpretation.
-    word_box = TBOX(0, 0, ImageWidth(), ImageHeight());
+    *word_box = TBOX(0, 0, ImageWidth(), ImageHeight());
   } else {
-    float baseline = row->base_line((word_box.left() + word_box.right()) / 2);
-    if (baseline + row->descenders() < word_box.bottom()) {
-      word_box.set_bottom(baseline + row->descenders());
+    float baseline = row->base_line((word_box->left() + word_box->right()) / 2);
+    if (baseline + row->descenders() < word_box->bottom()) {
+      word_box->set_bottom(baseline + row->descenders());
     }
-    if (baseline + row->x_height() + row->ascenders() > word_box.top()) {
-      word_box.set_top(baseline + row->x_height() + row->ascenders());
+    if (baseline + row->x_height() + row->ascenders() > word_box->top()) {
+      word_box->set_top(baseline + row->x_height() + row->ascenders());
     }
   }
-  ImageData *im_data = GetRectImage(word_box, block, kImagePadding, &word_box);
+  return GetRectImage(*word_box, block, kImagePadding, word_box);
+}
+
+// Recognizes a word or group of words, converting to WERD_RES in *words.
+// Analogous to classify_word_pass1, but can handle a group of words as well.
+void Tesseract::LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
+                                  PointerVector<WERD_RES> *words) {
+  auto parallel_it = lstm_parallel_words_.find(word->word);
+  if (parallel_it != lstm_parallel_words_.end()) {
+    // The word has already been recognized concurrently with other words.
+    PointerVector<WERD_RES> &parallel_words = parallel_it->second;
+    for (unsigned i = 0; i < parallel_words.size(); ++i) {
+      words->push_back(parallel_words[i]);
+      parallel_words[i] = nullptr;
+    }
+    lstm_parallel_words_.erase(parallel_it);
+    SearchWords(words);
+    return;
+  }
+  auto batch_it = lstm_batch_outputs_.find(word->word);
+  if (batch_it != lstm_batch_outputs_.end()) {
+    // The network has already been run on this word as part of a batch.
+    const LSTMBatchOutput &batch_output = batch_it->second;
+    lstm_recognizer_->DecodeLine(batch_output.outputs, batch_output.scale_factor,
+                                 classify_debug_level > 0, kWorstDictCertainty / kCertaintyScale,
+                                 batch_output.word_box, words, lstm_choice_mode,
+                                 lstm_choice_iterations);
+    lstm_batch_outputs_.erase(batch_it);
+    SearchWords(words);
+    return;
+  }
+  TBOX word_box;
+  ImageData *im_data = GetLSTMWordImage(block, row, word, &word_box);
   if (im_data == nullptr) {
     return;
   }
@@ -258,6 +293,110 @@ void Tesseract::LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
   SearchWords(words);
 }
 
+// Runs the LSTM network over the images of up to
+// kBatchWindowFactor * lstm_batch_size words, starting at words[start], in
+// batches of up to lstm_batch_size words of similar widths. Words that are
+// already done, or for which the batch doesn't produce usable outputs (eg
+// because they need to be tried inverted), are left for LSTMRecognizeWord to
+// run individually.
+// Returns the index of the first word that was not considered for the batch.
+unsigned Tesseract::LSTMRecognizeWordBatch(const std::vector<WordData> &words, unsigned start) {
+  std::vector<const WERD *> batch_words;
+  std::vector<TBOX> word_boxes;
+  std::vector<const ImageData *> images;
+  // The words to batch are chosen from a larger window, so that there are
+  // words of similar widths to put together, but not the whole page, so
+  // that not too many outputs are held before they are decoded.
+  const size_t window_size = static_cast<size_t>(lstm_batch_size) * kBatchWindowFactor;
+  unsigned w;
+  for (w = start; w < words.size() && images.size() < window_size; ++w) {
+    const WordData &word_data = words[w];
+    if (word_data.word->done || lstm_batch_outputs_.count(word_data.word->word) > 0) {
+      continue;
+    }
+    TBOX word_box;
+    ImageData *im_data = GetLSTMWordImage(*word_data.block, word_data.row, word_data.word,
+                                          &word_box);
+    if (im_data == nullptr) {
+      continue;
+    }
+    batch_words.push_back(word_data.word->word);
+    word_boxes.push_back(word_box);
+    images.push_back(im_data);
+  }
+  if (images.size() > 1) {
+    bool do_invert = tessedit_do_invert;
+    float threshold = do_invert ? double(invert_threshold) : 0.0f;
+    std::vector<NetworkIO> outputs;
+    std::vector<float> scale_factors;
+    if (lstm_recognizer_->RecognizeLines(images, threshold, classify_debug_level > 0, &outputs,
+                                         &scale_factors, lstm_batch_size)) {
+      for (size_t i = 0; i < images.size(); ++i) {
+        if (outputs[i].Width() > 0) {
+          LSTMBatchOutput &batch_output = lstm_batch_outputs_[batch_words[i]];
+          batch_output.outputs = std::move(outputs[i]);
+          batch_output.scale_factor = scale_factors[i];
+          batch_output.word_box = word_boxes[i];
+        }
+      }
+    }
+  }
+  for (auto image : images) {
+    delete image;
+  }
+  return w;
+}
+
+// Recognizes the next words, starting at words[start], concurrently on
+// lstm_word_threads threads, and keeps the recognized words in
+// lstm_parallel_words_ until LSTMRecognizeWord takes them, in order, so that
+// the results are the same as recognizing the words one at a time.
+// Returns the index of the first word that was not considered.
+unsigned Tesseract::LSTMRecognizeWordsParallel(const std::vector<WordData> &words,
+                                               unsigned start) {
+  // Enough words per thread to even out the differences in their lengths.
+  const unsigned kWordsPerThread = 8;
+  const unsigned end = std::min<size_t>(words.size(), start + kWordsPerThread * lstm_word_threads);
+  std::vector<const WERD *> parallel_words;
+  std::vector<TBOX> word_boxes;
+  std::vector<const ImageData *> images;
+  for (unsigned w = start; w < end; ++w) {
+    const WordData &word_data = words[w];
+    if (word_data.word->done || lstm_parallel_words_.count(word_data.word->word) > 0) {
+      continue;
+    }
+    TBOX word_box;
+    ImageData *im_data = GetLSTMWordImage(*word_data.block, word_data.row, word_data.word,
+                                          &word_box);
+    if (im_data == nullptr) {
+      continue;
+    }
+    parallel_words.push_back(word_data.word->word);
+    word_boxes.push_back(word_box);
+    images.push_back(im_data);
+  }
+  if (!images.empty()) {
+    bool do_invert = tessedit_do_invert;
+    float threshold = do_invert ? double(invert_threshold) : 0.0f;
+    std::vector<PointerVector<WERD_RES>> results;
+    lstm_recognizer_->RecognizeLinesInParallel(lstm_word_threads, images, threshold,
+                                               kWorstDictCertainty / kCertaintyScale, word_boxes,
+                                               &results, lstm_choice_mode,
+                                               lstm_choice_iterations);
+    for (size_t i = 0; i < images.size(); ++i) {
+      PointerVector<WERD_RES> &word_results = lstm_parallel_words_[parallel_words[i]];
+      for (unsigned r = 0; r < results[i].size(); ++r) {
+        word_results.push_back(results[i][r]);
+        results[i][r] = nullptr;
+      }
+    }
+  }
+  for (auto image : images) {
+    delete image;
+  }
+  return end;
+}
+
 // Apply segmentation search to the given set of words, within the constraints
 // of the existing ratings matrix. If there is already a best_choice on a word
 // leaves it untouched and just sets the done/accepted etc flags.
@@ -303,4 +442,26 @@ void Tesseract::SearchWords(PointerVector<WERD_RES> *words) {
   }
 }
 
+// Starts the streaming recognition of a single line image with the LSTM.
+bool Tesseract::LSTMBeginStreamingLine(int lookahead) {
+  return lstm_recognizer_ != nullptr &&
+         lstm_recognizer_->BeginStreamingLine(lookahead, kWorstDictCertainty / kCertaintyScale);
+}
+
+// Adds the next columns of the streaming line.
+bool Tesseract::LSTMAddStreamingColumns(Image columns) {
+  return lstm_recognizer_ != nullptr && lstm_recognizer_->AddStreamingColumns(columns);
+}
+
+// Returns the start of the text of the streaming line that can no longer
+// change.
+std::string Tesseract::LSTMStreamingLineText() const {
+  return lstm_recognizer_ != nullptr ? lstm_recognizer_->StreamingLineText() : std::string();
+}
+
+// Finishes the streaming line and returns its whole text.
+std::string Tesseract::LSTMEndStreamingLine() {
+  return lstm_recognizer_ != nullptr ? lstm_recognizer_->EndStreamingLine() : std::string();
+}
+
 } // namespace tesseract.
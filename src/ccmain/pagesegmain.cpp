@@ -52,6 +52,8 @@ namespace tesseract {
 
 // Max erosions to perform in removing an enclosing circle.
 const int kMaxCircleErosions = 8;
+// Max reduction of the image for layout analysis. See PageSegReduction.
+const int kMaxPageSegReduction = 16;
 
 // Helper to remove an enclosing circle from an image.
 // If there isn't one, then the image will most likely get badly mangled.
@@ -136,9 +138,16 @@ int Tesseract::SegmentPage(const char *input_file, BLOCK_LIST *blocks, Tesseract
   TO_BLOCK_LIST to_blocks;
   if (PSM_OSD_ENABLED(pageseg_mode) || PSM_BLOCK_FIND_ENABLED(pageseg_mode) ||
       PSM_SPARSE(pageseg_mode)) {
-    auto_page_seg_ret_val =
-        AutoPageSeg(pageseg_mode, blocks, &to_blocks,
-                    enable_noise_removal ? &diacritic_blobs : nullptr, osd_tess, osr);
+    int reduction = PageSegReduction(pageseg_mode);
+    if (reduction > 1) {
+      auto_page_seg_ret_val =
+          ReducedAutoPageSeg(reduction, pageseg_mode, blocks, &to_blocks,
+                             enable_noise_removal ? &diacritic_blobs : nullptr, osd_tess, osr);
+    } else {
+      auto_page_seg_ret_val =
+          AutoPageSeg(pageseg_mode, blocks, &to_blocks,
+                      enable_noise_removal ? &diacritic_blobs : nullptr, osd_tess, osr);
+    }
     if (pageseg_mode == PSM_OSD_ONLY) {
       return auto_page_seg_ret_val;
     }
@@ -244,6 +253,122 @@ int Tesseract::AutoPageSeg(PageSegMode pageseg_mode, BLOCK_LIST *blocks, TO_BLOC
   return result;
 }
 
+// Returns the power of 2 by which the image may be reduced for layout
+// analysis according to pageseg_reduced_resolution, or 1 if it may not.
+// Only plain layout analysis is done at reduced resolution. Orientation and
+// script detection, equation detection and vertical text need the blobs
+// themselves to be at full resolution, and sparse text needs the text lines
+// found by the layout analysis.
+int Tesseract::PageSegReduction(PageSegMode pageseg_mode) const {
+  if (pageseg_reduced_resolution <= 0 || source_resolution_ <= kMinCredibleResolution ||
+      PSM_OSD_ENABLED(pageseg_mode) || PSM_SPARSE(pageseg_mode) ||
+      pageseg_mode == PSM_SINGLE_BLOCK_VERT_TEXT ||
+      textord_tabfind_force_vertical_text) {
+    return 1;
+  }
+#ifndef DISABLED_LEGACY_ENGINE
+  if (equ_detect_ != nullptr) {
+    return 1;
+  }
+#endif
+  int reduction = 1;
+  // pixReduceRankBinaryCascade reduces by at most 4 factors of 2.
+  while (reduction < kMaxPageSegReduction &&
+         source_resolution_ >= pageseg_reduced_resolution * reduction * 2) {
+    reduction *= 2;
+  }
+  return reduction;
+}
+
+// As AutoPageSeg, but the layout is found on a copy of pix_binary_ reduced
+// by reduction. The blocks are then scaled up to full resolution, and
+// to_blocks is returned empty, so that Textord::TextordPage finds the blobs
+// and text lines in them at full resolution. diacritic_blobs is only used if
+// AutoPageSeg has to run at full resolution after all.
+// The lines removed from the reduced copy are removed from pix_binary_ too,
+// as AutoPageSeg would have done.
+// If the layout needs the blocks or blobs rotated, which only the full
+// AutoPageSeg can provide, it is run again at full resolution.
+int Tesseract::ReducedAutoPageSeg(int reduction, PageSegMode pageseg_mode, BLOCK_LIST *blocks,
+                                  TO_BLOCK_LIST *to_blocks, BLOBNBOX_LIST *diacritic_blobs,
+                                  Tesseract *osd_tess, OSResults *osr) {
+  int levels[4] = {0, 0, 0, 0};
+  for (int level = 0; (2 << level) <= reduction; ++level) {
+    // Rank 1 keeps every pixel, so thin strokes and rules survive.
+    levels[level] = 1;
+  }
+  // Swap in the reduced image for AutoPageSeg to work on. The grey and
+  // color images can't be used, as they no longer match it.
+  Image full_binary = pix_binary_;
+  Image full_thresholds = pix_thresholds_;
+  Image full_grey = pix_grey_;
+  Image full_color = scaled_color_;
+  int full_scaled_factor = scaled_factor_;
+  int full_resolution = source_resolution_;
+  pix_binary_ =
+      pixReduceRankBinaryCascade(full_binary, levels[0], levels[1], levels[2], levels[3]);
+  const ICOORD reduced_size(pixGetWidth(pix_binary_), pixGetHeight(pix_binary_));
+  const ICOORD full_size(pixGetWidth(full_binary), pixGetHeight(full_binary));
+  Image reduced_input = pix_binary_.copy();
+  pix_thresholds_ = nullptr;
+  pix_grey_ = nullptr;
+  scaled_color_ = nullptr;
+  scaled_factor_ = -1;
+  source_resolution_ = full_resolution / reduction;
+  BLOCK_LIST reduced_blocks;
+  BLOCK_IT block_it(&reduced_blocks);
+  auto *page_block = new BLOCK("", true, 0, 0, 0, 0, reduced_size.x(), reduced_size.y());
+  page_block->set_right_to_left(right_to_left());
+  block_it.add_to_end(page_block);
+  int result = AutoPageSeg(pageseg_mode, &reduced_blocks, to_blocks, nullptr, osd_tess, osr);
+  // Remove the lines that were found from the full resolution image. Each
+  // reduced pixel covers a square of reduction pixels at full resolution,
+  // which may hold parts of glyphs that touch the line, so only the pixels in
+  // it that are in lines at full resolution are removed.
+  Image removed = pixSubtract(nullptr, reduced_input, pix_binary_);
+  l_int32 empty = 1;
+  pixZero(removed, &empty);
+  if (!empty) {
+    Image removed_full = pixExpandBinaryPower2(removed, reduction);
+    removed_full &= full_binary;
+    Image line_pixels = LineFinder::LinePixels(full_resolution, removed_full);
+    pixSubtract(full_binary, full_binary, line_pixels);
+    line_pixels.destroy();
+    removed_full.destroy();
+  }
+  removed.destroy();
+  reduced_input.destroy();
+  pix_binary_.destroy();
+  pix_binary_ = full_binary;
+  pix_thresholds_ = full_thresholds;
+  pix_grey_ = full_grey;
+  scaled_color_ = full_color;
+  scaled_factor_ = full_scaled_factor;
+  source_resolution_ = full_resolution;
+  // The blobs in to_blocks are at reduced resolution.
+  to_blocks->clear();
+  if (result < 0) {
+    return result;
+  }
+  const FCOORD no_rotation(1.0f, 0.0f);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    BLOCK *block = block_it.data();
+    if (block->re_rotation() != no_rotation || block->classify_rotation() != no_rotation) {
+      if (textord_debug_tabfind) {
+        tprintf("Rotated layout: redoing it at full resolution\n");
+      }
+      return AutoPageSeg(pageseg_mode, blocks, to_blocks, diacritic_blobs, osd_tess, osr);
+    }
+    block->scale_polygon(reduction, reduced_size, full_size);
+    block->set_median_size(block->median_size().x() * reduction,
+                           block->median_size().y() * reduction);
+  }
+  blocks->clear();
+  block_it.set_to_list(blocks);
+  block_it.add_list_after(&reduced_blocks);
+  return result;
+}
+
 // Helper adds all the scripts from sid_set converted to ids from osd_set to
 // allowed_ids.
 static void AddAllScriptsConverted(const UNICHARSET &sid_set, const UNICHARSET &osd_set,
@@ -84,7 +84,7 @@ Tesseract::Tesseract()
     , INT_MEMBER(thresholding_method,
                  static_cast<int>(ThresholdMethod::Otsu),
                  "Thresholding method: 0 = Otsu, 1 = LeptonicaOtsu, 2 = "
-                 "Sauvola",
+                 "Sauvola, 3 = TiledOtsu",
                  this->params())
     , BOOL_MEMBER(thresholding_debug, false,
                   "Debug the thresholding process",
@@ -116,6 +116,10 @@ Tesseract::Tesseract()
                     "method. "
                     "For standard Otsu use 0.0, otherwise 0.1 is recommended",
                     this->params())
+    , INT_MEMBER(thresholding_threads, 0,
+                 "Number of threads used by the TiledOtsu thresholding method, "
+                 "which gives the same result as Otsu. 0 uses one per CPU.",
+                 this->params())
     , INT_INIT_MEMBER(tessedit_ocr_engine_mode, tesseract::OEM_DEFAULT,
                       "Which OCR engine(s) to run (Tesseract, LSTM, both)."
                       " Defaults to loading and running the most accurate"
@@ -445,8 +449,27 @@ Tesseract::Tesseract()
                     "information is lost due to the cut off at 0. The standard value is "
                     "5",
                     this->params())
+    , INT_MEMBER(lstm_batch_size, 1,
+                 "Maximum number of text lines to run through the LSTM network "
+                 "together as a single batch. Larger batches reduce the number "
+                 "of passes over the network weights. Lines of similar widths are "
+                 "batched together. 1 disables batching.",
+                 this->params())
+    , INT_MEMBER(lstm_word_threads, 1,
+                 "Number of threads used to recognize the words of a page "
+                 "concurrently with the LSTM, when only a single LSTM language is "
+                 "used. The results are the same as with 1, which disables it, "
+                 "but lstm_batch_size is then ignored.",
+                 this->params())
     , BOOL_MEMBER(pageseg_apply_music_mask, false,
                   "Detect music staff and remove intersecting components", this->params())
+    , INT_MEMBER(pageseg_reduced_resolution, 0,
+                 "If > 0, and the image resolution is at least twice this, find "
+                 "the page layout on a copy of the image reduced by a power of 2 "
+                 "to no less than this resolution, and then find the text lines "
+                 "at full resolution. Faster on high resolution scans, but small "
+                 "text, diacritics and thin column gaps may be lost. 0 disables it.",
+                 this->params())
     ,
 
     backup_config_file_(nullptr)
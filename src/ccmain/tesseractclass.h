@@ -36,6 +36,7 @@
 #  include "docqual.h" // for GARBAGE_LEVEL
 #endif
 #include "genericvector.h"   // for PointerVector
+#include "networkio.h"       // for NetworkIO
 #include "pageres.h"         // for WERD_RES (ptr only), PAGE_RES (pt...
 #include "params.h"          // for BOOL_VAR_H, BoolParam, DoubleParam
 #include "points.h"          // for FCOORD
@@ -51,6 +52,7 @@
 
 #include <cstdint> // for int16_t, int32_t, uint16_t
 #include <cstdio>  // for FILE
+#include <map>     // for std::map
 
 namespace tesseract {
 
@@ -165,6 +167,16 @@ struct WordData {
   PointerVector<WERD_RES> lang_words;
 };
 
+// Outputs of the LSTM network for a single word (or line), produced as part of
+// a batch of lines, waiting to be decoded.
+struct LSTMBatchOutput {
+  NetworkIO outputs;
+  // Reduction factor between the image and the outputs.
+  float scale_factor = 0.0f;
+  // The box in the image that the outputs correspond to.
+  TBOX word_box;
+};
+
 // Definition of a Tesseract WordRecognizer. The WordData provides the context
 // of row/block, in_word holds an initialized, possibly pre-classified word,
 // that the recognizer may or may not consume (but if so it sets
@@ -337,6 +349,16 @@ public:
                                                  Tesseract *osd_tess, OSResults *osr,
                                                  TO_BLOCK_LIST *to_blocks, Image *photo_mask_pix,
                                                  Image *music_mask_pix);
+  // Returns the power of 2 by which the image may be reduced for layout
+  // analysis according to pageseg_reduced_resolution, or 1 if it may not.
+  int PageSegReduction(PageSegMode pageseg_mode) const;
+  // As AutoPageSeg, but the layout is found on a copy of pix_binary_ reduced
+  // by reduction, and the blocks are then scaled up to full resolution.
+  // to_blocks is returned empty, as the blobs are found again at full
+  // resolution by Textord::TextordPage.
+  int ReducedAutoPageSeg(int reduction, PageSegMode pageseg_mode, BLOCK_LIST *blocks,
+                         TO_BLOCK_LIST *to_blocks, BLOBNBOX_LIST *diacritic_blobs,
+                         Tesseract *osd_tess, OSResults *osr);
   // par_control.cpp
   void PrerecAllWordsPar(const std::vector<WordData> &words);
 
@@ -367,14 +389,37 @@ public:
   // is also returned to enable calculation of output bounding boxes.
   ImageData *GetRectImage(const TBOX &box, const BLOCK &block, int padding,
                           TBOX *revised_box) const;
+  // Helper gets the image of a word (or group of words) for the LSTM, with
+  // the box extended to the ascenders and descenders of the row. The box that
+  // the image really covers is returned in *word_box.
+  ImageData *GetLSTMWordImage(const BLOCK &block, ROW *row, const WERD_RES *word,
+                              TBOX *word_box) const;
   // Recognizes a word or group of words, converting to WERD_RES in *words.
   // Analogous to classify_word_pass1, but can handle a group of words as well.
   void LSTMRecognizeWord(const BLOCK &block, ROW *row, WERD_RES *word,
                          PointerVector<WERD_RES> *words);
+  // Runs the LSTM network over the images of the next several batches of
+  // words, starting at words[start], in batches of up to lstm_batch_size
+  // words of similar widths, and keeps the outputs in lstm_batch_outputs_
+  // until LSTMRecognizeWord decodes them.
+  // Returns the index of the first word that was not considered for the batch.
+  unsigned LSTMRecognizeWordBatch(const std::vector<WordData> &words, unsigned start);
+  // Recognizes the next words, starting at words[start], concurrently on
+  // lstm_word_threads threads, and keeps the results in lstm_parallel_words_
+  // until LSTMRecognizeWord takes them in order.
+  // Returns the index of the first word that was not considered.
+  unsigned LSTMRecognizeWordsParallel(const std::vector<WordData> &words, unsigned start);
   // Apply segmentation search to the given set of words, within the constraints
   // of the existing ratings matrix. If there is already a best_choice on a word
   // leaves it untouched and just sets the done/accepted etc flags.
   void SearchWords(PointerVector<WERD_RES> *words);
+  // Streaming recognition of a single line image with the LSTM, as
+  // LSTMRecognizer::BeginStreamingLine etc. Begin returns false if there is
+  // no LSTM recognizer, and the others fail or return nothing without a line.
+  bool LSTMBeginStreamingLine(int lookahead);
+  bool LSTMAddStreamingColumns(Image columns);
+  std::string LSTMStreamingLineText() const;
+  std::string LSTMEndStreamingLine();
 
   //// control.h /////////////////////////////////////////////////////////
   bool ProcessTargetWord(const TBOX &word_box, const TBOX &target_word_box, const char *word_config,
@@ -769,6 +814,7 @@ public:
   double_VAR_H(thresholding_tile_size);
   double_VAR_H(thresholding_smooth_kernel_size);
   double_VAR_H(thresholding_score_fraction);
+  INT_VAR_H(thresholding_threads);
   INT_VAR_H(tessedit_ocr_engine_mode);
   STRING_VAR_H(tessedit_char_blacklist);
   STRING_VAR_H(tessedit_char_whitelist);
@@ -967,7 +1013,10 @@ public:
   INT_VAR_H(lstm_choice_mode);
   INT_VAR_H(lstm_choice_iterations);
   double_VAR_H(lstm_rating_coefficient);
+  INT_VAR_H(lstm_batch_size);
+  INT_VAR_H(lstm_word_threads);
   BOOL_VAR_H(pageseg_apply_music_mask);
+  INT_VAR_H(pageseg_reduced_resolution);
 
   //// ambigsrecog.cpp /////////////////////////////////////////////////////////
   FILE *init_recog_training(const char *filename);
@@ -1022,6 +1071,12 @@ private:
 #endif // ndef DISABLED_LEGACY_ENGINE
   // LSTM recognizer, if available.
   LSTMRecognizer *lstm_recognizer_;
+  // Outputs of the LSTM network for words that were run as part of a batch by
+  // LSTMRecognizeWordBatch, but have not yet been decoded. Keyed by the WERD.
+  std::map<const WERD *, LSTMBatchOutput> lstm_batch_outputs_;
+  // Words recognized by LSTMRecognizeWordsParallel, but not yet taken by
+  // LSTMRecognizeWord. Keyed by the WERD.
+  std::map<const WERD *, PointerVector<WERD_RES>> lstm_parallel_words_;
   // Output "page" number (actually line number) using TrainLineRecognizer.
   int train_line_page_num_;
 };
@@ -23,6 +23,7 @@
 
 #include "otsuthr.h"
 #include "thresholder.h"
+#include "threadteam.h" // for ThreadTeam
 #include "tprintf.h" // for tprintf
 
 #include <allheaders.h>
@@ -31,6 +32,7 @@
 #include <algorithm> // for std::max, std::min
 #include <cstdint>   // for uint32_t
 #include <cstring>
+#include <thread> // for std::thread
 #include <tuple>
 
 namespace tesseract {
@@ -56,6 +58,20 @@ void ImageThresholder::Clear() {
   pix_.destroy();
 }
 
+// Sets the number of threads for the legacy Otsu thresholding.
+void ImageThresholder::SetThresholdThreads(int num_threads) {
+  // More threads than CPUs would only wait for each other.
+  int num_cpus = std::thread::hardware_concurrency();
+  if (num_threads <= 0 || (num_cpus > 0 && num_threads > num_cpus)) {
+    num_threads = num_cpus;
+  }
+  if (num_threads <= 1) {
+    threshold_team_.reset();
+  } else if (threshold_team_ == nullptr || threshold_team_->size() != num_threads) {
+    threshold_team_ = std::make_unique<ThreadTeam>(num_threads);
+  }
+}
+
 // Return true if no image has been set.
 bool ImageThresholder::IsEmpty() const {
   return pix_ == nullptr;
@@ -326,7 +342,7 @@ Image ImageThresholder::GetPixRectThresholds() {
   int height = pixGetHeight(pix_grey);
   std::vector<int> thresholds;
   std::vector<int> hi_values;
-  OtsuThreshold(pix_grey, 0, 0, width, height, thresholds, hi_values);
+  OtsuThreshold(pix_grey, 0, 0, width, height, thresholds, hi_values, threshold_team_.get());
   pix_grey.destroy();
   Image pix_thresholds = pixCreate(width, height, 8);
   int threshold = thresholds[0] > 0 ? thresholds[0] : 128;
@@ -383,7 +399,7 @@ void ImageThresholder::OtsuThresholdRectToPix(Image src_pix, Image *out_pix) con
   std::vector<int> hi_values;
 
   int num_channels = OtsuThreshold(src_pix, rect_left_, rect_top_, rect_width_, rect_height_,
-                                   thresholds, hi_values);
+                                   thresholds, hi_values, threshold_team_.get());
   ThresholdRectToPix(src_pix, num_channels, thresholds, hi_values, out_pix);
 }
 
@@ -400,25 +416,36 @@ void ImageThresholder::ThresholdRectToPix(Image src_pix, int num_channels, const
   uint32_t *srcdata = pixGetData(src_pix);
   pixSetXRes(*pix, pixGetXRes(src_pix));
   pixSetYRes(*pix, pixGetYRes(src_pix));
-  for (int y = 0; y < rect_height_; ++y) {
-    const uint32_t *linedata = srcdata + (y + rect_top_) * src_wpl;
-    uint32_t *pixline = pixdata + y * wpl;
-    for (int x = 0; x < rect_width_; ++x) {
-      bool white_result = true;
-      for (int ch = 0; ch < num_channels; ++ch) {
-        int pixel = GET_DATA_BYTE(linedata, (x + rect_left_) * num_channels + ch);
-        if (hi_values[ch] >= 0 && (pixel > thresholds[ch]) == (hi_values[ch] == 0)) {
-          white_result = false;
-          break;
+  // A pixel is black if any channel value is foreground, so look up each
+  // value once instead of comparing it with the threshold.
+  std::vector<uint8_t> foreground(num_channels * kHistogramSize);
+  for (int ch = 0; ch < num_channels; ++ch) {
+    for (int value = 0; value < kHistogramSize; ++value) {
+      foreground[ch * kHistogramSize + value] =
+          hi_values[ch] >= 0 && (value > thresholds[ch]) == (hi_values[ch] == 0);
+    }
+  }
+  // The bands are whole rows of the output, so they don't share any words.
+  RunOnRowBands(threshold_team_.get(), 0, rect_height_, [&](int band_top, int band_bottom) {
+    for (int y = band_top; y < band_bottom; ++y) {
+      const uint32_t *linedata = srcdata + (y + rect_top_) * src_wpl;
+      uint32_t *pixline = pixdata + y * wpl;
+      int byte = rect_left_ * num_channels;
+      for (int w = 0; w * 32 < rect_width_; ++w) {
+        int num_bits = std::min(32, rect_width_ - w * 32);
+        uint32_t word = 0;
+        for (int bit = 0; bit < num_bits; ++bit) {
+          uint8_t black = 0;
+          for (int ch = 0; ch < num_channels; ++ch, ++byte) {
+            black |= foreground[ch * kHistogramSize + GET_DATA_BYTE(linedata, byte)];
+          }
+          // The first pixel is the most significant bit.
+          word |= static_cast<uint32_t>(black) << (31 - bit);
         }
-      }
-      if (white_result) {
-        CLEAR_DATA_BIT(pixline, x);
-      } else {
-        SET_DATA_BIT(pixline, x);
+        pixline[w] = word;
       }
     }
-  }
+  });
 }
 
 } // namespace tesseract.
@@ -21,6 +21,9 @@
 
 #include <tesseract/export.h>
 
+#include "image.h" // for Image
+
+#include <memory> // for std::unique_ptr
 #include <vector> // for std::vector
 
 struct Pix;
@@ -31,10 +34,12 @@ enum class ThresholdMethod {
   Otsu,          // Tesseract's legacy Otsu
   LeptonicaOtsu, // Leptonica's Otsu
   Sauvola,       // Leptonica's Sauvola
+  TiledOtsu,     // Tesseract's legacy Otsu, in bands of rows on several threads
   Max,           // Number of Thresholding methods
 };
 
 class TessBaseAPI;
+class ThreadTeam;
 
 /// Base class for all tesseract image thresholding classes.
 /// Specific classes can add new thresholding methods by
@@ -123,6 +128,12 @@ public:
   /// finished with it.
   void SetImage(const Image pix);
 
+  /// Sets the number of threads, including the calling thread, on which the
+  /// legacy Otsu thresholding counts the histograms and thresholds the
+  /// image, in bands of rows. The result is the same for any number.
+  /// 0 uses one thread per CPU.
+  void SetThresholdThreads(int num_threads);
+
   /// Threshold the source image as efficiently as possible to the output Pix.
   /// Creates a Pix and sets pix to point to the resulting pointer.
   /// Caller must use pixDestroy to free the created Pix.
@@ -194,6 +205,9 @@ protected:
   int rect_top_;
   int rect_width_;
   int rect_height_;
+  // Threads for the legacy Otsu thresholding, or nullptr for just the
+  // calling thread.
+  std::unique_ptr<ThreadTeam> threshold_team_;
 };
 
 } // namespace tesseract.
@@ -33,14 +33,57 @@
 
 #include <allheaders.h> // for pixDestroy, pixGetHeight, pixGetWidth, lept_...
 
+#include <chrono>       // for std::chrono
 #include <cinttypes>    // for PRId64
 #include <fstream>      // for std::ifstream
+#include <mutex>        // for std::call_once
+
+#if !defined(_WIN32)
+#  include <sys/mman.h> // for madvise
+#  include <unistd.h>   // for sysconf
+#endif
 
 namespace tesseract {
 
 // Number of documents to read ahead while training. Doesn't need to be very
 // large.
 const int kMaxReadAhead = 8;
+// Suffix of the filename of a document in the pre-decoded format.
+const char kDecodedSuffix[] = ".lstmd";
+// Magic number at the start of a document in the pre-decoded format.
+const uint32_t kDecodedMagic = 0x3144534c; // "LSD1"
+// The prefetched pages may use up to this fraction of the max memory of a
+// DocumentCache, leaving the rest for the documents.
+const int kPrefetchMemoryDivisor = 4;
+
+// Maps the given file of a pre-decoded document into memory, or reads it with
+// the reader if it can't be mapped. Returns false on error.
+static bool LoadDecodedFile(const std::string &filename, FileReader reader,
+                            std::shared_ptr<const char> *data, size_t *size) {
+  // A custom reader has to be used to read the file.
+  if ((reader == nullptr || reader == LoadDataFromFile) &&
+      MapDataFromFile(filename.c_str(), data, size)) {
+    return true;
+  }
+  auto *file_data = new std::vector<char>;
+  bool result = reader == nullptr ? LoadDataFromFile(filename.c_str(), file_data)
+                                  : (*reader)(filename.c_str(), file_data);
+  if (!result) {
+    delete file_data;
+    return false;
+  }
+  data->reset(file_data->data(), [file_data](const char *) { delete file_data; });
+  *size = file_data->size();
+  return true;
+}
+
+// Reads the header of a pre-decoded document, as written by
+// DocumentData::SaveDecodedDocument. Returns false on error.
+static bool ReadDecodedHeader(TFile *fp, int32_t *num_pages, int32_t *height) {
+  uint32_t magic;
+  return fp->DeSerialize(&magic) && magic == kDecodedMagic && fp->DeSerialize(num_pages) &&
+         *num_pages > 0 && fp->DeSerialize(height) && *height > 0;
+}
 
 ImageData::ImageData() : page_number_(-1), vertical_text_(false) {}
 // Takes ownership of the pix and destroys it.
@@ -179,6 +222,109 @@ bool ImageData::SkipDeSerialize(TFile *fp) {
   return fp->DeSerialize(&vertical);
 }
 
+// Writes to the given file in the pre-decoded format. Returns false in case
+// of error.
+bool ImageData::SerializeDecoded(int target_height, TFile *fp) const {
+  float scale_factor;
+  Image pix = PreScale(target_height, target_height, &scale_factor, nullptr, nullptr, nullptr);
+  if (pix == nullptr) {
+    return false;
+  }
+  // Convert to grey as Input::NormalizePix does.
+  Image grey_pix = pix;
+  if (pixGetDepth(pix) != 8) {
+    grey_pix = pixConvertTo8(pix, false);
+    pix.destroy();
+  }
+  // Everything else goes in a copy of *this without the image.
+  ImageData decoded;
+  decoded.imagefilename_ = imagefilename_;
+  decoded.page_number_ = page_number_;
+  decoded.language_ = language_;
+  decoded.transcription_ = transcription_;
+  for (auto box : boxes_) {
+    box.scale(scale_factor);
+    decoded.boxes_.push_back(box);
+  }
+  decoded.box_texts_ = box_texts_;
+  decoded.vertical_text_ = vertical_text_;
+  int32_t width = pixGetWidth(grey_pix);
+  int32_t height = pixGetHeight(grey_pix);
+  bool result = fp->Serialize(&scale_factor) && fp->Serialize(&width) &&
+                fp->Serialize(&height) && decoded.Serialize(fp);
+  const l_uint32 *data = pixGetData(grey_pix);
+  int wpl = pixGetWpl(grey_pix);
+  std::vector<uint8_t> row(width);
+  for (int y = 0; result && y < height; ++y) {
+    const l_uint32 *line = data + y * wpl;
+    for (int x = 0; x < width; ++x) {
+      row[x] = GET_DATA_BYTE(line, x);
+    }
+    result = fp->Serialize(&row[0], width);
+  }
+  grey_pix.destroy();
+  return result;
+}
+
+// Reads from the given file in the pre-decoded format, using the pixels in
+// place. Returns false in case of error.
+bool ImageData::DeSerializeDecoded(TFile *fp) {
+  if (!fp->DeSerialize(&decoded_scale_) || !fp->DeSerialize(&decoded_width_) ||
+      !fp->DeSerialize(&decoded_height_) || !DeSerialize(fp)) {
+    return false;
+  }
+  if (decoded_width_ <= 0 || decoded_height_ <= 0) {
+    return false;
+  }
+  size_t size = static_cast<size_t>(decoded_width_) * decoded_height_;
+  decoded_pixels_ = reinterpret_cast<const uint8_t *>(fp->View(size, 1, &decoded_owner_));
+  return decoded_pixels_ != nullptr;
+}
+
+// Makes *this use the same pre-decoded pixels as other, if it has any.
+void ImageData::ShareDecodedImage(const ImageData &other) {
+  decoded_pixels_ = other.decoded_pixels_;
+  decoded_owner_ = other.decoded_owner_;
+  decoded_width_ = other.decoded_width_;
+  decoded_height_ = other.decoded_height_;
+  decoded_scale_ = other.decoded_scale_;
+}
+
+// Returns a new copy of *this, sharing any pre-decoded pixels, or
+// pre-decoded at target_height if > 0.
+ImageData *ImageData::Copy(int target_height) const {
+  auto *copy = new ImageData;
+  if (target_height > 0 && (decoded_pixels_ == nullptr || decoded_height_ != target_height)) {
+    auto *data = new std::vector<char>;
+    TFile fp;
+    fp.OpenWrite(data);
+    if (SerializeDecoded(target_height, &fp)) {
+      std::shared_ptr<const char> owner(data->data(), [data](const char *) { delete data; });
+      fp.OpenView(owner.get(), data->size(), owner);
+      if (copy->DeSerializeDecoded(&fp)) {
+        return copy;
+      }
+      delete copy;
+      copy = new ImageData;
+    } else {
+      delete data;
+    }
+  }
+  copy->imagefilename_ = imagefilename_;
+  copy->page_number_ = page_number_;
+#ifdef TESSERACT_IMAGEDATA_AS_PIX
+  copy->internal_pix_ = internal_pix_.clone();
+#endif
+  copy->image_data_ = image_data_;
+  copy->language_ = language_;
+  copy->transcription_ = transcription_;
+  copy->boxes_ = boxes_;
+  copy->box_texts_ = box_texts_;
+  copy->vertical_text_ = vertical_text_;
+  copy->ShareDecodedImage(*this);
+  return copy;
+}
+
 // Saves the given Pix as a PNG-encoded string and destroys it.
 // In case of missing PNG support in Leptonica use PNM format,
 // which requires more memory.
@@ -192,6 +338,9 @@ void ImageData::SetPix(Image pix) {
 
 // Returns the Pix image for *this. Must be pixDestroyed after use.
 Image ImageData::GetPix() const {
+  if (decoded_pixels_ != nullptr) {
+    return GetDecodedPix();
+  }
 #ifdef TESSERACT_IMAGEDATA_AS_PIX
 #  ifdef GRAPHICS_DISABLED
   /* The only caller of this is the scaling functions to prescale the
@@ -232,8 +381,20 @@ Image ImageData::PreScale(int target_height, int max_height,
   if (scaled_height != nullptr) {
     *scaled_height = target_height;
   }
-  // Get the scaled image.
-  Image pix = pixScale(src_pix, im_factor, im_factor);
+  // Get the scaled image, unless it was pre-decoded at the right height.
+  Image pix = nullptr;
+  if (decoded_pixels_ != nullptr && target_height == input_height) {
+    pix = src_pix.clone();
+  } else {
+    if (decoded_pixels_ != nullptr) {
+      static std::once_flag warned;
+      std::call_once(warned, [input_height, target_height] {
+        tprintf("Warning: rescaling images pre-decoded at height %d to %d!\n", input_height,
+                target_height);
+      });
+    }
+    pix = pixScale(src_pix, im_factor, im_factor);
+  }
   if (pix == nullptr) {
     tprintf("Scaling pix of size %d, %d by factor %g made null pix!!\n",
             input_width, input_height, im_factor);
@@ -261,13 +422,14 @@ Image ImageData::PreScale(int target_height, int max_height,
     }
   }
   if (scale_factor != nullptr) {
-    *scale_factor = im_factor;
+    // A pre-decoded image was already scaled from the original.
+    *scale_factor = im_factor * decoded_scale_;
   }
   return pix;
 }
 
 int ImageData::MemoryUsed() const {
-  return image_data_.size();
+  return image_data_.size() + decoded_width_ * decoded_height_;
 }
 
 #ifndef GRAPHICS_DISABLED
@@ -359,6 +521,26 @@ Image ImageData::GetPixInternal(const std::vector<char> &image_data) {
 }
 #endif
 
+// Returns the Pix image for the pre-decoded pixels, copied a row at a time
+// from the mapped file. Must be pixDestroyed after use.
+Image ImageData::GetDecodedPix() const {
+  Image pix = pixCreate(decoded_width_, decoded_height_, 8);
+  if (pix == nullptr) {
+    return nullptr;
+  }
+  l_uint32 *data = pixGetData(pix);
+  int wpl = pixGetWpl(pix);
+  const uint8_t *pixels = decoded_pixels_;
+  for (int y = 0; y < decoded_height_; ++y) {
+    memcpy(data + y * wpl, pixels, decoded_width_);
+    pixels += decoded_width_;
+  }
+  // The rows are stored in byte order, but Leptonica keeps the bytes of each
+  // word in big-endian order.
+  pixEndianByteSwap(pix);
+  return pix;
+}
+
 // Parses the text string as a box file and adds any discovered boxes that
 // match the page number. Returns false on error.
 bool ImageData::AddBoxes(const char *box_text) {
@@ -416,6 +598,8 @@ void DocumentData::SetDocument(const char *filename, int64_t max_memory,
   pages_offset_ = -1;
   max_memory_ = max_memory;
   reader_ = reader;
+  decoded_file_.reset();
+  decoded_offsets_.clear();
 }
 
 // Writes all the pages to the given filename. Returns false on error.
@@ -430,6 +614,49 @@ bool DocumentData::SaveDocument(const char *filename, FileWriter writer) {
   return true;
 }
 
+// Writes all the pages to the given filename in the pre-decoded format, with
+// each image prescaled to target_height. The file starts with the magic
+// number, the number of pages and target_height, followed by the offset of
+// each page in the file and the size of the file, and then the pages.
+// Returns false on error.
+bool DocumentData::SaveDecodedDocument(const char *filename, int target_height,
+                                       FileWriter writer) {
+  std::lock_guard<std::mutex> lock(pages_mutex_);
+  std::vector<char> data;
+  TFile fp;
+  fp.OpenWrite(&data);
+  int32_t num_pages = pages_.size();
+  int32_t height = target_height;
+  std::vector<int64_t> offsets(num_pages + 1);
+  bool result = target_height > 0 && fp.Serialize(&kDecodedMagic) &&
+                fp.Serialize(&num_pages) && fp.Serialize(&height);
+  size_t offsets_start = data.size();
+  result = result && fp.Serialize(&offsets[0], offsets.size());
+  for (int page = 0; result && page < num_pages; ++page) {
+    offsets[page] = data.size();
+    uint8_t non_null = pages_[page] != nullptr;
+    result = fp.Serialize(&non_null) &&
+             (!non_null || pages_[page]->SerializeDecoded(target_height, &fp));
+  }
+  if (result) {
+    offsets[num_pages] = data.size();
+    memcpy(&data[offsets_start], &offsets[0], offsets.size() * sizeof(offsets[0]));
+    result = writer == nullptr ? SaveDataToFile(data, filename) : (*writer)(data, filename);
+  }
+  if (!result) {
+    tprintf("Serialize failed: %s\n", filename);
+  }
+  return result;
+}
+
+// Returns true if the given filename has the suffix of the pre-decoded
+// format.
+bool DocumentData::IsDecodedDocument(const std::string &filename) {
+  size_t suffix_size = strlen(kDecodedSuffix);
+  return filename.size() > suffix_size &&
+         filename.compare(filename.size() - suffix_size, suffix_size, kDecodedSuffix) == 0;
+}
+
 // Adds the given page data to this document, counting up memory.
 void DocumentData::AddPageToDocument(ImageData *page) {
   std::lock_guard<std::mutex> lock(pages_mutex_);
@@ -479,6 +706,12 @@ const ImageData *DocumentData::GetPage(int index) {
     // while the caller is using it, so give it a chance to work.
     std::this_thread::yield();
   }
+  if (page != nullptr) {
+    // Keep the read-ahead of a pre-decoded document kMaxReadAhead pages in
+    // front of the page in use.
+    std::lock_guard<std::mutex> lock(pages_mutex_);
+    PrefetchDecodedPages(index + kMaxReadAhead, 1);
+  }
   return page;
 }
 
@@ -513,6 +746,8 @@ int64_t DocumentData::UnCache() {
   }
   pages_.clear();
   pages_offset_ = -1;
+  decoded_file_.reset();
+  decoded_offsets_.clear();
   set_total_pages(-1);
   set_memory_used(0);
   tprintf("Unloaded document %s, saving %" PRId64 " memory\n",
@@ -547,6 +782,9 @@ bool DocumentData::ReCachePages() {
     delete page;
   }
   pages_.clear();
+  if (IsDecodedDocument(document_name_)) {
+    return ReCacheDecodedPages();
+  }
 #if !defined(TESSERACT_IMAGEDATA_AS_PIX)
   auto name_size = document_name_.size();
   if (name_size > 4 && document_name_.substr(name_size - 4) == ".png") {
@@ -626,10 +864,133 @@ bool DocumentData::ReCachePages() {
   return !pages_.empty();
 }
 
+// As ReCachePages, for a document in the pre-decoded format, with the
+// pages_mutex_ already locked. Only the pages that are wanted are read, and
+// their pixels stay in the file.
+bool DocumentData::ReCacheDecodedPages() {
+  if (decoded_file_ == nullptr && !MapDecodedDocument()) {
+    tprintf("Deserialize header failed: %s\n", document_name_.c_str());
+    return false;
+  }
+  int loaded_pages = decoded_offsets_.size() - 1;
+  pages_offset_ %= loaded_pages;
+  // Load the pages from the first one we want until max memory.
+  int page;
+  for (page = pages_offset_;
+       page < loaded_pages && (max_memory_ <= 0 || memory_used() <= max_memory_); ++page) {
+    TFile fp;
+    fp.OpenView(decoded_file_.get() + decoded_offsets_[page],
+                decoded_offsets_[page + 1] - decoded_offsets_[page], decoded_file_);
+    uint8_t non_null;
+    if (!fp.DeSerialize(&non_null)) {
+      break;
+    }
+    ImageData *image_data = nullptr;
+    if (non_null) {
+      image_data = new ImageData;
+      if (!image_data->DeSerializeDecoded(&fp)) {
+        delete image_data;
+        break;
+      }
+      if (image_data->imagefilename().empty()) {
+        image_data->set_imagefilename(document_name_);
+        image_data->set_page_number(page);
+      }
+      set_memory_used(memory_used() + image_data->MemoryUsed());
+    }
+    pages_.push_back(image_data);
+  }
+  if (page < loaded_pages && (max_memory_ <= 0 || memory_used() <= max_memory_)) {
+    tprintf("Deserialize failed: %s read %d/%d lines\n", document_name_.c_str(), page,
+            loaded_pages);
+    for (auto page : pages_) {
+      delete page;
+    }
+    pages_.clear();
+  }
+  if (!pages_.empty() && loaded_pages > 1) {
+    // Avoid lots of messages for training with single line images.
+    tprintf("Loaded %zu/%d lines (%d-%zu) of document %s\n", pages_.size(), loaded_pages,
+            pages_offset_ + 1, pages_offset_ + pages_.size(), document_name_.c_str());
+  }
+  set_total_pages(loaded_pages);
+  PrefetchDecodedPages(pages_offset_, kMaxReadAhead);
+  return !pages_.empty();
+}
+
+// Maps the pre-decoded document into memory, or reads it if it can't be
+// mapped, and reads its index. Returns false on error.
+bool DocumentData::MapDecodedDocument() {
+  std::shared_ptr<const char> data;
+  size_t size = 0;
+  if (!LoadDecodedFile(document_name_, reader_, &data, &size)) {
+    return false;
+  }
+  TFile fp;
+  fp.OpenView(data.get(), size, data);
+  int32_t num_pages;
+  int32_t height;
+  if (!ReadDecodedHeader(&fp, &num_pages, &height)) {
+    return false;
+  }
+  std::vector<int64_t> offsets(num_pages + 1);
+  if (!fp.DeSerialize(&offsets[0], offsets.size())) {
+    return false;
+  }
+  for (int page = 0; page < num_pages; ++page) {
+    if (offsets[page] <= 0 || offsets[page] >= offsets[page + 1]) {
+      return false;
+    }
+  }
+  if (offsets[num_pages] != static_cast<int64_t>(size)) {
+    return false;
+  }
+  decoded_file_ = std::move(data);
+  decoded_offsets_ = std::move(offsets);
+  return true;
+}
+
+// Returns the height that the given pre-decoded document was decoded at, or 0
+// if it can't be read.
+int DocumentData::ReadDecodedHeight(const std::string &filename, FileReader reader) {
+  std::shared_ptr<const char> data;
+  size_t size = 0;
+  if (!LoadDecodedFile(filename, reader, &data, &size)) {
+    return 0;
+  }
+  TFile fp;
+  fp.OpenView(data.get(), size, data);
+  int32_t num_pages;
+  int32_t height;
+  if (!ReadDecodedHeader(&fp, &num_pages, &height)) {
+    return 0;
+  }
+  return height;
+}
+
+// Advises the system that the count pages of the pre-decoded document from
+// index will be needed soon. The pages_mutex_ must be locked.
+void DocumentData::PrefetchDecodedPages(int index, int count) {
+#if !defined(_WIN32)
+  int num_pages = decoded_offsets_.size() - 1;
+  if (decoded_file_ == nullptr || num_pages <= 0) {
+    return;
+  }
+  int first = Modulo(index, num_pages);
+  int last = std::min(first + count, num_pages);
+  static const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  auto start = reinterpret_cast<uintptr_t>(decoded_file_.get() + decoded_offsets_[first]);
+  auto end = reinterpret_cast<uintptr_t>(decoded_file_.get() + decoded_offsets_[last]);
+  start -= start % page_size;
+  madvise(reinterpret_cast<void *>(start), end - start, MADV_WILLNEED);
+#endif
+}
+
 // A collection of DocumentData that knows roughly how much memory it is using.
 DocumentCache::DocumentCache(int64_t max_memory) : max_memory_(max_memory) {}
 
 DocumentCache::~DocumentCache() {
+  StopPrefetch();
   for (auto *document : documents_) {
     delete document;
   }
@@ -641,18 +1002,12 @@ bool DocumentCache::LoadDocuments(const std::vector<std::string> &filenames,
                                   CachingStrategy cache_strategy,
                                   FileReader reader) {
   cache_strategy_ = cache_strategy;
-  int64_t fair_share_memory = 0;
-  // In the round-robin case, each DocumentData handles restricting its content
-  // to its fair share of memory. In the sequential case, DocumentCache
-  // determines which DocumentDatas are held entirely in memory.
-  if (cache_strategy_ == CS_ROUND_ROBIN) {
-    fair_share_memory = max_memory_ / filenames.size();
-  }
   for (const auto &filename : filenames) {
     auto *document = new DocumentData(filename);
-    document->SetDocument(filename.c_str(), fair_share_memory, reader);
+    document->SetDocument(filename.c_str(), 0, reader);
     AddToCache(document);
   }
+  SetDocumentsMemory();
   if (!documents_.empty()) {
     // Try to get the first page now to verify the list of filenames.
     if (GetPageBySerial(0) != nullptr) {
@@ -663,6 +1018,28 @@ bool DocumentCache::LoadDocuments(const std::vector<std::string> &filenames,
   return false;
 }
 
+// Returns the memory the documents may use, which is the max_memory_ less the
+// share of the prefetched pages while prefetching.
+int64_t DocumentCache::DocumentsMemory() const {
+  if (prefetch_depth_ > 0) {
+    return max_memory_ - max_memory_ / kPrefetchMemoryDivisor;
+  }
+  return max_memory_;
+}
+
+// In the round-robin case, each DocumentData handles restricting its content
+// to its fair share of memory. In the sequential case, DocumentCache
+// determines which DocumentDatas are held entirely in memory.
+void DocumentCache::SetDocumentsMemory() {
+  if (cache_strategy_ != CS_ROUND_ROBIN || documents_.empty()) {
+    return;
+  }
+  int64_t fair_share_memory = DocumentsMemory() / documents_.size();
+  for (auto *document : documents_) {
+    document->set_max_memory(fair_share_memory);
+  }
+}
+
 // Adds document to the cache.
 bool DocumentCache::AddToCache(DocumentData *data) {
   documents_.push_back(data);
@@ -683,6 +1060,7 @@ DocumentData *DocumentCache::FindDocument(
 // Returns the total number of pages in an epoch. For CS_ROUND_ROBIN cache
 // strategy, could take a long time.
 int DocumentCache::TotalPages() {
+  std::lock_guard<std::mutex> lock(documents_mutex_);
   if (cache_strategy_ == CS_SEQUENTIAL) {
     // In sequential mode, we assume each doc has the same number of pages
     // whether it is true or not.
@@ -700,6 +1078,162 @@ int DocumentCache::TotalPages() {
   return total_pages;
 }
 
+// Starts num_threads threads that fetch up to depth pages ahead, pre-decoded
+// at target_height if > 0.
+void DocumentCache::SetPrefetch(int depth, int num_threads, int target_height) {
+  StopPrefetch();
+  if (depth <= 0 || num_threads <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(prefetch_mutex_);
+  prefetch_depth_ = depth;
+  prefetch_height_ = target_height;
+  prefetch_shutdown_ = false;
+  SetDocumentsMemory();
+  for (int t = 0; t < num_threads; ++t) {
+    prefetch_threads_.emplace_back(&DocumentCache::PrefetchLoop, this);
+  }
+}
+
+// Takes the page with the given serial number from the prefetch ring,
+// waiting for it if it isn't ready yet. If the serial number is not the next
+// one, the ring is dropped and refilled from it.
+const ImageData *DocumentCache::GetPrefetchedPage(int serial) {
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  if (serial == current_serial_) {
+    // Asked for the same page again.
+    return current_page_.get();
+  }
+  ++prefetch_requests_;
+  if (prefetch_ring_.empty() || prefetch_ring_.front()->serial != serial) {
+    for (auto &entry : prefetch_ring_) {
+      entry->dropped = true;
+      prefetch_memory_ -= entry->memory;
+    }
+    prefetch_ring_.clear();
+    next_prefetch_serial_ = serial;
+    FillPrefetchRing();
+  }
+  std::shared_ptr<PrefetchedPage> entry = prefetch_ring_.front();
+  if (!entry->ready) {
+    ++prefetch_stalls_;
+    auto start = std::chrono::steady_clock::now();
+    prefetch_ready_.wait(lock, [&entry] { return entry->ready; });
+    std::chrono::duration<double> stall = std::chrono::steady_clock::now() - start;
+    prefetch_stall_seconds_ += stall.count();
+  }
+  prefetch_ring_.pop_front();
+  prefetch_memory_ -= entry->memory;
+  current_page_ = std::move(entry->page);
+  current_serial_ = serial;
+  FillPrefetchRing();
+  return current_page_.get();
+}
+
+// Adds pages to the prefetch ring up to the depth and memory limits. Each
+// page is counted at the average size of the pages fetched so far when it is
+// queued, and until one has been fetched, only one page is queued at a time.
+// The ring always gets one page, however big, so it can't stall.
+// prefetch_mutex_ must be locked.
+void DocumentCache::FillPrefetchRing() {
+  int64_t max_prefetch_memory = max_memory_ / kPrefetchMemoryDivisor;
+  while (prefetch_ring_.size() < static_cast<size_t>(prefetch_depth_)) {
+    int64_t estimate = 0;
+    if (prefetch_fetched_pages_ > 0) {
+      estimate = prefetch_fetched_memory_ / prefetch_fetched_pages_;
+    } else if (!prefetch_ring_.empty() && !prefetch_ring_.back()->ready) {
+      break;
+    }
+    if (max_prefetch_memory > 0 && !prefetch_ring_.empty() &&
+        prefetch_memory_ + estimate > max_prefetch_memory) {
+      break;
+    }
+    auto entry = std::make_shared<PrefetchedPage>();
+    entry->serial = next_prefetch_serial_++;
+    entry->memory = estimate;
+    prefetch_memory_ += estimate;
+    prefetch_ring_.push_back(entry);
+    prefetch_work_.notify_one();
+  }
+}
+
+// Main loop of the prefetch threads. Each fetches the first page in the ring
+// that no other thread has taken. The documents are only used by one thread
+// at a time, to copy the page, but the pre-decoding runs concurrently.
+void DocumentCache::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(prefetch_mutex_);
+  for (;;) {
+    std::shared_ptr<PrefetchedPage> entry;
+    prefetch_work_.wait(lock, [this, &entry] {
+      if (prefetch_shutdown_) {
+        return true;
+      }
+      for (auto &ring_entry : prefetch_ring_) {
+        if (!ring_entry->taken) {
+          entry = ring_entry;
+          return true;
+        }
+      }
+      return false;
+    });
+    if (prefetch_shutdown_) {
+      return;
+    }
+    entry->taken = true;
+    lock.unlock();
+    ImageData *page = nullptr;
+    {
+      std::lock_guard<std::mutex> documents_lock(documents_mutex_);
+      const ImageData *document_page = GetPageByStrategy(entry->serial);
+      if (document_page != nullptr) {
+        page = document_page->Copy(0);
+      }
+    }
+    if (page != nullptr && prefetch_height_ > 0) {
+      ImageData *decoded_page = page->Copy(prefetch_height_);
+      delete page;
+      page = decoded_page;
+    }
+    lock.lock();
+    int64_t memory = page != nullptr ? page->MemoryUsed() : 0;
+    if (page != nullptr) {
+      ++prefetch_fetched_pages_;
+      prefetch_fetched_memory_ += memory;
+    }
+    entry->page.reset(page);
+    entry->ready = true;
+    if (!entry->dropped) {
+      // Replace the estimate with the real size.
+      prefetch_memory_ += memory - entry->memory;
+      entry->memory = memory;
+      FillPrefetchRing();
+    }
+    prefetch_ready_.notify_all();
+  }
+}
+
+// Stops the prefetch threads and drops the prefetched pages.
+void DocumentCache::StopPrefetch() {
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    prefetch_shutdown_ = true;
+  }
+  prefetch_work_.notify_all();
+  for (auto &thread : prefetch_threads_) {
+    thread.join();
+  }
+  prefetch_threads_.clear();
+  std::lock_guard<std::mutex> lock(prefetch_mutex_);
+  prefetch_depth_ = 0;
+  prefetch_ring_.clear();
+  prefetch_memory_ = 0;
+  prefetch_fetched_pages_ = 0;
+  prefetch_fetched_memory_ = 0;
+  SetDocumentsMemory();
+  current_page_.reset();
+  current_serial_ = -1;
+}
+
 // Returns a page by serial number, selecting them in a round-robin fashion
 // from all the documents. Highly disk-intensive, but doesn't need samples
 // to be shuffled between files to begin with.
@@ -739,11 +1273,12 @@ const ImageData *DocumentCache::GetPageSequential(int serial) {
       documents_[doc_index]->GetPage(serial % num_pages_per_doc_);
   // Count up total memory. Background loading makes it more complicated to
   // keep a running count.
+  int64_t max_memory = DocumentsMemory();
   int64_t total_memory = 0;
   for (auto *document : documents_) {
     total_memory += document->memory_used();
   }
-  if (total_memory >= max_memory_) {
+  if (total_memory >= max_memory) {
     // Find something to un-cache.
     // If there are more than 3 in front, then serial is from the back reader
     // of a pair of readers. If we un-cache from in-front-2 to 2-ahead, then
@@ -751,7 +1286,7 @@ const ImageData *DocumentCache::GetPageSequential(int serial) {
     // will work for both.
     int num_in_front = CountNeighbourDocs(doc_index, 1);
     for (int offset = num_in_front - 2;
-         offset > 1 && total_memory >= max_memory_; --offset) {
+         offset > 1 && total_memory >= max_memory; --offset) {
       int next_index = (doc_index + offset) % num_docs;
       total_memory -= documents_[next_index]->UnCache();
     }
@@ -759,14 +1294,14 @@ const ImageData *DocumentCache::GetPageSequential(int serial) {
     // we take away the document that a 2nd reader is using, it will put it
     // back and make a hole between.
     int num_behind = CountNeighbourDocs(doc_index, -1);
-    for (int offset = num_behind; offset < 0 && total_memory >= max_memory_;
+    for (int offset = num_behind; offset < 0 && total_memory >= max_memory;
          ++offset) {
       int next_index = (doc_index + offset + num_docs) % num_docs;
       total_memory -= documents_[next_index]->UnCache();
     }
   }
   int next_index = (doc_index + 1) % num_docs;
-  if (!documents_[next_index]->IsCached() && total_memory < max_memory_) {
+  if (!documents_[next_index]->IsCached() && total_memory < max_memory) {
     documents_[next_index]->LoadPageInBackground(0);
   }
   return doc;
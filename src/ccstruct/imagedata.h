@@ -22,8 +22,11 @@
 #include "image.h"
 #include "points.h" // for FCOORD
 
-#include <mutex>  // for std::mutex
-#include <thread> // for std::thread
+#include <condition_variable> // for std::condition_variable
+#include <deque>              // for std::deque
+#include <memory>             // for std::shared_ptr, std::unique_ptr
+#include <mutex>              // for std::mutex
+#include <thread>             // for std::thread
 
 struct Pix;
 
@@ -78,6 +81,23 @@ public:
   bool DeSerialize(TFile *fp);
   // As DeSerialize, but only seeks past the data - hence a static method.
   static bool SkipDeSerialize(TFile *fp);
+  // Writes to the given file in the pre-decoded format used by
+  // DocumentData::SaveDecodedDocument: the image prescaled to target_height
+  // and converted to 8 bit grey, as an uncompressed array of pixels, with the
+  // boxes scaled to match. Returns false in case of error.
+  bool SerializeDecoded(int target_height, TFile *fp) const;
+  // Reads from the given file in the pre-decoded format. The file must have
+  // been opened with TFile::OpenView, as the pixels are not copied, but used
+  // in place, and kept alive as long as *this needs them. Note that *this
+  // then has no image_data(), so Serialize writes it without an image.
+  // Returns false in case of error.
+  bool DeSerializeDecoded(TFile *fp);
+  // Makes *this use the same pre-decoded pixels as other, if it has any.
+  void ShareDecodedImage(const ImageData &other);
+  // Returns a new copy of *this, sharing any pre-decoded pixels. If
+  // target_height > 0, the copy is pre-decoded at that height instead, as
+  // by SerializeDecoded, unless that fails.
+  ImageData *Copy(int target_height) const;
 
   // Other accessors.
   const std::string &imagefilename() const {
@@ -145,6 +165,9 @@ private:
   static void SetPixInternal(Image pix, std::vector<char> *image_data);
   // Returns the Pix image for the image_data. Must be pixDestroyed after use.
   static Image GetPixInternal(const std::vector<char> &image_data);
+  // Returns the Pix image for the pre-decoded pixels, copied a row at a time
+  // from the mapped file. Must be pixDestroyed after use.
+  Image GetDecodedPix() const;
   // Parses the text string as a box file and adds any discovered boxes that
   // match the page number. Returns false on error.
   bool AddBoxes(const char *box_text);
@@ -163,6 +186,15 @@ private:
   std::vector<TBOX> boxes_;       // If non-empty boxes of the image.
   std::vector<std::string> box_texts_; // String for text in each box.
   bool vertical_text_;            // Image has been rotated from vertical.
+  // If not null, the pre-decoded image, as rows of 8 bit grey pixels, which
+  // is used instead of image_data_, and is kept alive by decoded_owner_.
+  const uint8_t *decoded_pixels_ = nullptr;
+  std::shared_ptr<const char> decoded_owner_;
+  int32_t decoded_width_ = 0;
+  int32_t decoded_height_ = 0;
+  // Scale factor that was applied to the original image to make the
+  // pre-decoded one. The boxes_ are already scaled by it.
+  float decoded_scale_ = 1.0f;
 };
 
 // A collection of ImageData that knows roughly how much memory it is using.
@@ -182,6 +214,25 @@ public:
   // Writes all the pages to the given filename. Returns false on error.
   TESS_API
   bool SaveDocument(const char *filename, FileWriter writer);
+  // Writes all the pages to the given filename in the pre-decoded format,
+  // with each image prescaled to target_height and converted to grey, as
+  // Input::PrepareLSTMInputs would for a network of that input height.
+  // A document with a name that IsDecodedDocument is read in that format,
+  // with its file mapped into memory, so its images are neither read nor
+  // decoded until used, and then their pixels are only copied, a row at a
+  // time, into a Pix. Pages are found through an index, so there is no need
+  // to read the earlier ones.
+  // Returns false on error.
+  TESS_API
+  bool SaveDecodedDocument(const char *filename, int target_height, FileWriter writer);
+  // Returns true if the given filename has the suffix of the pre-decoded
+  // format, ".lstmd".
+  TESS_API
+  static bool IsDecodedDocument(const std::string &filename);
+  // Returns the height that the given document in the pre-decoded format was
+  // decoded at, reading only its header, or 0 if it can't be read.
+  TESS_API
+  static int ReadDecodedHeight(const std::string &filename, FileReader reader);
 
   // Adds the given page data to this document, counting up memory.
   TESS_API
@@ -191,6 +242,12 @@ public:
     std::lock_guard<std::mutex> lock(general_mutex_);
     return document_name_;
   }
+  // Sets the max memory the document may use from the next time it loads its
+  // pages.
+  void set_max_memory(int64_t max_memory) {
+    std::lock_guard<std::mutex> lock(pages_mutex_);
+    max_memory_ = max_memory;
+  }
   int NumPages() const {
     std::lock_guard<std::mutex> lock(general_mutex_);
     return total_pages_;
@@ -253,6 +310,16 @@ private:
   // Locks the pages_mutex_ and loads as many pages as will fit into max_memory_
   // starting at index pages_offset_.
   bool ReCachePages();
+  // As ReCachePages, for a document in the pre-decoded format, with the
+  // pages_mutex_ already locked.
+  bool ReCacheDecodedPages();
+  // Maps the pre-decoded document into memory, or reads it if it can't be
+  // mapped, and reads its index. Returns false on error.
+  bool MapDecodedDocument();
+  // Advises the system that the count pages of the pre-decoded document from
+  // index will be needed soon, so it reads them in the background. Does
+  // nothing for other documents. The pages_mutex_ must be locked.
+  void PrefetchDecodedPages(int index, int count);
 
 private:
   // A name for this document.
@@ -269,6 +336,10 @@ private:
   int64_t max_memory_;
   // Saved reader from LoadDocument to allow re-caching.
   FileReader reader_;
+  // The file of a document in the pre-decoded format, and the offset in it
+  // of each page, followed by the size of the file.
+  std::shared_ptr<const char> decoded_file_;
+  std::vector<int64_t> decoded_offsets_;
   // Mutex that protects pages_ and pages_offset_ against multiple parallel
   // loads, and provides a wait for page.
   std::mutex pages_mutex_;
@@ -294,6 +365,7 @@ public:
 
   // Deletes all existing documents from the cache.
   void Clear() {
+    StopPrefetch();
     for (auto *document : documents_) {
       delete document;
     }
@@ -314,12 +386,44 @@ public:
 
   // Returns a page by serial number using the current cache_strategy_ to
   // determine the mapping from serial number to page.
+  // While prefetching, the page is only valid until the next call.
   const ImageData *GetPageBySerial(int serial) {
-    if (cache_strategy_ == CS_SEQUENTIAL) {
-      return GetPageSequential(serial);
-    } else {
-      return GetPageRoundRobin(serial);
+    if (prefetch_depth_ > 0) {
+      return GetPrefetchedPage(serial);
     }
+    return GetPageByStrategy(serial);
+  }
+
+  // Starts num_threads threads that fetch the pages that follow the last one
+  // requested from GetPageBySerial, in the order of the cache_strategy_, up
+  // to depth pages ahead. A quarter of the max_memory_ is set aside for the
+  // fetched pages, and taken from the documents while prefetching. Each page
+  // counts against it from when it is queued, at the average size of the pages
+  // fetched so far. If target_height > 0, the threads also
+  // pre-decode the images at that height, as ImageData::SerializeDecoded
+  // does, so it must only be used for networks with grey input of that
+  // height. Stops any previous prefetching, and stops if depth is 0.
+  TESS_API
+  void SetPrefetch(int depth, int num_threads, int target_height);
+  // Returns the number of pages requested from GetPageBySerial while
+  // prefetching, the number of them that were not ready yet, and the total
+  // time spent waiting for them.
+  int64_t prefetch_requests() const {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    return prefetch_requests_;
+  }
+  int64_t prefetch_stalls() const {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    return prefetch_stalls_;
+  }
+  double prefetch_stall_seconds() const {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    return prefetch_stall_seconds_;
+  }
+  // Returns the memory counted for the pages in the prefetch ring.
+  int64_t prefetch_memory() const {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    return prefetch_memory_;
   }
 
   const std::vector<DocumentData *> &documents() const {
@@ -331,6 +435,44 @@ public:
   int TotalPages();
 
 private:
+  // A page fetched by the prefetch threads.
+  struct PrefetchedPage {
+    int serial = 0;
+    // The page was taken by a thread to fetch.
+    bool taken = false;
+    // The page has been fetched, and may be nullptr for an empty document.
+    bool ready = false;
+    // The page was dropped from the ring before it was ready.
+    bool dropped = false;
+    std::unique_ptr<ImageData> page;
+    int64_t memory = 0;
+  };
+
+  // As GetPageBySerial, without prefetching.
+  const ImageData *GetPageByStrategy(int serial) {
+    if (cache_strategy_ == CS_SEQUENTIAL) {
+      return GetPageSequential(serial);
+    } else {
+      return GetPageRoundRobin(serial);
+    }
+  }
+  // As GetPageBySerial, taking the page from the prefetch ring, and waiting
+  // for it if it isn't ready yet.
+  const ImageData *GetPrefetchedPage(int serial);
+  // Adds pages to the prefetch ring up to the depth and memory limits.
+  // prefetch_mutex_ must be locked.
+  void FillPrefetchRing();
+  // Main loop of the prefetch threads.
+  void PrefetchLoop();
+  // Stops the prefetch threads and drops the prefetched pages.
+  void StopPrefetch();
+  // Returns the memory the documents may use, which is the max_memory_ less
+  // the share of the prefetched pages while prefetching.
+  int64_t DocumentsMemory() const;
+  // Gives each document its fair share of the DocumentsMemory in the
+  // CS_ROUND_ROBIN case.
+  void SetDocumentsMemory();
+
   // Returns a page by serial number, selecting them in a round-robin fashion
   // from all the documents. Highly disk-intensive, but doesn't need samples
   // to be shuffled between files to begin with.
@@ -355,6 +497,39 @@ private:
   int num_pages_per_doc_ = 0;
   // Max memory allowed in this cache.
   int64_t max_memory_ = 0;
+
+  // Number of pages to fetch ahead, or 0 if not prefetching.
+  int prefetch_depth_ = 0;
+  // Height to pre-decode the prefetched pages at, or 0 if not at all.
+  int prefetch_height_ = 0;
+  std::vector<std::thread> prefetch_threads_;
+  // The pages being fetched, in order of serial number, and the serial
+  // number of the page to add after them.
+  std::deque<std::shared_ptr<PrefetchedPage>> prefetch_ring_;
+  int next_prefetch_serial_ = 0;
+  // Memory used by the pages in the ring, estimated for those not fetched yet.
+  int64_t prefetch_memory_ = 0;
+  // Number and total memory of the pages fetched so far, for the estimate.
+  int64_t prefetch_fetched_pages_ = 0;
+  int64_t prefetch_fetched_memory_ = 0;
+  // The last page returned by GetPrefetchedPage, and its serial number.
+  std::unique_ptr<ImageData> current_page_;
+  int current_serial_ = -1;
+  bool prefetch_shutdown_ = false;
+  // Counts for the prefetch_ accessors.
+  int64_t prefetch_requests_ = 0;
+  int64_t prefetch_stalls_ = 0;
+  double prefetch_stall_seconds_ = 0.0;
+  // Protects all the prefetch_ data members, and current_page_.
+  mutable std::mutex prefetch_mutex_;
+  // Signals the prefetch threads that there is a page to fetch or that they
+  // have to stop.
+  std::condition_variable prefetch_work_;
+  // Signals that a page is ready.
+  std::condition_variable prefetch_ready_;
+  // Held by the prefetch threads while they use the documents, as they are
+  // not safe for multiple threads to access.
+  std::mutex documents_mutex_;
 };
 
 } // namespace tesseract
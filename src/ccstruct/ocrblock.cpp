@@ -106,6 +106,17 @@ void BLOCK::reflect_polygon_in_y_axis() {
   pdblk.box = *pdblk.poly_block()->bounding_box();
 }
 
+/**
+ * BLOCK::scale_polygon
+ *
+ * Maps the polygon up from an image reduced by factor and recomputes the
+ * bounding_box. Does nothing to any contained rows/words/blobs etc.
+ */
+void BLOCK::scale_polygon(int factor, const ICOORD &reduced_size, const ICOORD &full_size) {
+  pdblk.poly_block()->scale(factor, reduced_size, full_size);
+  pdblk.box = *pdblk.poly_block()->bounding_box();
+}
+
 /**
  * BLOCK::sort_rows
  *
@@ -166,6 +166,11 @@ public:
 
   void rotate(const FCOORD &rotation);
 
+  // Maps the polygon up from an image reduced by factor, as
+  // POLY_BLOCK::scale, and recomputes the bounding_box.
+  // Does nothing to any contained rows/words/blobs etc.
+  void scale_polygon(int factor, const ICOORD &reduced_size, const ICOORD &full_size);
+
   /// decreasing y order
   void sort_rows();
 
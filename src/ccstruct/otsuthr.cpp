@@ -19,11 +19,20 @@
 #include "otsuthr.h"
 
 #include <allheaders.h>
+#include <algorithm> // for std::max, std::min
 #include <cstring>
+#include <mutex> // for std::mutex
 #include "helpers.h"
+#include "threadteam.h"
 
 namespace tesseract {
 
+// Number of bands of rows per thread to split an image into, so that the
+// threads stay busy when some bands take longer than others.
+const int kBandsPerThread = 4;
+// Min number of rows in a band, below which the work is not worth a task.
+const int kMinBandRows = 32;
+
 // Computes the Otsu threshold(s) for the given image rectangle, making one
 // for each channel. Each channel is always one byte per pixel.
 // Returns an array of threshold values and an array of hi_values, such
@@ -33,7 +42,7 @@ namespace tesseract {
 // The return value is the number of channels in the input image, being
 // the size of the output thresholds and hi_values arrays.
 int OtsuThreshold(Image src_pix, int left, int top, int width, int height, std::vector<int> &thresholds,
-                  std::vector<int> &hi_values) {
+                  std::vector<int> &hi_values, ThreadTeam *team) {
   int num_channels = pixGetDepth(src_pix) / 8;
   // Of all channels with no good hi_value, keep the best so we can always
   // produce at least one answer.
@@ -43,13 +52,13 @@ int OtsuThreshold(Image src_pix, int left, int top, int width, int height, std::
   double best_hi_dist = 0.0;
   thresholds.resize(num_channels);
   hi_values.resize(num_channels);
+  std::vector<int> histograms;
+  HistogramRectChannels(src_pix, left, top, width, height, team, histograms);
 
   for (int ch = 0; ch < num_channels; ++ch) {
     thresholds[ch] = -1;
     hi_values[ch] = -1;
-    // Compute the histogram of the image rectangle.
-    int histogram[kHistogramSize];
-    HistogramRect(src_pix, ch, left, top, width, height, histogram);
+    const int *histogram = &histograms[ch * kHistogramSize];
     int H;
     int best_omega_0;
     int best_t = OtsuStats(histogram, &H, &best_omega_0);
@@ -107,6 +116,49 @@ void HistogramRect(Image src_pix, int channel, int left, int top, int width, int
   }
 }
 
+// Computes the histograms of all the channels of the given image rectangle
+// in a single pass over it.
+void HistogramRectChannels(Image src_pix, int left, int top, int width, int height,
+                           ThreadTeam *team, std::vector<int> &histograms) {
+  int num_channels = pixGetDepth(src_pix) / 8;
+  int size = num_channels * kHistogramSize;
+  histograms.assign(size, 0);
+  int src_wpl = pixGetWpl(src_pix);
+  const l_uint32 *srcdata = pixGetData(src_pix);
+  std::mutex mutex;
+  RunOnRowBands(team, top, height, [&](int band_top, int band_bottom) {
+    std::vector<int> counts(size);
+    for (int y = band_top; y < band_bottom; ++y) {
+      const l_uint32 *linedata = srcdata + y * src_wpl;
+      int byte = left * num_channels;
+      for (int x = 0; x < width; ++x) {
+        for (int ch = 0; ch < size; ch += kHistogramSize) {
+          ++counts[ch + GET_DATA_BYTE(linedata, byte)];
+          ++byte;
+        }
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int i = 0; i < size; ++i) {
+      histograms[i] += counts[i];
+    }
+  });
+}
+
+// Splits the rows into bands, and runs band on each of them.
+void RunOnRowBands(ThreadTeam *team, int top, int height,
+                   const std::function<void(int, int)> &band) {
+  int num_bands = team == nullptr ? 1 : team->size() * kBandsPerThread;
+  num_bands = std::max(1, std::min(num_bands, height / kMinBandRows));
+  if (num_bands == 1) {
+    band(top, top + height);
+    return;
+  }
+  team->Run(num_bands, [&](int b) {
+    band(top + height * b / num_bands, top + height * (b + 1) / num_bands);
+  });
+}
+
 // Computes the Otsu threshold(s) for the given histogram.
 // Also returns H = total count in histogram, and
 // omega0 = count of histogram below threshold.
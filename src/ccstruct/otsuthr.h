@@ -21,12 +21,15 @@
 
 #include "image.h"
 
-#include <vector> // for std::vector
+#include <functional> // for std::function
+#include <vector>     // for std::vector
 
 struct Pix;
 
 namespace tesseract {
 
+class ThreadTeam;
+
 const int kHistogramSize = 256; // The size of a histogram of pixel values.
 
 // Computes the Otsu threshold(s) for the given image rectangle, making one
@@ -37,9 +40,10 @@ const int kHistogramSize = 256; // The size of a histogram of pixel values.
 // that there is no apparent foreground. At least one hi_value will not be -1.
 // The return value is the number of channels in the input image, being
 // the size of the output thresholds and hi_values arrays.
+// If team is not null, the histograms are counted on its threads.
 int OtsuThreshold(Image src_pix, int left, int top, int width, int height,
                   std::vector<int> &thresholds,
-                  std::vector<int> &hi_values);
+                  std::vector<int> &hi_values, ThreadTeam *team = nullptr);
 
 // Computes the histogram for the given image rectangle, and the given
 // single channel. Each channel is always one byte per pixel.
@@ -48,6 +52,19 @@ int OtsuThreshold(Image src_pix, int left, int top, int width, int height,
 void HistogramRect(Image src_pix, int channel, int left, int top, int width, int height,
                    int *histogram);
 
+// Computes the histograms of all the channels of the given image rectangle
+// in a single pass over it. On return, histograms holds kHistogramSize
+// counts for each channel in turn. If team is not null, bands of rows are
+// counted on its threads, and their counts added up.
+void HistogramRectChannels(Image src_pix, int left, int top, int width, int height,
+                           ThreadTeam *team, std::vector<int> &histograms);
+
+// Splits the rows [top, top + height) into bands of consecutive rows, and
+// runs band(band_top, band_bottom) for each of them, on the threads of team
+// if it is not null, or else for all the rows at once on the calling thread.
+void RunOnRowBands(ThreadTeam *team, int top, int height,
+                   const std::function<void(int, int)> &band);
+
 // Computes the Otsu threshold(s) for the given histogram.
 // Also returns H = total count in histogram, and
 // omega0 = count of histogram below threshold.
@@ -242,6 +242,28 @@ void POLY_BLOCK::move(ICOORD shift) {
   compute_bb();
 }
 
+/**
+ * POLY_BLOCK::scale
+ *
+ * Map the POLY_BLOCK up from an image reduced by factor.
+ * @param factor reduction of the image the polygon is in
+ * @param reduced_size size of the reduced image
+ * @param full_size size of the image it was reduced from
+ */
+
+void POLY_BLOCK::scale(int factor, const ICOORD &reduced_size, const ICOORD &full_size) {
+  // The reduced image lies at the top, so the rows left out of it are below
+  // it, where y is 0.
+  int y_offset = full_size.y() - reduced_size.y() * factor;
+  ICOORDELT_IT pts = &vertices;
+  for (pts.mark_cycle_pt(); !pts.cycled_list(); pts.forward()) {
+    ICOORDELT *pt = pts.data();
+    pt->set_x(pt->x() >= reduced_size.x() ? full_size.x() : pt->x() * factor);
+    pt->set_y(pt->y() <= 0 ? 0 : pt->y() * factor + y_offset);
+  }
+  compute_bb();
+}
+
 #ifndef GRAPHICS_DISABLED
 void POLY_BLOCK::plot(ScrollView *window, int32_t num) {
   ICOORDELT_IT v = &vertices;
@@ -60,6 +60,13 @@ public:
   void reflect_in_y_axis();
   // Move by adding shift to all coordinates.
   void move(ICOORD shift);
+  // Maps the polygon from an image reduced by factor up to the image of
+  // full_size that it was reduced from, at the top left of which the reduced
+  // image of reduced_size lies. As the vertices lie between pixels, this
+  // covers all the pixels of each reduced pixel that the polygon covers.
+  // Vertices at the right or bottom of the reduced image go to those of the
+  // full image, to cover the pixels left out of the reduction.
+  void scale(int factor, const ICOORD &reduced_size, const ICOORD &full_size);
 
 #ifndef GRAPHICS_DISABLED
 
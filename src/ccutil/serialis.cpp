@@ -25,6 +25,13 @@
 #include <climits> // for INT_MAX
 #include <cstdio>
 
+#if !defined(_WIN32)
+#  include <fcntl.h>    // for open
+#  include <sys/mman.h> // for mmap, munmap
+#  include <sys/stat.h> // for fstat
+#  include <unistd.h>   // for close
+#endif
+
 namespace tesseract {
 
 // The default FileReader loads the whole file into the vector of char,
@@ -60,6 +67,33 @@ bool SaveDataToFile(const std::vector<char> &data, const char *filename) {
   return result;
 }
 
+// Maps the whole of the given file read-only into memory. See the header.
+bool MapDataFromFile(const char *filename, std::shared_ptr<const char> *data, size_t *size) {
+#if defined(_WIN32)
+  return false;
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  void *address = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    address = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (address == MAP_FAILED) {
+    return false;
+  }
+  size_t mapped_size = st.st_size;
+  data->reset(static_cast<const char *>(address), [mapped_size](const char *mapped) {
+    munmap(const_cast<char *>(mapped), mapped_size);
+  });
+  *size = mapped_size;
+  return true;
+#endif
+}
+
 TFile::TFile() {
 }
 
@@ -74,7 +108,7 @@ bool TFile::DeSerializeSize(int32_t *pSize) {
   if (FReadEndian(&size, sizeof(size), 1) != 1) {
     return false;
   }
-  if (size > data_->size() / 4) {
+  if (size > read_size_ / 4) {
     // Reverse endianness.
     swap_ = !swap_;
     ReverseN(&size, 4);
@@ -137,6 +171,20 @@ bool TFile::Skip(size_t count) {
   return true;
 }
 
+const char *TFile::View(size_t size, size_t alignment, std::shared_ptr<const char> *owner) {
+  ASSERT_HOST(!is_writing_);
+  if (owner_ == nullptr || swap_ || offset_ > read_size_ || read_size_ - offset_ < size) {
+    return nullptr;
+  }
+  const char *data = read_data_ + offset_;
+  if (reinterpret_cast<uintptr_t>(data) % alignment != 0) {
+    return nullptr;
+  }
+  offset_ += size;
+  *owner = owner_;
+  return data;
+}
+
 bool TFile::Open(const char *filename, FileReader reader) {
   if (!data_is_owned_) {
     data_ = new std::vector<char>;
@@ -145,11 +193,10 @@ bool TFile::Open(const char *filename, FileReader reader) {
   offset_ = 0;
   is_writing_ = false;
   swap_ = false;
-  if (reader == nullptr) {
-    return LoadDataFromFile(filename, data_);
-  } else {
-    return (*reader)(filename, data_);
-  }
+  bool result =
+      reader == nullptr ? LoadDataFromFile(filename, data_) : (*reader)(filename, data_);
+  ReadFromData();
+  return result;
 }
 
 bool TFile::Open(const char *data, size_t size) {
@@ -162,6 +209,7 @@ bool TFile::Open(const char *data, size_t size) {
   swap_ = false;
   data_->resize(size); // TODO: optimize no init
   memcpy(&(*data_)[0], data, size);
+  ReadFromData();
   return true;
 }
 
@@ -189,15 +237,26 @@ bool TFile::Open(FILE *fp, int64_t end_offset) {
     data_is_owned_ = true;
   }
   data_->resize(size); // TODO: optimize no init
+  ReadFromData();
   return fread(&(*data_)[0], 1, size, fp) == size;
 }
 
+bool TFile::OpenView(const char *data, size_t size, std::shared_ptr<const char> owner) {
+  offset_ = 0;
+  is_writing_ = false;
+  swap_ = false;
+  read_data_ = data;
+  read_size_ = size;
+  owner_ = std::move(owner);
+  return true;
+}
+
 char *TFile::FGets(char *buffer, int buffer_size) {
   ASSERT_HOST(!is_writing_);
   int size = 0;
-  while (size + 1 < buffer_size && offset_ < data_->size()) {
-    buffer[size++] = (*data_)[offset_++];
-    if ((*data_)[offset_ - 1] == '\n') {
+  while (size + 1 < buffer_size && offset_ < read_size_) {
+    buffer[size++] = read_data_[offset_++];
+    if (read_data_[offset_ - 1] == '\n') {
       break;
     }
   }
@@ -224,15 +283,15 @@ size_t TFile::FRead(void *buffer, size_t size, size_t count) {
   size_t required_size;
   if (SIZE_MAX / size <= count) {
     // Avoid integer overflow.
-    required_size = data_->size() - offset_;
+    required_size = read_size_ - offset_;
   } else {
     required_size = size * count;
-    if (data_->size() - offset_ < required_size) {
-      required_size = data_->size() - offset_;
+    if (read_size_ - offset_ < required_size) {
+      required_size = read_size_ - offset_;
     }
   }
   if (required_size > 0 && buffer != nullptr) {
-    memcpy(buffer, &(*data_)[offset_], required_size);
+    memcpy(buffer, read_data_ + offset_, required_size);
   }
   offset_ += required_size;
   return required_size / size;
@@ -258,6 +317,9 @@ void TFile::OpenWrite(std::vector<char> *data) {
   is_writing_ = true;
   swap_ = false;
   data_->clear();
+  read_data_ = nullptr;
+  read_size_ = 0;
+  owner_.reset();
 }
 
 bool TFile::CloseWrite(const char *filename, FileWriter writer) {
@@ -24,6 +24,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory> // std::shared_ptr
 #include <type_traits>
 #include <vector> // std::vector
 
@@ -43,6 +44,12 @@ TESS_API
 bool LoadDataFromFile(const char *filename, std::vector<char> *data);
 TESS_API
 bool SaveDataToFile(const std::vector<char> &data, const char *filename);
+// Maps the whole of the given file read-only into memory, setting *data to
+// the mapping, which is unmapped when the last copy of *data goes, and *size
+// to its size. Returns false if the file is empty or can't be mapped, as on
+// Windows, in which case the caller has to read it instead.
+TESS_API
+bool MapDataFromFile(const char *filename, std::shared_ptr<const char> *data, size_t *size);
 
 // Deserialize data from file.
 template <typename T>
@@ -71,10 +78,18 @@ public:
   bool Open(const char *data, size_t size);
   // From an open file and an end offset.
   bool Open(FILE *fp, int64_t end_offset);
+  // From an existing memory buffer, without copying it. The TFile shares the
+  // ownership of the buffer with owner, which keeps it alive while it is
+  // being read, and beyond for any data returned by View. If owner is null,
+  // the buffer must outlive the TFile, and View is not possible.
+  bool OpenView(const char *data, size_t size, std::shared_ptr<const char> owner);
   // Sets the value of the swap flag, so that FReadEndian does the right thing.
   void set_swap(bool value) {
     swap_ = value;
   }
+  bool swap() const {
+    return swap_;
+  }
 
   // Deserialize data.
   bool DeSerializeSize(int32_t *data);
@@ -191,6 +206,12 @@ public:
 
   // Skip data.
   bool Skip(size_t count);
+  // Returns a pointer to the next size bytes in place, and skips them, if the
+  // TFile was opened with OpenView, the data is aligned to alignment and no
+  // bytes need to be swapped. *owner is then set to keep the data alive.
+  // Otherwise returns nullptr without reading anything, so the data has to
+  // be copied with DeSerialize instead.
+  const char *View(size_t size, size_t alignment, std::shared_ptr<const char> *owner);
 
   // Reads a line like fgets. Returns nullptr on EOF, otherwise buffer.
   // Reads at most buffer_size bytes, including '\0' terminator, even if
@@ -217,8 +238,20 @@ public:
   size_t FWrite(const void *buffer, size_t size, size_t count);
 
 private:
+  // Makes data_ the data to read.
+  void ReadFromData() {
+    read_data_ = data_->data();
+    read_size_ = data_->size();
+    owner_.reset();
+  }
+
   // The buffered data from the file.
   std::vector<char> *data_ = nullptr;
+  // The data being read, which is data_, unless opened with OpenView.
+  const char *read_data_ = nullptr;
+  size_t read_size_ = 0;
+  // The owner of the data if opened with OpenView.
+  std::shared_ptr<const char> owner_;
   // The number of bytes used so far.
   unsigned offset_ = 0;
   // True if the data_ pointer is owned by *this.
@@ -23,7 +23,9 @@
 #include "tessdatamanager.h"
 
 #include <cstdio>
+#include <functional> // for std::hash
 #include <string>
+#include <string_view>
 
 #if defined(HAVE_LIBARCHIVE)
 #  include <archive.h>
@@ -95,6 +97,9 @@ bool TessdataManager::Init(const char *data_file_name) {
       return true;
     }
 #endif
+    if (LoadMappedFile(data_file_name)) {
+      return true;
+    }
     if (!LoadDataFromFile(data_file_name, &data)) {
       return false;
     }
@@ -106,13 +111,43 @@ bool TessdataManager::Init(const char *data_file_name) {
   return LoadMemBuffer(data_file_name, &data[0], data.size());
 }
 
-// Loads from the given memory buffer as if a file.
-bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size) {
-  // TODO: This method supports only the proprietary file format.
+// Maps the given file into memory and finds its components, without copying
+// them.
+bool TessdataManager::LoadMappedFile(const char *filename) {
+  std::shared_ptr<const char> mapped_file;
+  size_t size;
+  if (!MapDataFromFile(filename, &mapped_file, &size)) {
+    return false;
+  }
   Clear();
-  data_file_name_ = name;
+  data_file_name_ = filename;
+  int64_t entry_offsets[TESSDATA_NUM_ENTRIES];
+  int64_t entry_sizes[TESSDATA_NUM_ENTRIES];
+  if (!FindEntries(mapped_file.get(), size, entry_offsets, entry_sizes)) {
+    return false;
+  }
+  mapped_file_ = std::move(mapped_file);
+  for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    if (entry_offsets[i] >= 0) {
+      mapped_entries_[i].data = mapped_file_.get() + entry_offsets[i];
+      mapped_entries_[i].size = entry_sizes[i];
+    }
+  }
+  if (!IsComponentAvailable(TESSDATA_VERSION)) {
+    SetVersionString("Pre-4.0.0");
+  }
+  is_loaded_ = true;
+  return true;
+}
+
+// Finds the offset and size of each component of the data, as laid out by
+// Serialize, returning them in entry_offsets and entry_sizes. The offset of
+// a missing component is -1.
+bool TessdataManager::FindEntries(const char *data, size_t size, int64_t *entry_offsets,
+                                  int64_t *entry_sizes) {
+  // TODO: This method supports only the proprietary file format.
   TFile fp;
-  fp.Open(data, size);
+  fp.OpenView(data, size, nullptr);
   uint32_t num_entries;
   if (!fp.DeSerialize(&num_entries)) {
     return false;
@@ -125,11 +160,16 @@ bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size
   if (num_entries > kMaxNumTessdataEntries) {
     return false;
   }
-  // TODO: optimize (no init required).
   std::vector<int64_t> offset_table(num_entries);
-  if (!fp.DeSerialize(&offset_table[0], num_entries)) {
+  if (!fp.DeSerialize(offset_table.data(), num_entries)) {
     return false;
   }
+  for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    entry_offsets[i] = -1;
+    entry_sizes[i] = 0;
+  }
+  // The entries follow the offset table, in order.
+  int64_t offset = sizeof(num_entries) + num_entries * sizeof(offset_table[0]);
   for (unsigned i = 0; i < num_entries && i < TESSDATA_NUM_ENTRIES; ++i) {
     if (offset_table[i] >= 0) {
       int64_t entry_size = size - offset_table[i];
@@ -140,10 +180,30 @@ bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size
       if (j < num_entries) {
         entry_size = offset_table[j] - offset_table[i];
       }
-      entries_[i].resize(entry_size);
-      if (!fp.DeSerialize(&entries_[i][0], entry_size)) {
+      if (entry_size < 0 || entry_size > static_cast<int64_t>(size) - offset) {
         return false;
       }
+      entry_offsets[i] = offset;
+      entry_sizes[i] = entry_size;
+      offset += entry_size;
+    }
+  }
+  return true;
+}
+
+// Loads from the given memory buffer as if a file.
+bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size) {
+  Clear();
+  data_file_name_ = name;
+  int64_t entry_offsets[TESSDATA_NUM_ENTRIES];
+  int64_t entry_sizes[TESSDATA_NUM_ENTRIES];
+  if (!FindEntries(data, size, entry_offsets, entry_sizes)) {
+    return false;
+  }
+  for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    if (entry_offsets[i] >= 0) {
+      const char *entry = data + entry_offsets[i];
+      entries_[i].assign(entry, entry + entry_sizes[i]);
     }
   }
   if (entries_[TESSDATA_VERSION].empty()) {
@@ -156,6 +216,7 @@ bool TessdataManager::LoadMemBuffer(const char *name, const char *data, int size
 // Overwrites a single entry of the given type.
 void TessdataManager::OverwriteEntry(TessdataType type, const char *data, int size) {
   is_loaded_ = true;
+  mapped_entries_[type] = MappedEntry();
   entries_[type].resize(size);
   memcpy(&entries_[type][0], data, size);
 }
@@ -181,11 +242,12 @@ void TessdataManager::Serialize(std::vector<char> *data) const {
   int64_t offset_table[TESSDATA_NUM_ENTRIES];
   int64_t offset = sizeof(int32_t) + sizeof(offset_table);
   for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (entries_[i].empty()) {
+    auto type = static_cast<TessdataType>(i);
+    if (!IsComponentAvailable(type)) {
       offset_table[i] = -1;
     } else {
       offset_table[i] = offset;
-      offset += entries_[i].size();
+      offset += EntrySize(type);
     }
   }
   data->resize(offset, 0);
@@ -194,9 +256,10 @@ void TessdataManager::Serialize(std::vector<char> *data) const {
   fp.OpenWrite(data);
   fp.Serialize(&num_entries);
   fp.Serialize(&offset_table[0], countof(offset_table));
-  for (const auto &entry : entries_) {
-    if (!entry.empty()) {
-      fp.Serialize(&entry[0], entry.size());
+  for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    auto type = static_cast<TessdataType>(i);
+    if (IsComponentAvailable(type)) {
+      fp.Serialize(EntryData(type), EntrySize(type));
     }
   }
 }
@@ -206,6 +269,10 @@ void TessdataManager::Clear() {
   for (auto &entry : entries_) {
     entry.clear();
   }
+  for (auto &entry : mapped_entries_) {
+    entry = MappedEntry();
+  }
+  mapped_file_.reset();
   is_loaded_ = false;
 }
 
@@ -214,10 +281,11 @@ void TessdataManager::Directory() const {
   printf("Version:%s\n", VersionString().c_str());
   auto offset = TESSDATA_NUM_ENTRIES * sizeof(int64_t);
   for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (!entries_[i].empty()) {
-      printf("%u:%s:size=%zu, offset=%zu\n", i, kTessdataFileSuffixes[i], entries_[i].size(),
+    auto type = static_cast<TessdataType>(i);
+    if (IsComponentAvailable(type)) {
+      printf("%u:%s:size=%zu, offset=%zu\n", i, kTessdataFileSuffixes[i], EntrySize(type),
               offset);
-      offset += entries_[i].size();
+      offset += EntrySize(type);
     }
   }
 }
@@ -236,21 +304,37 @@ bool TessdataManager::GetComponent(TessdataType type, TFile *fp) {
 // loaded.
 bool TessdataManager::GetComponent(TessdataType type, TFile *fp) const {
   ASSERT_HOST(is_loaded_);
-  if (entries_[type].empty()) {
+  if (!IsComponentAvailable(type)) {
     return false;
   }
-  fp->Open(&entries_[type][0], entries_[type].size());
+  if (entries_[type].empty()) {
+    // The component is read in place from the mapped file, which the TFile
+    // keeps alive.
+    fp->OpenView(EntryData(type), EntrySize(type), mapped_file_);
+  } else {
+    fp->Open(&entries_[type][0], entries_[type].size());
+  }
   fp->set_swap(swap_);
   return true;
 }
 
+// Returns a hash of the data of the given component, or 0 if it is not
+// present.
+size_t TessdataManager::ComponentHash(TessdataType type) const {
+  if (!IsComponentAvailable(type)) {
+    return 0;
+  }
+  return std::hash<std::string_view>{}(std::string_view(EntryData(type), EntrySize(type)));
+}
+
 // Returns the current version string.
 std::string TessdataManager::VersionString() const {
-  return std::string(&entries_[TESSDATA_VERSION][0], entries_[TESSDATA_VERSION].size());
+  return std::string(EntryData(TESSDATA_VERSION), EntrySize(TESSDATA_VERSION));
 }
 
 // Sets the version string to the given v_str.
 void TessdataManager::SetVersionString(const std::string &v_str) {
+  mapped_entries_[TESSDATA_VERSION] = MappedEntry();
   entries_[TESSDATA_VERSION].resize(v_str.size());
   memcpy(&entries_[TESSDATA_VERSION][0], v_str.data(), v_str.size());
 }
@@ -306,9 +390,13 @@ bool TessdataManager::OverwriteComponents(const char *new_traineddata_filename,
 bool TessdataManager::ExtractToFile(const char *filename) {
   TessdataType type = TESSDATA_NUM_ENTRIES;
   ASSERT_HOST(tesseract::TessdataManager::TessdataTypeFromFileName(filename, &type));
-  if (entries_[type].empty()) {
+  if (!IsComponentAvailable(type)) {
     return false;
   }
+  if (entries_[type].empty()) {
+    std::vector<char> entry(EntryData(type), EntryData(type) + EntrySize(type));
+    return SaveDataToFile(entry, filename);
+  }
   return SaveDataToFile(entries_[type], filename);
 }
 
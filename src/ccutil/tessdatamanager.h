@@ -20,6 +20,7 @@
 #define TESSERACT_CCUTIL_TESSDATAMANAGER_H_
 
 #include <tesseract/baseapi.h> // FileReader
+#include <memory>              // std::shared_ptr
 #include <string>              // std::string
 #include <vector>              // std::vector
 #include "serialis.h"          // FileWriter
@@ -143,6 +144,9 @@ public:
   void LoadFileLater(const char *data_file_name);
   /**
    * Opens and reads the given data file right now.
+   * Without a reader, the file is mapped into memory, if possible, rather
+   * than read, so its components are not copied and the pages are shared by
+   * every process that maps the same file.
    * @return true on success.
    */
   bool Init(const char *data_file_name);
@@ -164,7 +168,7 @@ public:
 
   // Returns true if the component requested is present.
   bool IsComponentAvailable(TessdataType type) const {
-    return !entries_[type].empty();
+    return EntrySize(type) > 0;
   }
   // Opens the given TFile pointer to the given component type.
   // Returns false in case of failure.
@@ -173,6 +177,16 @@ public:
   // loaded.
   bool GetComponent(TessdataType type, TFile *fp) const;
 
+  // Returns a hash of the data of the given component, or 0 if it is not
+  // present, so components of different files can be told apart by their
+  // contents.
+  size_t ComponentHash(TessdataType type) const;
+  // Returns a copy of the data of the given component, or an empty string if
+  // it is not present.
+  std::string ComponentData(TessdataType type) const {
+    return std::string(EntryData(type), EntrySize(type));
+  }
+
   // Returns the current version string.
   std::string VersionString() const;
   // Sets the version string to the given v_str.
@@ -180,12 +194,12 @@ public:
 
   // Returns true if the base Tesseract components are present.
   bool IsBaseAvailable() const {
-    return !entries_[TESSDATA_UNICHARSET].empty() && !entries_[TESSDATA_INTTEMP].empty();
+    return IsComponentAvailable(TESSDATA_UNICHARSET) && IsComponentAvailable(TESSDATA_INTTEMP);
   }
 
   // Returns true if the LSTM components are present.
   bool IsLSTMAvailable() const {
-    return !entries_[TESSDATA_LSTM].empty();
+    return IsComponentAvailable(TESSDATA_LSTM);
   }
 
   // Return the name of the underlying data file.
@@ -223,6 +237,22 @@ public:
 private:
   // Use libarchive.
   bool LoadArchiveFile(const char *filename);
+  // Maps the given file into memory and finds its components, without
+  // copying them.
+  bool LoadMappedFile(const char *filename);
+  // Finds the offset and size of each component of the data, as laid out by
+  // Serialize, returning them in entry_offsets and entry_sizes.
+  bool FindEntries(const char *data, size_t size, int64_t *entry_offsets,
+                   int64_t *entry_sizes);
+
+  // Returns the data of the given component, from entries_ or mapped_file_.
+  const char *EntryData(TessdataType type) const {
+    return entries_[type].empty() ? mapped_entries_[type].data : &entries_[type][0];
+  }
+  // Returns the size of the given component, from entries_ or mapped_file_.
+  size_t EntrySize(TessdataType type) const {
+    return entries_[type].empty() ? mapped_entries_[type].size : entries_[type].size();
+  }
 
   /**
    * Fills type with TessdataType of the tessdata component represented by the
@@ -248,6 +278,14 @@ private:
   bool swap_;
   // Contents of each element of the traineddata file.
   std::vector<char> entries_[TESSDATA_NUM_ENTRIES];
+  // The whole traineddata file, if it was mapped into memory by Init.
+  std::shared_ptr<const char> mapped_file_;
+  // The elements that are in mapped_file_, rather than entries_.
+  struct MappedEntry {
+    const char *data = nullptr;
+    size_t size = 0;
+  };
+  MappedEntry mapped_entries_[TESSDATA_NUM_ENTRIES];
 };
 
 } // namespace tesseract
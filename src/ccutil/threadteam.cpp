@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////
+// File:        threadteam.cpp
+// Description: Persistent team of threads for fine grained parallel jobs.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "threadteam.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#  include <immintrin.h> // for _mm_pause
+#endif
+
+namespace tesseract {
+
+// Number of times a waiting thread polls before it starts to yield its CPU.
+// This is long enough to cover the serial work between the jobs of
+// consecutive LSTM timesteps.
+const int kSpinCount = 2000;
+// Number of times an idle worker polls while yielding before it sleeps.
+const int kYieldCount = 100;
+
+// Waits a little in a polling loop, after the given number of polls.
+// Yields once the spinning has gone on too long, so that the thread being
+// waited for can run even if there are more threads than CPUs.
+static inline void SpinWait(int spins) {
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+  if (spins < kSpinCount) {
+    _mm_pause();
+    return;
+  }
+#endif
+  std::this_thread::yield();
+}
+
+ThreadTeam::ThreadTeam(int num_threads)
+    : next_task_(0), busy_workers_(0), generation_(0), shutdown_(false) {
+  for (int i = 1; i < num_threads; ++i) {
+    workers_.emplace_back(&ThreadTeam::WorkerLoop, this);
+  }
+}
+
+ThreadTeam::~ThreadTeam() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_.store(true);
+  }
+  wakeup_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadTeam::Run(int num_tasks, const std::function<void(int)> &task) {
+  if (workers_.empty() || num_tasks <= 1) {
+    for (int i = 0; i < num_tasks; ++i) {
+      task(i);
+    }
+    return;
+  }
+  task_ = &task;
+  num_tasks_ = num_tasks;
+  next_task_.store(0, std::memory_order_relaxed);
+  busy_workers_.store(workers_.size(), std::memory_order_relaxed);
+  {
+    // Taking the lock ensures that no worker misses the wakeup between
+    // checking the generation and going to sleep.
+    std::lock_guard<std::mutex> lock(mutex_);
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+  wakeup_.notify_all();
+  RunTasks();
+  // Wait for the workers to finish their last task, and to stop using task_.
+  for (int spins = 0; busy_workers_.load(std::memory_order_acquire) != 0; ++spins) {
+    SpinWait(spins);
+  }
+}
+
+void ThreadTeam::WorkerLoop() {
+  uint32_t seen = 0;
+  for (;;) {
+    uint32_t generation;
+    int spins = 0;
+    while ((generation = generation_.load(std::memory_order_acquire)) == seen &&
+           !shutdown_.load(std::memory_order_relaxed)) {
+      if (spins < kSpinCount + kYieldCount) {
+        SpinWait(spins++);
+      } else {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wakeup_.wait(lock, [this, seen] {
+          return generation_.load(std::memory_order_acquire) != seen || shutdown_.load();
+        });
+      }
+    }
+    if (shutdown_.load()) {
+      return;
+    }
+    seen = generation;
+    RunTasks();
+    busy_workers_.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+void ThreadTeam::RunTasks() {
+  for (int i = next_task_.fetch_add(1); i < num_tasks_; i = next_task_.fetch_add(1)) {
+    (*task_)(i);
+  }
+}
+
+} // namespace tesseract.
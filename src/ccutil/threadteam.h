@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////
+// File:        threadteam.h
+// Description: Persistent team of threads for fine grained parallel jobs.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_THREADTEAM_H_
+#define TESSERACT_CCUTIL_THREADTEAM_H_
+
+#include <tesseract/export.h> // for TESS_API
+
+#include <atomic>             // for std::atomic
+#include <condition_variable> // for std::condition_variable
+#include <cstdint>            // for uint32_t
+#include <functional>         // for std::function
+#include <mutex>              // for std::mutex
+#include <thread>             // for std::thread
+#include <vector>             // for std::vector
+
+namespace tesseract {
+
+// A team of threads that stays alive between jobs, for running many small
+// parallel jobs, such as the gates of one LSTM timestep, without paying for
+// the creation of threads on each job. Idle workers spin for a while waiting
+// for the next job before they go to sleep, so consecutive jobs are started
+// with very little latency.
+// The calling thread is part of the team and runs tasks too.
+// A team must only be used by one thread at a time.
+class TESS_API ThreadTeam {
+public:
+  // Creates a team of num_threads threads, including the calling thread, so
+  // num_threads - 1 worker threads are started.
+  explicit ThreadTeam(int num_threads);
+  ~ThreadTeam();
+  ThreadTeam(const ThreadTeam &) = delete;
+  ThreadTeam &operator=(const ThreadTeam &) = delete;
+
+  // Returns the number of threads in the team, including the calling thread.
+  int size() const {
+    return workers_.size() + 1;
+  }
+
+  // Runs task(i) for each i in [0, num_tasks) on the threads of the team and
+  // returns when all the tasks are done. The tasks may run in any order.
+  void Run(int num_tasks, const std::function<void(int)> &task);
+
+private:
+  // Main loop of the worker threads.
+  void WorkerLoop();
+  // Runs tasks of the current job until there are none left.
+  void RunTasks();
+
+  std::vector<std::thread> workers_;
+  // Protects the sleep of idle workers.
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  // The current job.
+  const std::function<void(int)> *task_ = nullptr;
+  int num_tasks_ = 0;
+  // Index of the next task of the current job to run.
+  std::atomic<int> next_task_;
+  // Number of workers that have not finished the current job.
+  std::atomic<int> busy_workers_;
+  // Incremented to start each job.
+  std::atomic<uint32_t> generation_;
+  std::atomic<bool> shutdown_;
+};
+
+} // namespace tesseract.
+
+#endif // TESSERACT_CCUTIL_THREADTEAM_H_
@@ -431,6 +431,13 @@ void UnicharCompress::SetupDecoder() {
       }
     }
   }
+  // Sort the code lists, so they can be searched.
+  for (auto &next_code : next_codes_) {
+    std::sort(next_code.second->begin(), next_code.second->end());
+  }
+  for (auto &final_code : final_codes_) {
+    std::sort(final_code.second->begin(), final_code.second->end());
+  }
 }
 
 // Frees allocated memory.
@@ -183,13 +183,13 @@ public:
     return is_valid_start_[code];
   }
   // Returns a list of valid non-final next codes for a given prefix code,
-  // which may be empty.
+  // which may be empty. The list is in increasing order.
   const std::vector<int> *GetNextCodes(const RecodedCharID &code) const {
     auto it = next_codes_.find(code);
     return it == next_codes_.end() ? nullptr : it->second;
   }
   // Returns a list of valid final codes for a given prefix code, which may
-  // be empty.
+  // be empty. The list is in increasing order.
   const std::vector<int> *GetFinalCodes(const RecodedCharID &code) const {
     auto it = final_codes_.find(code);
     return it == final_codes_.end() ? nullptr : it->second;
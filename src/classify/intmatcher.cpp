@@ -27,11 +27,13 @@
 #include "intproto.h"
 #include "scrollview.h"
 #include "shapetable.h"
+#include "simddetect.h"
 
 #include "helpers.h"
 
 #include <cassert>
 #include <cmath>
+#include <vector>
 
 namespace tesseract {
 
@@ -132,9 +134,9 @@ static void HeapSort(int n, int ra[], int rb[]) {
 class ClassPruner {
 public:
   ClassPruner(int max_classes) {
-    // The unrolled loop in ComputeScores means that the array sizes need to
-    // be rounded up so that the array is big enough to accommodate the extra
-    // entries accessed by the unrolling. Each pruner word is of sized
+    // ComputeScores counts whole pruners at a time, so the array sizes need
+    // to be rounded up so that the array is big enough to accommodate the
+    // extra entries of the last pruner. Each pruner word is of sized
     // BITS_PER_WERD and each entry is NUM_BITS_PER_CLASS, so there are
     // BITS_PER_WERD / NUM_BITS_PER_CLASS entries.
     // See ComputeScores.
@@ -166,65 +168,27 @@ public:
                      const INT_FEATURE_STRUCT *features) {
     num_features_ = num_features;
     auto num_pruners = int_templates->NumClassPruners;
+    // Quantize each feature to NUM_CP_BUCKETS*NUM_CP_BUCKETS*NUM_CP_BUCKETS,
+    // giving the offset of its vector in the 3-D array of each pruner.
+    std::vector<int> offsets(num_features);
     for (int f = 0; f < num_features; ++f) {
       const INT_FEATURE_STRUCT *feature = &features[f];
-      // Quantize the feature to NUM_CP_BUCKETS*NUM_CP_BUCKETS*NUM_CP_BUCKETS.
       int x = feature->X * NUM_CP_BUCKETS >> 8;
       int y = feature->Y * NUM_CP_BUCKETS >> 8;
       int theta = feature->Theta * NUM_CP_BUCKETS >> 8;
-      int class_id = 0;
-      // Each CLASS_PRUNER_STRUCT only covers CLASSES_PER_CP(32) classes, so
-      // we need a collection of them, indexed by pruner_set.
-      for (unsigned pruner_set = 0; pruner_set < num_pruners; ++pruner_set) {
-        // Look up quantized feature in a 3-D array, an array of weights for
-        // each class.
-        const uint32_t *pruner_word_ptr = int_templates->ClassPruners[pruner_set]->p[x][y][theta];
-        for (int word = 0; word < WERDS_PER_CP_VECTOR; ++word) {
-          uint32_t pruner_word = *pruner_word_ptr++;
-          // This inner loop is unrolled to speed up the ClassPruner.
-          // Currently gcc would not unroll it unless it is set to O3
-          // level of optimization or -funroll-loops is specified.
-          /*
-uint32_t class_mask = (1 << NUM_BITS_PER_CLASS) - 1;
-for (int bit = 0; bit < BITS_PER_WERD/NUM_BITS_PER_CLASS; bit++) {
-  class_count_[class_id++] += pruner_word & class_mask;
-  pruner_word >>= NUM_BITS_PER_CLASS;
-}
-*/
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-          pruner_word >>= NUM_BITS_PER_CLASS;
-          class_count_[class_id++] += pruner_word & CLASS_PRUNER_CLASS_MASK;
-        }
-      }
+      offsets[f] = ((x * NUM_CP_BUCKETS + y) * NUM_CP_BUCKETS + theta) * WERDS_PER_CP_VECTOR;
+    }
+    // Each CLASS_PRUNER_STRUCT only covers CLASSES_PER_CP(32) classes, so
+    // we need a collection of them, indexed by pruner_set.
+    std::vector<const uint32_t *> pruners(num_pruners);
+    for (unsigned pruner_set = 0; pruner_set < num_pruners; ++pruner_set) {
+      pruners[pruner_set] = &int_templates->ClassPruners[pruner_set]->p[0][0][0][0];
     }
+    // The weights of all the features are added up a pruner at a time, with
+    // the fastest code for this machine.
+    static_assert(CLASSES_PER_CP == 32 && WERDS_PER_CP_VECTOR == 2,
+                  "ClassPrunerCounts expects 32 classes in 2 words per pruner");
+    ClassPrunerCounts(pruners.data(), num_pruners, offsets.data(), num_features, class_count_);
   }
 
   /// Adjusts the scores according to the number of expected features. Used
@@ -192,7 +192,9 @@ void Dawg::init(int unicharset_size) {
 ----------------------------------------------------------------------*/
 
 SquishedDawg::~SquishedDawg() {
-  delete[] edges_;
+  if (edges_owner_ == nullptr) {
+    delete[] edges_;
+  }
 }
 
 EDGE_REF SquishedDawg::edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
@@ -336,9 +338,17 @@ bool SquishedDawg::read_squished_dawg(TFile *file) {
   ASSERT_HOST(num_edges_ > 0); // DAWG should not be empty
   Dawg::init(unicharset_size);
 
-  edges_ = new EDGE_RECORD[num_edges_];
-  if (!file->DeSerialize(&edges_[0], num_edges_)) {
-    return false;
+  // Use the edges in place if the file is mapped into memory, rather than
+  // copying them.
+  const char *edges = file->View(num_edges_ * sizeof(EDGE_RECORD), alignof(EDGE_RECORD),
+                                 &edges_owner_);
+  if (edges != nullptr) {
+    edges_ = reinterpret_cast<EDGE_ARRAY>(const_cast<char *>(edges));
+  } else {
+    edges_ = new EDGE_RECORD[num_edges_];
+    if (!file->DeSerialize(&edges_[0], num_edges_)) {
+      return false;
+    }
   }
   if (debug_level_ > 2) {
     tprintf("type: %d lang: %s perm: %d unicharset_size: %d num_edges: %d\n",
@@ -431,13 +441,13 @@ bool SquishedDawg::write_squished_dawg(TFile *file) {
   for (edge = 0; edge < num_edges_; edge++) {
     if (forward_edge(edge)) { // write forward edges
       do {
-        old_index = next_node_from_edge_rec(edges_[edge]);
-        set_next_node(edge, node_map[old_index]);
+        // Write a copy of the edge, so edges_ are left untouched.
         temp_record = edges_[edge];
+        old_index = next_node_from_edge_rec(temp_record);
+        set_next_node_in_edge_rec(&temp_record, node_map[old_index]);
         if (!file->Serialize(&temp_record)) {
           return false;
         }
-        set_next_node(edge, old_index);
       } while (!last_edge(edge++));
 
       if (edge >= num_edges_) {
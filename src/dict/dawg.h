@@ -565,6 +565,9 @@ private:
 
   // Member variables.
   EDGE_ARRAY edges_ = nullptr;
+  // If not null, edges_ are read in place from the memory it owns, and must
+  // not be modified or deleted.
+  std::shared_ptr<const char> edges_owner_;
   int32_t num_edges_ = 0;
   int num_forward_edges_in_node0 = 0;
 };
@@ -58,6 +58,10 @@ void Convolve::Forward(bool debug, const NetworkIO &input, const TransposedArray
   int y_scale = 2 * half_y_ + 1;
   StrideMap::Index dest_index(output->stride_map());
   do {
+    TRand *randomizer = scratch->randomizer(dest_index.index(FD_BATCH));
+    if (randomizer == nullptr) {
+      randomizer = randomizer_;
+    }
     // Stack x_scale groups of y_scale * ni_ inputs together.
     int t = dest_index.t();
     int out_ix = 0;
@@ -65,14 +69,14 @@ void Convolve::Forward(bool debug, const NetworkIO &input, const TransposedArray
       StrideMap::Index x_index(dest_index);
       if (!x_index.AddOffset(x, FD_WIDTH)) {
         // This x is outside the image.
-        output->Randomize(t, out_ix, y_scale * ni_, randomizer_);
+        output->Randomize(t, out_ix, y_scale * ni_, randomizer);
       } else {
         int out_iy = out_ix;
         for (int y = -half_y_; y <= half_y_; ++y, out_iy += ni_) {
           StrideMap::Index y_index(x_index);
           if (!y_index.AddOffset(y, FD_HEIGHT)) {
             // This y is outside the image.
-            output->Randomize(t, out_iy, ni_, randomizer_);
+            output->Randomize(t, out_iy, ni_, randomizer);
           } else {
             output->CopyTimeStepGeneral(t, out_iy, ni_, input, y_index.t(), 0);
           }
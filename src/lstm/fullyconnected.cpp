@@ -24,6 +24,7 @@
 #ifdef _OPENMP
 #  include <omp.h>
 #endif
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 
@@ -36,6 +37,8 @@ const int kNumThreads = 4;
 #else
 const int kNumThreads = 1;
 #endif
+// Number of timesteps multiplied by the weights together in int mode.
+const int kNumBlockTimeSteps = 8;
 
 namespace tesseract {
 
@@ -136,36 +139,56 @@ void FullyConnected::Forward(bool debug, const NetworkIO &input,
     output->Resize(input, no_);
   }
   SetupForward(input, input_transpose);
-  std::vector<NetworkScratch::FloatVec> temp_lines(kNumThreads);
+  // In int mode, the timesteps are processed in blocks that share each pass
+  // over the weights.
+  int block_size = input.int_mode() ? kNumBlockTimeSteps : 1;
+  std::vector<NetworkScratch::FloatVec> temp_lines(kNumThreads * block_size);
   std::vector<NetworkScratch::FloatVec> curr_input(kNumThreads);
   int ro = no_;
   if (IntSimdMatrix::intSimdMatrix) {
     ro = IntSimdMatrix::intSimdMatrix->RoundOutputs(ro);
   }
+  for (auto &temp_line : temp_lines) {
+    temp_line.Init(ro, scratch);
+  }
   for (int i = 0; i < kNumThreads; ++i) {
-    temp_lines[i].Init(ro, scratch);
     curr_input[i].Init(ni_, scratch);
   }
+  int num_blocks = (width + block_size - 1) / block_size;
 #ifdef _OPENMP
 #  pragma omp parallel for num_threads(kNumThreads)
-  for (int t = 0; t < width; ++t) {
+  for (int b = 0; b < num_blocks; ++b) {
     // Thread-local pointer to temporary storage.
     int thread_id = omp_get_thread_num();
 #else
-  for (int t = 0; t < width; ++t) {
+  for (int b = 0; b < num_blocks; ++b) {
     // Thread-local pointer to temporary storage.
     int thread_id = 0;
 #endif
-    TFloat *temp_line = temp_lines[thread_id];
+    int start = b * block_size;
+    int end = std::min(start + block_size, width);
+    TFloat *block_lines[kNumBlockTimeSteps];
+    for (int t = start; t < end; ++t) {
+      block_lines[t - start] = temp_lines[thread_id * block_size + t - start];
+    }
     if (input.int_mode()) {
-      ForwardTimeStep(input.i(t), t, temp_line);
+      const int8_t *block_inputs[kNumBlockTimeSteps];
+      for (int t = start; t < end; ++t) {
+        block_inputs[t - start] = input.i(t);
+      }
+      weights_.MatrixDotMatrix(end - start, block_inputs, block_lines);
+      for (int t = start; t < end; ++t) {
+        ForwardTimeStep(t, block_lines[t - start]);
+      }
     } else {
-      input.ReadTimeStep(t, curr_input[thread_id]);
-      ForwardTimeStep(curr_input[thread_id], t, temp_line);
+      input.ReadTimeStep(start, curr_input[thread_id]);
+      ForwardTimeStep(curr_input[thread_id], start, block_lines[0]);
     }
-    output->WriteTimeStep(t, temp_line);
-    if (IsTraining() && type_ != NT_SOFTMAX) {
-      acts_.CopyTimeStepFrom(t, *output, t);
+    for (int t = start; t < end; ++t) {
+      output->WriteTimeStep(t, block_lines[t - start]);
+      if (IsTraining() && type_ != NT_SOFTMAX) {
+        acts_.CopyTimeStepFrom(t, *output, t);
+      }
     }
   }
   // Zero all the elements that are in the padding around images that allows
@@ -188,9 +211,9 @@ void FullyConnected::Forward(bool debug, const NetworkIO &input,
 
 // Components of Forward so FullyConnected can be reused inside LSTM.
 void FullyConnected::SetupForward(const NetworkIO &input, const TransposedArray *input_transpose) {
-  // Softmax output is always float, so save the input type.
-  int_mode_ = input.int_mode();
   if (IsTraining()) {
+    // Softmax output is always float, so save the input type.
+    int_mode_ = input.int_mode();
     acts_.Resize(input, no_);
     // Source_ is a transposed copy of input. It isn't needed if provided.
     external_source_ = input_transpose;
@@ -334,4 +357,22 @@ void FullyConnected::CountAlternators(const Network &other, TFloat *same, TFloat
   weights_.CountAlternators(fc->weights_, same, changed);
 }
 
+// Adds the weight deltas of other, a replica of *this, to those of *this.
+void FullyConnected::AddDeltas(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  weights_.AddDeltas(static_cast<const FullyConnected *>(&other)->weights_);
+}
+
+// Replaces the weight deltas of *this with those of other.
+void FullyConnected::CopyDeltas(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  weights_.CopyDeltas(static_cast<const FullyConnected *>(&other)->weights_);
+}
+
+// Replaces the weights of *this with those of other.
+void FullyConnected::CopyWeights(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  weights_.CopyWeights(static_cast<const FullyConnected *>(&other)->weights_);
+}
+
 } // namespace tesseract.
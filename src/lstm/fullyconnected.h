@@ -111,6 +111,12 @@ public:
   // positive (same direction) in *same and negative (different direction) in
   // *changed.
   void CountAlternators(const Network &other, TFloat *same, TFloat *changed) const override;
+  // Adds the weight deltas of other, a replica of *this, to those of *this.
+  void AddDeltas(const Network &other) override;
+  // Replaces the weight deltas of *this with those of other.
+  void CopyDeltas(const Network &other) override;
+  // Replaces the weights of *this with those of other.
+  void CopyWeights(const Network &other) override;
 
 protected:
   // Weight arrays of size [no, ni + 1].
@@ -19,6 +19,7 @@
 #define TESSERACT_LSTM_FUNCTIONS_H_
 
 #include "helpers.h"
+#include "simddetect.h" // for TanhVector, LogisticVector, LSTMCell
 #include "tesstypes.h"
 
 // Setting this to 1 or more causes massive dumps of debug data: weights,
@@ -167,6 +168,28 @@ inline void FuncInplace(int n, TFloat *inout) {
     inout[i] = f(inout[i]);
   }
 }
+// The gate functions use the vectorized versions for this machine if there
+// are any, which differ slightly from the tables (see gatefunctions.h).
+template <>
+inline void FuncInplace<GFunc>(int n, TFloat *inout) {
+  if (TanhVector != nullptr) {
+    TanhVector(n, inout);
+    return;
+  }
+  for (int i = 0; i < n; ++i) {
+    inout[i] = Tanh(inout[i]);
+  }
+}
+template <>
+inline void FuncInplace<FFunc>(int n, TFloat *inout) {
+  if (LogisticVector != nullptr) {
+    LogisticVector(n, inout);
+    return;
+  }
+  for (int i = 0; i < n; ++i) {
+    inout[i] = Logistic(inout[i]);
+  }
+}
 // Applies Func to u and multiplies the result by v component-wise,
 // putting the product in out, all of size n.
 template <class Func>
@@ -176,6 +199,28 @@ inline void FuncMultiply(const TFloat *u, const TFloat *v, int n, TFloat *out) {
     out[i] = f(u[i]) * v[i];
   }
 }
+// Updates the n states of an LSTM cell from its gates and computes its
+// outputs in a single pass over the vectors. See LSTMCellAVX2 in
+// gatefunctions.h for the details. Without a vectorized version for this
+// machine, the results are the same as of separate passes with the tables.
+inline void LSTMCellUpdate(int n, const TFloat *ci, const TFloat *gi, const TFloat *gf1,
+                           const TFloat *gfs, const TFloat *stepped_state, const TFloat *go,
+                           TFloat state_clip, TFloat *state, TFloat *output) {
+  if (LSTMCell != nullptr) {
+    LSTMCell(n, ci, gi, gf1, gfs, stepped_state, go, state_clip, state, output);
+    return;
+  }
+  for (int i = 0; i < n; ++i) {
+    TFloat s = state[i] * gf1[i];
+    if (gfs != nullptr && gf1[i] < gfs[i]) {
+      s = gfs[i] * stepped_state[i];
+    }
+    s += ci[i] * gi[i];
+    s = ClipToRange(s, -state_clip, state_clip);
+    state[i] = s;
+    output[i] = Tanh(s) * go[i];
+  }
+}
 // Applies the Softmax function in-place to inout, of size n.
 template <typename T>
 inline void SoftmaxInPlace(int n, T *inout) {
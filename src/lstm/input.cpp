@@ -22,10 +22,15 @@
 #include "pageres.h"
 #include "scrollview.h"
 
+#include <algorithm> // for std::stable_sort
+#include <numeric>   // for std::iota
+
 namespace tesseract {
 
 // Max height for variable height inputs before scaling anyway.
 const int kMaxInputHeight = 48;
+// Max fraction of a batch of lines that may be padding out to its widest line.
+const double kMaxBatchPadding = 0.25;
 
 Input::Input(const std::string &name, int ni, int no)
     : Network(NT_INPUT, name, ni, no), cached_x_scale_(1) {}
@@ -106,6 +111,32 @@ Image Input::PrepareLSTMInputs(const ImageData &image_data, const Network *netwo
 /* static */
 void Input::PreparePixInput(const StaticShape &shape, const Image pix, TRand *randomizer,
                             NetworkIO *input) {
+  Image normed_pix = NormalizePix(shape, pix);
+  input->FromPix(shape, normed_pix, randomizer);
+  normed_pix.destroy();
+}
+
+// As PreparePixInput, but converts a whole set of images into a single
+// batched NetworkIO, with one FD_BATCH element per image, in order, each
+// padded with noise from the randomizer of the same index.
+/* static */
+void Input::PreparePixInputs(const StaticShape &shape, const std::vector<Image> &pixes,
+                             const std::vector<TRand *> &randomizers, NetworkIO *input) {
+  std::vector<Image> normed_pixes;
+  normed_pixes.reserve(pixes.size());
+  for (auto &&pix : pixes) {
+    normed_pixes.push_back(NormalizePix(shape, pix));
+  }
+  input->FromPixes(shape, normed_pixes, randomizers);
+  for (auto &&normed_pix : normed_pixes) {
+    normed_pix.destroy();
+  }
+}
+
+// Returns a new Pix converted to the depth and scaled to the height
+// required by the given StaticShape. Must be destroyed after use.
+/* static */
+Image Input::NormalizePix(const StaticShape &shape, const Image pix) {
   bool color = shape.depth() == 3;
   Image var_pix = pix;
   int depth = pixGetDepth(var_pix);
@@ -139,8 +170,38 @@ void Input::PreparePixInput(const StaticShape &shape, const Image pix, TRand *ra
     normed_pix.destroy();
     normed_pix = scaled_pix;
   }
-  input->FromPix(shape, normed_pix, randomizer);
-  normed_pix.destroy();
+  return normed_pix;
+}
+
+// Splits lines of the given widths into batches of similar widths.
+// See the header for the details.
+/* static */
+void Input::BucketByWidth(const std::vector<int> &widths, int max_batch_size,
+                          std::vector<std::vector<int>> *batches) {
+  batches->clear();
+  std::vector<int> order(widths.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&widths](int a, int b) { return widths[a] < widths[b]; });
+  // Each line is at least as wide as those before it, so it sets the padded
+  // width of the batch that it joins.
+  int64_t total_width = 0;
+  for (int line : order) {
+    int width = widths[line];
+    if (!batches->empty()) {
+      std::vector<int> &batch = batches->back();
+      int64_t padded_width = static_cast<int64_t>(width) * (batch.size() + 1);
+      int64_t padding = padded_width - total_width - width;
+      bool full = max_batch_size > 0 && batch.size() >= static_cast<size_t>(max_batch_size);
+      if (!full && padding <= kMaxBatchPadding * padded_width) {
+        batch.push_back(line);
+        total_width += width;
+        continue;
+      }
+    }
+    batches->emplace_back(1, line);
+    total_width = width;
+  }
 }
 
 } // namespace tesseract.
@@ -92,6 +92,22 @@ public:
   // NOTE: It isn't safe for multiple threads to call this on the same pix.
   static void PreparePixInput(const StaticShape &shape, const Image pix,
                               TRand *randomizer, NetworkIO *input);
+  // As PreparePixInput, but converts a whole set of images into a single
+  // batched NetworkIO, with one FD_BATCH element per image, in order, each
+  // padded with noise from the randomizer of the same index.
+  static void PreparePixInputs(const StaticShape &shape,
+                               const std::vector<Image> &pixes,
+                               const std::vector<TRand *> &randomizers,
+                               NetworkIO *input);
+  // Returns a new Pix converted to the depth and scaled to the height
+  // required by the given StaticShape. Must be destroyed after use.
+  static Image NormalizePix(const StaticShape &shape, const Image pix);
+  // Splits lines of the given widths into batches of similar widths, so that
+  // little of each batch is padding out to its widest line, with up to
+  // max_batch_size lines each, or any number if 0. Each batch is a list of
+  // indices into widths, narrowest first.
+  static void BucketByWidth(const std::vector<int> &widths, int max_batch_size,
+                            std::vector<std::vector<int>> *batches);
 
 private:
   void DebugWeights() override {
@@ -24,9 +24,12 @@
 #ifdef _OPENMP
 #  include <omp.h>
 #endif
+#include <algorithm>  // for std::min
 #include <cstdio>
 #include <cstdlib>
-#include <sstream> // for std::ostringstream
+#include <functional> // for std::ref
+#include <sstream>    // for std::ostringstream
+#include <thread>     // for std::thread
 
 #if defined(_MSC_VER) && !defined(__clang__)
 #  include <intrin.h> // _BitScanReverse
@@ -35,6 +38,7 @@
 #include "fullyconnected.h"
 #include "functions.h"
 #include "networkscratch.h"
+#include "threadteam.h"
 #include "tprintf.h"
 
 // Macros for openmp code if it is available, otherwise empty macros.
@@ -66,6 +70,10 @@
 
 namespace tesseract {
 
+INT_VAR(lstm_gate_threads, 0,
+        "Number of threads for the LSTM gates: 0 = OpenMP sections if available,"
+        " 1 = single thread, >1 = persistent thread team");
+
 // Max absolute value of state_. It is reasonably high to enable the state
 // to count things.
 const TFloat kStateClip = 100.0;
@@ -206,11 +214,43 @@ void LSTM::ConvertToInt() {
     }
     gate_weights_[w].ConvertToInt();
   }
+  SplitGateWeights();
   if (softmax_ != nullptr) {
     softmax_->ConvertToInt();
   }
 }
 
+// Splits the int gate_weights_ into input_weights_ and recurrent_weights_,
+// and frees gate_weights_, which are only needed again to serialize.
+void LSTM::SplitGateWeights() {
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) {
+      continue;
+    }
+    gate_weights_[w].SplitInputs(ni_, &input_weights_[w], &recurrent_weights_[w]);
+    gate_weights_[w] = WeightMatrix();
+  }
+}
+
+// Returns the gate weights of type w, joined from input_weights_ and
+// recurrent_weights_ into *joined if they have been split.
+const WeightMatrix &LSTM::GateWeights(int w, WeightMatrix *joined) const {
+  if (!input_weights_[w].is_int_mode()) {
+    return gate_weights_[w];
+  }
+  joined->JoinInputs(input_weights_[w], recurrent_weights_[w]);
+  return *joined;
+}
+
+// Returns size rounded up as the int implementation of the gate weights
+// needs for its input.
+int LSTM::RoundGateInputs(int size) const {
+  if (input_weights_[CI].is_int_mode()) {
+    return input_weights_[CI].RoundInputs(size);
+  }
+  return gate_weights_[CI].RoundInputs(size);
+}
+
 // Sets up the network for training using the given weight_range.
 void LSTM::DebugWeights() {
   for (int w = 0; w < WT_COUNT; ++w) {
@@ -219,7 +259,8 @@ void LSTM::DebugWeights() {
     }
     std::ostringstream msg;
     msg << name_ << " Gate weights " << w;
-    gate_weights_[w].Debug2D(msg.str().c_str());
+    WeightMatrix joined;
+    GateWeights(w, &joined).Debug2D(msg.str().c_str());
   }
   if (softmax_ != nullptr) {
     softmax_->DebugWeights();
@@ -238,7 +279,8 @@ bool LSTM::Serialize(TFile *fp) const {
     if (w == GFS && !Is2D()) {
       continue;
     }
-    if (!gate_weights_[w].Serialize(IsTraining(), fp)) {
+    WeightMatrix joined;
+    if (!GateWeights(w, &joined).Serialize(IsTraining(), fp)) {
       return false;
     }
   }
@@ -274,6 +316,13 @@ bool LSTM::DeSerialize(TFile *fp) {
       is_2d_ = na_ - nf_ == ni_ + 2 * ns_;
     }
   }
+  for (int w = 0; w < WT_COUNT; ++w) {
+    input_weights_[w] = WeightMatrix();
+    recurrent_weights_[w] = WeightMatrix();
+  }
+  if (gate_weights_[CI].is_int_mode()) {
+    SplitGateWeights();
+  }
   delete softmax_;
   if (type_ == NT_LSTM_SOFTMAX || type_ == NT_LSTM_SOFTMAX_ENCODED) {
     softmax_ = static_cast<FullyConnected *>(Network::CreateFromFile(fp));
@@ -290,8 +339,23 @@ bool LSTM::DeSerialize(TFile *fp) {
 // See NetworkCpp for a detailed discussion of the arguments.
 void LSTM::Forward(bool debug, const NetworkIO &input, const TransposedArray *input_transpose,
                    NetworkScratch *scratch, NetworkIO *output) {
-  input_map_ = input.stride_map();
-  input_width_ = input.Width();
+  ForwardInDirection(debug, input, input_transpose, scratch, output, false);
+}
+
+// As Forward, but runs along the x dimension from right to left.
+// See the header for the details.
+void LSTM::ForwardXReversed(const NetworkIO &input, NetworkScratch *scratch, NetworkIO *output) {
+  ASSERT_HOST(!IsTraining() && !Is2D() && type_ == NT_LSTM);
+  ForwardInDirection(false, input, nullptr, scratch, output, true);
+}
+
+void LSTM::ForwardInDirection(bool debug, const NetworkIO &input,
+                              const TransposedArray *input_transpose, NetworkScratch *scratch,
+                              NetworkIO *output, bool x_reversed) {
+  if (IsTraining()) {
+    input_map_ = input.stride_map();
+    input_width_ = input.Width();
+  }
   if (softmax_ != nullptr) {
     output->ResizeFloat(input, no_);
   } else if (type_ == NT_LSTM_SUMMARY) {
@@ -300,10 +364,18 @@ void LSTM::Forward(bool debug, const NetworkIO &input, const TransposedArray *in
     output->Resize(input, no_);
   }
   ResizeForward(input);
+  // Input padded with the previous output. It is only needed by Backward, so
+  // when not training it comes from the scratch, leaving *this untouched.
+  NetworkScratch::IO scratch_source;
+  NetworkIO *source = &source_;
+  if (!IsTraining()) {
+    scratch_source.Resize(input, RoundGateInputs(na_), scratch);
+    source = scratch_source;
+  }
   // Temporary storage of forward computation for each gate.
   NetworkScratch::FloatVec temp_lines[WT_COUNT];
   int ro = ns_;
-  if (source_.int_mode() && IntSimdMatrix::intSimdMatrix) {
+  if (source->int_mode() && IntSimdMatrix::intSimdMatrix) {
     ro = IntSimdMatrix::intSimdMatrix->RoundOutputs(ro);
   }
   for (auto &temp_line : temp_lines) {
@@ -318,7 +390,7 @@ void LSTM::Forward(bool debug, const NetworkIO &input, const TransposedArray *in
   // Rotating buffers of width buf_width allow storage of the state and output
   // for the other dimension, used only when working in true 2D mode. The width
   // is enough to hold an entire strip of the major direction.
-  int buf_width = Is2D() ? input_map_.Size(FD_WIDTH) : 1;
+  int buf_width = Is2D() ? input.stride_map().Size(FD_WIDTH) : 1;
   std::vector<NetworkScratch::FloatVec> states, outputs;
   if (Is2D()) {
     states.resize(buf_width);
@@ -336,7 +408,7 @@ void LSTM::Forward(bool debug, const NetworkIO &input, const TransposedArray *in
   if (softmax_ != nullptr) {
     softmax_output.Init(no_, scratch);
     ZeroVector<TFloat>(no_, softmax_output);
-    int rounded_softmax_inputs = gate_weights_[CI].RoundInputs(ns_);
+    int rounded_softmax_inputs = RoundGateInputs(ns_);
     if (input.int_mode()) {
       int_output.Resize2d(true, 1, rounded_softmax_inputs, scratch);
     }
@@ -344,7 +416,63 @@ void LSTM::Forward(bool debug, const NetworkIO &input, const TransposedArray *in
   }
   NetworkScratch::FloatVec curr_input;
   curr_input.Init(na_, scratch);
-  StrideMap::Index src_index(input_map_);
+  // In int mode, the products of the input part of the gate weights are
+  // computed for all timesteps at once, with one pass over the weights for
+  // several timesteps, leaving only the recurrent part to the timestep loop.
+  bool split_inputs = input.int_mode() && input_weights_[CI].is_int_mode();
+  NetworkScratch::GradientStore input_products[WT_COUNT];
+  NetworkScratch::IO recurrent_input;
+  if (split_inputs) {
+    int width = input.Width();
+    std::vector<const int8_t *> inputs(width);
+    std::vector<TFloat *> products(width);
+    for (int t = 0; t < width; ++t) {
+      inputs[t] = input.i(t);
+    }
+    for (int w = 0; w < WT_COUNT; ++w) {
+      if (w == GFS && !Is2D()) {
+        continue;
+      }
+      input_products[w].Init(width, ro, scratch);
+      for (int t = 0; t < width; ++t) {
+        products[t] = (*input_products[w].get())[t];
+      }
+      input_weights_[w].MatrixDotMatrix(width, inputs.data(), products.data());
+    }
+    recurrent_input.Resize2d(true, 1, RoundGateInputs(na_ - ni_), scratch);
+  }
+  // The gates are in the order of WeightType, so the first num_gates of them
+  // are the ones in use.
+  int num_gates = Is2D() ? WT_COUNT : GFS;
+#ifdef _OPENMP
+  int num_omp_threads = lstm_gate_threads == 1 ? 1 : GFS;
+#endif
+  // The team can only run one job at a time, so if this LSTM is already
+  // running on another thread, the gates are computed without it.
+  std::unique_lock<std::mutex> team_lock(gate_team_mutex_, std::try_to_lock);
+  ThreadTeam *gate_team = nullptr;
+  if (team_lock.owns_lock()) {
+    if (lstm_gate_threads > 1) {
+      // More threads than CPUs would only wait for each other.
+      int num_threads = std::min(static_cast<int>(lstm_gate_threads), num_gates);
+      int num_cpus = std::thread::hardware_concurrency();
+      if (num_cpus > 0) {
+        num_threads = std::min(num_threads, num_cpus);
+      }
+      if (gate_team_ == nullptr || gate_team_->size() != num_threads) {
+        gate_team_ = std::make_unique<ThreadTeam>(num_threads);
+      }
+    } else {
+      gate_team_.reset();
+    }
+    gate_team = gate_team_.get();
+  }
+  StrideMap::Index src_index(input.stride_map());
+  if (x_reversed) {
+    // The rows are independent in 1-d, so walking the whole map backwards
+    // runs each row from right to left.
+    src_index.InitToLast();
+  }
   // Used only by NT_LSTM_SUMMARY.
   StrideMap::Index dest_index(output->stride_map());
   do {
@@ -359,88 +487,100 @@ void LSTM::Forward(bool debug, const NetworkIO &input, const TransposedArray *in
     }
     // Index of the 2-D revolving buffers (outputs, states).
     int mod_t = Modulo(t, buf_width); // Current timestep.
-    // Setup the padded input in source.
-    source_.CopyTimeStepGeneral(t, 0, ni_, input, t, 0);
-    if (softmax_ != nullptr) {
-      source_.WriteTimeStepPart(t, ni_, nf_, softmax_output);
-    }
-    source_.WriteTimeStepPart(t, ni_ + nf_, ns_, curr_output);
-    if (Is2D()) {
-      source_.WriteTimeStepPart(t, ni_ + nf_ + ns_, ns_, outputs[mod_t]);
-    }
-    if (!source_.int_mode()) {
-      source_.ReadTimeStep(t, curr_input);
-    }
-    // Matrix multiply the inputs with the source.
-    PARALLEL_IF_OPENMP(GFS)
-    // It looks inefficient to create the threads on each t iteration, but the
-    // alternative of putting the parallel outside the t loop, a single around
-    // the t-loop and then tasks in place of the sections is a *lot* slower.
-    // Cell inputs.
-    if (source_.int_mode()) {
-      gate_weights_[CI].MatrixDotVector(source_.i(t), temp_lines[CI]);
-    } else {
-      gate_weights_[CI].MatrixDotVector(curr_input, temp_lines[CI]);
-    }
-    FuncInplace<GFunc>(ns_, temp_lines[CI]);
-
-    SECTION_IF_OPENMP
-    // Input Gates.
-    if (source_.int_mode()) {
-      gate_weights_[GI].MatrixDotVector(source_.i(t), temp_lines[GI]);
-    } else {
-      gate_weights_[GI].MatrixDotVector(curr_input, temp_lines[GI]);
-    }
-    FuncInplace<FFunc>(ns_, temp_lines[GI]);
-
-    SECTION_IF_OPENMP
-    // 1-D forget gates.
-    if (source_.int_mode()) {
-      gate_weights_[GF1].MatrixDotVector(source_.i(t), temp_lines[GF1]);
+    if (split_inputs) {
+      // Setup only the recurrent part of the input.
+      if (softmax_ != nullptr) {
+        recurrent_input->WriteTimeStepPart(0, 0, nf_, softmax_output);
+      }
+      recurrent_input->WriteTimeStepPart(0, nf_, ns_, curr_output);
+      if (Is2D()) {
+        recurrent_input->WriteTimeStepPart(0, nf_ + ns_, ns_, outputs[mod_t]);
+      }
     } else {
-      gate_weights_[GF1].MatrixDotVector(curr_input, temp_lines[GF1]);
+      // Setup the padded input in source.
+      source->CopyTimeStepGeneral(t, 0, ni_, input, t, 0);
+      if (softmax_ != nullptr) {
+        source->WriteTimeStepPart(t, ni_, nf_, softmax_output);
+      }
+      source->WriteTimeStepPart(t, ni_ + nf_, ns_, curr_output);
+      if (Is2D()) {
+        source->WriteTimeStepPart(t, ni_ + nf_ + ns_, ns_, outputs[mod_t]);
+      }
+      if (!source->int_mode()) {
+        source->ReadTimeStep(t, curr_input);
+      }
     }
-    FuncInplace<FFunc>(ns_, temp_lines[GF1]);
-
-    // 2-D forget gates.
-    if (Is2D()) {
-      if (source_.int_mode()) {
-        gate_weights_[GFS].MatrixDotVector(source_.i(t), temp_lines[GFS]);
+    // Matrix multiply the inputs with the source, and apply the gate
+    // functions, leaving the result for gate w in temp_lines[w].
+    auto compute_gate = [&](int w) {
+      if (split_inputs) {
+        recurrent_weights_[w].MatrixDotVector(recurrent_input->i(0), temp_lines[w]);
+        AccumulateVector(ns_, (*input_products[w].get())[t], temp_lines[w]);
+      } else if (source->int_mode()) {
+        gate_weights_[w].MatrixDotVector(source->i(t), temp_lines[w]);
       } else {
-        gate_weights_[GFS].MatrixDotVector(curr_input, temp_lines[GFS]);
+        gate_weights_[w].MatrixDotVector(curr_input, temp_lines[w]);
       }
-      FuncInplace<FFunc>(ns_, temp_lines[GFS]);
-    }
-
-    SECTION_IF_OPENMP
-    // Output gates.
-    if (source_.int_mode()) {
-      gate_weights_[GO].MatrixDotVector(source_.i(t), temp_lines[GO]);
+      if (w == CI) {
+        FuncInplace<GFunc>(ns_, temp_lines[w]);
+      } else {
+        FuncInplace<FFunc>(ns_, temp_lines[w]);
+      }
+    };
+    if (gate_team != nullptr) {
+      // std::ref avoids copying the lambda into the std::function.
+      gate_team->Run(num_gates, std::ref(compute_gate));
     } else {
-      gate_weights_[GO].MatrixDotVector(curr_input, temp_lines[GO]);
+      PARALLEL_IF_OPENMP(num_omp_threads)
+      // It looks inefficient to create the threads on each t iteration, but the
+      // alternative of putting the parallel outside the t loop, a single around
+      // the t-loop and then tasks in place of the sections is a *lot* slower.
+      // Use lstm_gate_threads > 1 to run the gates on a persistent thread team
+      // instead.
+      // Cell inputs.
+      compute_gate(CI);
+      SECTION_IF_OPENMP
+      // Input Gates.
+      compute_gate(GI);
+      SECTION_IF_OPENMP
+      // 1-D forget gates.
+      compute_gate(GF1);
+      // 2-D forget gates.
+      if (Is2D()) {
+        compute_gate(GFS);
+      }
+      SECTION_IF_OPENMP
+      // Output gates.
+      compute_gate(GO);
+      END_PARALLEL_IF_OPENMP
     }
-    FuncInplace<FFunc>(ns_, temp_lines[GO]);
-    END_PARALLEL_IF_OPENMP
 
-    // Apply forget gate to state.
-    MultiplyVectorsInPlace(ns_, temp_lines[GF1], curr_state);
+    // In 2-D, the forget gates are max-pooled instead of blindly added, so
+    // the state comes from the forget gate with the larger value.
+    const TFloat *gfs = nullptr;
+    const TFloat *stepped_state = nullptr;
     if (Is2D()) {
-      // Max-pool the forget gates (in 2-d) instead of blindly adding.
-      int8_t *which_fg_col = which_fg_[t];
-      memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
+      // The choice of forget gate is only needed by Backward.
+      int8_t *which_fg_col = IsTraining() ? which_fg_[t] : nullptr;
+      if (which_fg_col != nullptr) {
+        memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
+      }
       if (valid_2d) {
-        const TFloat *stepped_state = states[mod_t];
-        for (int i = 0; i < ns_; ++i) {
-          if (temp_lines[GF1][i] < temp_lines[GFS][i]) {
-            curr_state[i] = temp_lines[GFS][i] * stepped_state[i];
-            which_fg_col[i] = 2;
+        gfs = temp_lines[GFS];
+        stepped_state = states[mod_t];
+        if (which_fg_col != nullptr) {
+          for (int i = 0; i < ns_; ++i) {
+            if (temp_lines[GF1][i] < gfs[i]) {
+              which_fg_col[i] = 2;
+            }
           }
         }
       }
     }
-    MultiplyAccumulate(ns_, temp_lines[CI], temp_lines[GI], curr_state);
-    // Clip curr_state to a sane range.
-    ClipVector<TFloat>(ns_, -kStateClip, kStateClip, curr_state);
+    // Apply the forget gate to the state, add the gated cell input, clip the
+    // state to a sane range and compute the output, all in one pass.
+    LSTMCellUpdate(ns_, temp_lines[CI], temp_lines[GI], temp_lines[GF1], gfs, stepped_state,
+                   temp_lines[GO], kStateClip, curr_state, curr_output);
     if (IsTraining()) {
       // Save the gate node values.
       node_values_[CI].WriteTimeStep(t, temp_lines[CI]);
@@ -451,7 +591,6 @@ void LSTM::Forward(bool debug, const NetworkIO &input, const TransposedArray *in
         node_values_[GFS].WriteTimeStep(t, temp_lines[GFS]);
       }
     }
-    FuncMultiply<HFunc>(curr_state, temp_lines[GO], ns_, curr_output);
     if (IsTraining()) {
       state_.WriteTimeStep(t, curr_state);
     }
@@ -482,14 +621,14 @@ void LSTM::Forward(bool debug, const NetworkIO &input, const TransposedArray *in
     }
     // Always zero the states at the end of every row, but only for the major
     // direction. The 2-D state remains intact.
-    if (src_index.IsLast(FD_WIDTH)) {
+    if (x_reversed ? src_index.index(FD_WIDTH) == 0 : src_index.IsLast(FD_WIDTH)) {
       ZeroVector<TFloat>(ns_, curr_state);
       ZeroVector<TFloat>(ns_, curr_output);
     }
-  } while (src_index.Increment());
+  } while (x_reversed ? src_index.Decrement() : src_index.Increment());
 #if DEBUG_DETAIL > 0
   tprintf("Source:%s\n", name_.c_str());
-  source_.Print(10);
+  source->Print(10);
   tprintf("State:%s\n", name_.c_str());
   state_.Print(10);
   tprintf("Output:%s\n", name_.c_str());
@@ -772,6 +911,51 @@ void LSTM::CountAlternators(const Network &other, TFloat *same, TFloat *changed)
   }
 }
 
+// Adds the weight deltas of other, a replica of *this, to those of *this.
+void LSTM::AddDeltas(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM *lstm = static_cast<const LSTM *>(&other);
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) {
+      continue;
+    }
+    gate_weights_[w].AddDeltas(lstm->gate_weights_[w]);
+  }
+  if (softmax_ != nullptr) {
+    softmax_->AddDeltas(*lstm->softmax_);
+  }
+}
+
+// Replaces the weight deltas of *this with those of other.
+void LSTM::CopyDeltas(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM *lstm = static_cast<const LSTM *>(&other);
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) {
+      continue;
+    }
+    gate_weights_[w].CopyDeltas(lstm->gate_weights_[w]);
+  }
+  if (softmax_ != nullptr) {
+    softmax_->CopyDeltas(*lstm->softmax_);
+  }
+}
+
+// Replaces the weights of *this with those of other.
+void LSTM::CopyWeights(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM *lstm = static_cast<const LSTM *>(&other);
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) {
+      continue;
+    }
+    gate_weights_[w].CopyWeights(lstm->gate_weights_[w]);
+  }
+  if (softmax_ != nullptr) {
+    softmax_->CopyWeights(*lstm->softmax_);
+  }
+}
+
 #if DEBUG_DETAIL > 3
 
 // Prints the weights for debug purposes.
@@ -840,10 +1024,10 @@ void LSTM::PrintDW() {
 
 // Resizes forward data to cope with an input image of the given width.
 void LSTM::ResizeForward(const NetworkIO &input) {
-  int rounded_inputs = gate_weights_[CI].RoundInputs(na_);
-  source_.Resize(input, rounded_inputs);
-  which_fg_.ResizeNoInit(input.Width(), ns_);
   if (IsTraining()) {
+    int rounded_inputs = RoundGateInputs(na_);
+    source_.Resize(input, rounded_inputs);
+    which_fg_.ResizeNoInit(input.Width(), ns_);
     state_.ResizeFloat(input, ns_);
     for (int w = 0; w < WT_COUNT; ++w) {
       if (w == GFS && !Is2D()) {
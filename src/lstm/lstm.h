@@ -20,9 +20,19 @@
 
 #include "fullyconnected.h"
 #include "network.h"
+#include "params.h"
+
+#include <memory> // for std::unique_ptr
+#include <mutex>  // for std::mutex
 
 namespace tesseract {
 
+class ThreadTeam;
+
+// Number of threads used to compute the gates of each LSTM timestep.
+// 0 uses OpenMP sections if built with OpenMP, otherwise a single thread.
+extern TESS_API INT_VAR_H(lstm_gate_threads);
+
 // C++ Implementation of the LSTM class from lstm.py.
 class LSTM : public Network {
 public:
@@ -98,6 +108,10 @@ public:
   // See Network for a detailed discussion of the arguments.
   void Forward(bool debug, const NetworkIO &input, const TransposedArray *input_transpose,
                NetworkScratch *scratch, NetworkIO *output) override;
+  // As Forward, but runs along the x dimension from right to left, giving
+  // the same result as a Reversed(NT_XREVERSED) wrapping *this, without
+  // the copies of the reversed input and output. Inference of 1-d only.
+  void ForwardXReversed(const NetworkIO &input, NetworkScratch *scratch, NetworkIO *output);
 
   // Runs backward propagation of errors on the deltas line.
   // See Network for a detailed discussion of the arguments.
@@ -110,6 +124,12 @@ public:
   // positive (same direction) in *same and negative (different direction) in
   // *changed.
   void CountAlternators(const Network &other, TFloat *same, TFloat *changed) const override;
+  // Adds the weight deltas of other, a replica of *this, to those of *this.
+  void AddDeltas(const Network &other) override;
+  // Replaces the weight deltas of *this with those of other.
+  void CopyDeltas(const Network &other) override;
+  // Replaces the weights of *this with those of other.
+  void CopyWeights(const Network &other) override;
   // Prints the weights for debug purposes.
   void PrintW();
   // Prints the weight deltas for debug purposes.
@@ -121,8 +141,22 @@ public:
   }
 
 private:
-  // Resizes forward data to cope with an input image of the given width.
+  // Implements Forward, walking the timesteps backwards if x_reversed.
+  void ForwardInDirection(bool debug, const NetworkIO &input,
+                          const TransposedArray *input_transpose, NetworkScratch *scratch,
+                          NetworkIO *output, bool x_reversed);
+  // Resizes the forward data that Backward needs to cope with an input image
+  // of the given width.
   void ResizeForward(const NetworkIO &input);
+  // Splits the int gate_weights_ into input_weights_ and recurrent_weights_,
+  // and frees gate_weights_, which are only needed again to serialize.
+  void SplitGateWeights();
+  // Returns the gate weights of type w, joined from input_weights_ and
+  // recurrent_weights_ into *joined if they have been split.
+  const WeightMatrix &GateWeights(int w, WeightMatrix *joined) const;
+  // Returns size rounded up as the int implementation of the gate weights
+  // needs for its input.
+  int RoundGateInputs(int size) const;
 
 private:
   // Size of padded input to weight matrices = ni_ + no_ for 1-D operation
@@ -139,11 +173,24 @@ private:
   // Flag indicating 2-D operation.
   bool is_2d_;
 
-  // Gate weight arrays of size [na + 1, no].
+  // Gate weight arrays of size [na + 1, no]. Empty in int mode, once they
+  // are split into input_weights_ and recurrent_weights_.
   WeightMatrix gate_weights_[WT_COUNT];
+  // In int mode, gate_weights_ split into the weights of the ni_ inputs plus
+  // the bias, and the weights of the feedback and recurrent inputs, so the
+  // input part can be computed for all timesteps at once. Serialized joined
+  // back together as gate_weights_.
+  WeightMatrix input_weights_[WT_COUNT];
+  WeightMatrix recurrent_weights_[WT_COUNT];
+  // Persistent threads that compute the gates if lstm_gate_threads > 1.
+  // Kept between calls of Forward to avoid creating threads for each line.
+  std::unique_ptr<ThreadTeam> gate_team_;
+  // Held by the Forward that is using gate_team_.
+  std::mutex gate_team_mutex_;
   // Used only if this is a softmax LSTM.
   FullyConnected *softmax_;
-  // Input padded with previous output of size [width, na].
+  // Input padded with previous output of size [width, na]. Used by Forward
+  // only when training.
   NetworkIO source_;
   // Internal state used during forward operation, of size [width, ns].
   NetworkIO state_;
@@ -30,13 +30,19 @@
 #include "input.h"
 #include "lstm.h"
 #include "normalis.h"
+#include "object_cache.h"
 #include "pageres.h"
 #include "ratngs.h"
 #include "recodebeam.h"
 #include "scrollview.h"
 #include "statistc.h"
+#include "threadteam.h"
 #include "tprintf.h"
+#include "weightmatrix.h"
 
+#include <algorithm> // for std::min
+#include <atomic>    // for std::atomic
+#include <string>    // for std::to_string
 #include <unordered_set>
 #include <vector>
 
@@ -61,11 +67,13 @@ LSTMRecognizer::LSTMRecognizer()
     , learning_rate_(0.0f)
     , momentum_(0.0f)
     , adam_beta_(0.0f)
+    , shared_model_(nullptr)
     , dict_(nullptr)
     , search_(nullptr)
     , debug_win_(nullptr) {}
 
 LSTMRecognizer::~LSTMRecognizer() {
+  ReleaseSharedModel();
   delete network_;
   delete dict_;
   delete search_;
@@ -81,6 +89,7 @@ bool LSTMRecognizer::Load(const ParamsVectors *params, const std::string &lang,
   if (!DeSerialize(mgr, &fp)) {
     return false;
   }
+  plan_.Compile(network_);
   if (lang.empty()) {
     return true;
   }
@@ -89,11 +98,117 @@ bool LSTMRecognizer::Load(const ParamsVectors *params, const std::string &lang,
   return true;
 }
 
+// Loads a model from mgr as Load does, sharing the network with the other
+// LSTMRecognizers that load the same model.
+bool LSTMRecognizer::LoadShared(const ParamsVectors *params, const std::string &lang,
+                                TessdataManager *mgr) {
+  if (!mgr->IsComponentAvailable(TESSDATA_LSTM) ||
+      !mgr->IsComponentAvailable(TESSDATA_LSTM_RECODER) ||
+      !mgr->IsComponentAvailable(TESSDATA_LSTM_UNICHARSET)) {
+    return Load(params, lang, mgr);
+  }
+  // The model is identified by the contents of its components, rather than
+  // the name of the file, as buffers loaded from memory may share a name, and
+  // a file may change on disk while a model loaded from it is still cached.
+  // The id only holds their hashes, so the cached model keeps the components
+  // themselves, to tell apart models whose hashes collide.
+  const TessdataType kSharedTypes[] = {TESSDATA_LSTM, TESSDATA_LSTM_RECODER,
+                                       TESSDATA_LSTM_UNICHARSET};
+  std::string model_id = kTessdataFileSuffixes[TESSDATA_LSTM];
+  std::string model_data;
+  for (auto type : kSharedTypes) {
+    std::string data = mgr->ComponentData(type);
+    model_id += ":" + std::to_string(data.size()) + ":" + std::to_string(mgr->ComponentHash(type));
+    model_data += data;
+  }
+  LSTMRecognizer *model =
+      GlobalModelCache()->Get(model_id, [mgr, &model_data]() -> LSTMRecognizer * {
+        auto *model = new LSTMRecognizer;
+        if (model->Load(nullptr, "", mgr)) {
+          model->shared_data_ = model_data;
+          return model;
+        }
+        delete model;
+        return nullptr;
+      });
+  if (model == nullptr) {
+    return false;
+  }
+  if (model->shared_data_ != model_data) {
+    // A different model with the same id is cached, so don't share.
+    GlobalModelCache()->Free(model);
+    return Load(params, lang, mgr);
+  }
+  ReleaseSharedModel();
+  delete network_;
+  shared_model_ = model;
+  network_ = model->network_;
+  network_str_ = model->network_str_;
+  training_flags_ = model->training_flags_;
+  training_iteration_ = model->training_iteration_;
+  sample_iteration_ = model->sample_iteration_;
+  null_char_ = model->null_char_;
+  adam_beta_ = model->adam_beta_;
+  learning_rate_ = model->learning_rate_;
+  momentum_ = model->momentum_;
+  recoder_ = model->recoder_;
+  // The unicharset is not shared, as the properties of each copy may be
+  // set from the unicharset of the legacy engine.
+  TFile fp;
+  if (!mgr->GetComponent(TESSDATA_LSTM_UNICHARSET, &fp) ||
+      !ccutil_.unicharset.load_from_file(&fp, false)) {
+    return false;
+  }
+  // The randomizer of the shared network belongs to the cached model, so
+  // give Forward our own.
+  scratch_space_.set_randomizer(&randomizer_);
+  plan_.Compile(network_);
+  if (lang.empty()) {
+    return true;
+  }
+  // Allow it to run without a dictionary.
+  LoadDictionary(params, lang, mgr);
+  return true;
+}
+
+ObjectCache<LSTMRecognizer> *LSTMRecognizer::GlobalModelCache() {
+  // This global cache (a singleton) will outlive every Tesseract instance
+  // (even those that someone else might declare as global static variables).
+  static ObjectCache<LSTMRecognizer> cache;
+  return &cache;
+}
+
+// Stops sharing the network of shared_model_, if any.
+void LSTMRecognizer::ReleaseSharedModel() {
+  if (shared_model_ != nullptr) {
+    network_ = nullptr;
+    plan_ = NetworkPlan();
+    GlobalModelCache()->Free(shared_model_);
+    shared_model_ = nullptr;
+    scratch_space_.set_randomizer(nullptr);
+  }
+}
+
+// Runs network_ forward on inputs, with the compiled plan_ unless debugging
+// or training.
+void LSTMRecognizer::RunNetwork(bool debug, const NetworkIO &inputs, NetworkScratch *scratch,
+                                NetworkIO *outputs) {
+  if (!debug && plan_.network() == network_ && !network_->IsTraining()) {
+    plan_.Run(inputs, scratch, outputs);
+  } else {
+    network_->Forward(debug, inputs, nullptr, scratch, outputs);
+  }
+}
+
 // Writes to the given file. Returns false in case of error.
-bool LSTMRecognizer::Serialize(const TessdataManager *mgr, TFile *fp) const {
+bool LSTMRecognizer::Serialize(const TessdataManager *mgr, TFile *fp,
+                               const IntSimdMatrix *shape) const {
   bool include_charsets = mgr == nullptr || !mgr->IsComponentAvailable(TESSDATA_LSTM_RECODER) ||
                           !mgr->IsComponentAvailable(TESSDATA_LSTM_UNICHARSET);
-  if (!network_->Serialize(fp)) {
+  WeightMatrix::SetSerializeShape(shape);
+  bool network_ok = network_->Serialize(fp);
+  WeightMatrix::SetSerializeShape(nullptr);
+  if (!network_ok) {
     return false;
   }
   if (include_charsets && !GetUnicharset().save_to_file(fp)) {
@@ -131,7 +246,9 @@ bool LSTMRecognizer::Serialize(const TessdataManager *mgr, TFile *fp) const {
 
 // Reads from the given file. Returns false in case of error.
 bool LSTMRecognizer::DeSerialize(const TessdataManager *mgr, TFile *fp) {
+  ReleaseSharedModel();
   delete network_;
+  plan_ = NetworkPlan();
   network_ = Network::CreateFromFile(fp);
   if (network_ == nullptr) {
     return false;
@@ -255,39 +372,299 @@ void LSTMRecognizer::RecognizeLine(const ImageData &image_data,
   if (!RecognizeLine(image_data, invert_threshold, debug, false, false, &scale_factor, &inputs, &outputs)) {
     return;
   }
+  DecodeLine(outputs, scale_factor, debug, worst_dict_cert, line_box, words, lstm_choice_mode,
+             lstm_choice_amount);
+}
+
+// Decodes the outputs of the network for a single line, as produced by
+// RecognizeLines, returning the recognized tesseract WERD_RES for the words.
+void LSTMRecognizer::DecodeLine(const NetworkIO &outputs, float scale_factor, bool debug,
+                                double worst_dict_cert, const TBOX &line_box,
+                                PointerVector<WERD_RES> *words, int lstm_choice_mode,
+                                int lstm_choice_amount) {
   if (search_ == nullptr) {
     search_ = new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
   }
-  search_->excludedUnichars.clear();
-  search_->Decode(outputs, kDictRatio, kCertOffset, worst_dict_cert, &GetUnicharset(),
+  DecodeLine(search_, outputs, scale_factor, debug, worst_dict_cert, line_box, words,
+             lstm_choice_mode, lstm_choice_amount);
+}
+
+void LSTMRecognizer::DecodeLine(RecodeBeamSearch *search, const NetworkIO &outputs,
+                                float scale_factor, bool debug, double worst_dict_cert,
+                                const TBOX &line_box, PointerVector<WERD_RES> *words,
+                                int lstm_choice_mode, int lstm_choice_amount) {
+  search->excludedUnichars.clear();
+  search->Decode(outputs, kDictRatio, kCertOffset, worst_dict_cert, &GetUnicharset(),
                   lstm_choice_mode);
-  search_->ExtractBestPathAsWords(line_box, scale_factor, debug, &GetUnicharset(), words,
+  search->ExtractBestPathAsWords(line_box, scale_factor, debug, &GetUnicharset(), words,
                                   lstm_choice_mode);
   if (lstm_choice_mode) {
-    search_->extractSymbolChoices(&GetUnicharset());
+    search->extractSymbolChoices(&GetUnicharset());
     for (int i = 0; i < lstm_choice_amount; ++i) {
-      search_->DecodeSecondaryBeams(outputs, kDictRatio, kCertOffset, worst_dict_cert,
+      search->DecodeSecondaryBeams(outputs, kDictRatio, kCertOffset, worst_dict_cert,
                                     &GetUnicharset(), lstm_choice_mode);
-      search_->extractSymbolChoices(&GetUnicharset());
+      search->extractSymbolChoices(&GetUnicharset());
     }
-    search_->segmentTimestepsByCharacters();
+    search->segmentTimestepsByCharacters();
     unsigned char_it = 0;
     for (size_t i = 0; i < words->size(); ++i) {
       for (int j = 0; j < words->at(i)->end; ++j) {
-        if (char_it < search_->ctc_choices.size()) {
-          words->at(i)->CTC_symbol_choices.push_back(search_->ctc_choices[char_it]);
+        if (char_it < search->ctc_choices.size()) {
+          words->at(i)->CTC_symbol_choices.push_back(search->ctc_choices[char_it]);
         }
-        if (char_it < search_->segmentedTimesteps.size()) {
-          words->at(i)->segmented_timesteps.push_back(search_->segmentedTimesteps[char_it]);
+        if (char_it < search->segmentedTimesteps.size()) {
+          words->at(i)->segmented_timesteps.push_back(search->segmentedTimesteps[char_it]);
         }
         ++char_it;
       }
       words->at(i)->timesteps =
-          search_->combineSegmentedTimesteps(&words->at(i)->segmented_timesteps);
+          search->combineSegmentedTimesteps(&words->at(i)->segmented_timesteps);
     }
-    search_->segmentedTimesteps.clear();
-    search_->ctc_choices.clear();
-    search_->excludedUnichars.clear();
+    search->segmentedTimesteps.clear();
+    search->ctc_choices.clear();
+    search->excludedUnichars.clear();
+  }
+}
+
+// Runs the network forward on a whole set of line images, in batches of
+// lines of similar widths. See the header for the details of the outputs.
+bool LSTMRecognizer::RecognizeLines(const std::vector<const ImageData *> &images,
+                                    float invert_threshold, bool debug,
+                                    std::vector<NetworkIO> *outputs,
+                                    std::vector<float> *scale_factors, int max_batch_size) {
+  outputs->clear();
+  outputs->resize(images.size());
+  scale_factors->assign(images.size(), 0.0f);
+  int min_width = network_->XScaleFactor();
+  // Indices into images of the lines that make it into a batch.
+  std::vector<int> batch_lines;
+  std::vector<Image> pixes;
+  std::vector<int> widths;
+  for (size_t i = 0; i < images.size(); ++i) {
+    // This ensures consistent recognition results.
+    SetRandomSeed();
+    float image_scale;
+    Image pix =
+        Input::PrepareLSTMInputs(*images[i], network_, min_width, &randomizer_, &image_scale);
+    if (pix == nullptr) {
+      continue;
+    }
+    // Reduction factor from image to coords.
+    (*scale_factors)[i] = min_width / image_scale;
+    batch_lines.push_back(i);
+    pixes.push_back(pix);
+    widths.push_back(pixGetWidth(pix));
+  }
+  if (pixes.empty()) {
+    return false;
+  }
+  std::vector<std::vector<int>> batches;
+  Input::BucketByWidth(widths, max_batch_size, &batches);
+  NetworkIO inputs, batch_outputs;
+  inputs.set_int_mode(IsIntMode());
+  std::vector<Image> batch_pixes;
+  for (const auto &batch : batches) {
+    batch_pixes.clear();
+    for (int p : batch) {
+      batch_pixes.push_back(pixes[p]);
+    }
+    // Each line gets its own random sequence, seeded as RecognizeLine would,
+    // so that the results don't depend on the batching.
+    std::vector<TRand> randomizers(batch.size());
+    std::vector<TRand *> batch_randomizers;
+    for (auto &randomizer : randomizers) {
+      SetRandomSeed(&randomizer);
+      batch_randomizers.push_back(&randomizer);
+    }
+    Input::PreparePixInputs(network_->InputShape(), batch_pixes, batch_randomizers, &inputs);
+    scratch_space_.set_batch_randomizers(batch_randomizers);
+    RunNetwork(debug, inputs, &scratch_space_, &batch_outputs);
+    scratch_space_.set_batch_randomizers(std::vector<TRand *>());
+    for (size_t b = 0; b < batch.size(); ++b) {
+      NetworkIO *line_outputs = &(*outputs)[batch_lines[batch[b]]];
+      line_outputs->CopyBatchFrom(batch_outputs, b);
+      if (invert_threshold > 0.0f) {
+        float pos_min, pos_mean, pos_sd;
+        OutputStats(*line_outputs, &pos_min, &pos_mean, &pos_sd);
+        if (pos_mean < invert_threshold) {
+          // Leave it to RecognizeLine to try the inverted image.
+          *line_outputs = NetworkIO();
+        }
+      }
+    }
+  }
+  for (auto &&pix : pixes) {
+    pix.destroy();
+  }
+  return true;
+}
+
+// Recognizes the line images concurrently on up to num_threads threads.
+// See the header for the details.
+void LSTMRecognizer::RecognizeLinesInParallel(int num_threads,
+                                              const std::vector<const ImageData *> &images,
+                                              float invert_threshold, double worst_dict_cert,
+                                              const std::vector<TBOX> &line_boxes,
+                                              std::vector<PointerVector<WERD_RES>> *words,
+                                              int lstm_choice_mode, int lstm_choice_amount) {
+  words->clear();
+  words->resize(images.size());
+  num_threads = std::max(1, std::min<int>(num_threads, images.size()));
+  if (line_team_ == nullptr || line_team_->size() < num_threads) {
+    line_team_ = std::make_unique<ThreadTeam>(num_threads);
+  }
+  while (line_workers_.size() < static_cast<size_t>(num_threads)) {
+    auto worker = std::make_unique<LineWorker>();
+    worker->scratch.set_randomizer(&worker->randomizer);
+    worker->search =
+        std::make_unique<RecodeBeamSearch>(recoder_, null_char_, SimpleTextOutput(), dict_);
+    line_workers_.push_back(std::move(worker));
+  }
+  // Each task is a worker, which takes the next line until there are none
+  // left, so the lines are shared out dynamically.
+  std::atomic<size_t> next_line(0);
+  line_team_->Run(num_threads, [&](int w) {
+    LineWorker *worker = line_workers_[w].get();
+    for (size_t i = next_line++; i < images.size(); i = next_line++) {
+      float scale_factor;
+      NetworkIO inputs, outputs;
+      if (RecognizeLine(*images[i], invert_threshold, false, false, false, &worker->randomizer,
+                        &worker->scratch, &scale_factor, &inputs, &outputs)) {
+        DecodeLine(worker->search.get(), outputs, scale_factor, false, worst_dict_cert,
+                   line_boxes[i], &(*words)[i], lstm_choice_mode, lstm_choice_amount);
+      }
+    }
+  });
+}
+
+// Starts the streaming recognition of a new line, returning false if there is
+// no network.
+bool LSTMRecognizer::BeginStreamingLine(int lookahead, double worst_dict_cert) {
+  if (network_ == nullptr) {
+    return false;
+  }
+  if (streaming_line_ == nullptr) {
+    streaming_line_ = std::make_unique<StreamingLine>();
+    streaming_line_->search =
+        std::make_unique<RecodeBeamSearch>(recoder_, null_char_, SimpleTextOutput(), dict_);
+  }
+  StreamingLine *line = streaming_line_.get();
+  line->active = true;
+  line->pix.destroy();
+  line->first_col = 0;
+  line->height = 0;
+  line->decoded_steps = 0;
+  line->lookahead = std::max(0, lookahead);
+  line->worst_dict_cert = worst_dict_cert;
+  line->search->DecodeBegin();
+  return true;
+}
+
+// Adds the next columns of the streaming line, and decodes all that it can.
+bool LSTMRecognizer::AddStreamingColumns(Image columns) {
+  StreamingLine *line = streaming_line_.get();
+  if (line == nullptr || !line->active || columns == nullptr) {
+    return false;
+  }
+  if (line->height == 0) {
+    line->height = pixGetHeight(columns);
+  } else if (pixGetHeight(columns) != line->height) {
+    tprintf("Columns of height %d don't fit a streaming line of height %d!\n",
+            pixGetHeight(columns), line->height);
+    return false;
+  }
+  Image normed_pix = Input::NormalizePix(network_->InputShape(), columns);
+  if (line->pix == nullptr) {
+    line->pix = normed_pix;
+  } else {
+    int width = pixGetWidth(line->pix);
+    int added_width = pixGetWidth(normed_pix);
+    int height = pixGetHeight(line->pix);
+    Image joined_pix = pixCreate(width + added_width, height, pixGetDepth(line->pix));
+    pixRasterop(joined_pix, 0, 0, width, height, PIX_SRC, line->pix, 0, 0);
+    pixRasterop(joined_pix, width, 0, added_width, height, PIX_SRC, normed_pix, 0, 0);
+    normed_pix.destroy();
+    line->pix.destroy();
+    line->pix = joined_pix;
+  }
+  RunStreamingWindow(false);
+  return true;
+}
+
+// Returns the start of the text of the streaming line that can no longer
+// change.
+std::string LSTMRecognizer::StreamingLineText() const {
+  std::string text;
+  if (streaming_line_ != nullptr && streaming_line_->active) {
+    std::vector<int> unichar_ids;
+    streaming_line_->search->ExtractStableUnicharIds(&unichar_ids);
+    for (int unichar_id : unichar_ids) {
+      text += GetUnicharset().id_to_unichar(unichar_id);
+    }
+  }
+  return text;
+}
+
+// Decodes the rest of the streaming line and returns its whole text.
+std::string LSTMRecognizer::EndStreamingLine() {
+  std::string text;
+  StreamingLine *line = streaming_line_.get();
+  if (line == nullptr || !line->active) {
+    return text;
+  }
+  RunStreamingWindow(true);
+  if (line->decoded_steps > 0) {
+    std::vector<int> unichar_ids;
+    std::vector<float> certs, ratings;
+    std::vector<int> xcoords;
+    line->search->ExtractBestPathAsUnicharIds(false, &GetUnicharset(), &unichar_ids, &certs,
+                                              &ratings, &xcoords);
+    for (int unichar_id : unichar_ids) {
+      text += GetUnicharset().id_to_unichar(unichar_id);
+    }
+  }
+  line->active = false;
+  line->pix.destroy();
+  return text;
+}
+
+// Runs the network on the window of the streaming line and decodes its
+// outputs, up to lookahead timesteps before the end unless at_end.
+void LSTMRecognizer::RunStreamingWindow(bool at_end) {
+  StreamingLine *line = streaming_line_.get();
+  if (line->pix == nullptr) {
+    return;
+  }
+  int scale = network_->XScaleFactor();
+  int width = pixGetWidth(line->pix);
+  // The window starts at a timestep boundary, so its outputs are timesteps
+  // first_step onwards of the line.
+  int first_step = line->first_col / scale;
+  int start = line->decoded_steps - first_step;
+  int num_steps = width / scale - (at_end ? 0 : line->lookahead);
+  if (width < scale || num_steps <= start) {
+    return; // Not enough new columns for another timestep.
+  }
+  NetworkIO inputs, outputs;
+  inputs.set_int_mode(IsIntMode());
+  SetRandomSeed();
+  Input::PreparePixInput(network_->InputShape(), line->pix, &randomizer_, &inputs);
+  RunNetwork(false, inputs, &scratch_space_, &outputs);
+  int end = outputs.Width() - (at_end ? 0 : line->lookahead);
+  if (end > start) {
+    line->search->DecodeMore(outputs, start, end, kDictRatio, kCertOffset,
+                             line->worst_dict_cert, &GetUnicharset());
+    line->decoded_steps += end - start;
+  }
+  // Drop the columns that are no longer needed as left context.
+  int drop_width = std::max(0, line->decoded_steps - line->lookahead) * scale - line->first_col;
+  if (drop_width > 0 && drop_width < width) {
+    Box *box = boxCreate(drop_width, 0, width - drop_width, pixGetHeight(line->pix));
+    Image kept_pix = pixClipRectangle(line->pix, box, nullptr);
+    boxDestroy(&box);
+    line->pix.destroy();
+    line->pix = kept_pix;
+    line->first_col += drop_width;
   }
 }
 
@@ -322,10 +699,19 @@ bool LSTMRecognizer::RecognizeLine(const ImageData &image_data,
                                    float invert_threshold, bool debug,
                                    bool re_invert, bool upside_down, float *scale_factor,
                                    NetworkIO *inputs, NetworkIO *outputs) {
+  return RecognizeLine(image_data, invert_threshold, debug, re_invert, upside_down, &randomizer_,
+                       &scratch_space_, scale_factor, inputs, outputs);
+}
+
+bool LSTMRecognizer::RecognizeLine(const ImageData &image_data, float invert_threshold,
+                                   bool debug, bool re_invert, bool upside_down,
+                                   TRand *randomizer, NetworkScratch *scratch,
+                                   float *scale_factor, NetworkIO *inputs,
+                                   NetworkIO *outputs) {
   // This ensures consistent recognition results.
-  SetRandomSeed();
+  SetRandomSeed(randomizer);
   int min_width = network_->XScaleFactor();
-  Image pix = Input::PrepareLSTMInputs(image_data, network_, min_width, &randomizer_, scale_factor);
+  Image pix = Input::PrepareLSTMInputs(image_data, network_, min_width, randomizer, scale_factor);
   if (pix == nullptr) {
     tprintf("Line cannot be recognized!!\n");
     return false;
@@ -343,9 +729,9 @@ bool LSTMRecognizer::RecognizeLine(const ImageData &image_data,
   // Reduction factor from image to coords.
   *scale_factor = min_width / *scale_factor;
   inputs->set_int_mode(IsIntMode());
-  SetRandomSeed();
-  Input::PreparePixInput(network_->InputShape(), pix, &randomizer_, inputs);
-  network_->Forward(debug, *inputs, nullptr, &scratch_space_, outputs);
+  SetRandomSeed(randomizer);
+  Input::PreparePixInput(network_->InputShape(), pix, randomizer, inputs);
+  RunNetwork(debug, *inputs, scratch, outputs);
   // Check for auto inversion.
   if (invert_threshold > 0.0f) {
     float pos_min, pos_mean, pos_sd;
@@ -354,10 +740,10 @@ bool LSTMRecognizer::RecognizeLine(const ImageData &image_data,
       // Run again inverted and see if it is any better.
       NetworkIO inv_inputs, inv_outputs;
       inv_inputs.set_int_mode(IsIntMode());
-      SetRandomSeed();
+      SetRandomSeed(randomizer);
       pixInvert(pix, pix);
-      Input::PreparePixInput(network_->InputShape(), pix, &randomizer_, &inv_inputs);
-      network_->Forward(debug, inv_inputs, nullptr, &scratch_space_, &inv_outputs);
+      Input::PreparePixInput(network_->InputShape(), pix, randomizer, &inv_inputs);
+      RunNetwork(debug, inv_inputs, scratch, &inv_outputs);
       float inv_min, inv_mean, inv_sd;
       OutputStats(inv_outputs, &inv_min, &inv_mean, &inv_sd);
       if (inv_mean > pos_mean) {
@@ -371,8 +757,8 @@ bool LSTMRecognizer::RecognizeLine(const ImageData &image_data,
       } else if (re_invert) {
         // Inverting was not an improvement, so undo and run again, so the
         // outputs match the best forward result.
-        SetRandomSeed();
-        network_->Forward(debug, *inputs, nullptr, &scratch_space_, outputs);
+        SetRandomSeed(randomizer);
+        RunNetwork(debug, *inputs, scratch, outputs);
       }
     }
   }
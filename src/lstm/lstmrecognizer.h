@@ -22,12 +22,15 @@
 #include "helpers.h"
 #include "matrix.h"
 #include "network.h"
+#include "networkplan.h"
 #include "networkscratch.h"
 #include "params.h"
 #include "recodebeam.h"
 #include "series.h"
 #include "unicharcompress.h"
 
+#include <memory> // for std::unique_ptr
+
 class BLOB_CHOICE_IT;
 struct Pix;
 class ROW_RES;
@@ -39,6 +42,10 @@ namespace tesseract {
 
 class Dict;
 class ImageData;
+struct IntSimdMatrix;
+template <typename T>
+class ObjectCache;
+class ThreadTeam;
 
 // Enum indicating training mode control flags.
 enum TrainingFlags {
@@ -221,10 +228,26 @@ public:
 
   // Loads a model from mgr, including the dictionary only if lang is not null.
   bool Load(const ParamsVectors *params, const std::string &lang, TessdataManager *mgr);
+  // As Load, but the network is shared, through GlobalModelCache, with all
+  // the other LSTMRecognizers that LoadShared a model with the same network,
+  // recoder and unicharset data, so its weights are held in memory and
+  // deserialized only once. Everything that changes during recognition stays
+  // with each LSTMRecognizer. The shared network must only be used for
+  // inference, so this LSTMRecognizer must not be trained. Falls back to Load
+  // if mgr does not hold the LSTM unicharset and recoder as separate
+  // components.
+  bool LoadShared(const ParamsVectors *params, const std::string &lang, TessdataManager *mgr);
+  // Returns the process-wide cache of the models shared by LoadShared.
+  // Unused models are deleted by DeleteUnusedObjects.
+  static ObjectCache<LSTMRecognizer> *GlobalModelCache();
 
   // Writes to the given file. Returns false in case of error.
   // If mgr contains a unicharset and recoder, then they are not encoded to fp.
-  bool Serialize(const TessdataManager *mgr, TFile *fp) const;
+  // If shape is not null, the int weights are also written reshaped for
+  // IntSimdMatrix implementations of that shape, which then load them without
+  // reshaping. See WeightMatrix::SetSerializeShape.
+  bool Serialize(const TessdataManager *mgr, TFile *fp,
+                 const IntSimdMatrix *shape = nullptr) const;
   // Reads from the given file. Returns false in case of error.
   // If mgr contains a unicharset and recoder, then they are taken from there,
   // otherwise, they are part of the serialization in fp.
@@ -252,6 +275,57 @@ public:
   void RecognizeLine(const ImageData &image_data, float invert_threshold, bool debug, double worst_dict_cert,
                      const TBOX &line_box, PointerVector<WERD_RES> *words, int lstm_choice_mode = 0,
                      int lstm_choice_amount = 5);
+  // Decodes the outputs of the network for a single line, as produced by
+  // RecognizeLines, returning the recognized tesseract WERD_RES for the words.
+  // scale_factor is the reduction factor between the image and the outputs.
+  // The other arguments are as for RecognizeLine.
+  void DecodeLine(const NetworkIO &outputs, float scale_factor, bool debug,
+                  double worst_dict_cert, const TBOX &line_box, PointerVector<WERD_RES> *words,
+                  int lstm_choice_mode = 0, int lstm_choice_amount = 5);
+  // Runs the network forward on a whole set of line images in batches, so
+  // the weights are streamed from memory once per batch instead of once per
+  // line. Lines of similar widths are batched together, so that little time
+  // is spent on padding the narrower lines out to the widest of their batch,
+  // with at most max_batch_size lines per batch, or any number if 0.
+  // Each line is given its own random sequence, seeded as by RecognizeLine,
+  // so its outputs are those RecognizeLine would produce, whatever the batch.
+  // On return, outputs and scale_factors have an entry per image.
+  // An entry of outputs is left empty (Width() == 0) if the image could not
+  // be prepared, or if invert_threshold > 0 and the line didn't reach it, in
+  // which case the line should be recognized individually by RecognizeLine,
+  // which knows how to try the inverted image. Returns false if no line at
+  // all could be run.
+  bool RecognizeLines(const std::vector<const ImageData *> &images, float invert_threshold,
+                      bool debug, std::vector<NetworkIO> *outputs,
+                      std::vector<float> *scale_factors, int max_batch_size = 0);
+  // Recognizes the line images concurrently on up to num_threads threads,
+  // each with its own scratch space and beam search, putting the words of
+  // images[i], with the line box line_boxes[i], in (*words)[i]. The results
+  // are exactly those of calling RecognizeLine on each line in turn without
+  // debug. Nothing else may use this LSTMRecognizer meanwhile.
+  void RecognizeLinesInParallel(int num_threads, const std::vector<const ImageData *> &images,
+                                float invert_threshold, double worst_dict_cert,
+                                const std::vector<TBOX> &line_boxes,
+                                std::vector<PointerVector<WERD_RES>> *words,
+                                int lstm_choice_mode = 0, int lstm_choice_amount = 5);
+
+  // Streaming recognition of a single line, whose image arrives a chunk of
+  // columns at a time, left to right, such as from a camera. The network is
+  // run on a window of the columns received so far, and its outputs are
+  // decoded except for the last lookahead timesteps, which wait for the
+  // columns to their right. The left context of the window is also lookahead
+  // timesteps, so the work for each chunk doesn't grow with the length of
+  // the line. As the network normally has bidirectional layers, the results
+  // are close to, but not exactly, those of RecognizeLine on the whole line.
+  // Starts a new line, returning false if there is no network.
+  bool BeginStreamingLine(int lookahead, double worst_dict_cert);
+  // Adds the next columns of the line, which must all be of the same height.
+  // Returns false if they can't be added.
+  bool AddStreamingColumns(Image columns);
+  // Returns the start of the text of the line that can no longer change.
+  std::string StreamingLineText() const;
+  // Decodes the rest of the line and returns its whole text.
+  std::string EndStreamingLine();
 
   // Helper computes min and mean best results in the output.
   void OutputStats(const NetworkIO &outputs, float *min_output, float *mean_output, float *sd);
@@ -284,12 +358,65 @@ public:
                          std::vector<int> *xcoords);
 
 protected:
+  // The state that each thread of RecognizeLinesInParallel needs of its own.
+  struct LineWorker {
+    TRand randomizer;
+    NetworkScratch scratch;
+    std::unique_ptr<RecodeBeamSearch> search;
+  };
+
+  // The state of a line being recognized by AddStreamingColumns.
+  struct StreamingLine {
+    ~StreamingLine() {
+      pix.destroy();
+    }
+    // True between BeginStreamingLine and EndStreamingLine.
+    bool active = false;
+    // Beam search held between lines, as search_ may be in use for others.
+    std::unique_ptr<RecodeBeamSearch> search;
+    // The columns of the line that are still needed, normalized for the
+    // network input, starting at column first_col of the normalized line.
+    Image pix = nullptr;
+    int first_col = 0;
+    // Height of the columns as given.
+    int height = 0;
+    // Number of timesteps of the line given to the beam search so far.
+    int decoded_steps = 0;
+    int lookahead = 0;
+    double worst_dict_cert = 0.0;
+  };
+
+  // Runs the network on the window of the streaming line and decodes its
+  // outputs, up to lookahead timesteps before the end unless at_end.
+  void RunStreamingWindow(bool at_end);
+
+  // Stops sharing the network of shared_model_, if any.
+  void ReleaseSharedModel();
+
+  // Runs network_ forward on inputs, with the compiled plan_ unless
+  // debugging or training.
+  void RunNetwork(bool debug, const NetworkIO &inputs, NetworkScratch *scratch,
+                  NetworkIO *outputs);
+
   // Sets the random seed from the sample_iteration_;
   void SetRandomSeed() {
+    SetRandomSeed(&randomizer_);
+  }
+  void SetRandomSeed(TRand *randomizer) const {
     int64_t seed = static_cast<int64_t>(sample_iteration_) * 0x10000001;
-    randomizer_.set_seed(seed);
-    randomizer_.IntRand();
+    randomizer->set_seed(seed);
+    randomizer->IntRand();
   }
+  // As the public RecognizeLine, but using the given randomizer and scratch.
+  bool RecognizeLine(const ImageData &image_data, float invert_threshold, bool debug,
+                     bool re_invert, bool upside_down, TRand *randomizer,
+                     NetworkScratch *scratch, float *scale_factor, NetworkIO *inputs,
+                     NetworkIO *outputs);
+  // As the public DecodeLine, but using the given beam search.
+  void DecodeLine(RecodeBeamSearch *search, const NetworkIO &outputs, float scale_factor,
+                  bool debug, double worst_dict_cert, const TBOX &line_box,
+                  PointerVector<WERD_RES> *words, int lstm_choice_mode,
+                  int lstm_choice_amount);
 
   // Displays the labels and cuts at the corresponding xcoords.
   // Size of labels should match xcoords.
@@ -354,12 +481,25 @@ protected:
   float adam_beta_;
 
   // === NOT SERIALIZED.
+  // If not null, the model in GlobalModelCache that owns network_.
+  LSTMRecognizer *shared_model_;
+  // In a model in GlobalModelCache, the components it was loaded from.
+  std::string shared_data_;
   TRand randomizer_;
   NetworkScratch scratch_space_;
+  // Flat version of network_ for inference, compiled once it is loaded.
+  // Must be reset wherever network_ is deleted or replaced, as a new network
+  // may be allocated at the same address as the old one.
+  NetworkPlan plan_;
   // Language model (optional) to use with the beam search.
   Dict *dict_;
   // Beam search held between uses to optimize memory allocation/use.
   RecodeBeamSearch *search_;
+  // Threads and their state for RecognizeLinesInParallel, held between uses.
+  std::unique_ptr<ThreadTeam> line_team_;
+  std::vector<std::unique_ptr<LineWorker>> line_workers_;
+  // The line being recognized by the streaming functions, if any.
+  std::unique_ptr<StreamingLine> streaming_line_;
 
   // == Debugging parameters.==
   // Recognition debug display window.
@@ -17,6 +17,8 @@
 
 #include "maxpool.h"
 
+#include <vector> // for std::vector
+
 namespace tesseract {
 
 Maxpool::Maxpool(const std::string &name, int ni, int x_scale, int y_scale)
@@ -37,8 +39,15 @@ bool Maxpool::DeSerialize(TFile *fp) {
 void Maxpool::Forward(bool debug, const NetworkIO &input, const TransposedArray *input_transpose,
                       NetworkScratch *scratch, NetworkIO *output) {
   output->ResizeScaled(input, x_scale_, y_scale_, no_);
-  maxes_.ResizeNoInit(output->Width(), ni_);
-  back_map_ = input.stride_map();
+  // The positions of the maxes are only needed by Backward. Otherwise they
+  // are kept locally, so nothing is written to *this.
+  std::vector<int> local_maxes;
+  if (IsTraining()) {
+    maxes_.ResizeNoInit(output->Width(), ni_);
+    back_map_ = input.stride_map();
+  } else {
+    local_maxes.resize(ni_);
+  }
 
   StrideMap::Index dest_index(output->stride_map());
   do {
@@ -48,7 +57,7 @@ void Maxpool::Forward(bool debug, const NetworkIO &input, const TransposedArray
                                dest_index.index(FD_WIDTH) * x_scale_);
     // Find the max input out of x_scale_ groups of y_scale_ inputs.
     // Do it independently for each input dimension.
-    int *max_line = maxes_[out_t];
+    int *max_line = IsTraining() ? maxes_[out_t] : &local_maxes[0];
     int in_t = src_index.t();
     output->CopyTimeStepFrom(out_t, input, in_t);
     for (int i = 0; i < ni_; ++i) {
@@ -240,6 +240,15 @@ public:
   virtual void CountAlternators([[maybe_unused]] const Network &other,
                                 [[maybe_unused]] TFloat *same,
                                 [[maybe_unused]] TFloat *changed) const {}
+  // Adds the weight deltas of the last Backward of other, which must be a
+  // replica of *this, to those of *this, so that one Update applies the
+  // deltas of several samples that were run on replicas.
+  virtual void AddDeltas([[maybe_unused]] const Network &other) {}
+  // Replaces the weight deltas of *this with those of other.
+  virtual void CopyDeltas([[maybe_unused]] const Network &other) {}
+  // Replaces the weights of *this with those of other, which must be a
+  // replica of *this, to keep the replica in step after an Update.
+  virtual void CopyWeights([[maybe_unused]] const Network &other) {}
 
   // Reads from the given file. Returns nullptr in case of error.
   // Determines the type of the serialized class and calls its DeSerialize
@@ -264,6 +273,8 @@ public:
   // reference it on a call to backward. This is a bit ugly, but it makes it
   // possible for a replicating parallel to calculate the input transpose once
   // instead of all the replicated networks having to do it.
+  // When not training, Forward keeps no state in the network, so a network
+  // may run concurrently on several threads, each with its own scratch.
   virtual void Forward(bool debug, const NetworkIO &input,
                        const TransposedArray *input_transpose,
                        NetworkScratch *scratch, NetworkIO *output) = 0;
@@ -31,6 +31,23 @@ const float kMinCertainty = -20.0f;
 // Probability corresponding to kMinCertainty.
 const float kMinProb = std::exp(kMinCertainty);
 
+// The values that SetPixel stores for each 8 bit pixel value, for a given
+// black and contrast, so whole images are converted with a lookup per pixel
+// instead of a division and a rounding.
+struct PixelTable {
+  PixelTable(float black, float contrast) {
+    for (int pixel = 0; pixel < 256; ++pixel) {
+      float float_pixel = (pixel - black) / contrast - 1.0f;
+      float_values[pixel] = float_pixel;
+      int_values[pixel] =
+          ClipToRange<int>(IntCastRounded((INT8_MAX + 1) * float_pixel), -INT8_MAX, INT8_MAX);
+    }
+  }
+
+  float float_values[256];
+  int8_t int_values[256];
+};
+
 // Resizes to a specific size as a 2-d temp buffer. No batches, no y-dim.
 void NetworkIO::Resize2d(bool int_mode, int width, int num_features) {
   stride_map_ = StrideMap();
@@ -162,14 +179,17 @@ static void ComputeBlackWhite(Image pix, float *black, float *white) {
 // with noise to match.
 void NetworkIO::FromPix(const StaticShape &shape, const Image pix, TRand *randomizer) {
   std::vector<Image> pixes(1, pix);
-  FromPixes(shape, pixes, randomizer);
+  std::vector<TRand *> randomizers(1, randomizer);
+  FromPixes(shape, pixes, randomizers);
 }
 
 // Sets up the array from the given set of images, using the currently set
 // int_mode_. If the image width doesn't match the shape, the images are
-// truncated or padded with noise to match.
+// truncated or padded with noise to match, drawn from the randomizer of the
+// same index, so each image gets the noise it would get on its own.
 void NetworkIO::FromPixes(const StaticShape &shape, const std::vector<Image> &pixes,
-                          TRand *randomizer) {
+                          const std::vector<TRand *> &randomizers) {
+  ASSERT_HOST(randomizers.size() == pixes.size());
   int target_height = shape.height();
   int target_width = shape.width();
   std::vector<std::pair<int, int>> h_w_pairs;
@@ -199,9 +219,9 @@ void NetworkIO::FromPixes(const StaticShape &shape, const std::vector<Image> &pi
       contrast = 1.0f;
     }
     if (shape.height() == 1) {
-      Copy1DGreyImage(b, pix, black, contrast, randomizer);
+      Copy1DGreyImage(b, pix, black, contrast, randomizers[b]);
     } else {
-      Copy2DImage(b, pix, black, contrast, randomizer);
+      Copy2DImage(b, pix, black, contrast, randomizers[b]);
     }
   }
 }
@@ -222,11 +242,16 @@ void NetworkIO::Copy2DImage(int batch, Image pix, float black, float contrast, T
   int t = index.t();
   int target_height = stride_map_.Size(FD_HEIGHT);
   int target_width = stride_map_.Size(FD_WIDTH);
+  // The extent of this image in the batch. Beyond it, the elements are
+  // invalid and stay zero.
+  int valid_height = index.MaxIndexOfDim(FD_HEIGHT) + 1;
+  int valid_width = index.MaxIndexOfDim(FD_WIDTH) + 1;
   int num_features = NumFeatures();
   bool color = num_features == 3;
   if (width > target_width) {
     width = target_width;
   }
+  PixelTable table(black, contrast);
   uint32_t *line = pixGetData(pix);
   for (int y = 0; y < target_height; ++y, line += wpl) {
     int x = 0;
@@ -234,18 +259,28 @@ void NetworkIO::Copy2DImage(int batch, Image pix, float black, float contrast, T
       for (x = 0; x < width; ++x, ++t) {
         if (color) {
           int f = 0;
-          for (int c = COLOR_RED; c <= COLOR_BLUE; ++c) {
+          for (int c = COLOR_RED; c <= COLOR_BLUE; ++c, ++f) {
             int pixel = GET_DATA_BYTE(line + x, c);
-            SetPixel(t, f++, pixel, black, contrast);
+            if (int_mode_) {
+              i_[t][f] = table.int_values[pixel];
+            } else {
+              f_[t][f] = table.float_values[pixel];
+            }
           }
         } else {
           int pixel = GET_DATA_BYTE(line, x);
-          SetPixel(t, 0, pixel, black, contrast);
+          if (int_mode_) {
+            i_[t][0] = table.int_values[pixel];
+          } else {
+            f_[t][0] = table.float_values[pixel];
+          }
         }
       }
     }
-    for (; x < target_width; ++x) {
-      Randomize(t++, 0, num_features, randomizer);
+    for (; x < target_width; ++x, ++t) {
+      if (y < valid_height && x < valid_width) {
+        Randomize(t, 0, num_features, randomizer);
+      }
     }
   }
 }
@@ -267,16 +302,26 @@ void NetworkIO::Copy1DGreyImage(int batch, Image pix, float black, float contras
   if (width > target_width) {
     width = target_width;
   }
-  int x;
-  for (x = 0; x < width; ++x, ++t) {
-    for (int y = 0; y < height; ++y) {
-      uint32_t *line = pixGetData(pix) + wpl * y;
-      int pixel = GET_DATA_BYTE(line, x);
-      SetPixel(t, y, pixel, black, contrast);
+  // The width of this image in the batch. Beyond it, the elements are invalid
+  // and stay zero.
+  int valid_width = index.MaxIndexOfDim(FD_WIDTH) + 1;
+  // Each row of the image fills one feature of all the timesteps, so the
+  // image is read in memory order.
+  PixelTable table(black, contrast);
+  uint32_t *line = pixGetData(pix);
+  for (int y = 0; y < height; ++y, line += wpl) {
+    if (int_mode_) {
+      for (int x = 0; x < width; ++x) {
+        i_[t + x][y] = table.int_values[GET_DATA_BYTE(line, x)];
+      }
+    } else {
+      for (int x = 0; x < width; ++x) {
+        f_[t + x][y] = table.float_values[GET_DATA_BYTE(line, x)];
+      }
     }
   }
-  for (; x < target_width; ++x) {
-    Randomize(t++, 0, height, randomizer);
+  for (int x = width; x < valid_width; ++x) {
+    Randomize(t + x, 0, height, randomizer);
   }
 }
 
@@ -923,6 +968,24 @@ void NetworkIO::CopyWithXYTranspose(const NetworkIO &src) {
   } while (src_b_index.AddOffset(1, FD_BATCH) && dest_b_index.AddOffset(1, FD_BATCH));
 }
 
+// Copies the single image at the given batch index of src to *this, sized
+// to the valid height and width of that image, without any padding.
+void NetworkIO::CopyBatchFrom(const NetworkIO &src, int batch) {
+  StrideMap::Index src_index(src.stride_map_, batch, 0, 0);
+  int height = src_index.MaxIndexOfDim(FD_HEIGHT) + 1;
+  int width = src_index.MaxIndexOfDim(FD_WIDTH) + 1;
+  std::vector<std::pair<int, int>> h_w_pairs(1, std::make_pair(height, width));
+  StrideMap stride_map;
+  stride_map.SetStride(h_w_pairs);
+  ResizeToMap(src.int_mode(), stride_map, src.NumFeatures());
+  StrideMap::Index dest_index(stride_map_);
+  do {
+    StrideMap::Index src_t(src.stride_map_, batch, dest_index.index(FD_HEIGHT),
+                           dest_index.index(FD_WIDTH));
+    CopyTimeStepFrom(dest_index.t(), src, src_t.t());
+  } while (dest_index.Increment());
+}
+
 // Copies src to *this, at the given feature_offset, returning the total
 // feature offset after the copy. Multiple calls will stack outputs from
 // multiple sources in feature space.
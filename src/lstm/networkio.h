@@ -20,18 +20,23 @@
 
 #include "helpers.h"
 #include "image.h"
+#include "simddetect.h" // for TanhPrimeMultiply3Add
 #include "static_shape.h"
 #include "stridemap.h"
 #include "weightmatrix.h"
 
 #include <cmath>
 #include <cstdio>
+#include <type_traits> // for std::is_same
 #include <vector>
 
 struct Pix;
 
 namespace tesseract {
 
+// Derivative of the state nonlinearity, defined in functions.h.
+struct HPrime;
+
 // Class to contain all the input/output of a network, allowing for fixed or
 // variable-strided 2d to 1d mapping, and float or int8_t values. Provides
 // enough calculating functions to hide the detail of the implementation.
@@ -69,9 +74,10 @@ public:
   void FromPix(const StaticShape &shape, const Image pix, TRand *randomizer);
   // Sets up the array from the given set of images, using the currently set
   // int_mode_. If the image width doesn't match the shape, the images are
-  // truncated or padded with noise to match.
+  // truncated or padded with noise to match, drawn from the randomizer of the
+  // same index, so each image gets the noise it would get on its own.
   void FromPixes(const StaticShape &shape, const std::vector<Image> &pixes,
-                 TRand *randomizer);
+                 const std::vector<TRand *> &randomizers);
   // Copies the given pix to *this at the given batch index, stretching and
   // clipping the pixel values so that [black, black + 2*contrast] maps to the
   // dynamic range of *this, ie [-1,1] for a float and (-127,127) for int.
@@ -240,6 +246,9 @@ public:
   void CopyWithXReversal(const NetworkIO &src);
   // Copies src to *this with independent transpose of the x and y dimensions.
   void CopyWithXYTranspose(const NetworkIO &src);
+  // Copies the single image at the given batch index of src to *this, sized
+  // to the valid height and width of that image, without any padding.
+  void CopyBatchFrom(const NetworkIO &src, int batch);
   // Copies src to *this, at the given feature_offset, returning the total
   // feature offset after the copy. Multiple calls will stack outputs from
   // multiple sources in feature space.
@@ -303,6 +312,12 @@ public:
     const float *u = f_[t];
     const float *v = v_io.f_[t];
     int dim = f_.dim2();
+    if constexpr (std::is_same<Func, HPrime>::value) {
+      if (TanhPrimeMultiply3Add != nullptr) {
+        TanhPrimeMultiply3Add(dim, u, v, w, product);
+        return;
+      }
+    }
     for (int i = 0; i < dim; ++i) {
       product[i] += f(u[i]) * v[i] * w[i];
     }
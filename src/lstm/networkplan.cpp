@@ -0,0 +1,243 @@
+///////////////////////////////////////////////////////////////////////
+// File:        networkplan.cpp
+// Description: Flat execution plan for inference of a network tree.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "networkplan.h"
+
+#include "lstm.h"
+#include "networkio.h"
+#include "parallel.h"
+#include "plumbing.h"
+
+#include <utility> // for std::move
+
+namespace tesseract {
+
+// Builds the plan for network. See the header for the details.
+void NetworkPlan::Compile(Network *network) {
+  network_ = network;
+  steps_.clear();
+  num_values_ = 1;
+  num_buffers_ = 0;
+  output_is_input_ = false;
+  AssignBuffers(CompileNetwork(network, 0));
+}
+
+// Runs the network on input, putting the result in *output.
+void NetworkPlan::Run(const NetworkIO &input, NetworkScratch *scratch, NetworkIO *output) const {
+  if (output_is_input_) {
+    *output = input;
+    return;
+  }
+  std::vector<NetworkScratch::IO> buffers(num_buffers_);
+  for (auto &io : buffers) {
+    io.Resize(input, input.NumFeatures(), scratch);
+  }
+  int num_steps = steps_.size();
+  for (int s = 0; s < num_steps; ++s) {
+    Parallel *branches = steps_[s].branches;
+    if (branches == nullptr) {
+      RunStep(steps_[s], input, &buffers, scratch, output);
+      continue;
+    }
+    int first = s;
+    while (s + 1 < num_steps && steps_[s + 1].branches == branches) {
+      ++s;
+    }
+    branches->RunBranches(s + 1 - first, [&](int b) {
+      RunStep(steps_[first + b], input, &buffers, scratch, output);
+    });
+  }
+}
+
+// Runs the given step, with the intermediate buffers.
+void NetworkPlan::RunStep(const Step &step, const NetworkIO &input,
+                          std::vector<NetworkScratch::IO> *buffers, NetworkScratch *scratch,
+                          NetworkIO *output) const {
+  auto buffer = [&](int index) -> NetworkIO * {
+    return index == kOutputBuffer ? output : (*buffers)[index];
+  };
+  const NetworkIO &src = step.sources[0] == kInputBuffer ? input : *buffer(step.sources[0]);
+  NetworkIO *dest = buffer(step.dest);
+  switch (step.type) {
+    case ST_FORWARD:
+      step.layer->Forward(false, src, nullptr, scratch, dest);
+      break;
+    case ST_LSTM_X_REVERSED:
+      static_cast<LSTM *>(step.layer)->ForwardXReversed(src, scratch, dest);
+      break;
+    case ST_X_REVERSAL:
+      dest->CopyWithXReversal(src);
+      break;
+    case ST_Y_REVERSAL:
+      dest->CopyWithYReversal(src);
+      break;
+    case ST_XY_TRANSPOSE:
+      dest->CopyWithXYTranspose(src);
+      break;
+    case ST_PACK: {
+      dest->Resize(src, step.num_features);
+      int out_offset = 0;
+      for (int source : step.sources) {
+        const NetworkIO &part = source == kInputBuffer ? input : *buffer(source);
+        // All the parts must have the same width.
+        ASSERT_HOST(part.Width() == dest->Width());
+        out_offset = dest->CopyPacking(part, out_offset);
+      }
+      break;
+    }
+  }
+}
+
+// Appends the steps to compute network from the value with id source,
+// returning the id of the value that holds the result.
+int NetworkPlan::CompileNetwork(Network *network, int source) {
+  NetworkType type = network->type();
+  switch (type) {
+    case NT_INPUT:
+      // Input just copies the data, so its output is its input.
+      return source;
+    case NT_SERIES:
+      for (auto *layer : static_cast<Plumbing *>(network)->stack()) {
+        source = CompileNetwork(layer, source);
+      }
+      return source;
+    case NT_PARALLEL:
+    case NT_REPLICATED:
+    case NT_PAR_RL_LSTM:
+    case NT_PAR_UD_LSTM: {
+      size_t first_step = steps_.size();
+      std::vector<int> parts;
+      for (auto *layer : static_cast<Plumbing *>(network)->stack()) {
+        parts.push_back(CompileNetwork(layer, source));
+      }
+      // The LSTM directions can run concurrently if each is just one step,
+      // as then they only read source.
+      auto *parallel = static_cast<Parallel *>(network);
+      if (parallel->HasLSTMBranches() && steps_.size() - first_step == parts.size()) {
+        for (size_t p = 0; p < parts.size(); ++p) {
+          if (steps_[first_step + p].dest == parts[p]) {
+            steps_[first_step + p].branches = parallel;
+          }
+        }
+      }
+      return AddStep(ST_PACK, nullptr, network->NumOutputs(), std::move(parts));
+    }
+    case NT_XREVERSED:
+    case NT_YREVERSED:
+    case NT_XYTRANSPOSE: {
+      Network *reversed = static_cast<Plumbing *>(network)->stack()[0];
+      if (type == NT_XREVERSED && reversed->type() == NT_LSTM &&
+          !static_cast<LSTM *>(reversed)->Is2D()) {
+        return AddStep(ST_LSTM_X_REVERSED, reversed, 0, {source});
+      }
+      StepType reversal = ReversalType(type);
+      source = AddStep(reversal, nullptr, 0, {source});
+      source = CompileNetwork(reversed, source);
+      return AddStep(reversal, nullptr, 0, {source});
+    }
+    default:
+      // Including NT_PAR_2D_LSTM, which runs its parts concurrently.
+      return AddStep(ST_FORWARD, network, 0, {source});
+  }
+}
+
+// Appends a step with the given sources, returning the id of its result.
+int NetworkPlan::AddStep(StepType type, Network *layer, int num_features,
+                         std::vector<int> sources) {
+  if (type == ST_X_REVERSAL || type == ST_Y_REVERSAL || type == ST_XY_TRANSPOSE) {
+    // Look for the step that made the source, and if it is the same
+    // reversal, undo it by using its source instead. The step itself is
+    // dropped later if nothing else uses its result.
+    for (const auto &step : steps_) {
+      if (step.dest == sources[0] && step.type == type) {
+        return step.sources[0];
+      }
+    }
+  }
+  steps_.push_back({type, layer, num_features, std::move(sources), num_values_, nullptr});
+  return num_values_++;
+}
+
+// Returns the reversal step type that the given Reversed type makes.
+NetworkPlan::StepType NetworkPlan::ReversalType(NetworkType type) {
+  if (type == NT_XREVERSED) {
+    return ST_X_REVERSAL;
+  }
+  if (type == NT_YREVERSED) {
+    return ST_Y_REVERSAL;
+  }
+  return ST_XY_TRANSPOSE;
+}
+
+// Replaces the value ids by buffer indices, reusing a buffer as soon as the
+// last step that reads its value is done.
+void NetworkPlan::AssignBuffers(int result) {
+  // Drop the steps whose results are never used, working backwards so that
+  // their sources can be dropped as well.
+  std::vector<bool> used(num_values_, false);
+  used[result] = true;
+  for (int s = steps_.size() - 1; s >= 0; --s) {
+    if (used[steps_[s].dest]) {
+      for (int source : steps_[s].sources) {
+        used[source] = true;
+      }
+    } else {
+      steps_.erase(steps_.begin() + s);
+    }
+  }
+  if (steps_.empty()) {
+    output_is_input_ = true;
+    return;
+  }
+  // The result is made by the last step, straight into the output.
+  ASSERT_HOST(steps_.back().dest == result);
+  std::vector<int> last_use(num_values_, -1);
+  for (size_t s = 0; s < steps_.size(); ++s) {
+    for (int source : steps_[s].sources) {
+      last_use[source] = s;
+    }
+  }
+  // Buffer index holding each value, and whether each buffer is free.
+  std::vector<int> value_buffers(num_values_, kInputBuffer);
+  std::vector<bool> free_buffers;
+  for (size_t s = 0; s < steps_.size(); ++s) {
+    Step &step = steps_[s];
+    // The destination is chosen before freeing the sources, as no step can
+    // write to a buffer that it reads.
+    int dest = kOutputBuffer;
+    if (step.dest != result) {
+      dest = 0;
+      while (dest < num_buffers_ && !free_buffers[dest]) {
+        ++dest;
+      }
+      if (dest == num_buffers_) {
+        ++num_buffers_;
+        free_buffers.push_back(false);
+      }
+      free_buffers[dest] = false;
+    }
+    for (int &source : step.sources) {
+      int value = source;
+      source = value_buffers[value];
+      if (last_use[value] == static_cast<int>(s) && source >= 0) {
+        free_buffers[source] = true;
+      }
+    }
+    value_buffers[step.dest] = dest;
+    step.dest = dest;
+  }
+}
+
+} // namespace tesseract.
@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////
+// File:        networkplan.h
+// Description: Flat execution plan for inference of a network tree.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_LSTM_NETWORKPLAN_H_
+#define TESSERACT_LSTM_NETWORKPLAN_H_
+
+#include "network.h"
+#include "networkscratch.h"
+
+#include <vector>
+
+namespace tesseract {
+
+class Parallel;
+
+// Inference-only replacement for Network::Forward of a whole network tree.
+// Compile flattens the Series, Parallel and Reversed plumbing into a list of
+// steps that run the layers that compute something, and works out in
+// advance how many intermediate buffers are needed and which step uses
+// which, so Run makes no recursive calls and borrows each buffer from the
+// scratch just once. Along the way:
+// The copies made by Input layers are elided.
+// An x-reversed 1-d LSTM runs from right to left over its input, instead of
+// over a reversed copy of it, giving its output already in place.
+// Reversals that undo each other are both dropped.
+// The directions of a bidirectional LSTM, if each is a single step, run
+// concurrently, as Parallel::Forward does.
+// Anything else runs with its own Forward, so the result of Run is always
+// the same as that of Forward, without debug.
+// A plan holds no state of its own, so it can be shared by threads that run
+// it at the same time, each with its own NetworkScratch.
+class TESS_API NetworkPlan {
+public:
+  NetworkPlan() = default;
+
+  // Builds the plan for network, which must stay alive and unchanged, other
+  // than its weights, for as long as the plan is used.
+  void Compile(Network *network);
+  // Returns the network that the plan was compiled from, or nullptr.
+  const Network *network() const {
+    return network_;
+  }
+  // Returns the number of steps that Run executes.
+  int num_steps() const {
+    return steps_.size();
+  }
+  // Returns the number of intermediate buffers that Run uses.
+  int num_buffers() const {
+    return num_buffers_;
+  }
+
+  // Runs the network on input, putting the result in *output, as
+  // network()->Forward(false, input, nullptr, scratch, output) would.
+  void Run(const NetworkIO &input, NetworkScratch *scratch, NetworkIO *output) const;
+
+private:
+  enum StepType {
+    ST_FORWARD,           // Forward of layer.
+    ST_LSTM_X_REVERSED,   // ForwardXReversed of an LSTM layer.
+    ST_X_REVERSAL,        // Copy reversed in x.
+    ST_Y_REVERSAL,        // Copy reversed in y.
+    ST_XY_TRANSPOSE,      // Copy with x and y transposed.
+    ST_PACK,              // Copy the sources side by side in the features.
+  };
+  // Special buffer indices.
+  static const int kInputBuffer = -1;
+  static const int kOutputBuffer = -2;
+  struct Step {
+    StepType type;
+    // The layer to run, for ST_FORWARD and ST_LSTM_X_REVERSED.
+    Network *layer;
+    // Number of output features, for ST_PACK.
+    int num_features;
+    // Values read, more than one only for ST_PACK. While compiling, these
+    // are value ids, later replaced by buffer indices.
+    std::vector<int> sources;
+    // Value written, later replaced by a buffer index.
+    int dest;
+    // If not null, the step is a branch of this bidirectional LSTM, and it
+    // runs concurrently with the adjacent steps of the same branches.
+    Parallel *branches;
+  };
+
+  // Appends the steps to compute network from the value with id source,
+  // returning the id of the value that holds the result.
+  int CompileNetwork(Network *network, int source);
+  // Appends a step with the given sources, returning the id of its result.
+  int AddStep(StepType type, Network *layer, int num_features, std::vector<int> sources);
+  // Runs the given step, with the intermediate buffers.
+  void RunStep(const Step &step, const NetworkIO &input,
+               std::vector<NetworkScratch::IO> *buffers, NetworkScratch *scratch,
+               NetworkIO *output) const;
+  // Returns the reversal step type that the given Reversed type makes.
+  static StepType ReversalType(NetworkType type);
+  // Replaces the value ids by buffer indices, reusing a buffer as soon as
+  // the last step that reads its value is done.
+  void AssignBuffers(int result);
+
+  // The network that the plan was compiled from.
+  const Network *network_ = nullptr;
+  std::vector<Step> steps_;
+  // Number of value ids handed out so far, of which 0 is the input.
+  int num_values_ = 0;
+  // Number of intermediate buffers used by the steps.
+  int num_buffers_ = 0;
+  // True if the output is just a copy of the input.
+  bool output_is_input_ = false;
+};
+
+} // namespace tesseract.
+
+#endif // TESSERACT_LSTM_NETWORKPLAN_H_
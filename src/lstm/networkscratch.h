@@ -25,6 +25,8 @@
 
 namespace tesseract {
 
+class TRand;
+
 // Generic scratch space for network layers. Provides NetworkIO that can store
 // a complete set (over time) of intermediates, and vector<float>
 // scratch space that auto-frees after use. The aim here is to provide a set
@@ -32,7 +34,7 @@ namespace tesseract {
 // and don't have to be reallocated on each call.
 class NetworkScratch {
 public:
-  NetworkScratch() : int_mode_(false) {}
+  NetworkScratch() : int_mode_(false), randomizer_(nullptr) {}
   ~NetworkScratch() = default;
 
   // Sets the network representation. If the representation is integer, then
@@ -44,6 +46,31 @@ public:
     int_mode_ = int_mode;
   }
 
+  // Sets the random number generator to be used by the network layers in
+  // place of their own, so that networks can run concurrently on different
+  // threads, each with its own NetworkScratch, with reproducible results.
+  void set_randomizer(TRand *randomizer) {
+    randomizer_ = randomizer;
+  }
+  TRand *randomizer() const {
+    return randomizer_;
+  }
+  // Sets one random number generator per FD_BATCH element of the inputs, to
+  // be used in place of randomizer_, so that each line of a batch sees the
+  // same random sequence as it would if it were run on its own. The
+  // generators are borrowed, and an empty vector turns the feature off.
+  void set_batch_randomizers(const std::vector<TRand *> &randomizers) {
+    batch_randomizers_ = randomizers;
+  }
+  // Returns the random number generator for the given batch element, or
+  // randomizer_ if there are no per-batch generators.
+  TRand *randomizer(int batch) const {
+    if (batch < static_cast<int>(batch_randomizers_.size())) {
+      return batch_randomizers_[batch];
+    }
+    return randomizer_;
+  }
+
   // Class that acts like a NetworkIO (by having an implicit cast operator),
   // yet actually holds a pointer to NetworkIOs in the source NetworkScratch,
   // and knows how to unstack the borrowed pointers on destruction.
@@ -266,6 +293,10 @@ public:
 private:
   // If true, the network weights are int8_t, if false, float.
   bool int_mode_;
+  // If not null, overrides the randomizer_ of the network layers.
+  TRand *randomizer_;
+  // If not empty, overrides randomizer_, one per batch element.
+  std::vector<TRand *> batch_randomizers_;
   // Stacks of NetworkIO and vector<float>. Once allocated, they are not
   // deleted until the NetworkScratch is deleted.
   Stack<NetworkIO> int_stack_;
@@ -27,14 +27,25 @@
 
 #include "functions.h" // For conditional undef of _OPENMP.
 #include "networkscratch.h"
+#include "threadteam.h"
+
+#include <algorithm> // for std::min
+#include <thread>    // for std::thread
 
 namespace tesseract {
 
+INT_VAR(lstm_branch_threads, 0,
+        "Number of threads for the directions of a bidirectional or 2-d LSTM:"
+        " 0 or 1 = one after the other, >1 = concurrently on a persistent"
+        " thread team");
+
 // ni_ and no_ will be set by AddToStack.
 Parallel::Parallel(const std::string &name, NetworkType type) : Plumbing(name) {
   type_ = type;
 }
 
+Parallel::~Parallel() = default;
+
 // Returns the shape output from the network given an input shape (which may
 // be partially unknown ie zero).
 StaticShape Parallel::OutputShape(const StaticShape &input_shape) const {
@@ -59,17 +70,25 @@ void Parallel::Forward(bool debug, const NetworkIO &input, const TransposedArray
     debug = false;
   }
   int stack_size = stack_.size();
-  if (type_ == NT_PAR_2D_LSTM) {
-    // Special case, run parallel in parallel.
+  if (type_ == NT_PAR_2D_LSTM || (HasLSTMBranches() && lstm_branch_threads > 1)) {
+    // Special case, run parallel in parallel. The scratch is safe to share
+    // between the threads, and LSTMs do not use its randomizer.
     std::vector<NetworkScratch::IO> results(stack_size);
     for (int i = 0; i < stack_size; ++i) {
       results[i].Resize(input, stack_[i]->NumOutputs(), scratch);
     }
+    auto run_branch = [&](int i) {
+      stack_[i]->Forward(debug, input, nullptr, scratch, results[i]);
+    };
+    if (lstm_branch_threads > 1) {
+      RunBranches(stack_size, run_branch);
+    } else {
 #ifdef _OPENMP
 #  pragma omp parallel for num_threads(stack_size)
 #endif
-    for (int i = 0; i < stack_size; ++i) {
-      stack_[i]->Forward(debug, input, nullptr, scratch, results[i]);
+      for (int i = 0; i < stack_size; ++i) {
+        run_branch(i);
+      }
     }
     // Now pack all the results (serially) into the output.
     int out_offset = 0;
@@ -108,6 +127,30 @@ void Parallel::Forward(bool debug, const NetworkIO &input, const TransposedArray
 #endif
 }
 
+// Runs branch(i) for each i in [0, num_branches), concurrently if
+// lstm_branch_threads > 1. See the header for the details.
+void Parallel::RunBranches(int num_branches, const std::function<void(int)> &branch) {
+  // The team can only run one job at a time, so if it is already in use by
+  // another thread running the same network, the branches run in turn.
+  std::unique_lock<std::mutex> team_lock(branch_team_mutex_, std::try_to_lock);
+  if (lstm_branch_threads <= 1 || !team_lock.owns_lock()) {
+    for (int i = 0; i < num_branches; ++i) {
+      branch(i);
+    }
+    return;
+  }
+  // More threads than CPUs or branches would only wait for each other.
+  int num_threads = std::min(static_cast<int>(lstm_branch_threads), num_branches);
+  int num_cpus = std::thread::hardware_concurrency();
+  if (num_cpus > 0) {
+    num_threads = std::min(num_threads, num_cpus);
+  }
+  if (branch_team_ == nullptr || branch_team_->size() != num_threads) {
+    branch_team_ = std::make_unique<ThreadTeam>(num_threads);
+  }
+  branch_team_->Run(num_branches, branch);
+}
+
 // Runs backward propagation of errors on the deltas line.
 // See NetworkCpp for a detailed discussion of the arguments.
 bool Parallel::Backward(bool debug, const NetworkIO &fwd_deltas, NetworkScratch *scratch,
@@ -18,16 +18,29 @@
 #ifndef TESSERACT_LSTM_PARALLEL_H_
 #define TESSERACT_LSTM_PARALLEL_H_
 
+#include "params.h"
 #include "plumbing.h"
 
+#include <functional> // for std::function
+#include <memory>     // for std::unique_ptr
+#include <mutex>      // for std::mutex
+
 namespace tesseract {
 
+class ThreadTeam;
+
+// Number of threads used to run the independent directions of a
+// bidirectional or 2-d LSTM layer. 0 or 1 runs them in turn, or for 2-d
+// with OpenMP if available.
+extern TESS_API INT_VAR_H(lstm_branch_threads);
+
 // Runs multiple networks in parallel, interlacing their outputs.
 class Parallel : public Plumbing {
 public:
   // ni_ and no_ will be set by AddToStack.
   TESS_API
   Parallel(const std::string &name, NetworkType type);
+  ~Parallel() override;
 
   // Returns the shape output from the network given an input shape (which may
   // be partially unknown ie zero).
@@ -70,6 +83,16 @@ public:
   bool Backward(bool debug, const NetworkIO &fwd_deltas, NetworkScratch *scratch,
                 NetworkIO *back_deltas) override;
 
+  // Returns true if the networks of the stack are independent LSTM
+  // directions, which may run concurrently.
+  bool HasLSTMBranches() const {
+    return type_ == NT_PAR_RL_LSTM || type_ == NT_PAR_UD_LSTM || type_ == NT_PAR_2D_LSTM;
+  }
+  // Runs branch(i) for each i in [0, num_branches), concurrently on a team of
+  // lstm_branch_threads threads, or in turn if that is 1 or less, or if
+  // another thread is already using the team of *this.
+  void RunBranches(int num_branches, const std::function<void(int)> &branch);
+
 private:
   // If *this is a NT_REPLICATED, then it feeds a replicated network with
   // identical inputs, and it would be extremely wasteful for them to each
@@ -77,6 +100,10 @@ private:
   // and passes a pointer to the replicated network, allowing it to use the
   // transpose on the next call to Backward.
   TransposedArray transposed_input_;
+  // Persistent threads that run the branches if lstm_branch_threads > 1.
+  std::unique_ptr<ThreadTeam> branch_team_;
+  // Held by the RunBranches that is using branch_team_.
+  std::mutex branch_team_mutex_;
 };
 
 } // namespace tesseract.
@@ -264,4 +264,40 @@ void Plumbing::CountAlternators(const Network &other, TFloat *same, TFloat *chan
   }
 }
 
+// Adds the weight deltas of other, a replica of *this, to those of *this.
+void Plumbing::AddDeltas(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const auto *plumbing = static_cast<const Plumbing *>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (size_t i = 0; i < stack_.size(); ++i) {
+    if (stack_[i]->IsTraining()) {
+      stack_[i]->AddDeltas(*plumbing->stack_[i]);
+    }
+  }
+}
+
+// Replaces the weight deltas of *this with those of other.
+void Plumbing::CopyDeltas(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const auto *plumbing = static_cast<const Plumbing *>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (size_t i = 0; i < stack_.size(); ++i) {
+    if (stack_[i]->IsTraining()) {
+      stack_[i]->CopyDeltas(*plumbing->stack_[i]);
+    }
+  }
+}
+
+// Replaces the weights of *this with those of other.
+void Plumbing::CopyWeights(const Network &other) {
+  ASSERT_HOST(other.type() == type_);
+  const auto *plumbing = static_cast<const Plumbing *>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (size_t i = 0; i < stack_.size(); ++i) {
+    if (stack_[i]->IsTraining()) {
+      stack_[i]->CopyWeights(*plumbing->stack_[i]);
+    }
+  }
+}
+
 } // namespace tesseract.
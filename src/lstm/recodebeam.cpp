@@ -21,9 +21,10 @@
 
 #include "networkio.h"
 #include "pageres.h"
+#include "simddetect.h"
 #include "unicharcompress.h"
 
-#include <algorithm> // for std::reverse
+#include <algorithm> // for std::binary_search, std::reverse, std::sort, std::unique
 
 namespace tesseract {
 
@@ -59,6 +60,10 @@ RecodeBeamSearch::RecodeBeamSearch(const UnicharCompress &recoder,
                                    int null_char, bool simple_text, Dict *dict)
     : recoder_(recoder),
       beam_size_(0),
+      dawgs_used_(0),
+      counted_steps_(0),
+      line_nodes_(0),
+      peak_nodes_(0),
       top_code_(-1),
       second_code_(-1),
       dict_(dict),
@@ -83,7 +88,7 @@ RecodeBeamSearch::~RecodeBeamSearch() {
 void RecodeBeamSearch::Decode(const NetworkIO &output, double dict_ratio,
                               double cert_offset, double worst_dict_cert,
                               const UNICHARSET *charset, int lstm_choice_mode) {
-  beam_size_ = 0;
+  DecodeBegin();
   int width = output.Width();
   if (lstm_choice_mode) {
     timesteps.clear();
@@ -96,17 +101,80 @@ void RecodeBeamSearch::Decode(const NetworkIO &output, double dict_ratio,
       SaveMostCertainChoices(output.f(t), output.NumFeatures(), charset, t);
     }
   }
+  UpdatePeakNodes();
 }
 void RecodeBeamSearch::Decode(const GENERIC_2D_ARRAY<float> &output,
                               double dict_ratio, double cert_offset,
                               double worst_dict_cert,
                               const UNICHARSET *charset) {
-  beam_size_ = 0;
+  DecodeBegin();
   int width = output.dim1();
   for (int t = 0; t < width; ++t) {
     ComputeTopN(output[t], output.dim2(), kBeamWidths[0]);
     DecodeStep(output[t], t, dict_ratio, cert_offset, worst_dict_cert, charset);
   }
+  UpdatePeakNodes();
+}
+
+// Starts the decoding of a line whose outputs arrive a piece at a time.
+void RecodeBeamSearch::DecodeBegin() {
+  beam_size_ = 0;
+  counted_steps_ = 0;
+  line_nodes_ = 0;
+  ResetDawgStorage();
+}
+
+// Decodes the timesteps [start, end) of output as the next timesteps of the
+// line started by DecodeBegin.
+void RecodeBeamSearch::DecodeMore(const NetworkIO &output, int start, int end,
+                                  double dict_ratio, double cert_offset,
+                                  double worst_dict_cert,
+                                  const UNICHARSET *charset) {
+  for (int t = start; t < end; ++t) {
+    ComputeTopN(output.f(t), output.NumFeatures(), kBeamWidths[0]);
+    DecodeStep(output.f(t), beam_size_, dict_ratio, cert_offset,
+               worst_dict_cert, charset);
+  }
+  UpdatePeakNodes();
+}
+
+// Returns the unichar-ids of the start of the line decoded so far that all of
+// the paths in the beam have in common.
+int RecodeBeamSearch::ExtractStableUnicharIds(
+    std::vector<int> *unichar_ids) const {
+  unichar_ids->clear();
+  if (beam_size_ == 0) {
+    return 0;
+  }
+  // Every node of a timestep continues a node of the previous timestep, so
+  // follow the paths back together until they meet.
+  std::vector<const RecodeNode *> nodes;
+  for (auto &beam : beam_[beam_size_ - 1]->beams_) {
+    for (auto &entry : beam.heap()) {
+      nodes.push_back(&entry.data());
+    }
+  }
+  int t = beam_size_ - 1;
+  while (!nodes.empty() && t >= 0) {
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    if (nodes.size() == 1) {
+      break;
+    }
+    for (auto &node : nodes) {
+      node = node->prev;
+    }
+    --t;
+  }
+  if (nodes.size() != 1 || nodes[0] == nullptr) {
+    return 0;
+  }
+  std::vector<const RecodeNode *> path;
+  ExtractPath(nodes[0], &path);
+  std::vector<float> certs, ratings;
+  std::vector<int> xcoords;
+  ExtractPathAsUnicharIds(path, unichar_ids, &certs, &ratings, &xcoords);
+  return t + 1;
 }
 
 void RecodeBeamSearch::DecodeSecondaryBeams(
@@ -671,48 +739,37 @@ WERD_RES *RecodeBeamSearch::InitializeWord(bool leading_space,
 // is one of the top_n.
 void RecodeBeamSearch::ComputeTopN(const float *outputs, int num_outputs,
                                    int top_n) {
-  top_n_flags_.clear();
-  top_n_flags_.resize(num_outputs, TN_ALSO_RAN);
-  top_code_ = -1;
-  second_code_ = -1;
-  top_heap_.clear();
+  ResetTopN(num_outputs);
   for (int i = 0; i < num_outputs; ++i) {
-    if (top_heap_.size() < top_n || outputs[i] > top_heap_.PeekTop().key()) {
-      TopPair entry(outputs[i], i);
-      top_heap_.Push(&entry);
-      if (top_heap_.size() > top_n) {
-        top_heap_.Pop(&entry);
+    if (top_heap_.size() >= top_n) {
+      // Skip the outputs that can't make it into the full heap.
+      i += FirstAbove(outputs + i, num_outputs - i, top_heap_.PeekTop().key());
+      if (i == num_outputs) {
+        break;
       }
     }
-  }
-  while (!top_heap_.empty()) {
-    TopPair entry;
-    top_heap_.Pop(&entry);
-    if (top_heap_.size() > 1) {
-      top_n_flags_[entry.data()] = TN_TOPN;
-    } else {
-      top_n_flags_[entry.data()] = TN_TOP2;
-      if (top_heap_.empty()) {
-        top_code_ = entry.data();
-      } else {
-        second_code_ = entry.data();
-      }
+    TopPair entry(outputs[i], i);
+    top_heap_.Push(&entry);
+    if (top_heap_.size() > top_n) {
+      top_heap_.Pop(&entry);
     }
   }
-  top_n_flags_[null_char_] = TN_TOP2;
+  SetTopNFromHeap();
 }
 
 void RecodeBeamSearch::ComputeSecTopN(std::unordered_set<int> *exList,
                                       const float *outputs, int num_outputs,
                                       int top_n) {
-  top_n_flags_.clear();
-  top_n_flags_.resize(num_outputs, TN_ALSO_RAN);
-  top_code_ = -1;
-  second_code_ = -1;
-  top_heap_.clear();
+  ResetTopN(num_outputs);
   for (int i = 0; i < num_outputs; ++i) {
-    if ((top_heap_.size() < top_n || outputs[i] > top_heap_.PeekTop().key()) &&
-        !exList->count(i)) {
+    if (top_heap_.size() >= top_n) {
+      // Skip the outputs that can't make it into the full heap.
+      i += FirstAbove(outputs + i, num_outputs - i, top_heap_.PeekTop().key());
+      if (i == num_outputs) {
+        break;
+      }
+    }
+    if (!exList->count(i)) {
       TopPair entry(outputs[i], i);
       top_heap_.Push(&entry);
       if (top_heap_.size() > top_n) {
@@ -720,6 +777,33 @@ void RecodeBeamSearch::ComputeSecTopN(std::unordered_set<int> *exList,
       }
     }
   }
+  SetTopNFromHeap();
+}
+
+// Clears the top_n_flags_ and top_n_codes_ set by the previous timestep,
+// ready for top_heap_ to be filled for the current one.
+void RecodeBeamSearch::ResetTopN(int num_outputs) {
+  if (top_n_flags_.size() != static_cast<size_t>(num_outputs)) {
+    top_n_flags_.clear();
+    top_n_flags_.resize(num_outputs, TN_ALSO_RAN);
+  } else {
+    for (auto &codes : top_n_codes_) {
+      for (int code : codes) {
+        top_n_flags_[code] = TN_ALSO_RAN;
+      }
+    }
+  }
+  for (auto &codes : top_n_codes_) {
+    codes.clear();
+  }
+  top_code_ = -1;
+  second_code_ = -1;
+  top_heap_.clear();
+}
+
+// Sets top_n_flags_, top_n_codes_ and the top/second codes from top_heap_,
+// emptying it.
+void RecodeBeamSearch::SetTopNFromHeap() {
   while (!top_heap_.empty()) {
     TopPair entry;
     top_heap_.Pop(&entry);
@@ -733,8 +817,36 @@ void RecodeBeamSearch::ComputeSecTopN(std::unordered_set<int> *exList,
         second_code_ = entry.data();
       }
     }
+    if (entry.data() != null_char_) {
+      top_n_codes_[top_n_flags_[entry.data()]].push_back(entry.data());
+    }
   }
   top_n_flags_[null_char_] = TN_TOP2;
+  top_n_codes_[TN_TOP2].push_back(null_char_);
+  for (auto &codes : top_n_codes_) {
+    std::sort(codes.begin(), codes.end());
+  }
+}
+
+// Returns the codes from the given increasing list that may have the given
+// top_n_flag, in increasing order.
+const std::vector<int> &RecodeBeamSearch::CodesWithFlag(
+    const std::vector<int> &codes, TopNState top_n_flag) {
+  if (top_n_flag == TN_ALSO_RAN) {
+    return codes;
+  }
+  const std::vector<int> &top_codes = top_n_codes_[top_n_flag];
+  // Short lists are cheaper to scan than to search.
+  if (codes.size() <= 4 * top_codes.size()) {
+    return codes;
+  }
+  flagged_codes_.clear();
+  for (int code : top_codes) {
+    if (std::binary_search(codes.begin(), codes.end(), code)) {
+      flagged_codes_.push_back(code);
+    }
+  }
+  return flagged_codes_;
 }
 
 // Adds the computation for the current time-step to the beam. Call at each
@@ -941,7 +1053,7 @@ void RecodeBeamSearch::ContinueContext(
   }
   const std::vector<int> *final_codes = recoder_.GetFinalCodes(prefix);
   if (final_codes != nullptr) {
-    for (int code : *final_codes) {
+    for (int code : CodesWithFlag(*final_codes, top_n_flag)) {
       if (top_n_flags_[code] != top_n_flag) {
         continue;
       }
@@ -980,7 +1092,7 @@ void RecodeBeamSearch::ContinueContext(
   }
   const std::vector<int> *next_codes = recoder_.GetNextCodes(prefix);
   if (next_codes != nullptr) {
-    for (int code : *next_codes) {
+    for (int code : CodesWithFlag(*next_codes, top_n_flag)) {
       if (top_n_flags_[code] != top_n_flag) {
         continue;
       }
@@ -1100,7 +1212,7 @@ void RecodeBeamSearch::ContinueDawg(int code, int unichar_id, float cert,
     return; // Can't break words between space delimited chars.
   }
   DawgPositionVector initial_dawgs;
-  auto *updated_dawgs = new DawgPositionVector;
+  DawgPositionVector *updated_dawgs = NewDawgs();
   DawgArgs dawg_args(&initial_dawgs, updated_dawgs, NO_PERM);
   bool word_start = false;
   if (uni_prev == nullptr) {
@@ -1131,7 +1243,7 @@ void RecodeBeamSearch::ContinueDawg(int code, int unichar_id, float cert,
                        nodawg_heap);
     }
   } else {
-    delete updated_dawgs;
+    UnusedDawgs(updated_dawgs);
   }
 }
 
@@ -1150,7 +1262,7 @@ void RecodeBeamSearch::PushInitialDawgIfBetter(int code, int unichar_id,
     score += prev->score;
   }
   if (best_initial_dawg->code < 0 || score > best_initial_dawg->score) {
-    auto *initial_dawgs = new DawgPositionVector;
+    DawgPositionVector *initial_dawgs = NewDawgs();
     dict_->default_dawgs(initial_dawgs, false);
     RecodeNode node(code, unichar_id, permuter, true, start, end, false, cert,
                     score, prev, initial_dawgs,
@@ -1206,12 +1318,11 @@ void RecodeBeamSearch::PushHeapIfBetter(int max_size, int code, int unichar_id,
     }
     RecodePair entry(score, node);
     heap->Push(&entry);
-    ASSERT_HOST(entry.data().dawgs == nullptr);
     if (heap->size() > max_size) {
       heap->Pop(&entry);
     }
-  } else {
-    delete d;
+  } else if (d != nullptr) {
+    UnusedDawgs(d);
   }
 }
 
@@ -1225,7 +1336,6 @@ void RecodeBeamSearch::PushHeapIfBetter(int max_size, RecodeNode *node,
     }
     RecodePair entry(node->score, *node);
     heap->Push(&entry);
-    ASSERT_HOST(entry.data().dawgs == nullptr);
     if (heap->size() > max_size) {
       heap->Pop(&entry);
     }
@@ -1258,6 +1368,60 @@ bool RecodeBeamSearch::UpdateHeapIfMatched(RecodeNode *new_node,
   return false;
 }
 
+// Starts a new line, making all of the dawg storage available again.
+void RecodeBeamSearch::ResetDawgStorage() {
+  dawgs_used_ = 0;
+}
+
+// Returns a cleared DawgPositionVector from the dawg storage, which stays
+// valid until the next ResetDawgStorage.
+DawgPositionVector *RecodeBeamSearch::NewDawgs() {
+  if (dawgs_used_ == static_cast<int>(dawg_storage_.size())) {
+    dawg_storage_.push_back(std::make_unique<DawgPositionVector>());
+  }
+  DawgPositionVector *dawgs = dawg_storage_[dawgs_used_++].get();
+  dawgs->clear();
+  return dawgs;
+}
+
+// Returns the DawgPositionVector from the last call to NewDawgs to the dawg
+// storage, if it ended up not being used.
+void RecodeBeamSearch::UnusedDawgs(const DawgPositionVector *dawgs) {
+  if (dawgs_used_ > 0 && dawg_storage_[dawgs_used_ - 1].get() == dawgs) {
+    --dawgs_used_;
+  }
+}
+
+// Records the number of nodes in the beams of the current line. The beams of
+// the timesteps already counted don't change, so only the new ones are added.
+void RecodeBeamSearch::UpdatePeakNodes() {
+  for (; counted_steps_ < beam_size_; ++counted_steps_) {
+    for (auto &beam : beam_[counted_steps_]->beams_) {
+      line_nodes_ += beam.size();
+    }
+  }
+  peak_nodes_ = std::max(peak_nodes_, line_nodes_);
+}
+
+// Returns the peak sizes of the storage that is kept from one line to the
+// next.
+RecodeBeamSearch::StorageStats RecodeBeamSearch::GetStorageStats() const {
+  StorageStats stats;
+  stats.timesteps = beam_.size();
+  stats.nodes = peak_nodes_;
+  stats.dawg_vectors = dawg_storage_.size();
+  for (auto *step : beam_) {
+    stats.bytes += sizeof(*step);
+    for (auto &beam : step->beams_) {
+      stats.bytes += beam.heap().capacity() * sizeof(RecodePair);
+    }
+  }
+  for (auto &dawgs : dawg_storage_) {
+    stats.bytes += sizeof(*dawgs) + dawgs->capacity() * sizeof(DawgPosition);
+  }
+  return stats;
+}
+
 // Computes and returns the code-hash for the given code and prev.
 uint64_t RecodeBeamSearch::ComputeCodeHash(int code, bool dup,
                                            const RecodeNode *prev) const {
@@ -29,6 +29,7 @@
 #include "ratngs.h"
 #include "unicharcompress.h"
 
+#include <memory>        // for std::unique_ptr
 #include <unordered_set> // for std::unordered_set
 #include <vector>        // for std::vector
 
@@ -118,24 +119,6 @@ struct RecodeNode {
       , prev(p)
       , dawgs(d)
       , code_hash(hash) {}
-  // NOTE: If we could use C++11, then this would be a move constructor.
-  // Instead we have copy constructor that does a move!! This is because we
-  // don't want to copy the whole DawgPositionVector each time, and true
-  // copying isn't necessary for this struct. It does get moved around a lot
-  // though inside the heap and during heap push, hence the move semantics.
-  RecodeNode(const RecodeNode &src) : dawgs(nullptr) {
-    *this = src;
-    ASSERT_HOST(src.dawgs == nullptr);
-  }
-  RecodeNode &operator=(const RecodeNode &src) {
-    delete dawgs;
-    memcpy(this, &src, sizeof(src));
-    ((RecodeNode &)src).dawgs = nullptr;
-    return *this;
-  }
-  ~RecodeNode() {
-    delete dawgs;
-  }
   // Prints details of the node.
   void Print(int null_char, const UNICHARSET &unicharset, int depth) const;
 
@@ -167,7 +150,8 @@ struct RecodeNode {
   float score;
   // The previous node in this chain. Borrowed pointer.
   const RecodeNode *prev;
-  // The currently active dawgs at this position. Owned pointer.
+  // The currently active dawgs at this position. Borrowed pointer to the
+  // dawg storage of the RecodeBeamSearch, which is reused for each line.
   DawgPositionVector *dawgs;
   // A hash of all codes in the prefix and this->code as well. Used for
   // duplicate path removal.
@@ -191,6 +175,20 @@ public:
   void Decode(const GENERIC_2D_ARRAY<float> &output, double dict_ratio, double cert_offset,
               double worst_dict_cert, const UNICHARSET *charset);
 
+  // Decodes a line whose network outputs arrive a piece at a time, as with
+  // streaming input: DecodeBegin starts the line, then each call to
+  // DecodeMore decodes the timesteps [start, end) of output as the next
+  // timesteps of the line. Decode is the same as DecodeBegin, followed by a
+  // single DecodeMore with all of the output.
+  void DecodeBegin();
+  void DecodeMore(const NetworkIO &output, int start, int end, double dict_ratio,
+                  double cert_offset, double worst_dict_cert, const UNICHARSET *charset);
+  // Returns the unichar-ids of the start of the line decoded so far that all
+  // of the paths in the beam have in common, and so will be the start of the
+  // best path however the line continues. Returns the number of timesteps
+  // that they cover.
+  int ExtractStableUnicharIds(std::vector<int> *unichar_ids) const;
+
   void DecodeSecondaryBeams(const NetworkIO &output, double dict_ratio, double cert_offset,
                             double worst_dict_cert, const UNICHARSET *charset,
                             int lstm_choice_mode = 0);
@@ -208,6 +206,20 @@ public:
                               const UNICHARSET *unicharset, PointerVector<WERD_RES> *words,
                               int lstm_choice_mode = 0);
 
+  // Sizes of the storage that is kept from one line to the next, instead of
+  // being freed, for sizing it. All are peaks over the lines decoded so far.
+  struct StorageStats {
+    // RecodeBeams, one per timestep of the longest line.
+    int timesteps = 0;
+    // RecodeNodes held in the beams of a line.
+    int nodes = 0;
+    // DawgPositionVectors used by a line.
+    int dawg_vectors = 0;
+    // Bytes reserved for all of the above.
+    size_t bytes = 0;
+  };
+  StorageStats GetStorageStats() const;
+
   // Generates debug output of the content of the beams after a Decode.
   void DebugBeams(const UNICHARSET &unicharset) const;
 
@@ -318,6 +330,17 @@ private:
 
   void ComputeSecTopN(std::unordered_set<int> *exList, const float *outputs, int num_outputs,
                       int top_n);
+  // Clears the top_n_flags_ and top_n_codes_ set by the previous timestep,
+  // ready for top_heap_ to be filled for the current one.
+  void ResetTopN(int num_outputs);
+  // Sets top_n_flags_, top_n_codes_ and the top/second codes from top_heap_,
+  // emptying it.
+  void SetTopNFromHeap();
+  // Returns the codes from the given increasing list that may have the given
+  // top_n_flag, in increasing order. Except for TN_ALSO_RAN, these are looked
+  // up from the few top_n_codes_, so continuing a context doesn't cost the
+  // length of a long list, such as the first codes of a CJK model.
+  const std::vector<int> &CodesWithFlag(const std::vector<int> &codes, TopNState top_n_flag);
 
   // Adds the computation for the current time-step to the beam. Call at each
   // time-step in sequence from left to right. outputs is the activation vector
@@ -374,6 +397,16 @@ private:
   // Searches the heap for an entry matching new_node, and updates the entry
   // with reshuffle if needed. Returns true if there was a match.
   bool UpdateHeapIfMatched(RecodeNode *new_node, RecodeHeap *heap);
+  // Starts a new line, making all of the dawg storage available again.
+  void ResetDawgStorage();
+  // Returns a cleared DawgPositionVector from the dawg storage, which stays
+  // valid until the next ResetDawgStorage.
+  DawgPositionVector *NewDawgs();
+  // Returns the DawgPositionVector from the last call to NewDawgs to the dawg
+  // storage, if it ended up not being used.
+  void UnusedDawgs(const DawgPositionVector *dawgs);
+  // Records the number of nodes in the beams of the current line.
+  void UpdatePeakNodes();
   // Computes and returns the code-hash for the given code and prev.
   uint64_t ComputeCodeHash(int code, bool dup, const RecodeNode *prev) const;
   // Backtracks to extract the best path through the lattice that was built
@@ -404,9 +437,27 @@ private:
   std::vector<RecodeBeam *> secondary_beam_;
   // The number of timesteps valid in beam_;
   int beam_size_;
+  // Storage for the dawgs of the RecodeNodes in beam_ and secondary_beam_.
+  // The vectors are cleared and reused for each line instead of being
+  // allocated for each node, so they keep their capacity.
+  std::vector<std::unique_ptr<DawgPositionVector>> dawg_storage_;
+  // The number of elements of dawg_storage_ in use for the current line.
+  int dawgs_used_;
+  // The number of timesteps of the current line counted in line_nodes_.
+  int counted_steps_;
+  // The number of RecodeNodes held by beam_ for the current line.
+  int line_nodes_;
+  // The peak number of RecodeNodes held by beam_ for a line.
+  int peak_nodes_;
   // A flag to indicate which outputs are the top-n choices. Current timestep
   // only.
   std::vector<TopNState> top_n_flags_;
+  // The codes flagged TN_TOP2 and TN_TOPN in top_n_flags_, in increasing
+  // order, so the flags can be reset and searched without a pass over all of
+  // the outputs.
+  std::vector<int> top_n_codes_[TN_ALSO_RAN];
+  // Scratch space for CodesWithFlag.
+  std::vector<int> flagged_codes_;
   // A record of the highest and second scoring codes.
   int top_code_;
   int second_code_;
@@ -69,7 +69,9 @@ bool Reconfig::DeSerialize(TFile *fp) {
 void Reconfig::Forward(bool debug, const NetworkIO &input, const TransposedArray *input_transpose,
                        NetworkScratch *scratch, NetworkIO *output) {
   output->ResizeScaled(input, x_scale_, y_scale_, no_);
-  back_map_ = input.stride_map();
+  if (IsTraining()) {
+    back_map_ = input.stride_map();
+  }
   StrideMap::Index dest_index(output->stride_map());
   do {
     int out_t = dest_index.t();
@@ -212,6 +212,57 @@ void WeightMatrix::ConvertToInt() {
   }
 }
 
+// Splits the int weights by input column into *first, holding the first
+// num_inputs columns and the biases, and *rest, holding the remaining columns
+// and zero biases, both with the scales of *this.
+void WeightMatrix::SplitInputs(int num_inputs, WeightMatrix *first, WeightMatrix *rest) const {
+  assert(int_mode_);
+  int num_outputs = wi_.dim1();
+  int num_rest = wi_.dim2() - 1 - num_inputs;
+  first->wi_.ResizeNoInit(num_outputs, num_inputs + 1);
+  rest->wi_.ResizeNoInit(num_outputs, num_rest + 1);
+  for (int i = 0; i < num_outputs; ++i) {
+    const int8_t *src = wi_[i];
+    memcpy(first->wi_[i], src, num_inputs * sizeof(*src));
+    first->wi_(i, num_inputs) = src[num_inputs + num_rest];
+    memcpy(rest->wi_[i], src + num_inputs, num_rest * sizeof(*src));
+    rest->wi_(i, num_rest) = 0;
+  }
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  // The reshaped weights can usually be split as they are, which is much
+  // cheaper than reshaping the parts.
+  bool split_shaped = matrix != nullptr && !shaped_w_.empty() &&
+                      matrix->SplitInputs(shaped_w_, num_outputs, wi_.dim2() - 1, num_inputs,
+                                          first->shaped_w_, rest->shaped_w_);
+  for (auto *part : {first, rest}) {
+    part->int_mode_ = true;
+    part->scales_ = scales_;
+    if (matrix != nullptr && !split_shaped) {
+      int32_t rounded_num_out;
+      matrix->Init(part->wi_, part->shaped_w_, rounded_num_out);
+    }
+  }
+}
+
+// Sets *this to the int weights that SplitInputs split into first and rest,
+// without any reshaped copy, so they can be serialized as one matrix.
+void WeightMatrix::JoinInputs(const WeightMatrix &first, const WeightMatrix &rest) {
+  assert(first.int_mode_ && rest.int_mode_);
+  int num_outputs = first.wi_.dim1();
+  int num_inputs = first.wi_.dim2() - 1;
+  int num_rest = rest.wi_.dim2() - 1;
+  wi_.ResizeNoInit(num_outputs, num_inputs + num_rest + 1);
+  for (int i = 0; i < num_outputs; ++i) {
+    int8_t *dest = wi_[i];
+    memcpy(dest, first.wi_[i], num_inputs * sizeof(*dest));
+    memcpy(dest + num_inputs, rest.wi_[i], num_rest * sizeof(*dest));
+    dest[num_inputs + num_rest] = first.wi_(i, num_inputs);
+  }
+  int_mode_ = true;
+  scales_ = first.scales_;
+  shaped_w_.clear();
+}
+
 // Allocates any needed memory for running Backward, and zeroes the deltas,
 // thus eliminating any existing momentum.
 void WeightMatrix::InitBackward() {
@@ -229,16 +280,28 @@ void WeightMatrix::InitBackward() {
 const int kInt8Flag = 1;
 // Flag on mode to indicate that this weightmatrix uses adam.
 const int kAdamFlag = 4;
+// Flag on mode to indicate that the int weights are followed by the shape of
+// an IntSimdMatrix and the weights reshaped for it.
+const int kShapedFlag = 8;
 // Flag on mode to indicate that this weightmatrix uses double. Set
 // independently of kInt8Flag as even in int mode the scales can
 // be float or double.
 const int kDoubleFlag = 128;
 
+// The shape for which Serialize on this thread writes the reshaped weights.
+static thread_local const IntSimdMatrix *serialize_shape = nullptr;
+
+void WeightMatrix::SetSerializeShape(const IntSimdMatrix *shape) {
+  serialize_shape = shape;
+}
+
 // Writes to the given file. Returns false in case of error.
 bool WeightMatrix::Serialize(bool training, TFile *fp) const {
   // For backward compatibility, add kDoubleFlag to mode to indicate the doubles
   // format, without errs, so we can detect and read old format weight matrices.
-  uint8_t mode = (int_mode_ ? kInt8Flag : 0) | (use_adam_ ? kAdamFlag : 0) | kDoubleFlag;
+  const IntSimdMatrix *shape = int_mode_ ? serialize_shape : nullptr;
+  uint8_t mode = (int_mode_ ? kInt8Flag : 0) | (use_adam_ ? kAdamFlag : 0) |
+                 (shape != nullptr ? kShapedFlag : 0) | kDoubleFlag;
   if (!fp->Serialize(&mode)) {
     return false;
   }
@@ -259,6 +322,16 @@ bool WeightMatrix::Serialize(bool training, TFile *fp) const {
         return false;
       }
     }
+    if (shape != nullptr) {
+      int32_t geometry[] = {shape->num_outputs_per_register_, shape->max_output_registers_,
+                            shape->num_inputs_per_register_, shape->num_inputs_per_group_};
+      std::vector<int8_t> shaped_w;
+      int32_t rounded_num_out;
+      shape->Init(wi_, shaped_w, rounded_num_out);
+      if (!fp->Serialize(geometry, 4) || !fp->Serialize(shaped_w)) {
+        return false;
+      }
+    }
   } else {
     if (!tesseract::Serialize(fp, wf_)) {
       return false;
@@ -313,9 +386,37 @@ bool WeightMatrix::DeSerialize(bool training, TFile *fp) {
       scale /= INT8_MAX;
     }
 #endif
-    if (IntSimdMatrix::intSimdMatrix) {
-      int32_t rounded_num_out;
-      IntSimdMatrix::intSimdMatrix->Init(wi_, shaped_w_, rounded_num_out);
+    const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+    bool shaped = false;
+    if (mode & kShapedFlag) {
+      int32_t geometry[4];
+      uint32_t shaped_size;
+      if (!fp->DeSerialize(geometry, 4) || !fp->DeSerialize(&shaped_size)) {
+        return false;
+      }
+      IntSimdMatrix shape = {nullptr,     geometry[0], geometry[1],
+                             geometry[2], geometry[3], nullptr};
+      if (matrix != nullptr && matrix->SameShape(shape)) {
+        int rounded_num_in = IntSimdMatrix::Roundup(wi_.dim2() - 1, matrix->num_inputs_per_group_);
+        if (shaped_size !=
+            static_cast<uint32_t>((rounded_num_in + 1) * matrix->RoundOutputs(wi_.dim1()))) {
+          return false;
+        }
+        shaped_w_.resize(shaped_size);
+        if (!fp->DeSerialize(&shaped_w_[0], shaped_size)) {
+          return false;
+        }
+        shaped = true;
+      } else if (!fp->Skip(shaped_size)) {
+        return false;
+      }
+    }
+    if (matrix != nullptr) {
+      int32_t rounded_num_out = matrix->RoundOutputs(wi_.dim1());
+      if (!shaped) {
+        // Fall back to reshaping the weights for this machine.
+        matrix->Init(wi_, shaped_w_, rounded_num_out);
+      }
       scales_.resize(rounded_num_out);
     }
   } else {
@@ -400,6 +501,26 @@ void WeightMatrix::MatrixDotVector(const int8_t *u, TFloat *v) const {
   }
 }
 
+void WeightMatrix::MatrixDotMatrix(int num_vectors, const int8_t *const *u,
+                                   TFloat *const *v) const {
+  assert(int_mode_);
+  if (num_vectors <= 0) {
+    return;
+  }
+  const IntSimdMatrix *matrix = IntSimdMatrix::intSimdMatrix;
+  if (matrix == nullptr) {
+    IntSimdMatrix::MatrixDotMatrix(wi_, scales_, num_vectors, u, v);
+  } else if (matrix->matrixDotMatrixFunction != nullptr) {
+    matrix->matrixDotMatrixFunction(wi_.dim1(), wi_.dim2(), &shaped_w_[0], &scales_[0],
+                                    num_vectors, u, v);
+  } else {
+    for (int c = 0; c < num_vectors; ++c) {
+      matrix->matrixDotVectorFunction(wi_.dim1(), wi_.dim2(), &shaped_w_[0], &scales_[0], u[c],
+                                      v[c]);
+    }
+  }
+}
+
 // MatrixDotVector for peep weights, MultiplyAccumulate adds the
 // component-wise products of *this[0] and v to inout.
 void WeightMatrix::MultiplyAccumulate(const TFloat *v, TFloat *inout) {
@@ -489,6 +610,20 @@ void WeightMatrix::AddDeltas(const WeightMatrix &other) {
   dw_ += other.dw_;
 }
 
+// Replaces the dw_ in *this with the dw_ in other.
+void WeightMatrix::CopyDeltas(const WeightMatrix &other) {
+  assert(dw_.dim1() == other.dw_.dim1());
+  assert(dw_.dim2() == other.dw_.dim2());
+  dw_ = other.dw_;
+}
+
+// Replaces the float weights in *this with those in other.
+void WeightMatrix::CopyWeights(const WeightMatrix &other) {
+  assert(!int_mode_ && !other.int_mode_);
+  wf_ = other.wf_;
+  wf_t_ = other.wf_t_;
+}
+
 // Sums the products of weight updates in *this and other, splitting into
 // positive (same direction) in *same and negative (different direction) in
 // *changed.
@@ -524,7 +659,7 @@ static void HistogramWeight(TFloat weight, STATS *histogram) {
   histogram->add(bucket, 1);
 }
 
-void WeightMatrix::Debug2D(const char *msg) {
+void WeightMatrix::Debug2D(const char *msg) const {
   STATS histogram(0, kHistogramBuckets - 1);
   if (int_mode_) {
     for (int i = 0; i < wi_.dim1(); ++i) {
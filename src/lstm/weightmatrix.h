@@ -91,6 +91,15 @@ public:
   // Store a multiplicative scale factor (as a float) that will reproduce
   // the original value, subject to rounding errors.
   void ConvertToInt();
+  // Splits the int weights by input column into *first, holding the first
+  // num_inputs columns and the biases, and *rest, holding the remaining
+  // columns and zero biases, both with the scales of *this. MatrixDotVector
+  // of *this is then the sum of MatrixDotVector of first and rest applied to
+  // the corresponding parts of the input, subject to rounding errors.
+  void SplitInputs(int num_inputs, WeightMatrix *first, WeightMatrix *rest) const;
+  // Sets *this to the int weights that SplitInputs split into first and rest,
+  // without any reshaped copy, so they can be serialized as one matrix.
+  void JoinInputs(const WeightMatrix &first, const WeightMatrix &rest);
   // Returns the size rounded up to an internal factor used by the SIMD
   // implementation for its input.
   int RoundInputs(int size) const {
@@ -120,6 +129,13 @@ public:
   // thus eliminating any existing momentum.
   void InitBackward();
 
+  // Sets the shape of IntSimdMatrix for which Serialize on the calling thread
+  // also writes the int weights reshaped, so that DeSerialize on a machine
+  // whose IntSimdMatrix has the same shape does not have to reshape them.
+  // Weights written with a shape can't be read by versions before 5.5.
+  // The default of nullptr writes only the unshaped weights.
+  static void SetSerializeShape(const IntSimdMatrix *shape);
+
   // Writes to the given file. Returns false in case of error.
   bool Serialize(bool training, TFile *fp) const;
   // Reads from the given file. Returns false in case of error.
@@ -135,6 +151,11 @@ public:
   // Asserts that the call matches what we have.
   void MatrixDotVector(const TFloat *u, TFloat *v) const;
   void MatrixDotVector(const int8_t *u, TFloat *v) const;
+  // Computes matrix.matrix v[c] = Wu[c] for each of the num_vectors input
+  // vectors u[c], each under the same conditions as MatrixDotVector.
+  // Faster than separate calls to MatrixDotVector, as the weights are read
+  // fewer times. Does nothing if num_vectors is 0.
+  void MatrixDotMatrix(int num_vectors, const int8_t *const *u, TFloat *const *v) const;
   // MatrixDotVector for peep weights, MultiplyAccumulate adds the
   // component-wise products of *this[0] and v to inout.
   void MultiplyAccumulate(const TFloat *v, TFloat *inout);
@@ -153,12 +174,16 @@ public:
   void Update(float learning_rate, float momentum, float adam_beta, int num_samples);
   // Adds the dw_ in other to the dw_ is *this.
   void AddDeltas(const WeightMatrix &other);
+  // Replaces the dw_ in *this with the dw_ in other.
+  void CopyDeltas(const WeightMatrix &other);
+  // Replaces the float weights in *this with those in other.
+  void CopyWeights(const WeightMatrix &other);
   // Sums the products of weight updates in *this and other, splitting into
   // positive (same direction) in *same and negative (different direction) in
   // *changed.
   void CountAlternators(const WeightMatrix &other, TFloat *same, TFloat *changed) const;
 
-  void Debug2D(const char *msg);
+  void Debug2D(const char *msg) const;
 
 private:
   // Choice between float and 8 bit int implementations.
@@ -20,7 +20,9 @@
 #ifndef TESSERACT_TEXTORD_BBGRID_H_
 #define TESSERACT_TEXTORD_BBGRID_H_
 
+#include <algorithm>
 #include <unordered_set>
+#include <vector>
 
 #include "clst.h"
 #include "coutln.h"
@@ -141,12 +143,13 @@ private:
   int *grid_; // 2-d array of ints.
 };
 
-// The BBGrid class holds C_LISTs of template classes BBC (bounding box class)
+// The BBGrid class holds pointers to template classes BBC (bounding box class)
 // in a grid for fast neighbour access.
 // The BBC class must have a member const TBOX& bounding_box() const.
 // The BBC class must have been CLISTIZEH'ed elsewhere to make the
 // list class BBC_CLIST and the iterator BBC_C_IT.
-// Use of C_LISTs enables BBCs to exist in multiple cells simultaneously.
+// Each cell holds a sorted array of pointers, so BBCs can exist in multiple
+// cells simultaneously.
 // As a consequence, ownership of BBCs is assumed to be elsewhere and
 // persistent for at least the life of the BBGrid, or at least until Clear is
 // called which removes all references to inserted objects without actually
@@ -223,7 +226,39 @@ public:
   virtual void HandleClick(int x, int y);
 
 protected:
-  BBC_CLIST *grid_; // 2-d array of CLISTS of BBC elements.
+  // The cells are stored CSR-style: the entries of all the cells are in the
+  // single array entries_, so a search walks contiguous memory instead of
+  // chasing the nodes of a list for every element. Each cell has room to
+  // grow in place. A cell that outgrows its room moves to the end of
+  // entries_, and entries_ is rebuilt in cell order, dropping the abandoned
+  // room, once that is more than half of it.
+  struct GridCell {
+    int start;    // Index in entries_ of the first element of the cell.
+    int size;     // Number of elements in the cell.
+    int capacity; // Room for elements in entries_ from start.
+  };
+
+  // Returns the number of elements in the cell at the given grid index.
+  int CellSize(int grid_index) const {
+    return cells_[grid_index].size;
+  }
+  // Returns the element at the given position in the cell at grid_index.
+  BBC *CellEntry(int grid_index, int pos) const {
+    return entries_[cells_[grid_index].start + pos];
+  }
+  // Inserts bbox in the cell at grid_index, keeping the cell sorted by
+  // SortByBoxLeft, unless bbox is already found before its sorted position.
+  void InsertInCell(int grid_index, BBC *bbox);
+  // Removes all the instances of bbox from the cell at grid_index.
+  void RemoveFromCell(int grid_index, BBC *bbox);
+  // Moves the cell at grid_index to the end of entries_ with twice the room.
+  void GrowCell(int grid_index);
+  // Rebuilds entries_ with the cells in order and no abandoned room.
+  void CompactCells();
+
+  std::vector<GridCell> cells_; // 2-d array of cells.
+  std::vector<BBC *> entries_;  // Elements of all the cells.
+  int unused_entries_ = 0;      // Abandoned room in entries_.
 
 private:
 };
@@ -335,9 +370,13 @@ private:
   BBC *CommonNext();
   // Factored out final return when search is exhausted.
   BBC *CommonEnd();
-  // Factored out function to set the iterator to the current x_, y_
-  // grid coords and mark the cycle pt.
+  // Factored out function to set the iterator to the start of the cell at
+  // the current x_, y_ grid coords.
   void SetIterator();
+  // Returns true if the iterator has passed the end of the current cell.
+  bool CellCycled() const {
+    return cell_pos_ >= grid_->CellSize(cell_index_);
+  }
 
 private:
   // The grid we are searching.
@@ -355,9 +394,11 @@ private:
   int y_ = 0;
   bool unique_mode_ = false;
   BBC *previous_return_ = nullptr; // Previous return from Next*.
-  BBC *next_return_ = nullptr;     // Current value of it_.data() used for repositioning.
-  // An iterator over the list at (x_, y_) in the grid_.
-  BBC_C_IT it_;
+  BBC *next_return_ = nullptr;     // Current element of the cell used for repositioning.
+  // The iterator over the cell at (x_, y_) in the grid_, as its grid index
+  // and the position in it of the next element to return.
+  int cell_index_ = 0;
+  int cell_pos_ = 0;
   // Set of unique returned elements used when unique_mode_ is true.
   std::unordered_set<BBC *> returns_;
 };
@@ -469,18 +510,15 @@ int SortByBoxBottom(const void *void1, const void *void2) {
 // BBGrid IMPLEMENTATION.
 ///////////////////////////////////////////////////////////////////////
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
-BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid() : grid_(nullptr) {}
+BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid() = default;
 
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
-BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid(int gridsize, const ICOORD &bleft, const ICOORD &tright)
-    : grid_(nullptr) {
+BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid(int gridsize, const ICOORD &bleft, const ICOORD &tright) {
   Init(gridsize, bleft, tright);
 }
 
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
-BBGrid<BBC, BBC_CLIST, BBC_C_IT>::~BBGrid() {
-  delete[] grid_;
-}
+BBGrid<BBC, BBC_CLIST, BBC_C_IT>::~BBGrid() = default;
 
 // (Re)Initialize the grid. The gridsize is the size in pixels of each cell,
 // and bleft, tright are the bounding box of everything to go in it.
@@ -488,15 +526,16 @@ template <class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Init(int gridsize, const ICOORD &bleft,
                                             const ICOORD &tright) {
   GridBase::Init(gridsize, bleft, tright);
-  delete[] grid_;
-  grid_ = new BBC_CLIST[gridbuckets_];
+  cells_.assign(gridbuckets_, GridCell{0, 0, 0});
+  entries_.clear();
+  unused_entries_ = 0;
 }
 
-// Clear all lists, but leave the array of lists present.
+// Clear all cells, but leave the cells and their room present.
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Clear() {
-  for (int i = 0; i < gridbuckets_; ++i) {
-    grid_[i].shallow_clear();
+  for (auto &cell : cells_) {
+    cell.size = 0;
   }
 }
 
@@ -504,7 +543,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Clear() {
 // intact.
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::ClearGridData(void (*free_method)(BBC *)) {
-  if (grid_ == nullptr) {
+  if (cells_.empty()) {
     return;
   }
   GridSearch<BBC, BBC_CLIST, BBC_C_IT> search(this);
@@ -540,7 +579,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertBBox(bool h_spread, bool v_spread,
   int grid_index = start_y * gridwidth_;
   for (int y = start_y; y <= end_y; ++y, grid_index += gridwidth_) {
     for (int x = start_x; x <= end_x; ++x) {
-      grid_[grid_index + x].add_sorted(SortByBoxLeft<BBC>, true, bbox);
+      InsertInCell(grid_index + x, bbox);
     }
   }
 }
@@ -562,7 +601,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertPixPtBBox(int left, int bottom, Ima
     l_uint32 *data = pixGetData(pix) + y * pixGetWpl(pix);
     for (int x = 0; x < width; ++x) {
       if (GET_DATA_BIT(data, x)) {
-        grid_[(bottom + y) * gridwidth_ + x + left].add_sorted(SortByBoxLeft<BBC>, true, bbox);
+        InsertInCell((bottom + y) * gridwidth_ + x + left, bbox);
       }
     }
   }
@@ -580,12 +619,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox(BBC *bbox) {
   int grid_index = start_y * gridwidth_;
   for (int y = start_y; y <= end_y; ++y, grid_index += gridwidth_) {
     for (int x = start_x; x <= end_x; ++x) {
-      BBC_C_IT it(&grid_[grid_index + x]);
-      for (it.mark_cycle_pt(); !it.cycled_list(); it.forward()) {
-        if (it.data() == bbox) {
-          it.extract();
-        }
-      }
+      RemoveFromCell(grid_index + x, bbox);
     }
   }
 }
@@ -605,7 +639,7 @@ IntGrid *BBGrid<BBC, BBC_CLIST, BBC_C_IT>::CountCellElements() {
   auto *intgrid = new IntGrid(gridsize(), bleft(), tright());
   for (int y = 0; y < gridheight(); ++y) {
     for (int x = 0; x < gridwidth(); ++x) {
-      int cell_count = grid_[y * gridwidth() + x].length();
+      int cell_count = CellSize(y * gridwidth() + x);
       intgrid->SetGridCell(x, y, cell_count);
     }
   }
@@ -674,13 +708,13 @@ template <class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::AssertNoDuplicates() {
   // Process all grid cells.
   for (int i = gridwidth_ * gridheight_ - 1; i >= 0; --i) {
-    // Iterate over all elements excent the last.
-    for (BBC_C_IT it(&grid_[i]); !it.at_last(); it.forward()) {
-      BBC *ptr = it.data();
-      BBC_C_IT it2(it);
-      // None of the rest of the elements in the list should equal ptr.
-      for (it2.forward(); !it2.at_first(); it2.forward()) {
-        ASSERT_HOST(it2.data() != ptr);
+    // Iterate over all elements except the last.
+    int size = CellSize(i);
+    for (int pos = 0; pos + 1 < size; ++pos) {
+      BBC *ptr = CellEntry(i, pos);
+      // None of the rest of the elements in the cell should equal ptr.
+      for (int pos2 = pos + 1; pos2 < size; ++pos2) {
+        ASSERT_HOST(CellEntry(i, pos2) != ptr);
       }
     }
   }
@@ -692,6 +726,86 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::HandleClick(int x, int y) {
   tprintf("Click at (%d, %d)\n", x, y);
 }
 
+// Inserts bbox in the cell at grid_index, keeping the cell sorted by
+// SortByBoxLeft, unless bbox is already found before its sorted position.
+// This behaves exactly as CLIST::add_sorted with unique set.
+template <class BBC, class BBC_CLIST, class BBC_C_IT>
+void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertInCell(int grid_index, BBC *bbox) {
+  GridCell *cell = &cells_[grid_index];
+  BBC **entries = entries_.data() + cell->start;
+  int pos = cell->size;
+  if (pos > 0 && SortByBoxLeft<BBC>(&entries[pos - 1], &bbox) >= 0) {
+    if (entries[pos - 1] == bbox) {
+      return;
+    }
+    for (pos = 0; pos < cell->size; ++pos) {
+      if (entries[pos] == bbox) {
+        return;
+      }
+      if (SortByBoxLeft<BBC>(&entries[pos], &bbox) > 0) {
+        break;
+      }
+    }
+  }
+  if (cell->size == cell->capacity) {
+    GrowCell(grid_index);
+    cell = &cells_[grid_index];
+    entries = entries_.data() + cell->start;
+  }
+  for (int i = cell->size; i > pos; --i) {
+    entries[i] = entries[i - 1];
+  }
+  entries[pos] = bbox;
+  ++cell->size;
+}
+
+// Removes all the instances of bbox from the cell at grid_index.
+template <class BBC, class BBC_CLIST, class BBC_C_IT>
+void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RemoveFromCell(int grid_index, BBC *bbox) {
+  GridCell &cell = cells_[grid_index];
+  BBC **entries = entries_.data() + cell.start;
+  int dest = 0;
+  for (int pos = 0; pos < cell.size; ++pos) {
+    if (entries[pos] != bbox) {
+      entries[dest++] = entries[pos];
+    }
+  }
+  cell.size = dest;
+}
+
+// Moves the cell at grid_index to the end of entries_ with twice the room.
+template <class BBC, class BBC_CLIST, class BBC_C_IT>
+void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::GrowCell(int grid_index) {
+  const int kMinCellCapacity = 4;
+  if (unused_entries_ > static_cast<int>(entries_.size()) / 2) {
+    CompactCells();
+  }
+  GridCell &cell = cells_[grid_index];
+  int start = entries_.size();
+  int capacity = std::max(cell.capacity * 2, kMinCellCapacity);
+  entries_.resize(start + capacity);
+  std::copy(entries_.begin() + cell.start, entries_.begin() + cell.start + cell.size,
+            entries_.begin() + start);
+  unused_entries_ += cell.capacity;
+  cell.start = start;
+  cell.capacity = capacity;
+}
+
+// Rebuilds entries_ with the cells in order and no abandoned room.
+template <class BBC, class BBC_CLIST, class BBC_C_IT>
+void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::CompactCells() {
+  std::vector<BBC *> entries(entries_.size() - unused_entries_);
+  int start = 0;
+  for (auto &cell : cells_) {
+    std::copy(entries_.begin() + cell.start, entries_.begin() + cell.start + cell.size,
+              entries.begin() + start);
+    cell.start = start;
+    start += cell.capacity;
+  }
+  entries_.swap(entries);
+  unused_entries_ = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////
 // GridSearch IMPLEMENTATION.
 ///////////////////////////////////////////////////////////////////////
@@ -712,7 +826,7 @@ BBC *GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextFullSearch() {
   int x;
   int y;
   do {
-    while (it_.cycled_list()) {
+    while (CellCycled()) {
       ++x_;
       if (x_ >= grid_->gridwidth_) {
         --y_;
@@ -748,7 +862,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartRadSearch(int x, int y, int max_
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC *GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRadSearch() {
   for (;;) {
-    while (it_.cycled_list()) {
+    while (CellCycled()) {
       ++rad_index_;
       if (rad_index_ >= radius_) {
         ++rad_dir_;
@@ -801,7 +915,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartSideSearch(int x, int ymin, int
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC *GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextSideSearch(bool right_to_left) {
   for (;;) {
-    while (it_.cycled_list()) {
+    while (CellCycled()) {
       ++rad_index_;
       if (rad_index_ > radius_) {
         if (right_to_left) {
@@ -848,7 +962,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartVerticalSearch(int xmin, int xma
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC *GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextVerticalSearch(bool top_to_bottom) {
   for (;;) {
-    while (it_.cycled_list()) {
+    while (CellCycled()) {
       ++rad_index_;
       if (rad_index_ > radius_) {
         if (top_to_bottom) {
@@ -895,7 +1009,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartRectSearch(const TBOX &rect) {
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC *GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRectSearch() {
   for (;;) {
-    while (it_.cycled_list()) {
+    while (CellCycled()) {
       ++x_;
       if (x_ > max_radius_) {
         --y_;
@@ -932,18 +1046,17 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox() {
     // if previous_return_ is not on the list, then it has been removed already.
     BBC *prev_data = nullptr;
     BBC *new_previous_return = nullptr;
-    it_.move_to_first();
-    for (it_.mark_cycle_pt(); !it_.cycled_list();) {
-      if (it_.data() == previous_return_) {
+    int size = grid_->CellSize(cell_index_);
+    for (int pos = 0; pos < size; ++pos) {
+      BBC *data = grid_->CellEntry(cell_index_, pos);
+      if (data == previous_return_) {
         new_previous_return = prev_data;
-        it_.extract();
-        it_.forward();
-        next_return_ = it_.cycled_list() ? nullptr : it_.data();
+        next_return_ = pos + 1 < size ? grid_->CellEntry(cell_index_, pos + 1) : nullptr;
       } else {
-        prev_data = it_.data();
-        it_.forward();
+        prev_data = data;
       }
     }
+    grid_->RemoveFromCell(cell_index_, previous_return_);
     grid_->RemoveBBox(previous_return_);
     previous_return_ = new_previous_return;
     RepositionIterator();
@@ -956,23 +1069,25 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RepositionIterator() {
   // returns list.
   returns_.clear();
   // Reset the iterator back to one past the previous return.
-  // If the previous_return_ is no longer in the list, then
+  // If the previous_return_ is no longer in the cell, then
   // next_return_ serves as a backup.
-  it_.move_to_first();
+  int size = grid_->CellSize(cell_index_);
   // Special case, the first element was removed and reposition
-  // iterator was called. In this case, the data is fine, but the
-  // cycle point is not. Detect it and return.
-  if (!it_.empty() && it_.data() == next_return_) {
-    it_.mark_cycle_pt();
+  // iterator was called. In this case, start at the first element.
+  if (size > 0 && grid_->CellEntry(cell_index_, 0) == next_return_) {
+    cell_pos_ = 0;
     return;
   }
-  for (it_.mark_cycle_pt(); !it_.cycled_list(); it_.forward()) {
-    if (it_.data() == previous_return_ || it_.data_relative(1) == next_return_) {
+  for (cell_pos_ = 0; cell_pos_ < size; ++cell_pos_) {
+    // The element after the last is the first, as in a circular list.
+    int next_pos = cell_pos_ + 1 < size ? cell_pos_ + 1 : 0;
+    if (grid_->CellEntry(cell_index_, cell_pos_) == previous_return_ ||
+        grid_->CellEntry(cell_index_, next_pos) == next_return_) {
       CommonNext();
       return;
     }
   }
-  // We ran off the end of the list. Move to a new cell next time.
+  // We ran off the end of the cell. Move to a new cell next time.
   previous_return_ = nullptr;
   next_return_ = nullptr;
 }
@@ -985,16 +1100,16 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonStart(int x, int y) {
   y_ = y_origin_;
   SetIterator();
   previous_return_ = nullptr;
-  next_return_ = it_.empty() ? nullptr : it_.data();
+  next_return_ = CellCycled() ? nullptr : grid_->CellEntry(cell_index_, cell_pos_);
   returns_.clear();
 }
 
 // Factored out helper to complete a next search.
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC *GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonNext() {
-  previous_return_ = it_.data();
-  it_.forward();
-  next_return_ = it_.cycled_list() ? nullptr : it_.data();
+  previous_return_ = grid_->CellEntry(cell_index_, cell_pos_);
+  ++cell_pos_;
+  next_return_ = CellCycled() ? nullptr : grid_->CellEntry(cell_index_, cell_pos_);
   return previous_return_;
 }
 
@@ -1006,12 +1121,12 @@ BBC *GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonEnd() {
   return nullptr;
 }
 
-// Factored out function to set the iterator to the current x_, y_
-// grid coords and mark the cycle pt.
+// Factored out function to set the iterator to the start of the cell at
+// the current x_, y_ grid coords.
 template <class BBC, class BBC_CLIST, class BBC_C_IT>
 void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::SetIterator() {
-  it_ = &(grid_->grid_[y_ * grid_->gridwidth_ + x_]);
-  it_.mark_cycle_pt();
+  cell_index_ = y_ * grid_->gridwidth_ + x_;
+  cell_pos_ = 0;
 }
 
 } // namespace tesseract.
@@ -658,6 +658,24 @@ static void FindAndRemoveHLines(Image pix_intersections, int vertical_x,
   }
 }
 
+// Returns the pixels of pix that lie in horizontal or vertical runs at least
+// as long as the lines that FindAndRemoveLines looks for at the given
+// resolution, so pixels of glyphs that only touch a line are left out.
+Image LineFinder::LinePixels(int resolution, Image pix) {
+  int min_line_length = resolution / kMinLineLengthFraction;
+  int closing_brick = std::max(1, resolution / kThinLineFraction / 3);
+  // Close up small nicks in the lines, as GetLineMasks does, but only keep
+  // the pixels that were set in pix.
+  Image pix_closed = pixCloseBrick(nullptr, pix, closing_brick, closing_brick);
+  Image pix_lines = pixOpenBrick(nullptr, pix_closed, 1, min_line_length);
+  Image pix_hline = pixOpenBrick(nullptr, pix_closed, min_line_length, 1);
+  pix_closed.destroy();
+  pix_lines |= pix_hline;
+  pix_hline.destroy();
+  pix_lines &= pix;
+  return pix_lines;
+}
+
 // Finds vertical and horizontal line objects in the given pix.
 // Uses the given resolution to determine size thresholds instead of any
 // that may be present in the pix.
@@ -53,6 +53,13 @@ public:
   static void FindAndRemoveLines(int resolution, bool debug, Image pix, int *vertical_x,
                                  int *vertical_y, Image *pix_music_mask, TabVector_LIST *v_lines,
                                  TabVector_LIST *h_lines);
+
+  /**
+   * Returns the pixels of pix that lie in horizontal or vertical runs at least
+   * as long as the lines that FindAndRemoveLines looks for at the given
+   * resolution, so pixels of glyphs that only touch a line are left out.
+   */
+  static Image LinePixels(int resolution, Image pix);
 };
 
 } // namespace tesseract.
@@ -21,35 +21,85 @@
 #include "crakedge.h"
 #include "edgloop.h"
 #include "pdblock.h"
+#include "threadteam.h"
 
 #include <allheaders.h>
 
-#include <memory> // std::unique_ptr
+#include <algorithm> // for std::sort
+#include <cstring>   // for std::memcpy
+#include <memory>    // std::unique_ptr
+#include <mutex>     // for std::mutex
+#include <thread>    // for std::thread
+#include <utility>   // for std::pair
+#include <vector>    // for std::vector
 
 namespace tesseract {
 
+static INT_VAR(edges_threads, 1,
+               "Number of strips of rows in which to scan each block for the "
+               "outlines of blobs, on up to as many threads as there are cores. "
+               "The outlines are the same for any number.");
+
 #define WHITE_PIX 1 /*thresholded colours */
 #define BLACK_PIX 0
 // Flips between WHITE_PIX and BLACK_PIX.
 #define FLIP_COLOUR(pix) (1 - (pix))
 
+// Min number of rows in a strip of a block scanned on its own thread.
+const int kMinStripRows = 64;
+// Number of pixels compared at once when skipping runs that make no edges.
+const int kRunPixels = sizeof(uint64_t);
+
 struct CrackPos {
   CRACKEDGE **free_cracks; // Freelist for fast allocation.
   int x;                   // Position of new edge.
   int y;
 };
 
+// The scan of a strip of rows of a block.
+struct EdgeStrip {
+  int top_y;    // First row scanned, at the top.
+  int bottom_y; // Last row scanned.
+  // Edges in progress below the last row, by x from the left of the block.
+  std::vector<CRACKEDGE *> edges;
+  // If not at the top of the block, stand-ins for the edges in progress
+  // above the top row, by x, as those are not known when the strip starts.
+  std::vector<CRACKEDGE *> stand_ins;
+  CRACKEDGE *free_cracks = nullptr;
+  // The outlines closed within the strip, and the point of each at which
+  // it was closed.
+  C_OUTLINE_LIST outlines;
+  std::vector<ICOORD> closing_points;
+};
+
+// Threads on which to scan the strips, used by one block_edges at a time.
+static std::mutex strip_team_mutex;
+static std::unique_ptr<ThreadTeam> strip_team;
+
 static void free_crackedges(CRACKEDGE *start);
 
 static void join_edges(CRACKEDGE *edge1, CRACKEDGE *edge2, CRACKEDGE **free_cracks,
                        C_OUTLINE_IT *outline_it);
 
-static void line_edges(TDimension x, TDimension y, TDimension xext, uint8_t uppercolour, uint8_t *bwpos,
-                       CRACKEDGE **prevline, CRACKEDGE **free_cracks, C_OUTLINE_IT *outline_it);
+static void line_edges(TDimension x, TDimension y, TDimension xext, uint8_t uppercolour,
+                       const uint8_t *bwpos, const uint8_t *abovepos, CRACKEDGE **prevline,
+                       CRACKEDGE **free_cracks, C_OUTLINE_IT *outline_it);
 
 static void make_margins(PDBLK *block, BLOCK_LINE_IT *line_it, uint8_t *pixels, uint8_t margin,
                          TDimension left, TDimension right, TDimension y);
 
+static void get_block_line(Image t_pix, PDBLK *block, BLOCK_LINE_IT *line_it, const ICOORD &bleft,
+                     const ICOORD &tright, int y, uint8_t *pixels);
+
+static void scan_strip(Image t_pix, PDBLK *block, EdgeStrip *strip, C_OUTLINE_IT *outline_it);
+
+static void join_strips(EdgeStrip *upper, EdgeStrip *lower, CRACKEDGE **free_cracks,
+                        C_OUTLINE_IT *outline_it);
+
+static CRACKEDGE *closing_crack(CRACKEDGE *start);
+
+static ICOORD closing_point(const C_OUTLINE *outline);
+
 static CRACKEDGE *h_edge(int sign, CRACKEDGE *join, CrackPos *pos);
 static CRACKEDGE *v_edge(int sign, CRACKEDGE *join, CrackPos *pos);
 
@@ -57,6 +107,10 @@ static CRACKEDGE *v_edge(int sign, CRACKEDGE *join, CrackPos *pos);
  * block_edges
  *
  * Extract edges from a PDBLK.
+ * A tall block may be scanned in strips of rows on several threads, with
+ * the outlines that cross from one strip to the next joined up afterwards.
+ * The outlines are put in the order in which a single scan from the top
+ * would close them, so the result is the same either way.
  **********************************************************************/
 
 void block_edges(Image t_pix,   // thresholded image
@@ -64,43 +118,264 @@ void block_edges(Image t_pix,   // thresholded image
                  C_OUTLINE_IT *outline_it) {
   ICOORD bleft; // bounding box
   ICOORD tright;
-  BLOCK_LINE_IT line_it = block; // line iterator
 
   int width = pixGetWidth(t_pix);
   int height = pixGetHeight(t_pix);
-  int wpl = pixGetWpl(t_pix);
-  // lines in progress
-  std::unique_ptr<CRACKEDGE *[]> ptrline(new CRACKEDGE *[width + 1]);
-  CRACKEDGE *free_cracks = nullptr;
-
   block->bounding_box(bleft, tright); // block box
   ASSERT_HOST(tright.x() <= width);
   ASSERT_HOST(tright.y() <= height);
   int block_width = tright.x() - bleft.x();
-  for (int x = block_width; x >= 0; x--) {
-    ptrline[x] = nullptr; //  no lines in progress
+  // The rows below the top of the block, down to the margin below it.
+  int num_rows = tright.y() - bleft.y() + 1;
+  int num_strips =
+      std::max(1, std::min(static_cast<int>(edges_threads), num_rows / kMinStripRows));
+  std::vector<EdgeStrip> strips(num_strips);
+  for (int s = 0; s < num_strips; ++s) {
+    strips[s].top_y = tright.y() - 1 - num_rows * s / num_strips;
+    strips[s].bottom_y = tright.y() - num_rows * (s + 1) / num_strips;
+    strips[s].edges.resize(block_width + 1, nullptr);
+  }
+  if (num_strips == 1) {
+    scan_strip(t_pix, block, &strips[0], outline_it);
+    free_crackedges(strips[0].free_cracks); // really free them
+    return;
+  }
+  auto scan_task = [&](int s) {
+    C_OUTLINE_IT strip_it(&strips[s].outlines);
+    scan_strip(t_pix, block, &strips[s], &strip_it);
+    // In the order in which the scan closed them, as they are taken below.
+    strip_it.move_to_first();
+    for (strip_it.mark_cycle_pt(); !strip_it.cycled_list(); strip_it.forward()) {
+      strips[s].closing_points.push_back(closing_point(strip_it.data()));
+    }
+  };
+  // The strips are the same however many cores there are, but they are only
+  // scanned on as many threads as there are cores, and on the calling thread
+  // alone if another block is using the team.
+  int num_threads = num_strips;
+  int num_cpus = std::thread::hardware_concurrency();
+  if (num_cpus > 0) {
+    num_threads = std::min(num_threads, num_cpus);
+  }
+  std::unique_lock<std::mutex> team_lock(strip_team_mutex, std::defer_lock);
+  if (num_threads > 1 && team_lock.try_lock()) {
+    if (strip_team == nullptr || strip_team->size() != num_threads) {
+      strip_team = std::make_unique<ThreadTeam>(num_threads);
+    }
+    strip_team->Run(num_strips, scan_task);
+    team_lock.unlock();
+  } else {
+    for (int s = 0; s < num_strips; ++s) {
+      scan_task(s);
+    }
   }
+  // Join up the edges that cross from each strip to the next.
+  C_OUTLINE_LIST joined_outlines;
+  C_OUTLINE_IT joined_it(&joined_outlines);
+  CRACKEDGE *free_cracks = nullptr;
+  for (int s = 1; s < num_strips; ++s) {
+    join_strips(&strips[s - 1], &strips[s], &free_cracks, &joined_it);
+  }
+  // Put all the outlines in the order in which the scan reaches the points
+  // at which they close, from the top down and then from left to right.
+  std::vector<std::pair<ICOORD, C_OUTLINE *>> outlines;
+  for (auto &strip : strips) {
+    C_OUTLINE_IT strip_it(&strip.outlines);
+    for (auto point : strip.closing_points) {
+      outlines.emplace_back(point, strip_it.extract());
+      strip_it.forward();
+    }
+    free_crackedges(strip.free_cracks);
+  }
+  for (joined_it.mark_cycle_pt(); !joined_it.cycled_list(); joined_it.forward()) {
+    ICOORD point = closing_point(joined_it.data());
+    outlines.emplace_back(point, joined_it.extract());
+  }
+  free_crackedges(free_cracks);
+  std::sort(outlines.begin(), outlines.end(),
+            [](const std::pair<ICOORD, C_OUTLINE *> &a, const std::pair<ICOORD, C_OUTLINE *> &b) {
+              return a.first.y() != b.first.y() ? a.first.y() > b.first.y()
+                                                : a.first.x() < b.first.x();
+            });
+  for (auto &outline : outlines) {
+    outline_it->add_after_then_move(outline.second);
+  }
+}
 
-  std::unique_ptr<uint8_t[]> bwline(new uint8_t[width]);
+/**********************************************************************
+ * scan_strip
+ *
+ * Scan the rows of a strip for edges, from the top down. If the strip is
+ * not at the top of the block, it starts with stand-ins for the edges in
+ * progress above it, which are made from the row above.
+ **********************************************************************/
 
+static void scan_strip(Image t_pix, PDBLK *block, EdgeStrip *strip, C_OUTLINE_IT *outline_it) {
+  ICOORD bleft; // bounding box
+  ICOORD tright;
+  BLOCK_LINE_IT line_it = block; // line iterator
+
+  block->bounding_box(bleft, tright);
+  int block_width = tright.x() - bleft.x();
   const uint8_t margin = WHITE_PIX;
+  std::vector<uint8_t> bwline(block_width);
+  std::vector<uint8_t> aboveline(block_width);
+
+  get_block_line(t_pix, block, &line_it, bleft, tright, strip->top_y + 1, &aboveline[0]);
+  if (strip->top_y + 1 < tright.y()) {
+    // An edge is in progress wherever the colour changes along the row above.
+    strip->stand_ins.resize(block_width + 1, nullptr);
+    CrackPos pos = {&strip->free_cracks, bleft.x(), strip->top_y + 1};
+    uint8_t prevcolour = margin;
+    for (int x = 0; x <= block_width; ++x, ++pos.x) {
+      uint8_t colour = x < block_width ? aboveline[x] : margin;
+      if (colour != prevcolour) {
+        strip->edges[x] = v_edge(colour - prevcolour, nullptr, &pos);
+        strip->stand_ins[x] = strip->edges[x];
+        prevcolour = colour;
+      }
+    }
+  }
+  for (int y = strip->top_y; y >= strip->bottom_y; y--) {
+    get_block_line(t_pix, block, &line_it, bleft, tright, y, &bwline[0]);
+    line_edges(bleft.x(), y, block_width, margin, &bwline[0], &aboveline[0], &strip->edges[0],
+               &strip->free_cracks, outline_it);
+    bwline.swap(aboveline);
+  }
+}
+
+/**********************************************************************
+ * get_block_line
+ *
+ * Get the binary pixels of a row of the block, with the pixels outside it,
+ * including all those of the rows above and below it, set to margin.
+ **********************************************************************/
 
-  for (int y = tright.y() - 1; y >= bleft.y() - 1; y--) {
-    if (y >= bleft.y() && y < tright.y()) {
-      // Get the binary pixels from the image.
-      l_uint32 *line = pixGetData(t_pix) + wpl * (height - 1 - y);
-      for (int x = 0; x < block_width; ++x) {
-        bwline[x] = GET_DATA_BIT(line, x + bleft.x()) ^ 1;
+static void get_block_line(Image t_pix, PDBLK *block, BLOCK_LINE_IT *line_it, const ICOORD &bleft,
+                     const ICOORD &tright, int y, uint8_t *pixels) {
+  const uint8_t margin = WHITE_PIX;
+  int block_width = tright.x() - bleft.x();
+  if (y >= bleft.y() && y < tright.y()) {
+    // Get the binary pixels from the image.
+    int height = pixGetHeight(t_pix);
+    int wpl = pixGetWpl(t_pix);
+    l_uint32 *line = pixGetData(t_pix) + wpl * (height - 1 - y);
+    for (int x = 0; x < block_width; ++x) {
+      int image_x = x + bleft.x();
+      if (image_x % 32 == 0 && x + 32 <= block_width) {
+        // Whole words of one colour, most of a page, are set at once.
+        l_uint32 word = line[image_x / 32];
+        if (word == 0 || word == ~static_cast<l_uint32>(0)) {
+          memset(pixels + x, word == 0 ? WHITE_PIX : BLACK_PIX, 32 * sizeof(pixels[0]));
+          x += 31;
+          continue;
+        }
       }
-      make_margins(block, &line_it, bwline.get(), margin, bleft.x(), tright.x(), y);
+      pixels[x] = GET_DATA_BIT(line, image_x) ^ 1;
+    }
+    make_margins(block, line_it, pixels, margin, bleft.x(), tright.x(), y);
+  } else {
+    memset(pixels, margin, block_width * sizeof(pixels[0]));
+  }
+}
+
+/**********************************************************************
+ * join_strips
+ *
+ * Replace the stand-ins for the edges in progress above the lower strip
+ * with the edges in progress below the upper one, which are at the same
+ * places. When that closes a loop, send it for approximation.
+ **********************************************************************/
+
+static void join_strips(EdgeStrip *upper, EdgeStrip *lower, CRACKEDGE **free_cracks,
+                        C_OUTLINE_IT *outline_it) {
+  for (size_t x = 0; x < lower->stand_ins.size(); ++x) {
+    CRACKEDGE *stand_in = lower->stand_ins[x];
+    if (stand_in == nullptr) {
+      continue;
+    }
+    CRACKEDGE *edge = upper->edges[x];
+    ASSERT_HOST(edge != nullptr && edge->pos == stand_in->pos && edge->stepy == stand_in->stepy);
+    bool closed;
+    if (stand_in->stepy < 0) {
+      // The edge runs down into the lower strip, so it is the last of its
+      // chain, and the stand-in the first of its own.
+      closed = edge->next == stand_in;
+      if (!closed) {
+        CRACKEDGE *first = edge->next;
+        CRACKEDGE *last = stand_in->prev;
+        last->next = first;
+        first->prev = last;
+      }
+      edge->next = stand_in->next;
+      edge->next->prev = edge;
     } else {
-      memset(bwline.get(), margin, block_width * sizeof(bwline[0]));
+      // The edge runs up from the lower strip, so it is the first of its
+      // chain, and the stand-in the last of its own.
+      closed = stand_in->next == edge;
+      if (!closed) {
+        CRACKEDGE *first = stand_in->next;
+        CRACKEDGE *last = edge->prev;
+        last->next = first;
+        first->prev = last;
+      }
+      edge->prev = stand_in->prev;
+      edge->prev->next = edge;
+    }
+    if (closed) {
+      // Start from the crack that join_edges would have closed the loop
+      // from in a single scan, as complete_edge depends on it.
+      edge = closing_crack(edge);
+      complete_edge(edge, outline_it);
+      // attach freelist to end
+      edge->prev->next = *free_cracks;
+      *free_cracks = edge; // and free list
     }
-    line_edges(bleft.x(), y, block_width, margin, bwline.get(), ptrline.get(), &free_cracks,
-               outline_it);
+    stand_in->next = *free_cracks;
+    *free_cracks = stand_in;
   }
+}
+
+/**********************************************************************
+ * closing_crack
+ *
+ * Return the crack of a closed loop that ends at the point at which a scan
+ * from the top closes it, as found by closing_point, which is the one that
+ * join_edges closes the loop from.
+ **********************************************************************/
+
+static CRACKEDGE *closing_crack(CRACKEDGE *start) {
+  CRACKEDGE *closing = start; // crack starting at the closing point
+  CRACKEDGE *edgept = start;
+  do {
+    edgept = edgept->next;
+    if (edgept->pos.y() < closing->pos.y() ||
+        (edgept->pos.y() == closing->pos.y() && edgept->pos.x() > closing->pos.x())) {
+      closing = edgept;
+    }
+  } while (edgept != start);
+  return closing->prev;
+}
+
+/**********************************************************************
+ * closing_point
+ *
+ * Return the point at which a scan from the top closes the outline: the
+ * right end of its rightmost stretch along the bottom, as all its other
+ * points are joined up before the scan gets there.
+ **********************************************************************/
 
-  free_crackedges(free_cracks); // really free them
+static ICOORD closing_point(const C_OUTLINE *outline) {
+  int bottom = outline->bounding_box().bottom();
+  ICOORD pos = outline->start_pos();
+  ICOORD point(outline->bounding_box().left(), bottom);
+  for (int i = 0; i < outline->pathlength(); ++i) {
+    if (pos.y() == bottom && pos.x() > point.x()) {
+      point.set_x(pos.x());
+    }
+    pos += outline->step(i);
+  }
+  return point;
 }
 
 /**********************************************************************
@@ -162,12 +437,13 @@ static void make_margins(   // get a line
  * When edges close into loops, send them for approximation.
  **********************************************************************/
 
-static void line_edges(TDimension x,         // coord of line start
-                       TDimension y,         // coord of line
-                       TDimension xext,      // width of line
-                       uint8_t uppercolour,  // start of prev line
-                       uint8_t *bwpos,       // thresholded line
-                       CRACKEDGE **prevline, // edges in progress
+static void line_edges(TDimension x,            // coord of line start
+                       TDimension y,            // coord of line
+                       TDimension xext,         // width of line
+                       uint8_t uppercolour,     // start of prev line
+                       const uint8_t *bwpos,    // thresholded line
+                       const uint8_t *abovepos, // thresholded prev line
+                       CRACKEDGE **prevline,    // edges in progress
                        CRACKEDGE **free_cracks, C_OUTLINE_IT *outline_it) {
   CrackPos pos = {free_cracks, x, y};
   int xmax;              // max x coord
@@ -181,7 +457,33 @@ static void line_edges(TDimension x,         // coord of line start
 
   // do each pixel
   for (; pos.x < xmax; pos.x++, prevline++) {
+    if (prevcolour == uppercolour) {
+      // Pixels of the same colour as the one before and the ones above make
+      // no edges, so skip runs of them several at a time.
+      const uint64_t run = prevcolour * 0x0101010101010101ULL;
+      int skip = 0;
+      uint64_t pixels, above;
+      while (pos.x + skip + kRunPixels <= xmax) {
+        memcpy(&pixels, bwpos + skip, kRunPixels);
+        memcpy(&above, abovepos + skip, kRunPixels);
+        if (pixels != run || above != run) {
+          break;
+        }
+        skip += kRunPixels;
+      }
+      if (skip > 0) {
+        current = nullptr; // no edge now
+        pos.x += skip;
+        prevline += skip;
+        bwpos += skip;
+        abovepos += skip;
+        if (pos.x == xmax) {
+          break;
+        }
+      }
+    }
     const int colour = *bwpos++; // current pixel
+    ++abovepos;
     if (*prevline != nullptr) {
       // changed above
       // change colour
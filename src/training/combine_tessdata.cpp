@@ -18,6 +18,7 @@
 ///////////////////////////////////////////////////////////////////////
 
 #include "commontraining.h" // CheckSharedLibraryVersion
+#include "intsimdmatrix.h"
 #include "lstmrecognizer.h"
 #include "tessdatamanager.h"
 
@@ -107,6 +108,14 @@ static int list_network(TessdataManager &tm, const char *filename) {
 // component type (.unicharset for the unicharset, .unicharambigs for unichar
 // ambigs, etc). See k*FileSuffix variable in ccutil/tessdatamanager.h.
 //
+// Specify option -s to store the int weights of the LSTM component also
+// reshaped for the given SIMD implementation (as for the dotproduct
+// parameter), so that machines which use it load them without reshaping:
+//
+// combine_tessdata -s tessdata/eng.traineddata avx2
+//
+// Older versions of Tesseract can't read the resulting traineddata file.
+//
 // Specify option -u to unpack all the components to the specified path:
 //
 // combine_tessdata -u tessdata/eng.traineddata /home/$USER/temp/eng.
@@ -194,7 +203,16 @@ int main(int argc, char **argv) {
 
     // Write the updated traineddata file.
     tm.OverwriteComponents(new_traineddata_filename, argv + 3, argc - 3);
-  } else if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+  } else if ((argc == 3 && strcmp(argv[1], "-c") == 0) ||
+             (argc == 4 && strcmp(argv[1], "-s") == 0)) {
+    const IntSimdMatrix *shape = nullptr;
+    if (argc == 4) {
+      shape = IntSimdMatrix::ShapeForName(argv[3]);
+      if (shape == nullptr) {
+        tprintf("Unknown SIMD implementation %s!\n", argv[3]);
+        return EXIT_FAILURE;
+      }
+    }
     if (!tm.Init(argv[2])) {
       tprintf("Failed to read %s\n", argv[2]);
       return EXIT_FAILURE;
@@ -209,10 +227,12 @@ int main(int argc, char **argv) {
       tprintf("Failed to deserialize LSTM in %s!\n", argv[2]);
       return EXIT_FAILURE;
     }
-    recognizer.ConvertToInt();
+    if (!recognizer.IsIntMode()) {
+      recognizer.ConvertToInt();
+    }
     std::vector<char> lstm_data;
     fp.OpenWrite(&lstm_data);
-    ASSERT_HOST(recognizer.Serialize(&tm, &fp));
+    ASSERT_HOST(recognizer.Serialize(&tm, &fp, shape));
     tm.OverwriteEntry(tesseract::TESSDATA_LSTM, &lstm_data[0],
                       lstm_data.size());
     if (!tm.SaveFile(argv[2], nullptr)) {
@@ -270,8 +290,15 @@ int main(int argc, char **argv) {
         );
     printf(
         "Usage for compacting LSTM component to int:\n"
-        "  %s -c traineddata_file\n",
+        "  %s -c traineddata_file\n\n",
         argv[0]);
+    printf(
+        "Usage for storing the int LSTM weights reshaped for a SIMD"
+        " implementation\n"
+        "  (avx512vnni, avx2, avxvnni, avx512f, avx, sse or neon):\n"
+        "  %s -s traineddata_file simd_implementation\n"
+        "  (e.g. %s -s eng.traineddata avx2)\n",
+        argv[0], argv[0]);
     return EXIT_FAILURE;
   }
   tm.Directory();
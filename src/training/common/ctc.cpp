@@ -21,14 +21,24 @@
 #include "network.h"
 #include "networkio.h"
 #include "scrollview.h"
+#include "threadteam.h"
 
 #include <algorithm>
 #include <cfloat> // for FLT_MAX
 #include <cmath>
 #include <memory>
+#include <mutex> // for std::mutex
 
 namespace tesseract {
 
+BOOL_VAR(ctc_concurrent_passes, false,
+         "Run the forward and backward passes of CTC concurrently, on a"
+         " persistent pair of threads");
+
+// Threads on which to run the passes, used by one CTC at a time.
+static std::mutex pass_team_mutex;
+static std::unique_ptr<ThreadTeam> pass_team;
+
 // Magic constants that keep CTC stable.
 // Minimum probability limit for softmax input to ctc_loss.
 const float CTC::kMinProb_ = 1e-12;
@@ -51,7 +61,8 @@ const double CTC::kMinTotalFinalProb_ = 1e-6;
 // Returns false if there is insufficient time for the labels.
 /* static */
 bool CTC::ComputeCTCTargets(const std::vector<int> &labels, int null_char,
-                            const GENERIC_2D_ARRAY<float> &outputs, NetworkIO *targets) {
+                            const GENERIC_2D_ARRAY<float> &outputs, NetworkIO *targets,
+                            bool log_space) {
   std::unique_ptr<CTC> ctc(new CTC(labels, null_char, outputs));
   if (!ctc->ComputeLabelLimits()) {
     return false; // Not enough time.
@@ -67,22 +78,55 @@ bool CTC::ComputeCTCTargets(const std::vector<int> &labels, int null_char,
   NormalizeProbs(&ctc->outputs_);
   // Run regular CTC on the biased outputs.
   // Run forward and backward
-  GENERIC_2D_ARRAY<double> log_alphas, log_betas;
-  ctc->Forward(&log_alphas);
-  ctc->Backward(&log_betas);
-  // Normalize and come out of log space with a clipped softmax over time.
-  log_alphas += log_betas;
-  ctc->NormalizeSequence(&log_alphas);
-  ctc->LabelsToClasses(log_alphas, targets);
+  GENERIC_2D_ARRAY<double> alphas, betas;
+  if (log_space) {
+    RunPasses([&] { ctc->Forward(&alphas); }, [&] { ctc->Backward(&betas); });
+    // Normalize and come out of log space with a clipped softmax over time.
+    alphas += betas;
+    ctc->NormalizeSequence(&alphas);
+  } else {
+    std::vector<double> alpha_log_scales, beta_log_scales;
+    RunPasses([&] { ctc->ScaledForward(&alphas, &alpha_log_scales); },
+              [&] { ctc->ScaledBackward(&betas, &beta_log_scales); });
+    ctc->NormalizeScaledSequence(alpha_log_scales, betas, beta_log_scales, &alphas);
+  }
+  ctc->LabelsToClasses(alphas, targets);
   NormalizeProbs(targets);
   return true;
 }
 
+// Runs forward and backward, concurrently if ctc_concurrent_passes.
+/* static */
+void CTC::RunPasses(const std::function<void()> &forward, const std::function<void()> &backward) {
+  std::unique_lock<std::mutex> team_lock(pass_team_mutex, std::defer_lock);
+  if (!ctc_concurrent_passes || !team_lock.try_lock()) {
+    forward();
+    backward();
+    return;
+  }
+  if (pass_team == nullptr) {
+    pass_team = std::make_unique<ThreadTeam>(2);
+  }
+  pass_team->Run(2, [&](int pass) {
+    if (pass == 0) {
+      forward();
+    } else {
+      backward();
+    }
+  });
+}
+
 CTC::CTC(const std::vector<int> &labels, int null_char, const GENERIC_2D_ARRAY<float> &outputs)
     : labels_(labels), outputs_(outputs), null_char_(null_char) {
   num_timesteps_ = outputs.dim1();
   num_classes_ = outputs.dim2();
   num_labels_ = labels_.size();
+  skips_.resize(num_labels_ + 2, 0.0);
+  for (int u = 2; u < num_labels_; ++u) {
+    if (labels_[u - 1] == null_char_ && labels_[u] != labels_[u - 2]) {
+      skips_[u] = 1.0;
+    }
+  }
 }
 
 // Computes vectors of min and max label index for each timestep, based on
@@ -336,6 +380,155 @@ void CTC::Backward(GENERIC_2D_ARRAY<double> *log_probs) const {
   }
 }
 
+// Scales values[lo..hi] to sum to 1, and returns the log of their sum before
+// scaling, or 0 if they are all 0.
+static double ScaleToUnitSum(double *values, int lo, int hi) {
+  double total = 0.0;
+#pragma omp simd reduction(+ : total)
+  for (int u = lo; u <= hi; ++u) {
+    total += values[u];
+  }
+  if (total <= 0.0) {
+    return 0.0;
+  }
+  double scale = 1.0 / total;
+#pragma omp simd
+  for (int u = lo; u <= hi; ++u) {
+    values[u] *= scale;
+  }
+  return std::log(total);
+}
+
+// As Forward, but with probabilities, scaled to sum to 1 at each timestep.
+// Without logs, each timestep is a plain sum of products over the labels,
+// all of which depend only on the previous timestep, so it vectorizes.
+void CTC::ScaledForward(GENERIC_2D_ARRAY<double> *probs, std::vector<double> *log_scales) const {
+  probs->Resize(num_timesteps_, num_labels_, 0.0);
+  log_scales->resize(num_timesteps_);
+  double *probs_0 = (*probs)[0];
+  probs_0[0] = outputs_(0, labels_[0]);
+  if (labels_[0] == null_char_) {
+    probs_0[1] = outputs_(0, labels_[1]);
+  }
+  (*log_scales)[0] = ScaleToUnitSum(probs_0, 0, num_labels_ - 1);
+  const int *labels = labels_.data();
+  const double *skips = skips_.data();
+  for (int t = 1; t < num_timesteps_; ++t) {
+    const double *prev = (*probs)[t - 1];
+    double *probs_t = (*probs)[t];
+    const float *outputs_t = outputs_[t];
+    int min_u = min_labels_[t];
+    int max_u = max_labels_[t];
+    // The first 2 labels have no null to skip, and the first no previous.
+    for (int u = min_u; u <= max_u && u < 2; ++u) {
+      double sum = u > 0 ? prev[u] + prev[u - 1] : prev[u];
+      probs_t[u] = sum * outputs_t[labels[u]];
+    }
+#pragma omp simd
+    for (int u = std::max(min_u, 2); u <= max_u; ++u) {
+      probs_t[u] = (prev[u] + prev[u - 1] + skips[u] * prev[u - 2]) * outputs_t[labels[u]];
+    }
+    (*log_scales)[t] = (*log_scales)[t - 1] + ScaleToUnitSum(probs_t, min_u, max_u);
+  }
+}
+
+// As Backward, but with probabilities, scaled to sum to 1 at each timestep.
+void CTC::ScaledBackward(GENERIC_2D_ARRAY<double> *probs, std::vector<double> *log_scales) const {
+  probs->Resize(num_timesteps_, num_labels_, 0.0);
+  log_scales->resize(num_timesteps_);
+  double *probs_last = (*probs)[num_timesteps_ - 1];
+  probs_last[num_labels_ - 1] = 1.0;
+  if (labels_[num_labels_ - 1] == null_char_) {
+    probs_last[num_labels_ - 2] = 1.0;
+  }
+  (*log_scales)[num_timesteps_ - 1] = ScaleToUnitSum(probs_last, 0, num_labels_ - 1);
+  const int *labels = labels_.data();
+  const double *skips = skips_.data();
+  // The probs at t+1 times the outputs of their labels, padded with zeros
+  // for the labels beyond the end.
+  std::vector<double> next_probs(num_labels_ + 2, 0.0);
+  double *next = next_probs.data();
+  for (int t = num_timesteps_ - 2; t >= 0; --t) {
+    const double *probs_tp1 = (*probs)[t + 1];
+    double *probs_t = (*probs)[t];
+    const float *outputs_tp1 = outputs_[t + 1];
+    int min_u = min_labels_[t];
+    int max_u = max_labels_[t];
+    int max_next = std::min(max_u + 2, num_labels_ - 1);
+#pragma omp simd
+    for (int u = min_u; u <= max_next; ++u) {
+      next[u] = probs_tp1[u] * outputs_tp1[labels[u]];
+    }
+#pragma omp simd
+    for (int u = min_u; u <= max_u; ++u) {
+      probs_t[u] = next[u] + next[u + 1] + skips[u + 2] * next[u + 2];
+    }
+    (*log_scales)[t] = (*log_scales)[t + 1] + ScaleToUnitSum(probs_t, min_u, max_u);
+  }
+}
+
+// As NormalizeSequence on the sum of the log_probs of Forward and Backward,
+// but with the scaled probabilities of ScaledForward and ScaledBackward.
+// The log of each product is only needed relative to the max, so it is
+// found with one log and one exp per timestep, instead of per label.
+void CTC::NormalizeScaledSequence(const std::vector<double> &alpha_log_scales,
+                                  const GENERIC_2D_ARRAY<double> &betas,
+                                  const std::vector<double> &beta_log_scales,
+                                  GENERIC_2D_ARRAY<double> *alphas) const {
+  // Multiply the alphas by the betas, and find the max log prob of each
+  // timestep, and over all.
+  std::vector<double> max_probs(num_timesteps_);
+  double max_logprob = -DBL_MAX;
+  for (int t = 0; t < num_timesteps_; ++t) {
+    double *probs_t = (*alphas)[t];
+    const double *betas_t = betas[t];
+    double max_prob = 0.0;
+#pragma omp simd reduction(max : max_prob)
+    for (int u = 0; u < num_labels_; ++u) {
+      probs_t[u] *= betas_t[u];
+      max_prob = std::max(max_prob, probs_t[u]);
+    }
+    max_probs[t] = max_prob;
+    if (max_prob > 0.0) {
+      double logprob = std::log(max_prob) + alpha_log_scales[t] + beta_log_scales[t];
+      max_logprob = std::max(max_logprob, logprob);
+    }
+  }
+  // Bring the probs back to their unscaled values relative to the max,
+  // clipped as by ClippedExp, and sum them over time for each label.
+  const double min_prob = ClippedExp(-kMaxExpArg_);
+  std::vector<double> totals(num_labels_, 0.0);
+  double *label_totals = totals.data();
+  for (int t = 0; t < num_timesteps_; ++t) {
+    double max_prob = max_probs[t];
+    if (max_prob == 0.0) {
+      continue; // No possible labels.
+    }
+    double *probs_t = (*alphas)[t];
+    double max_scale =
+        ClippedExp(std::log(max_prob) + alpha_log_scales[t] + beta_log_scales[t] - max_logprob);
+#pragma omp simd
+    for (int u = 0; u < num_labels_; ++u) {
+      double prob = probs_t[u];
+      // Separate impossible path from unlikely probs.
+      prob = prob > 0.0 ? std::max(prob / max_prob * max_scale, min_prob) : 0.0;
+      probs_t[u] = prob;
+      label_totals[u] += prob;
+    }
+  }
+  // As in NormalizeSequence, some labels may be all zero.
+  for (int u = 0; u < num_labels_; ++u) {
+    label_totals[u] = 1.0 / std::max(label_totals[u], kMinTotalTimeProb_);
+  }
+  for (int t = 0; t < num_timesteps_; ++t) {
+    double *probs_t = (*alphas)[t];
+#pragma omp simd
+    for (int u = 0; u < num_labels_; ++u) {
+      probs_t[u] *= label_totals[u];
+    }
+  }
+}
+
 // Normalizes and brings probs out of log space with a softmax over time.
 void CTC::NormalizeSequence(GENERIC_2D_ARRAY<double> *probs) const {
   double max_logprob = probs->Max();
@@ -370,26 +563,22 @@ void CTC::NormalizeSequence(GENERIC_2D_ARRAY<double> *probs) const {
 void CTC::LabelsToClasses(const GENERIC_2D_ARRAY<double> &probs, NetworkIO *targets) const {
   // For each timestep compute the max prob for each class over all
   // instances of the class in the labels_.
+  // The max is taken after conversion to float, which gives the same result
+  // as converting the max, so it can go straight into the targets.
   for (int t = 0; t < num_timesteps_; ++t) {
     float *targets_t = targets->f(t);
-    std::vector<double> class_probs(num_classes_);
+    const double *probs_t = probs[t];
+    std::fill(targets_t, targets_t + num_classes_, 0.0f);
     for (int u = 0; u < num_labels_; ++u) {
-      double prob = probs(t, u);
+      float prob = probs_t[u];
       // Note that although Graves specifies sum over all labels of the same
       // class, we need to allow skipped blanks to go to zero, so they don't
       // interfere with the non-blanks, so max is better than sum.
-      if (prob > class_probs[labels_[u]]) {
-        class_probs[labels_[u]] = prob;
+      if (prob > targets_t[labels_[u]]) {
+        targets_t[labels_[u]] = prob;
       }
       //         class_probs[labels_[u]] += prob;
     }
-    int best_class = 0;
-    for (int c = 0; c < num_classes_; ++c) {
-      targets_t[c] = class_probs[c];
-      if (class_probs[c] > class_probs[best_class]) {
-        best_class = c;
-      }
-    }
   }
 }
 
@@ -405,6 +594,7 @@ void CTC::NormalizeProbs(GENERIC_2D_ARRAY<float> *probs) {
     float *probs_t = (*probs)[t];
     // Compute the total and clip that to prevent amplification of noise.
     double total = 0.0;
+#pragma omp simd reduction(+ : total)
     for (int c = 0; c < num_classes; ++c) {
       total += probs_t[c];
     }
@@ -413,14 +603,14 @@ void CTC::NormalizeProbs(GENERIC_2D_ARRAY<float> *probs) {
     }
     // Compute the increased total as a result of clipping.
     double increment = 0.0;
+#pragma omp simd reduction(+ : increment)
     for (int c = 0; c < num_classes; ++c) {
       double prob = probs_t[c] / total;
-      if (prob < kMinProb_) {
-        increment += kMinProb_ - prob;
-      }
+      increment += std::max(kMinProb_ - prob, 0.0);
     }
     // Now normalize with clipping. Any additional clipping is negligible.
     total += increment;
+#pragma omp simd
     for (int c = 0; c < num_classes; ++c) {
       float prob = probs_t[c] / total;
       probs_t[c] = std::max(prob, kMinProb_);
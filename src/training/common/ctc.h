@@ -22,10 +22,17 @@
 #include "export.h"
 #include "network.h"
 #include "networkio.h"
+#include "params.h"
 #include "scrollview.h"
 
+#include <functional> // for std::function
+#include <vector>
+
 namespace tesseract {
 
+// If true, the forward and backward passes of CTC run concurrently.
+extern TESS_COMMON_TRAINING_API BOOL_VAR_H(ctc_concurrent_passes);
+
 // Class to encapsulate CTC and simple target generation.
 class TESS_COMMON_TRAINING_API CTC {
 public:
@@ -49,8 +56,13 @@ public:
   // normalized with NormalizeProbs.
   // On return targets is filled with the computed targets.
   // Returns false if there is insufficient time for the labels.
+  // The passes over the labels normally run with probabilities, scaled to sum
+  // to 1 at each timestep, which vectorize well. If log_space, they run in
+  // log space instead, which is slower, but is kept as the reference that the
+  // scaled passes must match.
   static bool ComputeCTCTargets(const std::vector<int> &truth_labels, int null_char,
-                                const GENERIC_2D_ARRAY<float> &outputs, NetworkIO *targets);
+                                const GENERIC_2D_ARRAY<float> &outputs, NetworkIO *targets,
+                                bool log_space = false);
 
 private:
   // Constructor is private as the instance only holds information specific to
@@ -75,6 +87,21 @@ private:
   void Backward(GENERIC_2D_ARRAY<double> *log_probs) const;
   // Normalizes and brings probs out of log space with a softmax over time.
   void NormalizeSequence(GENERIC_2D_ARRAY<double> *probs) const;
+  // As Forward, but with probabilities, which are scaled to sum to 1 at each
+  // timestep, so log_probs(t, u) = log(probs(t, u)) + log_scales[t].
+  void ScaledForward(GENERIC_2D_ARRAY<double> *probs, std::vector<double> *log_scales) const;
+  // As Backward, but with scaled probabilities, as ScaledForward.
+  void ScaledBackward(GENERIC_2D_ARRAY<double> *probs, std::vector<double> *log_scales) const;
+  // As NormalizeSequence on the sum of the log_probs of Forward and Backward,
+  // but with the scaled probabilities of ScaledForward and ScaledBackward.
+  // The result is put in alphas.
+  void NormalizeScaledSequence(const std::vector<double> &alpha_log_scales,
+                               const GENERIC_2D_ARRAY<double> &betas,
+                               const std::vector<double> &beta_log_scales,
+                               GENERIC_2D_ARRAY<double> *alphas) const;
+  // Runs forward and backward, concurrently if ctc_concurrent_passes.
+  static void RunPasses(const std::function<void()> &forward,
+                        const std::function<void()> &backward);
   // For each timestep computes the max prob for each class over all
   // instances of the class in the labels_, and sets the targets to
   // the max observed prob.
@@ -122,6 +149,9 @@ private:
   // Min and max valid label indices for each timestep.
   std::vector<int> min_labels_;
   std::vector<int> max_labels_;
+  // 1 for each label that can be reached by skipping the null before it, else
+  // 0, padded with 2 zeros at the end.
+  std::vector<double> skips_;
 };
 
 } // namespace tesseract
@@ -65,6 +65,16 @@ static STRING_PARAM_FLAG(old_traineddata, "",
                          " character set that is to be replaced");
 static BOOL_PARAM_FLAG(randomly_rotate, false,
                        "Train OSD and randomly turn training samples upside-down");
+static BOOL_PARAM_FLAG(decode_corpus, false,
+                       "Write each training file in the pre-decoded .lstmd format,"
+                       " at the input height of the network, and exit.");
+static INT_PARAM_FLAG(prefetch_depth, 0,
+                      "Number of training samples to fetch and decode ahead of use,"
+                      " or 0 to fetch each when it is needed");
+static INT_PARAM_FLAG(prefetch_threads, 2, "Number of threads to fetch samples ahead on");
+static INT_PARAM_FLAG(batch_size, 1,
+                      "Number of samples to train concurrently as one mini-batch,"
+                      " each on its own thread, with one weight update per batch");
 
 // Number of training images to train between calls to MaintainCheckpoints.
 const int kNumPagesPerBatch = 100;
@@ -187,6 +197,30 @@ int main(int argc, char **argv) {
       trainer.set_perfect_delay(FLAGS_perfect_sample_delay);
     }
   }
+  if (FLAGS_decode_corpus) {
+    int target_height = trainer.DecodedInputHeight();
+    if (target_height == 0) {
+      tprintf("Can't decode the corpus for a network that doesn't take grey"
+              " images of a fixed height!\n");
+      return EXIT_FAILURE;
+    }
+    // Write the pre-decoded companion of each training file next to it.
+    for (const auto &filename : filenames) {
+      std::string decoded_name = filename;
+      if (decoded_name.size() > 6 && decoded_name.substr(decoded_name.size() - 6) == ".lstmf") {
+        decoded_name.resize(decoded_name.size() - 6);
+      }
+      decoded_name += ".lstmd";
+      tesseract::DocumentData document(filename);
+      if (!document.LoadDocument(filename.c_str(), 0, 0, nullptr) ||
+          !document.SaveDecodedDocument(decoded_name.c_str(), target_height, nullptr)) {
+        tprintf("Failed to decode %s\n", filename.c_str());
+        return EXIT_FAILURE;
+      }
+      tprintf("Wrote %s\n", decoded_name.c_str());
+    }
+    return EXIT_SUCCESS;
+  }
   if (!trainer.LoadAllTrainingData(
           filenames,
           FLAGS_sequential_training ? tesseract::CS_SEQUENTIAL : tesseract::CS_ROUND_ROBIN,
@@ -194,6 +228,9 @@ int main(int argc, char **argv) {
     tprintf("Load of images failed!!\n");
     return EXIT_FAILURE;
   }
+  if (FLAGS_prefetch_depth > 0) {
+    trainer.SetPrefetch(FLAGS_prefetch_depth, FLAGS_prefetch_threads);
+  }
 
   tesseract::LSTMTester tester(static_cast<int64_t>(FLAGS_max_image_MB) * 1048576);
   tesseract::TestCallback tester_callback = nullptr;
@@ -221,7 +258,7 @@ int main(int argc, char **argv) {
     for (int target_iteration = iteration + kNumPagesPerBatch;
          iteration < target_iteration && iteration < max_iterations;
          iteration = trainer.training_iteration()) {
-      trainer.TrainOnLine(&trainer, false);
+      trainer.TrainOnBatch(&trainer, FLAGS_batch_size);
     }
     std::stringstream log_str;
     log_str.imbue(std::locale::classic());
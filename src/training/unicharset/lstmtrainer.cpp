@@ -22,10 +22,12 @@
 #  include "config_auto.h"
 #endif
 
+#include <algorithm>           // for std::min
 #include <cmath>
 #include <iomanip>             // for std::setprecision
 #include <locale>              // for std::locale::classic
 #include <string>
+#include <thread>              // for std::thread
 #include "lstmtrainer.h"
 
 #include <allheaders.h>
@@ -36,9 +38,11 @@
 #include "networkbuilder.h"
 #include "ratngs.h"
 #include "recodebeam.h"
+#include "serialis.h"
 #ifdef INCLUDE_TENSORFLOW
 #  include "tfnetwork.h"
 #endif
+#include "threadteam.h"
 #include "tprintf.h"
 
 namespace tesseract {
@@ -170,6 +174,8 @@ bool LSTMTrainer::InitNetwork(const char *network_spec, int append_index,
   learning_rate_ = learning_rate;
   momentum_ = momentum;
   SetNullChar();
+  // The network is replaced, so the plan of the old one must not be used.
+  plan_ = NetworkPlan();
   if (!NetworkBuilder::InitNetwork(recoder_.code_range(), network_spec,
                                    append_index, net_flags, weight_range,
                                    &randomizer_, &network_)) {
@@ -191,6 +197,7 @@ bool LSTMTrainer::InitNetwork(const char *network_spec, int append_index,
 #ifdef INCLUDE_TENSORFLOW
 int LSTMTrainer::InitTensorFlowNetwork(const std::string &tf_proto) {
   delete network_;
+  plan_ = NetworkPlan();
   TFNetwork *tf_net = new TFNetwork("TensorFlow");
   training_iteration_ = tf_net->InitFromProtoStr(tf_proto);
   if (training_iteration_ == 0) {
@@ -298,10 +305,44 @@ bool LSTMTrainer::LoadAllTrainingData(const std::vector<std::string> &filenames,
                                       bool randomly_rotate) {
   randomly_rotate_ = randomly_rotate;
   training_data_.Clear();
+  if (network_ != nullptr) {
+    // Pre-decoded images are only usable at the height they were decoded at.
+    int target_height = DecodedInputHeight();
+    for (const auto &filename : filenames) {
+      if (!DocumentData::IsDecodedDocument(filename)) {
+        continue;
+      }
+      if (target_height == 0) {
+        tprintf("Can't train on pre-decoded %s with a network that doesn't take"
+                " grey images of a fixed height!\n", filename.c_str());
+        return false;
+      }
+      int height = DocumentData::ReadDecodedHeight(filename, LoadDataFromFile);
+      if (height != target_height) {
+        tprintf("%s was pre-decoded at height %d, but the network needs %d!\n",
+                filename.c_str(), height, target_height);
+        return false;
+      }
+    }
+  }
   return training_data_.LoadDocuments(filenames, cache_strategy,
                                       LoadDataFromFile);
 }
 
+// Returns the height that the training images can be pre-decoded at for the
+// network, or 0 if they can't be.
+int LSTMTrainer::DecodedInputHeight() const {
+  // Input::PrepareLSTMInputs scales the images to NumInputs(), and
+  // NormalizePix then converts them to grey, unless the input has 3 colours.
+  StaticShape shape = network_->InputShape();
+  return shape.depth() == 1 && shape.height() == NumInputs() ? NumInputs() : 0;
+}
+
+// Starts fetching the training samples ahead of use on num_threads threads.
+void LSTMTrainer::SetPrefetch(int depth, int num_threads) {
+  training_data_.SetPrefetch(depth, num_threads, DecodedInputHeight());
+}
+
 // Keeps track of best and locally worst char error_rate and launches tests
 // using tester, when a new min or max is reached.
 // Writes checkpoints at appropriate times and builds and returns a log message
@@ -400,6 +441,11 @@ void LSTMTrainer::PrepareLogMsg(std::stringstream &log_msg) const {
           << "%, BCER train=" << error_rates_[ET_CHAR_ERROR]
           << "%, BWER train=" << error_rates_[ET_WORD_RECERR]
           << "%, skip ratio=" << error_rates_[ET_SKIP_RATIO] << "%,";
+  int64_t requests = training_data_.prefetch_requests();
+  if (requests > 0) {
+    log_msg << " data stalls=" << training_data_.prefetch_stalls() << "/" << requests << " ("
+            << training_data_.prefetch_stall_seconds() << "s),";
+  }
 }
 
 // Appends <intro_str> iteration learning_iteration()/training_iteration()/
@@ -897,6 +943,118 @@ Trainability LSTMTrainer::TrainOnLine(const ImageData *trainingdata,
   return trainable;
 }
 
+// Trains on the next batch_size samples of samples_trainer as one mini-batch.
+// See the header for the details.
+int LSTMTrainer::TrainOnBatch(LSTMTrainer *samples_trainer, int batch_size) {
+  if (batch_size <= 1) {
+    return TrainOnLine(samples_trainer, false) != nullptr ? 1 : 0;
+  }
+  while (replicas_.size() < static_cast<size_t>(batch_size)) {
+    std::vector<char> data;
+    auto replica = std::make_unique<LSTMTrainer>();
+    if (!samples_trainer->SaveTrainingDump(LIGHT, *this, &data) ||
+        !samples_trainer->ReadTrainingDump(data, *replica)) {
+      tprintf("Failed to make a replica for batch training!\n");
+      return TrainOnLine(samples_trainer, false) != nullptr ? 1 : 0;
+    }
+    replicas_.push_back(std::move(replica));
+  }
+  int num_threads = batch_size;
+  int num_cpus = std::thread::hardware_concurrency();
+  if (num_cpus > 0) {
+    num_threads = std::min(num_threads, num_cpus);
+  }
+  if (batch_team_ == nullptr || batch_team_->size() != num_threads) {
+    batch_team_ = std::make_unique<ThreadTeam>(num_threads);
+  }
+  // The samples are taken in order, as TrainOnLine would. Each is copied, as
+  // getting the later ones may evict the earlier ones from the cache, apart
+  // from any pre-decoded pixels, which are shared.
+  int first_serial = sample_iteration_;
+  std::vector<ImageData> samples(batch_size);
+  std::vector<char> have_sample(batch_size, false);
+  for (int b = 0; b < batch_size; ++b) {
+    const ImageData *image =
+        samples_trainer->training_data_.GetPageBySerial(first_serial + b);
+    if (image != nullptr) {
+      std::vector<char> data;
+      TFile fp;
+      fp.OpenWrite(&data);
+      if (image->Serialize(&fp)) {
+        fp.Open(&data[0], data.size());
+        have_sample[b] = samples[b].DeSerialize(&fp);
+        samples[b].ShareDecodedImage(*image);
+      }
+    }
+  }
+  // Run the samples forward on their replicas. Nothing in the forward pass
+  // depends on the results of the earlier samples in the batch. The replica's
+  // training_iteration_ only indexes its error buffers and debug output.
+  std::vector<Trainability> results(batch_size, UNENCODABLE);
+  std::vector<NetworkIO> targets(batch_size);
+  batch_team_->Run(batch_size, [&](int b) {
+    LSTMTrainer *replica = replicas_[b].get();
+    replica->network_->CopyWeights(*network_);
+    if (!have_sample[b]) {
+      return;
+    }
+    replica->sample_iteration_ = first_serial + b;
+    replica->prev_sample_iteration_ = first_serial + b;
+    replica->training_iteration_ = training_iteration_;
+    replica->randomly_rotate_ = randomly_rotate_;
+    NetworkIO fwd_outputs;
+    results[b] = replica->PrepareForBackward(&samples[b], &fwd_outputs, &targets[b]);
+  });
+  // Record the errors of the usable samples in order, as TrainOnLine would,
+  // which gives each sample the training_iteration_ and
+  // last_perfect_training_iteration_ that decide whether it is backpropagated.
+  std::vector<int> backprop;
+  int num_used = 0;
+  for (int b = 0; b < batch_size; ++b) {
+    if (results[b] == UNENCODABLE || results[b] == NOT_BOXED) {
+      continue;
+    }
+    for (int type = ET_RMS; type < ET_SKIP_RATIO; ++type) {
+      auto error_type = static_cast<ErrorTypes>(type);
+      UpdateErrorBuffer(replicas_[b]->NewSingleError(error_type), error_type);
+    }
+    UpdateErrorBuffer(first_serial + b - prev_sample_iteration_, ET_SKIP_RATIO);
+    if (network_->IsTraining() &&
+        (results[b] != PERFECT ||
+         training_iteration() > last_perfect_training_iteration_ + perfect_delay_)) {
+      backprop.push_back(b);
+    }
+    sample_iteration_ = first_serial + b + 1;
+    RollErrorBuffers();
+    ++num_used;
+  }
+  // Run the chosen samples backward on their replicas.
+  std::vector<LSTMTrainer *> sources(backprop.size());
+  batch_team_->Run(backprop.size(), [&](int s) {
+    int b = backprop[s];
+    sources[s] = replicas_[b].get();
+    NetworkIO bp_deltas;
+    sources[s]->network_->Backward(false, targets[b], &sources[s]->scratch_space_, &bp_deltas);
+  });
+  sample_iteration_ = first_serial + batch_size;
+  if (sources.empty()) {
+    return num_used;
+  }
+  // Sum the deltas in a tree, each level adding the second of each pair of
+  // sums into the first, with the pairs running concurrently.
+  int num_sources = sources.size();
+  for (int stride = 1; stride < num_sources; stride *= 2) {
+    int num_pairs = (num_sources - stride + 2 * stride - 1) / (2 * stride);
+    batch_team_->Run(num_pairs, [&](int p) {
+      int first = 2 * stride * p;
+      sources[first]->network_->AddDeltas(*sources[first + stride]->network_);
+    });
+  }
+  network_->CopyDeltas(*sources[0]->network_);
+  network_->Update(learning_rate_, momentum_, adam_beta_, training_iteration_);
+  return num_used;
+}
+
 // Prepares the ground truth, runs forward, and prepares the targets.
 // Returns a Trainability enum to indicate the suitability of the sample.
 Trainability LSTMTrainer::PrepareForBackward(const ImageData *trainingdata,
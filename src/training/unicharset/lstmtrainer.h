@@ -187,10 +187,20 @@ public:
 
   // Loads a set of lstmf files that were created using the lstm.train config to
   // tesseract into memory ready for training. Returns false if nothing was
-  // loaded.
+  // loaded, or if the network is set up and any of the files is pre-decoded
+  // at a height other than its DecodedInputHeight.
   bool LoadAllTrainingData(const std::vector<std::string> &filenames,
                            CachingStrategy cache_strategy,
                            bool randomly_rotate);
+  // Starts fetching the training samples ahead of use on num_threads
+  // threads, up to depth samples ahead, after LoadAllTrainingData. If the
+  // network takes grey images, the samples are also pre-decoded at its input
+  // height, so the images are decoded and scaled on those threads too.
+  void SetPrefetch(int depth, int num_threads);
+  // Returns the height that the training images can be pre-decoded at for the
+  // network, which is its input height if it takes grey images of a fixed
+  // height, or 0 if they can't be pre-decoded.
+  int DecodedInputHeight() const;
 
   // Keeps track of best and locally worst error rate, using internally computed
   // values. See MaintainCheckpointsSpecific for more detail.
@@ -281,6 +291,17 @@ public:
     return image;
   }
   Trainability TrainOnLine(const ImageData *trainingdata, bool batch);
+  // Trains on the next batch_size samples of samples_trainer as one
+  // mini-batch, with the same result as batch_size calls of TrainOnLine, but
+  // for the Update of the weights, which is done just once, from the sum of
+  // the deltas of all the samples. Each sample runs forward on its own replica
+  // of the network, concurrently on up to batch_size threads. Their errors are
+  // then recorded in order, which decides, as TrainOnLine would, which of them
+  // run backward, concurrently again. The deltas of the replicas are summed
+  // in a tree, so the replicas add theirs in pairs concurrently too. Returns
+  // the number of samples that were usable. A batch_size of 1 just calls
+  // TrainOnLine.
+  int TrainOnBatch(LSTMTrainer *samples_trainer, int batch_size);
 
   // Prepares the ground truth, runs forward, and prepares the targets.
   // Returns a Trainability enum to indicate the suitability of the sample.
@@ -487,6 +508,12 @@ protected:
   double error_rates_[ET_COUNT]; // RMS training error.
   // Traineddata file with optional dawgs + UNICHARSET and recoder.
   TessdataManager mgr_;
+
+  // === NOT SERIALIZED.
+  // Replicas of *this that run the samples of TrainOnBatch, and the threads
+  // to run them, held between batches.
+  std::vector<std::unique_ptr<LSTMTrainer>> replicas_;
+  std::unique_ptr<ThreadTeam> batch_team_;
 };
 
 } // namespace tesseract.
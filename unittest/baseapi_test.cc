@@ -21,6 +21,8 @@
 #include <allheaders.h>
 #include "gmock/gmock-matchers.h"
 
+#include <algorithm>
+#include <cctype>
 #include <memory>
 #include <regex>
 #include <string>
@@ -51,6 +53,24 @@ std::string GetCleanedTextResult(tesseract::TessBaseAPI *tess, Image pix) {
   return ocr_result;
 }
 
+// Returns the number of bytes to insert, delete or substitute to turn a into b.
+static int EditDistance(const std::string &a, const std::string &b) {
+  std::vector<int> row(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); ++j) {
+    row[j] = j;
+  }
+  for (size_t i = 1; i <= a.size(); ++i) {
+    int diagonal = row[0];
+    row[0] = i;
+    for (size_t j = 1; j <= b.size(); ++j) {
+      int substitution = diagonal + (a[i - 1] != b[j - 1]);
+      diagonal = row[j];
+      row[j] = std::min({substitution, row[j] + 1, row[j - 1] + 1});
+    }
+  }
+  return row[b.size()];
+}
+
 // The fixture for testing Tesseract.
 class TesseractTest : public testing::Test {
 protected:
@@ -272,6 +292,79 @@ TEST_F(TesseractTest, LSTMGeometryTest) {
   src_pix.destroy();
 }
 
+// Tests that a line fed a few columns at a time to the streaming LSTM gives
+// a stable prefix of its final text, that the final text is close to that of
+// the whole line recognized at once, and logs the time until the first
+// characters can be shown.
+TEST_F(TesseractTest, StreamingLSTMLineTest) {
+  tesseract::TessBaseAPI api;
+  if (api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY) == -1) {
+    // eng.traineddata not found.
+    GTEST_SKIP();
+  }
+  Image src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  // Recognize the page normally to find its first text line.
+  api.SetImage(src_pix);
+  Boxa *lines = api.GetComponentImages(tesseract::RIL_TEXTLINE, true, nullptr, nullptr);
+  ASSERT_TRUE(lines != nullptr);
+  ASSERT_GT(boxaGetCount(lines), 0);
+  Box *line_box = boxaGetBox(lines, 0, L_CLONE);
+  Image line_pix = pixClipRectangle(src_pix, line_box, nullptr);
+  boxDestroy(&line_box);
+  boxaDestroy(&lines);
+  const int kChunkWidth = 16;
+  const int kLookahead = 8;
+  ASSERT_TRUE(api.BeginStreamingLine(kLookahead));
+  CycleTimer timer;
+  timer.Restart();
+  int64_t first_char_ms = -1;
+  std::string stable_text;
+  int width = pixGetWidth(line_pix);
+  int height = pixGetHeight(line_pix);
+  for (int x = 0; x < width; x += kChunkWidth) {
+    Box *chunk_box = boxCreate(x, 0, std::min(kChunkWidth, width - x), height);
+    Image chunk = pixClipRectangle(line_pix, chunk_box, nullptr);
+    boxDestroy(&chunk_box);
+    EXPECT_TRUE(api.AddStreamingLineColumns(chunk));
+    chunk.destroy();
+    char *text = api.GetStreamingLineText();
+    std::string partial_text = text;
+    delete[] text;
+    // The stable text may only grow.
+    EXPECT_EQ(partial_text.compare(0, stable_text.size(), stable_text), 0);
+    stable_text = partial_text;
+    if (first_char_ms < 0 && !stable_text.empty()) {
+      first_char_ms = timer.GetInMs();
+    }
+  }
+  char *result = api.EndStreamingLine();
+  std::string final_text = result;
+  delete[] result;
+  timer.Stop();
+  LOG(INFO) << "Streamed line in " << timer.GetInMs() << "ms, first characters after "
+            << first_char_ms << "ms: " << final_text;
+  EXPECT_FALSE(final_text.empty());
+  EXPECT_EQ(final_text.compare(0, stable_text.size(), stable_text), 0);
+  // Recognize the whole line at once, as a raw line without layout analysis.
+  api.SetPageSegMode(tesseract::PSM_RAW_LINE);
+  api.SetImage(line_pix);
+  char *line_text = api.GetUTF8Text();
+  ASSERT_TRUE(line_text != nullptr);
+  std::string expected_text = line_text;
+  delete[] line_text;
+  while (!expected_text.empty() && isspace(static_cast<unsigned char>(expected_text.back()))) {
+    expected_text.pop_back();
+  }
+  // Each window of the stream is normalized and binarized on its own, so the
+  // text may differ a little from that of the whole line.
+  int max_distance = expected_text.size() / 10;
+  EXPECT_LE(EditDistance(final_text, expected_text), max_distance)
+      << final_text << " vs " << expected_text;
+  line_pix.destroy();
+  src_pix.destroy();
+}
+
 TEST_F(TesseractTest, InitConfigOnlyTest) {
   // Languages for testing initialization.
   const char *langs[] = {"eng", "chi_tra", "jpn", "vie"};
@@ -0,0 +1,185 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bbgrid.h"
+#include <chrono>
+#include <memory>
+#include <set>
+#include <vector>
+#include "helpers.h"
+#include "include_gunit.h"
+
+namespace tesseract {
+
+// Minimal element for a BBGrid.
+class GridBox {
+public:
+  GridBox(const TBOX &box, int id) : box_(box), id_(id) {}
+  const TBOX &bounding_box() const {
+    return box_;
+  }
+  int id() const {
+    return id_;
+  }
+
+private:
+  TBOX box_;
+  int id_;
+};
+
+CLISTIZEH(GridBox)
+
+using TestGrid = BBGrid<GridBox, GridBox_CLIST, GridBox_C_IT>;
+using TestGridSearch = GridSearch<GridBox, GridBox_CLIST, GridBox_C_IT>;
+
+class BBGridTest : public ::testing::Test {
+protected:
+  // Makes num_boxes random boxes of text-like sizes on a page of the given
+  // size, and inserts them all in a grid of the given gridsize.
+  void MakeGrid(int num_boxes, int width, int height, int gridsize) {
+    grid_ = std::make_unique<TestGrid>(gridsize, ICOORD(0, 0), ICOORD(width, height));
+    TRand rand;
+    rand.set_seed(42);
+    boxes_.clear();
+    for (int i = 0; i < num_boxes; ++i) {
+      int w = 3 + rand.IntRand() % 30;
+      int h = 8 + rand.IntRand() % 30;
+      int x = rand.IntRand() % (width - w);
+      int y = rand.IntRand() % (height - h);
+      boxes_.push_back(std::make_unique<GridBox>(TBOX(x, y, x + w, y + h), i));
+      grid_->InsertBBox(true, true, boxes_.back().get());
+    }
+  }
+
+  // Returns the ids of all the boxes in the grid, found by a full search.
+  std::multiset<int> FullSearchIds() {
+    std::multiset<int> ids;
+    TestGridSearch search(grid_.get());
+    search.StartFullSearch();
+    GridBox *box;
+    while ((box = search.NextFullSearch()) != nullptr) {
+      ids.insert(box->id());
+    }
+    return ids;
+  }
+
+  std::unique_ptr<TestGrid> grid_;
+  std::vector<std::unique_ptr<GridBox>> boxes_;
+};
+
+// Tests that a full search returns each box exactly once.
+TEST_F(BBGridTest, FullSearchReturnsEachBoxOnce) {
+  MakeGrid(2000, 1000, 1400, 16);
+  std::multiset<int> ids = FullSearchIds();
+  EXPECT_EQ(ids.size(), boxes_.size());
+  EXPECT_EQ(std::set<int>(ids.begin(), ids.end()).size(), boxes_.size());
+  grid_->AssertNoDuplicates();
+}
+
+// Tests that a rect search returns exactly the boxes that overlap it.
+TEST_F(BBGridTest, RectSearchFindsOverlaps) {
+  MakeGrid(2000, 1000, 1400, 16);
+  const TBOX kRects[] = {TBOX(0, 0, 100, 100), TBOX(250, 300, 600, 420), TBOX(990, 1390, 999, 1399),
+                         TBOX(0, 0, 999, 1399)};
+  for (const auto &rect : kRects) {
+    std::set<int> expected;
+    for (const auto &box : boxes_) {
+      if (rect.overlap(box->bounding_box())) {
+        expected.insert(box->id());
+      }
+    }
+    std::set<int> found;
+    TestGridSearch search(grid_.get());
+    search.SetUniqueMode(true);
+    search.StartRectSearch(rect);
+    GridBox *box;
+    while ((box = search.NextRectSearch()) != nullptr) {
+      EXPECT_TRUE(found.insert(box->id()).second);
+    }
+    EXPECT_EQ(found, expected);
+  }
+}
+
+// Tests removal of boxes in the middle of searches, with a second search on
+// the same grid kept valid by RepositionIterator.
+TEST_F(BBGridTest, RemoveWhileSearching) {
+  MakeGrid(2000, 1000, 1400, 16);
+  std::set<int> removed;
+  for (const auto &centre : boxes_) {
+    const TBOX &box = centre->bounding_box();
+    TestGridSearch other(grid_.get());
+    other.StartRectSearch(box);
+    other.NextRectSearch();
+    TestGridSearch search(grid_.get());
+    search.StartRadSearch((box.left() + box.right()) / 2, box.bottom(), 2);
+    GridBox *neighbour;
+    while ((neighbour = search.NextRadSearch()) != nullptr) {
+      ASSERT_EQ(removed.count(neighbour->id()), 0);
+      if (neighbour->id() % 5 == 0 && neighbour != centre.get()) {
+        search.RemoveBBox();
+        removed.insert(neighbour->id());
+        other.RepositionIterator();
+      }
+    }
+    // The rest of the other search must only find boxes that are still in
+    // the grid.
+    GridBox *other_box;
+    while ((other_box = other.NextRectSearch()) != nullptr) {
+      ASSERT_EQ(removed.count(other_box->id()), 0);
+    }
+  }
+  std::multiset<int> ids = FullSearchIds();
+  EXPECT_EQ(ids.size() + removed.size(), boxes_.size());
+  for (int id : removed) {
+    EXPECT_EQ(ids.count(id), 0);
+  }
+  grid_->AssertNoDuplicates();
+  // Put the removed boxes back.
+  for (int id : removed) {
+    grid_->InsertBBox(true, true, boxes_[id].get());
+  }
+  EXPECT_EQ(FullSearchIds().size(), boxes_.size());
+  grid_->AssertNoDuplicates();
+}
+
+// Microbenchmark of the neighbourhood searches done during layout analysis
+// of a dense page: a radius and a side search around every box, with some
+// removals that require another search to RepositionIterator.
+TEST_F(BBGridTest, SpeedTest) {
+  MakeGrid(60000, 5000, 7000, 32);
+  auto start = std::chrono::steady_clock::now();
+  int num_returns = 0;
+  for (const auto &centre : boxes_) {
+    const TBOX &box = centre->bounding_box();
+    TestGridSearch other(grid_.get());
+    other.StartRectSearch(box);
+    other.NextRectSearch();
+    TestGridSearch search(grid_.get());
+    search.StartRadSearch((box.left() + box.right()) / 2, box.bottom(), 3);
+    GridBox *neighbour;
+    while ((neighbour = search.NextRadSearch()) != nullptr) {
+      ++num_returns;
+      if ((neighbour->id() * 7 + centre->id()) % 97 == 0 && neighbour != centre.get()) {
+        search.RemoveBBox();
+        other.RepositionIterator();
+      }
+    }
+    TestGridSearch side(grid_.get());
+    side.StartSideSearch(box.right(), box.bottom(), box.top());
+    for (int i = 0; i < 50 && side.NextSideSearch(false) != nullptr; ++i) {
+      ++num_returns;
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_GT(num_returns, 0);
+  LOG(INFO) << "Searches returned " << num_returns << " boxes in " << elapsed.count() << "s\n";
+}
+
+} // namespace tesseract
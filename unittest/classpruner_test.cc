@@ -0,0 +1,130 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "classpruner.h"
+#include <chrono>
+#include <vector>
+#include "helpers.h"
+#include "include_gunit.h"
+#include "simddetect.h"
+
+namespace tesseract {
+
+// Number of words in a class pruner: 24 x 24 x 24 vectors of 2 words.
+const int kWordsPerPruner = 24 * 24 * 24 * 2;
+
+class ClassPrunerTest : public ::testing::Test {
+protected:
+  // Makes num_pruners pruners of random weights, and num_features random
+  // offsets of vectors in them.
+  void MakePruners(int num_pruners, int num_features, TRand *randomizer) {
+    words_.resize(num_pruners * kWordsPerPruner);
+    for (auto &word : words_) {
+      word = static_cast<uint32_t>(randomizer->IntRand()) ^
+             (static_cast<uint32_t>(randomizer->IntRand()) << 16);
+    }
+    pruners_.clear();
+    for (int p = 0; p < num_pruners; ++p) {
+      pruners_.push_back(&words_[p * kWordsPerPruner]);
+    }
+    offsets_.clear();
+    for (int f = 0; f < num_features; ++f) {
+      offsets_.push_back(2 * (randomizer->IntRand() % (kWordsPerPruner / 2)));
+    }
+  }
+
+  // Returns the counts of the classes as the scalar class pruner makes them,
+  // starting from initial.
+  std::vector<int> ScalarCounts(int initial) const {
+    std::vector<int> counts(pruners_.size() * 32, initial);
+    for (size_t p = 0; p < pruners_.size(); ++p) {
+      for (int offset : offsets_) {
+        for (int c = 0; c < 32; ++c) {
+          counts[32 * p + c] += (pruners_[p][offset + c / 16] >> (2 * (c % 16))) & 3;
+        }
+      }
+    }
+    return counts;
+  }
+
+  // Checks the given counts against the scalar ones, for a range of numbers
+  // of pruners and features, including all the weights at their maximum.
+  void ExpectCounts(ClassPrunerCountsFunction class_pruner_counts) {
+    TRand randomizer;
+    randomizer.set_seed(42);
+    for (int num_pruners : {1, 2, 7}) {
+      for (int num_features : {0, 1, 5, 64, 512}) {
+        MakePruners(num_pruners, num_features, &randomizer);
+        std::vector<int> counts(num_pruners * 32, 3);
+        class_pruner_counts(pruners_.data(), num_pruners, offsets_.data(), num_features,
+                            counts.data());
+        EXPECT_EQ(counts, ScalarCounts(3)) << num_pruners << " pruners, " << num_features
+                                           << " features";
+      }
+    }
+    MakePruners(3, 512, &randomizer);
+    for (auto &word : words_) {
+      word = ~0u;
+    }
+    std::vector<int> counts(3 * 32, 0);
+    class_pruner_counts(pruners_.data(), 3, offsets_.data(), 512, counts.data());
+    EXPECT_EQ(counts, std::vector<int>(3 * 32, 3 * 512));
+  }
+
+  std::vector<uint32_t> words_;
+  std::vector<const uint32_t *> pruners_;
+  std::vector<int> offsets_;
+};
+
+TEST_F(ClassPrunerTest, Native) {
+  ExpectCounts(ClassPrunerCounts);
+}
+
+TEST_F(ClassPrunerTest, AVX2) {
+#if defined(HAVE_AVX2)
+  if (!SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVX2 found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectCounts(ClassPrunerCountsAVX2);
+#else
+  GTEST_LOG_(INFO) << "AVX2 unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+TEST_F(ClassPrunerTest, NEON) {
+#if defined(__aarch64__)
+  ExpectCounts(ClassPrunerCountsNEON);
+#else
+  GTEST_LOG_(INFO) << "NEON unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Microbenchmark of the counts of a blob of a large character set, with the
+// code selected for this machine.
+TEST_F(ClassPrunerTest, SpeedTest) {
+  const int kNumPruners = 200;
+  const int kNumFeatures = 100;
+  TRand randomizer;
+  randomizer.set_seed(1);
+  MakePruners(kNumPruners, kNumFeatures, &randomizer);
+  std::vector<int> counts(kNumPruners * 32, 0);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 100; ++i) {
+    ClassPrunerCounts(pruners_.data(), kNumPruners, offsets_.data(), kNumFeatures, counts.data());
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_GT(counts[0], 0);
+  LOG(INFO) << "Class pruner counts took " << elapsed.count() / 100 << "s per blob\n";
+}
+
+} // namespace tesseract
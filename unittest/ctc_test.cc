@@ -0,0 +1,139 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ctc.h"
+#include <chrono>
+#include <vector>
+#include "helpers.h"
+#include "include_gunit.h"
+#include "matrix.h"
+#include "networkio.h"
+
+namespace tesseract {
+
+const int kNullChar = 0;
+
+class CTCTest : public ::testing::Test {
+protected:
+  // Makes num_labels random non-null labels, each with a null before it,
+  // and one at the end, as the trainer does. Labels are repeated with the
+  // given probability, to make some of the nulls essential.
+  static std::vector<int> MakeLabels(int num_labels, int num_classes, double repeat_prob,
+                                     TRand *randomizer) {
+    std::vector<int> labels;
+    int label = 1;
+    for (int i = 0; i < num_labels; ++i) {
+      if (i == 0 || randomizer->UnsignedRand(1.0) >= repeat_prob) {
+        label = 1 + randomizer->IntRand() % (num_classes - 1);
+      }
+      labels.push_back(kNullChar);
+      labels.push_back(label);
+    }
+    labels.push_back(kNullChar);
+    return labels;
+  }
+
+  // Makes random network outputs that roughly follow the labels, spread over
+  // the timesteps, as a partly trained network would give, and normalizes
+  // them as the trainer does.
+  static void MakeOutputs(const std::vector<int> &labels, int num_timesteps, int num_classes,
+                          TRand *randomizer, NetworkIO *outputs) {
+    outputs->Resize2d(false, num_timesteps, num_classes);
+    for (int t = 0; t < num_timesteps; ++t) {
+      float *outputs_t = outputs->f(t);
+      for (int c = 0; c < num_classes; ++c) {
+        outputs_t[c] = randomizer->UnsignedRand(0.1);
+      }
+      int label = labels[t * labels.size() / num_timesteps];
+      outputs_t[label] += randomizer->UnsignedRand(1.0);
+    }
+    CTC::NormalizeProbs(outputs);
+  }
+
+  // Computes the targets with the passes in log space and with scaled
+  // probabilities, and checks that they match.
+  static void ExpectScaledMatchesLogSpace(int num_labels, int num_timesteps, int num_classes,
+                                          double repeat_prob, int seed) {
+    SCOPED_TRACE(testing::Message() << "labels=" << num_labels << " timesteps=" << num_timesteps
+                                    << " seed=" << seed);
+    TRand randomizer;
+    randomizer.set_seed(seed);
+    std::vector<int> labels = MakeLabels(num_labels, num_classes, repeat_prob, &randomizer);
+    NetworkIO outputs;
+    MakeOutputs(labels, num_timesteps, num_classes, &randomizer, &outputs);
+    NetworkIO expected, targets;
+    expected.Resize2d(false, num_timesteps, num_classes);
+    targets.Resize2d(false, num_timesteps, num_classes);
+    bool expected_ok =
+        CTC::ComputeCTCTargets(labels, kNullChar, outputs.float_array(), &expected, true);
+    bool ok = CTC::ComputeCTCTargets(labels, kNullChar, outputs.float_array(), &targets, false);
+    ASSERT_EQ(ok, expected_ok);
+    if (!ok) {
+      return;
+    }
+    for (int t = 0; t < num_timesteps; ++t) {
+      for (int c = 0; c < num_classes; ++c) {
+        ASSERT_NEAR(targets.f(t)[c], expected.f(t)[c], 1e-5) << "t=" << t << " c=" << c;
+      }
+    }
+  }
+};
+
+// Tests that the scaled passes give the same targets as the log space ones
+// over a range of line lengths, including lines with barely enough time for
+// the labels, and with essential nulls between repeated labels.
+TEST_F(CTCTest, ScaledMatchesLogSpace) {
+  for (int seed = 1; seed <= 4; ++seed) {
+    ExpectScaledMatchesLogSpace(1, 5, 20, 0.0, seed);
+    ExpectScaledMatchesLogSpace(10, 40, 20, 0.0, seed);
+    ExpectScaledMatchesLogSpace(10, 12, 20, 0.0, seed);
+    ExpectScaledMatchesLogSpace(30, 200, 110, 0.3, seed);
+    ExpectScaledMatchesLogSpace(30, 45, 110, 0.3, seed);
+    ExpectScaledMatchesLogSpace(200, 1500, 300, 0.1, seed);
+  }
+  // Not enough time for the labels.
+  ExpectScaledMatchesLogSpace(30, 20, 110, 0.0, 1);
+}
+
+// Tests that running the passes concurrently makes no difference.
+TEST_F(CTCTest, ConcurrentPassesMatch) {
+  ctc_concurrent_passes = true;
+  for (int seed = 1; seed <= 4; ++seed) {
+    ExpectScaledMatchesLogSpace(30, 200, 110, 0.3, seed);
+    ExpectScaledMatchesLogSpace(200, 1500, 300, 0.1, seed);
+  }
+  ctc_concurrent_passes = false;
+}
+
+// Microbenchmark of the targets of a long line, with the passes in log space
+// and with scaled probabilities.
+TEST_F(CTCTest, SpeedTest) {
+  const int kNumLabels = 300;
+  const int kNumTimesteps = 2000;
+  const int kNumClasses = 300;
+  TRand randomizer;
+  randomizer.set_seed(1);
+  std::vector<int> labels = MakeLabels(kNumLabels, kNumClasses, 0.1, &randomizer);
+  NetworkIO outputs, targets;
+  MakeOutputs(labels, kNumTimesteps, kNumClasses, &randomizer, &outputs);
+  targets.Resize2d(false, kNumTimesteps, kNumClasses);
+  for (bool log_space : {true, false}) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+      EXPECT_TRUE(
+          CTC::ComputeCTCTargets(labels, kNullChar, outputs.float_array(), &targets, log_space));
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    LOG(INFO) << (log_space ? "Log space" : "Scaled") << " CTC took " << elapsed.count() / 10
+              << "s per line\n";
+  }
+}
+
+} // namespace tesseract
@@ -0,0 +1,167 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gatefunctions.h"
+#include <cmath>
+#include <vector>
+#include "functions.h"
+#include "include_gunit.h"
+#include "simddetect.h"
+
+namespace tesseract {
+
+// Maximum difference between the vectorized functions and the tables.
+const double kMaxTableError = 2e-6;
+
+class GateFunctionsTest : public ::testing::Test {
+protected:
+  // Returns n values spread over a range that covers the saturated tails of
+  // both functions, starting at an odd offset so that they hit the table
+  // entries in many places.
+  std::vector<TFloat> TestValues(int n) {
+    std::vector<TFloat> values(n);
+    for (int i = 0; i < n; ++i) {
+      values[i] = -20.0 + 40.0 * (i + 0.37) / n;
+    }
+    return values;
+  }
+
+  // Checks the given gate functions against the tables, for a range of
+  // lengths, to cover the elements that don't fill a register too.
+  void ExpectCloseToTables(VectorFunction tanh, VectorFunction logistic,
+                           TanhPrimeMultiply3AddFunction tanh_prime_multiply3_add,
+                           LSTMCellFunction lstm_cell) {
+    for (int n : {1, 3, 7, 15, 17, 33, 100003}) {
+      std::vector<TFloat> values = TestValues(n);
+      std::vector<TFloat> tanh_values(values);
+      tanh(n, &tanh_values[0]);
+      std::vector<TFloat> logistic_values(values);
+      logistic(n, &logistic_values[0]);
+      for (int i = 0; i < n; ++i) {
+        EXPECT_NEAR(tanh_values[i], Tanh(values[i]), kMaxTableError) << values[i];
+        EXPECT_NEAR(logistic_values[i], Logistic(values[i]), kMaxTableError) << values[i];
+      }
+      // The state values are limited to +/-100 by the state clip of the LSTM.
+      std::vector<float> u(n), v(n);
+      std::vector<TFloat> w(n), product(n), expected(n);
+      for (int i = 0; i < n; ++i) {
+        u[i] = values[i];
+        v[i] = std::sin(values[i]);
+        w[i] = std::cos(values[i]);
+        product[i] = expected[i] = 0.25;
+      }
+      tanh_prime_multiply3_add(n, &u[0], &v[0], &w[0], &product[0]);
+      HPrime prime;
+      for (int i = 0; i < n; ++i) {
+        expected[i] += prime(u[i]) * v[i] * w[i];
+        EXPECT_NEAR(product[i], expected[i], 2 * kMaxTableError) << values[i];
+      }
+      ExpectCellCloseToTables(n, lstm_cell, false);
+      ExpectCellCloseToTables(n, lstm_cell, true);
+    }
+  }
+
+  // Checks the given LSTM cell update against separate passes over the
+  // vectors with the tables, as LSTM::Forward used to do it, for a 1-D or
+  // 2-D LSTM.
+  void ExpectCellCloseToTables(int n, LSTMCellFunction lstm_cell, bool two_d) {
+    const TFloat kStateClip = 100.0;
+    std::vector<TFloat> values = TestValues(n);
+    std::vector<TFloat> ci(n), gi(n), gf1(n), gfs(n), stepped_state(n), go(n);
+    std::vector<TFloat> state(n), output(n), expected_state(n), expected_output(n);
+    for (int i = 0; i < n; ++i) {
+      TFloat x = values[i];
+      ci[i] = Tanh(x);
+      gi[i] = Logistic(2 * std::sin(x));
+      gf1[i] = Logistic(x);
+      gfs[i] = Logistic(std::cos(x));
+      stepped_state[i] = 3 * std::sin(3 * x);
+      go[i] = Logistic(-x);
+      // Large enough to hit the clip.
+      state[i] = expected_state[i] = 150 * std::cos(x);
+    }
+    MultiplyVectorsInPlace(n, &gf1[0], &expected_state[0]);
+    if (two_d) {
+      for (int i = 0; i < n; ++i) {
+        if (gf1[i] < gfs[i]) {
+          expected_state[i] = gfs[i] * stepped_state[i];
+        }
+      }
+    }
+    MultiplyAccumulate(n, &ci[0], &gi[0], &expected_state[0]);
+    ClipVector<TFloat>(n, -kStateClip, kStateClip, &expected_state[0]);
+    FuncMultiply<HFunc>(&expected_state[0], &go[0], n, &expected_output[0]);
+    lstm_cell(n, &ci[0], &gi[0], &gf1[0], two_d ? &gfs[0] : nullptr,
+              two_d ? &stepped_state[0] : nullptr, &go[0], kStateClip, &state[0], &output[0]);
+    for (int i = 0; i < n; ++i) {
+      EXPECT_NEAR(state[i], expected_state[i], 1e-12 * kStateClip) << values[i];
+      EXPECT_NEAR(output[i], expected_output[i], kMaxTableError) << values[i];
+    }
+  }
+};
+
+// Tests the functions selected for this machine through FuncInplace, which
+// falls back to the tables if there are none.
+TEST_F(GateFunctionsTest, FuncInplace) {
+  const int n = 1001;
+  std::vector<TFloat> values = TestValues(n);
+  std::vector<TFloat> g_values(values);
+  FuncInplace<GFunc>(n, &g_values[0]);
+  std::vector<TFloat> f_values(values);
+  FuncInplace<FFunc>(n, &f_values[0]);
+  for (int i = 0; i < n; ++i) {
+    EXPECT_NEAR(g_values[i], Tanh(values[i]), kMaxTableError);
+    EXPECT_NEAR(f_values[i], Logistic(values[i]), kMaxTableError);
+    // The results must stay in range, as they multiply the LSTM state.
+    EXPECT_LE(std::fabs(g_values[i]), 1.0);
+    EXPECT_GE(f_values[i], 0.0);
+    EXPECT_LE(f_values[i], 1.0);
+  }
+}
+
+TEST_F(GateFunctionsTest, AVX2) {
+#if defined(HAVE_AVX2)
+  if (!SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVX2 found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectCloseToTables(TanhVectorAVX2, LogisticVectorAVX2, TanhPrimeMultiply3AddAVX2,
+                      LSTMCellAVX2);
+#else
+  GTEST_LOG_(INFO) << "AVX2 unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+TEST_F(GateFunctionsTest, AVX512F) {
+#if defined(HAVE_AVX512F)
+  if (!SIMDDetect::IsAVX512FAvailable()) {
+    GTEST_LOG_(INFO) << "No AVX512F found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectCloseToTables(TanhVectorAVX512F, LogisticVectorAVX512F, TanhPrimeMultiply3AddAVX512F,
+                      LSTMCellAVX512F);
+#else
+  GTEST_LOG_(INFO) << "AVX512F unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+TEST_F(GateFunctionsTest, NEON) {
+#if defined(__aarch64__)
+  ExpectCloseToTables(TanhVectorNEON, LogisticVectorNEON, TanhPrimeMultiply3AddNEON,
+                      LSTMCellNEON);
+#else
+  GTEST_LOG_(INFO) << "NEON unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+} // namespace tesseract
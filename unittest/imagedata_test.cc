@@ -9,9 +9,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include <allheaders.h>
+
 #include "imagedata.h"
 #include "include_gunit.h"
 #include "log.h"
@@ -121,4 +124,125 @@ TEST_F(ImagedataTest, CachesMultiDocs) {
   }
 }
 
+TEST_F(ImagedataTest, PrefetchesInOrder) {
+  // This test verifies that prefetching pages on several threads gives the
+  // same pages as reading them in turn, with both caching strategies, even
+  // when the serial numbers jump around.
+  const std::vector<int> kNumPages = {6, 5, 7};
+  std::vector<std::vector<std::string>> page_texts;
+  std::vector<std::string> filenames;
+  for (size_t d = 0; d < kNumPages.size(); ++d) {
+    page_texts.emplace_back(std::vector<std::string>());
+    filenames.push_back(MakeFakeDoc(kNumPages[d], d + 10, &page_texts.back()));
+  }
+  const int kSerials[] = {0, 1, 2, 3, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                          16, 17, 18, 19, 20, 21, 2, 3, 4, 5, 17, 18, -1};
+  for (auto strategy : {tesseract::CS_ROUND_ROBIN, tesseract::CS_SEQUENTIAL}) {
+    DocumentCache cache(8000000);
+    DocumentCache prefetch_cache(8000000);
+    cache.LoadDocuments(filenames, strategy, nullptr);
+    prefetch_cache.LoadDocuments(filenames, strategy, nullptr);
+    prefetch_cache.SetPrefetch(4, 3, 0);
+    int num_requests = 0;
+    for (int i = 0; kSerials[i] >= 0; ++i) {
+      const ImageData *expected = cache.GetPageBySerial(kSerials[i]);
+      const ImageData *page = prefetch_cache.GetPageBySerial(kSerials[i]);
+      CHECK(expected != nullptr);
+      CHECK(page != nullptr);
+      EXPECT_EQ(expected->transcription(), page->transcription()) << "Serial " << kSerials[i];
+      if (i == 0 || kSerials[i] != kSerials[i - 1]) {
+        ++num_requests;
+      }
+    }
+    EXPECT_EQ(num_requests, prefetch_cache.prefetch_requests());
+    EXPECT_LE(prefetch_cache.prefetch_stalls(), num_requests);
+    LOG(INFO) << "Stalled on " << prefetch_cache.prefetch_stalls() << " of "
+              << prefetch_cache.prefetch_requests() << " pages";
+  }
+}
+
+TEST_F(ImagedataTest, PrefetchKeepsToItsShare) {
+  // This test verifies that the pages queued for prefetching never count for
+  // more than their share of the memory, so they can't overshoot it by the
+  // pages that are still being fetched.
+  const std::vector<int> kNumPages = {6, 5, 7};
+  // Room for 8 of the fake pages, of which 2 are for prefetching.
+  const int64_t kMaxMemory = 8 * 1048576;
+  std::vector<std::vector<std::string>> page_texts;
+  std::vector<std::string> filenames;
+  for (size_t d = 0; d < kNumPages.size(); ++d) {
+    page_texts.emplace_back(std::vector<std::string>());
+    filenames.push_back(MakeFakeDoc(kNumPages[d], d + 20, &page_texts.back()));
+  }
+  for (auto strategy : {tesseract::CS_ROUND_ROBIN, tesseract::CS_SEQUENTIAL}) {
+    DocumentCache cache(kMaxMemory);
+    cache.LoadDocuments(filenames, strategy, nullptr);
+    cache.SetPrefetch(6, 3, 0);
+    for (int serial = 0; serial < 40; ++serial) {
+      CHECK(cache.GetPageBySerial(serial) != nullptr);
+      EXPECT_LE(cache.prefetch_memory(), kMaxMemory / 4) << "Serial " << serial;
+    }
+  }
+}
+
+TEST_F(ImagedataTest, DecodedDocMatchesPreScale) {
+  // This test verifies that a document written in the pre-decoded format
+  // gives the same prescaled images and text as the original document,
+  // without any scaling of its own, whatever the order the pages are read.
+  const int kNumPages = 5;
+  const int kTargetHeight = 36;
+  DocumentData write_doc("My document");
+  std::vector<std::string> page_texts;
+  std::vector<std::unique_ptr<ImageData>> originals;
+  for (int p = 0; p < kNumPages; ++p) {
+    // Make a grey image with a different size and pattern for each page.
+    int width = 200 + 37 * p;
+    int height = 30 + 11 * p;
+    Image pix = pixCreate(width, height, 8);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        pixSetPixel(pix, x, y, (x * 7 + y * 13 + p * 29) % 256);
+      }
+    }
+    l_uint8 *data;
+    size_t size;
+    ASSERT_EQ(0, pixWriteMem(&data, &size, pix, IFF_PNG));
+    pix.destroy();
+    page_texts.push_back("Page " + std::to_string(p));
+    const char *image_data = reinterpret_cast<const char *>(data);
+    write_doc.AddPageToDocument(ImageData::Build("noname", p, "eng", image_data, size,
+                                                 page_texts.back().c_str(), nullptr));
+    originals.emplace_back(ImageData::Build("noname", p, "eng", image_data, size,
+                                            page_texts.back().c_str(), nullptr));
+    lept_free(data);
+  }
+  std::string filename = file::JoinPath(FLAGS_test_tmpdir, "decoded.lstmd");
+  EXPECT_TRUE(DocumentData::IsDecodedDocument(filename));
+  ASSERT_TRUE(write_doc.SaveDecodedDocument(filename.c_str(), kTargetHeight, nullptr));
+  EXPECT_EQ(kTargetHeight, DocumentData::ReadDecodedHeight(filename, nullptr));
+  // A limited memory allowance makes the pages get loaded in several parts.
+  DocumentData read_doc("My document");
+  EXPECT_TRUE(read_doc.LoadDocument(filename.c_str(), 0, 20000, nullptr));
+  const int kPageReadOrder[] = {0, 1, 4, 2, 3, 0, -1};
+  for (int i = 0; kPageReadOrder[i] >= 0; ++i) {
+    int p = kPageReadOrder[i];
+    const ImageData *decoded = read_doc.GetPage(p);
+    ASSERT_NE(nullptr, decoded);
+    EXPECT_EQ(page_texts[p], decoded->transcription());
+    EXPECT_TRUE(decoded->image_data().empty());
+    float expected_scale, scale;
+    int expected_width, width;
+    Image expected_pix = originals[p]->PreScale(kTargetHeight, kTargetHeight, &expected_scale,
+                                                &expected_width, nullptr, nullptr);
+    Image pix = decoded->PreScale(kTargetHeight, kTargetHeight, &scale, &width, nullptr, nullptr);
+    EXPECT_FLOAT_EQ(expected_scale, scale);
+    EXPECT_EQ(expected_width, width);
+    l_int32 same = 0;
+    pixEqual(expected_pix, pix, &same);
+    EXPECT_TRUE(same);
+    expected_pix.destroy();
+    pix.destroy();
+  }
+}
+
 } // namespace tesseract
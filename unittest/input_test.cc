@@ -0,0 +1,63 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "input.h"
+#include <vector>
+#include "include_gunit.h"
+
+namespace tesseract {
+
+// Tests that every line goes into exactly one batch, narrowest first.
+TEST(InputTest, BucketByWidthCoversAllLines) {
+  std::vector<int> widths = {300, 40, 310, 45, 1000, 290, 42};
+  std::vector<std::vector<int>> batches;
+  Input::BucketByWidth(widths, 0, &batches);
+  std::vector<int> seen(widths.size(), 0);
+  int prev_width = 0;
+  for (const auto &batch : batches) {
+    EXPECT_FALSE(batch.empty());
+    for (int line : batch) {
+      ++seen[line];
+      EXPECT_GE(widths[line], prev_width);
+      prev_width = widths[line];
+    }
+  }
+  for (int count : seen) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+// Tests that lines of very different widths are kept apart, and lines of
+// similar widths are put together.
+TEST(InputTest, BucketByWidthGroupsSimilarWidths) {
+  std::vector<int> widths = {300, 40, 310, 45, 1000, 290, 42};
+  std::vector<std::vector<int>> batches;
+  Input::BucketByWidth(widths, 0, &batches);
+  std::vector<std::vector<int>> expected = {{1, 6, 3}, {5, 0, 2}, {4}};
+  EXPECT_EQ(batches, expected);
+}
+
+// Tests that no batch exceeds the max size.
+TEST(InputTest, BucketByWidthLimitsBatchSize) {
+  std::vector<int> widths(10, 100);
+  std::vector<std::vector<int>> batches;
+  Input::BucketByWidth(widths, 4, &batches);
+  ASSERT_EQ(batches.size(), 3);
+  EXPECT_EQ(batches[0].size(), 4);
+  EXPECT_EQ(batches[1].size(), 4);
+  EXPECT_EQ(batches[2].size(), 2);
+  // Equal widths stay in their original order.
+  EXPECT_EQ(batches[0][0], 0);
+  EXPECT_EQ(batches[2][1], 9);
+  Input::BucketByWidth({}, 4, &batches);
+  EXPECT_TRUE(batches.empty());
+}
+
+} // namespace tesseract
@@ -21,8 +21,10 @@
 #include <vector>
 #include "include_gunit.h"
 #include "matrix.h"
+#include "serialis.h"
 #include "simddetect.h"
 #include "tprintf.h"
+#include "weightmatrix.h"
 
 namespace tesseract {
 
@@ -97,16 +99,203 @@ protected:
     EXPECT_FLOAT_EQ(total, 337849.39354684710);
 #endif
   }
+  // Tests a range of sizes and numbers of input vectors and compares the
+  // results of matrix.matrix against the generic matrix.vector.
+  void ExpectEqualMatrixResults(const IntSimdMatrix &matrix) {
+    for (int num_out = 1; num_out < 130; num_out += 3) {
+      for (int num_in = 1; num_in < 130; num_in += 5) {
+        for (int num_vectors = 1; num_vectors <= 9; ++num_vectors) {
+          GENERIC_2D_ARRAY<int8_t> w = InitRandom(num_out, num_in + 1);
+          std::vector<TFloat> scales = RandomScales(num_out);
+          std::vector<std::vector<int8_t>> u;
+          std::vector<std::vector<TFloat>> test_results;
+          std::vector<const int8_t *> inputs;
+          std::vector<TFloat *> outputs;
+          for (int c = 0; c < num_vectors; ++c) {
+            u.push_back(RandomVector(num_in, matrix));
+            test_results.emplace_back(matrix.RoundOutputs(num_out));
+          }
+          for (int c = 0; c < num_vectors; ++c) {
+            inputs.push_back(u[c].data());
+            outputs.push_back(test_results[c].data());
+          }
+          std::vector<int8_t> shaped_wi;
+          int32_t rounded_num_out;
+          matrix.Init(w, shaped_wi, rounded_num_out);
+          std::vector<TFloat> shaped_scales(scales);
+          shaped_scales.resize(rounded_num_out);
+          if (matrix.matrixDotMatrixFunction) {
+            matrix.matrixDotMatrixFunction(w.dim1(), w.dim2(), &shaped_wi[0], &shaped_scales[0],
+                                           num_vectors, &inputs[0], &outputs[0]);
+          } else {
+            IntSimdMatrix::MatrixDotMatrix(w, scales, num_vectors, &inputs[0], &outputs[0]);
+          }
+          std::vector<TFloat> base_result(num_out);
+          for (int c = 0; c < num_vectors; ++c) {
+            IntSimdMatrix::MatrixDotVector(w, scales, u[c].data(), base_result.data());
+            for (int i = 0; i < num_out; ++i) {
+              EXPECT_FLOAT_EQ(base_result[i], test_results[c][i]) << "c=" << c << " i=" << i;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Checks that splitting the reshaped weights of a random matrix gives the
+  // same as reshaping the split matrix for each multiple of the input group
+  // size, and that the split is refused for the other sizes.
+  void ExpectEqualSplits(const IntSimdMatrix &matrix) {
+    for (int num_out = 1; num_out < 70; num_out += 3) {
+      for (int num_in = 1; num_in < 70; num_in += 5) {
+        GENERIC_2D_ARRAY<int8_t> w = InitRandom(num_out, num_in + 1);
+        std::vector<int8_t> shaped_w;
+        int32_t rounded_num_out;
+        matrix.Init(w, shaped_w, rounded_num_out);
+        for (int num_first = 0; num_first <= num_in; ++num_first) {
+          std::vector<int8_t> first, rest;
+          bool split = matrix.SplitInputs(shaped_w, num_out, num_in, num_first, first, rest);
+          EXPECT_EQ(split, num_first % matrix.num_inputs_per_group_ == 0);
+          if (!split) {
+            continue;
+          }
+          int num_rest = num_in - num_first;
+          GENERIC_2D_ARRAY<int8_t> w_first(num_out, num_first + 1, 0);
+          GENERIC_2D_ARRAY<int8_t> w_rest(num_out, num_rest + 1, 0);
+          for (int i = 0; i < num_out; ++i) {
+            for (int j = 0; j < num_first; ++j) {
+              w_first(i, j) = w(i, j);
+            }
+            w_first(i, num_first) = w(i, num_in);
+            for (int j = 0; j < num_rest; ++j) {
+              w_rest(i, j) = w(i, num_first + j);
+            }
+          }
+          std::vector<int8_t> expected_first, expected_rest;
+          matrix.Init(w_first, expected_first, rounded_num_out);
+          matrix.Init(w_rest, expected_rest, rounded_num_out);
+          EXPECT_EQ(first, expected_first) << num_out << "x" << num_in << " at " << num_first;
+          EXPECT_EQ(rest, expected_rest) << num_out << "x" << num_in << " at " << num_first;
+        }
+      }
+    }
+  }
+  // Serializes a random int WeightMatrix with its weights reshaped for the
+  // given shape and checks that the deserialized copy gives the same results.
+  void ExpectSameAfterShapedSerialize(const IntSimdMatrix *shape) {
+    const int kNumOut = 37;
+    const int kNumIn = 101;
+    WeightMatrix weights;
+    weights.InitWeightsFloat(kNumOut, kNumIn + 1, false, 0.5f, &random_);
+    weights.ConvertToInt();
+    std::vector<char> data;
+    TFile writer;
+    writer.OpenWrite(&data);
+    WeightMatrix::SetSerializeShape(shape);
+    bool serialized = weights.Serialize(false, &writer);
+    WeightMatrix::SetSerializeShape(nullptr);
+    ASSERT_TRUE(serialized);
+    const int8_t kSentinel = 42;
+    ASSERT_TRUE(writer.Serialize(&kSentinel));
+    TFile reader;
+    ASSERT_TRUE(reader.Open(&data[0], data.size()));
+    WeightMatrix loaded;
+    ASSERT_TRUE(loaded.DeSerialize(false, &reader));
+    int8_t sentinel;
+    ASSERT_TRUE(reader.DeSerialize(&sentinel));
+    EXPECT_EQ(sentinel, kSentinel);
+    std::vector<int8_t> u = RandomVector(kNumIn, *IntSimdMatrix::intSimdMatrix);
+    std::vector<TFloat> expected(IntSimdMatrix::intSimdMatrix->RoundOutputs(kNumOut));
+    std::vector<TFloat> result(expected.size());
+    weights.MatrixDotVector(u.data(), expected.data());
+    loaded.MatrixDotVector(u.data(), result.data());
+    for (int i = 0; i < kNumOut; ++i) {
+      EXPECT_FLOAT_EQ(expected[i], result[i]) << "i=" << i;
+    }
+  }
 
   TRand random_;
 };
 
+// Tests splitting reshaped weights for each of the known shapes.
+TEST_F(IntSimdMatrixTest, SplitInputs) {
+  for (const char *name : {"avx512vnni", "avx2", "sse", "neon"}) {
+    const IntSimdMatrix *shape = IntSimdMatrix::ShapeForName(name);
+    ASSERT_NE(shape, nullptr) << name;
+    ExpectEqualSplits(*shape);
+  }
+  EXPECT_EQ(IntSimdMatrix::ShapeForName("unknown"), nullptr);
+}
+
+// Tests that the named shapes match the implementations that are available.
+TEST_F(IntSimdMatrixTest, ShapeForName) {
+#if defined(HAVE_AVX2)
+  EXPECT_TRUE(IntSimdMatrix::ShapeForName("avx2")->SameShape(IntSimdMatrix::intSimdMatrixAVX2));
+#endif
+#if defined(HAVE_AVX512VNNI)
+  EXPECT_TRUE(IntSimdMatrix::ShapeForName("avx512vnni")
+                  ->SameShape(IntSimdMatrix::intSimdMatrixAVX512VNNI));
+#endif
+#if defined(HAVE_AVXVNNI)
+  EXPECT_TRUE(
+      IntSimdMatrix::ShapeForName("avxvnni")->SameShape(IntSimdMatrix::intSimdMatrixAVXVNNI));
+#endif
+#if defined(HAVE_SSE4_1)
+  EXPECT_TRUE(IntSimdMatrix::ShapeForName("sse")->SameShape(IntSimdMatrix::intSimdMatrixSSE));
+#endif
+  EXPECT_FALSE(IntSimdMatrix::ShapeForName("avx2")->SameShape(
+      *IntSimdMatrix::ShapeForName("avx512vnni")));
+}
+
+// Tests loading weights reshaped for the IntSimdMatrix in use, which are
+// used as they are, and for another shape, which are reshaped on load.
+TEST_F(IntSimdMatrixTest, ShapedSerialize) {
+  if (IntSimdMatrix::intSimdMatrix == nullptr) {
+    GTEST_LOG_(INFO) << "No IntSimdMatrix in use! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectSameAfterShapedSerialize(nullptr);
+  ExpectSameAfterShapedSerialize(IntSimdMatrix::intSimdMatrix);
+  for (const char *name : {"avx512vnni", "avx2", "sse", "neon"}) {
+    ExpectSameAfterShapedSerialize(IntSimdMatrix::ShapeForName(name));
+  }
+}
+
+// Tests that joining the parts of split weights gives back the same matrix,
+// as LSTM relies on to serialize its split gate weights.
+TEST_F(IntSimdMatrixTest, JoinInputs) {
+  const int kNumOut = 37;
+  const int kNumIn = 101;
+  WeightMatrix weights;
+  weights.InitWeightsFloat(kNumOut, kNumIn + 1, false, 0.5f, &random_);
+  weights.ConvertToInt();
+  std::vector<char> expected;
+  TFile writer;
+  writer.OpenWrite(&expected);
+  ASSERT_TRUE(weights.Serialize(false, &writer));
+  for (int num_first : {1, 8, 50, 100}) {
+    WeightMatrix first, rest, joined;
+    weights.SplitInputs(num_first, &first, &rest);
+    joined.JoinInputs(first, rest);
+    std::vector<char> data;
+    writer.OpenWrite(&data);
+    ASSERT_TRUE(joined.Serialize(false, &writer));
+    EXPECT_EQ(data, expected) << "split at " << num_first;
+  }
+}
+
 // Test the C++ implementation without SIMD.
 TEST_F(IntSimdMatrixTest, C) {
-  static const IntSimdMatrix matrix = {nullptr, 1, 1, 1, 1};
+  static const IntSimdMatrix matrix = {nullptr, 1, 1, 1, 1, nullptr};
   ExpectEqualResults(matrix);
 }
 
+// Tests the C++ implementation of matrix.matrix without SIMD.
+TEST_F(IntSimdMatrixTest, CMatrix) {
+  static const IntSimdMatrix matrix = {nullptr, 1, 1, 1, 1, nullptr};
+  ExpectEqualMatrixResults(matrix);
+}
+
 // Tests that the SSE implementation gets the same result as the vanilla.
 TEST_F(IntSimdMatrixTest, SSE) {
 #if defined(HAVE_SSE4_1)
@@ -121,6 +310,20 @@ TEST_F(IntSimdMatrixTest, SSE) {
 #endif
 }
 
+// Tests that the SSE matrix.matrix gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, SSEMatrix) {
+#if defined(HAVE_SSE4_1)
+  if (!SIMDDetect::IsSSEAvailable()) {
+    GTEST_LOG_(INFO) << "No SSE found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixSSE);
+#else
+  GTEST_LOG_(INFO) << "SSE unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
 // Tests that the AVX2 implementation gets the same result as the vanilla.
 TEST_F(IntSimdMatrixTest, AVX2) {
 #if defined(HAVE_AVX2)
@@ -135,4 +338,74 @@ TEST_F(IntSimdMatrixTest, AVX2) {
 #endif
 }
 
+// Tests that the AVX2 matrix.matrix gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVX2Matrix) {
+#if defined(HAVE_AVX2)
+  if (!SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVX2 found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixAVX2);
+#else
+  GTEST_LOG_(INFO) << "AVX2 unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests that the AVX512VNNI implementation gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVX512VNNI) {
+#if defined(HAVE_AVX512VNNI)
+  if (!SIMDDetect::IsAVX512VNNIAvailable() || !SIMDDetect::IsAVX512BWAvailable()) {
+    GTEST_LOG_(INFO) << "No AVX512VNNI found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectEqualResults(IntSimdMatrix::intSimdMatrixAVX512VNNI);
+#else
+  GTEST_LOG_(INFO) << "AVX512VNNI unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests that the AVX512VNNI matrix.matrix gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVX512VNNIMatrix) {
+#if defined(HAVE_AVX512VNNI)
+  if (!SIMDDetect::IsAVX512VNNIAvailable() || !SIMDDetect::IsAVX512BWAvailable()) {
+    GTEST_LOG_(INFO) << "No AVX512VNNI found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixAVX512VNNI);
+#else
+  GTEST_LOG_(INFO) << "AVX512VNNI unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests that the AVXVNNI implementation gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVXVNNI) {
+#if defined(HAVE_AVXVNNI)
+  if (!SIMDDetect::IsAVXVNNIAvailable() || !SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVXVNNI found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectEqualResults(IntSimdMatrix::intSimdMatrixAVXVNNI);
+#else
+  GTEST_LOG_(INFO) << "AVXVNNI unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+// Tests that the AVXVNNI matrix.matrix gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVXVNNIMatrix) {
+#if defined(HAVE_AVXVNNI)
+  if (!SIMDDetect::IsAVXVNNIAvailable() || !SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVXVNNI found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixAVXVNNI);
+#else
+  GTEST_LOG_(INFO) << "AVXVNNI unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
 } // namespace tesseract
@@ -9,8 +9,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "include_gunit.h"
 
@@ -24,6 +28,7 @@
 #include "pageres.h"
 #include "polyblk.h"
 #include "stepblob.h"
+#include "tesseractclass.h"
 
 namespace tesseract {
 
@@ -182,6 +187,45 @@ protected:
     } while (it->Next(tesseract::RIL_BLOCK));
   }
 
+  // Runs layout analysis alone on the current image, returning the boxes of
+  // the blocks found, in image coords, and the time it took in ms.
+  std::vector<TBOX> LayoutBlocks(double *ms) {
+    api_.SetImage(src_pix_);
+    // Not all the test images record their resolution, so they are all laid
+    // out as 300 dpi scans.
+    api_.SetSourceResolution(300);
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<PageIterator> it(api_.AnalyseLayout());
+    *ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+              .count();
+    std::vector<TBOX> boxes;
+    if (it != nullptr) {
+      do {
+        int left, top, right, bottom;
+        if (it->BoundingBox(tesseract::RIL_BLOCK, &left, &top, &right, &bottom)) {
+          boxes.emplace_back(ICOORD(left, top), ICOORD(right, bottom));
+        }
+      } while (it->Next(tesseract::RIL_BLOCK));
+    }
+    return boxes;
+  }
+
+  // Returns the fraction of the expected blocks that a block of boxes
+  // overlaps by at least half of the area of their union.
+  static double BlockAgreement(const std::vector<TBOX> &expected, const std::vector<TBOX> &boxes) {
+    int matched = 0;
+    for (const auto &e : expected) {
+      for (const auto &box : boxes) {
+        double overlap = e.intersection(box).area();
+        if (overlap >= 0.5 * (e.area() + box.area() - overlap)) {
+          ++matched;
+          break;
+        }
+      }
+    }
+    return expected.empty() ? 1.0 : static_cast<double>(matched) / expected.size();
+  }
+
   Image src_pix_;
   std::string ocr_text_;
   tesseract::TessBaseAPI api_;
@@ -208,6 +252,85 @@ TEST_F(LayoutTest, UNLV8087_054) {
   delete it;
 }
 
+// Tests that POLY_BLOCK::scale maps a block found on an image reduced by 4
+// onto exactly the pixels of the full image that were reduced into the
+// pixels of the block.
+TEST_F(LayoutTest, ScaleReducedBlock) {
+  const int kFactor = 4;
+  // The full size is not a multiple of the factor, so the reduction left out
+  // the last column and the last 2 rows, which are at the bottom, at y 0 and 1.
+  const ICOORD kReducedSize(10, 7);
+  const ICOORD kFullSize(41, 30);
+  const TBOX kReducedBoxes[] = {TBOX(2, 1, 5, 4), TBOX(0, 0, 10, 7), TBOX(3, 0, 10, 2),
+                                TBOX(0, 6, 1, 7)};
+  for (const auto &reduced_box : kReducedBoxes) {
+    POLY_BLOCK block(reduced_box, PT_FLOWING_TEXT);
+    block.scale(kFactor, kReducedSize, kFullSize);
+    PB_LINE_IT lines(&block);
+    for (int y = 0; y < kFullSize.y(); ++y) {
+      // The reduced pixels that this row and each column went into, taking
+      // those left out as part of the last ones.
+      int reduced_row = std::min((kFullSize.y() - 1 - y) / kFactor, kReducedSize.y() - 1);
+      int reduced_y = kReducedSize.y() - 1 - reduced_row;
+      std::string expected(kFullSize.x(), '.');
+      for (int x = 0; x < kFullSize.x(); ++x) {
+        int reduced_x = std::min(x / kFactor, kReducedSize.x() - 1);
+        if (reduced_box.left() <= reduced_x && reduced_x < reduced_box.right() &&
+            reduced_box.bottom() <= reduced_y && reduced_y < reduced_box.top()) {
+          expected[x] = '#';
+        }
+      }
+      std::string covered(kFullSize.x(), '.');
+      std::unique_ptr<ICOORDELT_LIST> segments(lines.get_line(y));
+      ICOORDELT_IT seg_it(segments.get());
+      for (seg_it.mark_cycle_pt(); !seg_it.cycled_list(); seg_it.forward()) {
+        for (int x = seg_it.data()->x(); x < seg_it.data()->x() + seg_it.data()->y(); ++x) {
+          if (0 <= x && x < kFullSize.x()) {
+            covered[x] = '#';
+          }
+        }
+      }
+      EXPECT_EQ(expected, covered) << "y=" << y << " for reduced box " << reduced_box.left()
+                                   << "," << reduced_box.bottom() << "," << reduced_box.right()
+                                   << "," << reduced_box.top();
+    }
+  }
+}
+
+// Compares the layout found at reduced resolution with that found at full
+// resolution, reporting the agreement of the blocks and the time taken, and
+// tests that the important blocks of 8087_054 are still found in order.
+TEST_F(LayoutTest, ReducedResolutionLayout) {
+  const char *kImages[] = {"8087_054.3B.tif", "hebrew.png"};
+  for (const char *image : kImages) {
+    SetImage(image, "eng");
+    api_.SetVariable("pageseg_reduced_resolution", "0");
+    double full_ms;
+    std::vector<TBOX> full_blocks = LayoutBlocks(&full_ms);
+    // Reduce by 2 from 300 dpi.
+    api_.SetVariable("pageseg_reduced_resolution", "150");
+    double reduced_ms;
+    std::vector<TBOX> reduced_blocks = LayoutBlocks(&reduced_ms);
+    EXPECT_GT(api_.tesseract()->PageSegReduction(tesseract::PSM_AUTO), 1) << image;
+    double agreement = BlockAgreement(full_blocks, reduced_blocks);
+    LOG(INFO) << image << ": " << full_blocks.size() << " blocks in " << full_ms << "ms, "
+              << reduced_blocks.size() << " at reduced resolution in " << reduced_ms
+              << "ms, agreeing on " << agreement * 100 << "%\n";
+    RecordProperty(std::string(image) + "_block_agreement", std::to_string(agreement));
+    RecordProperty(std::string(image) + "_full_ms", std::to_string(full_ms));
+    RecordProperty(std::string(image) + "_reduced_ms", std::to_string(reduced_ms));
+    EXPECT_GE(agreement, 0.5) << image;
+  }
+  SetImage("8087_054.3B.tif", "eng");
+  api_.SetVariable("pageseg_reduced_resolution", "150");
+  api_.SetSourceResolution(300);
+  EXPECT_EQ(api_.Recognize(nullptr), 0);
+  EXPECT_GT(api_.tesseract()->PageSegReduction(tesseract::PSM_AUTO), 1);
+  tesseract::ResultIterator *it = api_.GetIterator();
+  VerifyBlockTextOrder(kStrings8087_054, kBlocks8087_054, it);
+  delete it;
+}
+
 // Tests that Tesseract gets the important blocks and in the right order
 // on GOOGLE:13510798882202548:74:84.sj-79.tif (Hebrew image)
 // TODO: replace hebrew.png by Google image referred above
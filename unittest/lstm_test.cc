@@ -139,6 +139,99 @@ TEST_F(LSTMTrainerTest, DeterminismTest) {
   LOG(INFO) << "********** *** ************\n";
 }
 
+// Tests that training on mini-batches, with the samples of each on several
+// threads, learns, and gets the same results every time.
+TEST_F(LSTMTrainerTest, BatchTest) {
+  SetupTrainerEng("[1,1,0,32 Lfx100 O1c1]", "1D-lstm", false, false);
+  double lstm_batch_err_a = TrainIterations(kTrainerIterations * 2, 4);
+  EXPECT_LT(lstm_batch_err_a, 90);
+  LOG(INFO) << "********** Expected  < 90 ************\n";
+  double char_error_a = trainer_->CharError();
+  SetupTrainerEng("[1,1,0,32 Lfx100 O1c1]", "1D-lstm", false, false);
+  double lstm_batch_err_b = TrainIterations(kTrainerIterations * 2, 4);
+  EXPECT_FLOAT_EQ(lstm_batch_err_a, lstm_batch_err_b);
+  EXPECT_FLOAT_EQ(char_error_a, trainer_->CharError());
+}
+
+// Tests that a mini-batch keeps the same training state as training on its
+// samples in turn, when some of them are unusable. The learning rate is 0, so
+// the weights don't change between the samples of the batch.
+TEST_F(LSTMTrainerTest, BatchMatchesLines) {
+  // Copy the training data, making every third line unencodable.
+  DocumentData doc("eng");
+  ASSERT_TRUE(
+      doc.LoadDocument(TestDataNameToPath("eng.Arial.exp0.lstmf").c_str(), 0, 0, nullptr));
+  DocumentData mixed("mixed");
+  for (int p = 0; p < doc.NumPages(); ++p) {
+    const ImageData *page = doc.GetPage(p);
+    std::string truth = p % 3 == 1 ? "中文" : page->transcription();
+    mixed.AddPageToDocument(ImageData::Build(
+        page->imagefilename().c_str(), p, page->language().c_str(), page->image_data().data(),
+        page->image_data().size(), truth.c_str(), nullptr));
+  }
+  std::string filename = file::JoinPath(FLAGS_test_tmpdir, "mixed.lstmf");
+  ASSERT_TRUE(mixed.SaveDocument(filename.c_str(), nullptr));
+  const int kBatchSize = 4;
+  const int kNumBatches = 5;
+  SetupTrainerEng("[1,1,0,32 Lfx100 O1c1]", "1D-lstm", false, false);
+  ASSERT_TRUE(trainer_->LoadAllTrainingData({filename}, CS_SEQUENTIAL, false));
+  trainer_->SetLearningRate(0.0f);
+  auto batch_trainer = std::move(trainer_);
+  SetupTrainerEng("[1,1,0,32 Lfx100 O1c1]", "1D-lstm", false, false);
+  ASSERT_TRUE(trainer_->LoadAllTrainingData({filename}, CS_SEQUENTIAL, false));
+  trainer_->SetLearningRate(0.0f);
+  for (int batch = 0; batch < kNumBatches; ++batch) {
+    batch_trainer->TrainOnBatch(batch_trainer.get(), kBatchSize);
+    for (int b = 0; b < kBatchSize; ++b) {
+      trainer_->TrainOnLine(trainer_.get(), false);
+    }
+    EXPECT_EQ(trainer_->sample_iteration(), batch_trainer->sample_iteration());
+    EXPECT_EQ(trainer_->training_iteration(), batch_trainer->training_iteration());
+    EXPECT_EQ(trainer_->learning_iteration(), batch_trainer->learning_iteration());
+    for (int type = ET_RMS; type < ET_COUNT; ++type) {
+      auto error_type = static_cast<ErrorTypes>(type);
+      EXPECT_DOUBLE_EQ(trainer_->LastSingleError(error_type),
+                       batch_trainer->LastSingleError(error_type))
+          << "Batch " << batch << ", error type " << type;
+    }
+  }
+  EXPECT_LT(trainer_->training_iteration(), trainer_->sample_iteration());
+}
+
+// Tests that running lines of mixed widths through the network in batches, of
+// any size, gives exactly the outputs of running each line on its own.
+TEST_F(LSTMTrainerTest, RecognizeLinesTest) {
+  SetupTrainerEng("[1,32,0,1 Ct5,5,16 Mp2,2 Lfys32 Lbx64 O1c1]", "batch-lstm", false, false);
+  const int kNumLines = 7;
+  std::vector<const ImageData *> images;
+  std::vector<NetworkIO> expected(kNumLines);
+  for (int i = 0; i < kNumLines; ++i) {
+    images.push_back(trainer_->mutable_training_data()->GetPageBySerial(i));
+    float scale_factor;
+    NetworkIO inputs;
+    EXPECT_TRUE(trainer_->RecognizeLine(*images[i], 0.0f, false, false, false, &scale_factor,
+                                        &inputs, &expected[i]));
+    LOG(INFO) << "Line " << i << " has " << expected[i].Width() << " timesteps\n";
+  }
+  for (int batch_size : {0, 1, 2, 3, 5}) {
+    std::vector<NetworkIO> outputs;
+    std::vector<float> scale_factors;
+    EXPECT_TRUE(
+        trainer_->RecognizeLines(images, 0.0f, false, &outputs, &scale_factors, batch_size));
+    ASSERT_EQ(kNumLines, outputs.size());
+    for (int i = 0; i < kNumLines; ++i) {
+      ASSERT_EQ(expected[i].Width(), outputs[i].Width()) << "batch_size=" << batch_size;
+      ASSERT_EQ(expected[i].NumFeatures(), outputs[i].NumFeatures());
+      for (int t = 0; t < outputs[i].Width(); ++t) {
+        for (int f = 0; f < outputs[i].NumFeatures(); ++f) {
+          ASSERT_EQ(expected[i].f(t)[f], outputs[i].f(t)[f])
+              << "batch_size=" << batch_size << ", line " << i << ", t=" << t << ", f=" << f;
+        }
+      }
+    }
+  }
+}
+
 // The baseline network against which to test the built-in softmax.
 TEST_F(LSTMTrainerTest, SoftmaxBaselineTest) {
   // A basic single-layer, single direction LSTM.
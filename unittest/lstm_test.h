@@ -98,7 +98,8 @@ protected:
     LOG(INFO) << "Setup network:" << model_name << "\n";
   }
   // Trains for a given number of iterations and returns the char error rate.
-  double TrainIterations(int max_iterations) {
+  // If batch_size > 1, trains on mini-batches of that many samples.
+  double TrainIterations(int max_iterations, int batch_size = 1) {
     int iteration = trainer_->training_iteration();
     int iteration_limit = iteration + max_iterations;
     double best_error = 100.0;
@@ -108,9 +109,15 @@ protected:
       // Train a few.
       double mean_error = 0.0;
       while (iteration < target_iteration && iteration < iteration_limit) {
-        trainer_->TrainOnLine(trainer_.get(), false);
+        int prev_iteration = iteration;
+        if (batch_size > 1) {
+          trainer_->TrainOnBatch(trainer_.get(), batch_size);
+        } else {
+          trainer_->TrainOnLine(trainer_.get(), false);
+        }
         iteration = trainer_->training_iteration();
-        mean_error += trainer_->LastSingleError(ET_CHAR_ERROR);
+        // Only the error of the last sample is available after a batch.
+        mean_error += trainer_->LastSingleError(ET_CHAR_ERROR) * (iteration - prev_iteration);
       }
       trainer_->MaintainCheckpoints(nullptr, log_str);
       iteration = trainer_->training_iteration();
@@ -212,4 +212,29 @@ TEST_F(NetworkioTest, CopyWithXYTranspose) {
 #endif
 }
 
+// Tests that CopyBatchFrom extracts each image of the batch without padding.
+TEST_F(NetworkioTest, CopyBatchFrom) {
+#ifdef INCLUDE_TENSORFLOW
+  NetworkIO nio;
+  SetupNetworkIO(&nio);
+  const int kExpectedSizes[] = {3 * 4, 4 * 5};
+  int expected_value = 0;
+  for (int b = 0; b < 2; ++b) {
+    NetworkIO copy;
+    copy.CopyBatchFrom(nio, b);
+    EXPECT_EQ(copy.stride_map().Size(FD_BATCH), 1);
+    EXPECT_EQ(copy.Width(), kExpectedSizes[b]);
+    // The batch is copied densely, in order.
+    for (int t = 0; t < copy.Width(); ++t, ++expected_value) {
+      EXPECT_EQ(copy.i(t)[0], expected_value);
+      EXPECT_EQ(copy.i(t)[1], -expected_value);
+    }
+  }
+  EXPECT_EQ(expected_value, 32);
+#else
+  LOG(INFO) << "Skip test because of missing xla::Array2D";
+  GTEST_SKIP();
+#endif
+}
+
 } // namespace tesseract
@@ -0,0 +1,158 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "networkplan.h"
+#include <memory>
+#include <utility>
+#include <vector>
+#include "include_gunit.h"
+#include "networkbuilder.h"
+#include "networkio.h"
+#include "networkscratch.h"
+#include "parallel.h"
+#include "stridemap.h"
+
+namespace tesseract {
+
+class NetworkPlanTest : public ::testing::Test {
+protected:
+  // Builds the network from spec, with random weights, for inference in
+  // int or float mode.
+  std::unique_ptr<Network> BuildNetwork(const char *spec, bool int_mode) {
+    Network *network = nullptr;
+    TRand randomizer;
+    randomizer.set_seed(42);
+    EXPECT_TRUE(NetworkBuilder::InitNetwork(10, spec, -1, 0, 0.5f, &randomizer, &network));
+    network->SetEnableTraining(TS_DISABLED);
+    if (int_mode) {
+      network->ConvertToInt();
+    }
+    return std::unique_ptr<Network>(network);
+  }
+
+  // Fills *inputs with a batch of random images of the given height and the
+  // given widths.
+  static void SetupInputs(int height, const std::vector<int> &widths, bool int_mode,
+                          NetworkIO *inputs) {
+    std::vector<std::pair<int, int>> h_w_sizes;
+    for (int width : widths) {
+      h_w_sizes.emplace_back(height, width);
+    }
+    StrideMap stride_map;
+    stride_map.SetStride(h_w_sizes);
+    inputs->ResizeToMap(int_mode, stride_map, 1);
+    TRand randomizer;
+    randomizer.set_seed(7);
+    StrideMap::Index index(stride_map);
+    do {
+      inputs->SetPixel(index.t(), 0, randomizer.IntRand() % 256, 0.0f, 128.0f);
+    } while (index.Increment());
+  }
+
+  // Checks that all the valid outputs are identical.
+  static void ExpectSameOutputs(const NetworkIO &expected, const NetworkIO &outputs) {
+    ASSERT_EQ(outputs.Width(), expected.Width());
+    ASSERT_EQ(outputs.NumFeatures(), expected.NumFeatures());
+    StrideMap::Index index(expected.stride_map());
+    do {
+      int t = index.t();
+      for (int f = 0; f < expected.NumFeatures(); ++f) {
+        ASSERT_EQ(outputs.f(t)[f], expected.f(t)[f]) << "t=" << t << " f=" << f;
+      }
+    } while (index.Increment());
+  }
+
+  // Runs the network with Forward and with a compiled plan, and checks that
+  // all the valid outputs are identical. If branch_threads > 1, the
+  // directions of the LSTMs also run concurrently, with both Forward and the
+  // plan, and must still give the same outputs as running them in turn.
+  void ExpectPlanMatchesForward(const char *spec, int height, bool int_mode,
+                                int branch_threads = 0) {
+    SCOPED_TRACE(spec);
+    std::unique_ptr<Network> network = BuildNetwork(spec, int_mode);
+    NetworkPlan plan;
+    plan.Compile(network.get());
+    EXPECT_EQ(plan.network(), network.get());
+    NetworkIO inputs;
+    SetupInputs(height, {37, 23}, int_mode, &inputs);
+    TRand randomizer;
+    NetworkScratch scratch;
+    scratch.set_int_mode(int_mode);
+    scratch.set_randomizer(&randomizer);
+    NetworkIO expected, outputs;
+    lstm_branch_threads = 0;
+    randomizer.set_seed(1);
+    network->Forward(false, inputs, nullptr, &scratch, &expected);
+    lstm_branch_threads = branch_threads;
+    if (branch_threads > 1) {
+      randomizer.set_seed(1);
+      network->Forward(false, inputs, nullptr, &scratch, &outputs);
+      ExpectSameOutputs(expected, outputs);
+    }
+    randomizer.set_seed(1);
+    plan.Run(inputs, &scratch, &outputs);
+    lstm_branch_threads = 0;
+    ExpectSameOutputs(expected, outputs);
+  }
+};
+
+// Tests the usual shape of model, with reversed LSTMs in series.
+TEST_F(NetworkPlanTest, MatchesForwardInSeries) {
+  const char *kSpec = "[1,36,0,1 Ct3,3,16 Mp3,3 Lfys48 Lfx96 Lrx96 Lfx192 O1c1]";
+  ExpectPlanMatchesForward(kSpec, 36, false);
+  ExpectPlanMatchesForward(kSpec, 36, true);
+  // A series needs no more than two buffers between its layers.
+  std::unique_ptr<Network> network = BuildNetwork(kSpec, false);
+  NetworkPlan plan;
+  plan.Compile(network.get());
+  EXPECT_LE(plan.num_buffers(), 2);
+}
+
+// Tests bidirectional LSTMs, which run in parallel.
+TEST_F(NetworkPlanTest, MatchesForwardInParallel) {
+  const char *kSpec = "[1,36,0,1 Ct3,3,16 Mp3,3 Lfys48 Lbx64 Lbx32 O1c1]";
+  ExpectPlanMatchesForward(kSpec, 36, false);
+  ExpectPlanMatchesForward(kSpec, 36, true);
+}
+
+// Tests bidirectional and 2-d LSTMs with their directions running
+// concurrently.
+TEST_F(NetworkPlanTest, MatchesForwardWithConcurrentBranches) {
+  const char *kSpec = "[1,36,0,1 Ct3,3,16 Mp3,3 Lfys48 Lbx64 Lbx32 O1c1]";
+  ExpectPlanMatchesForward(kSpec, 36, false, 2);
+  ExpectPlanMatchesForward(kSpec, 36, true, 2);
+  const char *k2DSpec = "[1,8,0,1 Ct3,3,8 L2xy8 Lfys16 Lbx16 O1c1]";
+  ExpectPlanMatchesForward(k2DSpec, 8, false, 4);
+  ExpectPlanMatchesForward(k2DSpec, 8, true, 4);
+}
+
+// Tests reversals that cannot run in place, and that undo each other, as
+// well as y LSTMs, which transpose their inputs.
+TEST_F(NetworkPlanTest, MatchesForwardWithReversals) {
+  const char *kSpec = "[1,8,0,1 Ct3,3,8 Rx[Cr1,1,8 Lfx16] Rx[Lfx16 Cr1,1,8] Lry8 Lfys16 O1c1]";
+  ExpectPlanMatchesForward(kSpec, 8, false);
+  ExpectPlanMatchesForward(kSpec, 8, true);
+  // The two reversals between the Rx blocks cancel out, as do the two
+  // transposes between Lry and Lfys, leaving Ct (2 steps), the Rx blocks
+  // (2 * 4 - 2), Lry and Lfys (2 * 3 - 2) and O1c1.
+  std::unique_ptr<Network> network = BuildNetwork(kSpec, false);
+  NetworkPlan plan;
+  plan.Compile(network.get());
+  EXPECT_EQ(plan.num_steps(), 13);
+}
+
+// Tests that a 2-d LSTM is run as a whole.
+TEST_F(NetworkPlanTest, MatchesForwardWith2DLSTM) {
+  const char *kSpec = "[1,8,0,1 Ct3,3,8 L2xy8 Lfys16 O1c1]";
+  ExpectPlanMatchesForward(kSpec, 8, false);
+  ExpectPlanMatchesForward(kSpec, 8, true);
+}
+
+} // namespace tesseract
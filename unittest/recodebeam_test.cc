@@ -419,6 +419,30 @@ TEST_F(RecodeBeamTest, DoesEnglish) {
   ExpectCorrect(outputs, transcription);
 }
 
+// Tests that the storage of the beam search, including the dawg positions
+// used by the dictionary, is reused for the next line instead of growing.
+TEST_F(RecodeBeamTest, ReusesStorage) {
+  LoadUnicharset("eng_beam.unicharset");
+  LoadDict("eng_beam");
+  GENERIC_2D_ARRAY<float> outputs =
+      GenerateSyntheticOutputs(kGWRTops, kGWRTopScores, kGWR2nds, kGWR2ndScores, nullptr);
+  RecodeBeamSearch beam_search(recoder_, encoded_null_char_, false, &lstm_dict_);
+  beam_search.Decode(outputs, 3.5, -0.125, -25.0, nullptr);
+  RecodeBeamSearch::StorageStats first = beam_search.GetStorageStats();
+  EXPECT_EQ(outputs.dim1(), first.timesteps);
+  EXPECT_GT(first.nodes, 0);
+  EXPECT_GT(first.dawg_vectors, 0);
+  EXPECT_GT(first.bytes, 0);
+  for (int line = 1; line < 4; ++line) {
+    beam_search.Decode(outputs, 3.5, -0.125, -25.0, nullptr);
+    RecodeBeamSearch::StorageStats stats = beam_search.GetStorageStats();
+    EXPECT_EQ(first.timesteps, stats.timesteps) << "line " << line;
+    EXPECT_EQ(first.nodes, stats.nodes) << "line " << line;
+    EXPECT_EQ(first.dawg_vectors, stats.dawg_vectors) << "line " << line;
+    EXPECT_EQ(first.bytes, stats.bytes) << "line " << line;
+  }
+}
+
 TEST_F(RecodeBeamTest, DISABLED_EngDictionary) {
   LOG(INFO) << "Testing eng dictionary"
             << "\n";
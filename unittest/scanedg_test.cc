@@ -0,0 +1,123 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "scanedg.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include "coutln.h"
+#include "helpers.h"
+#include "include_gunit.h"
+#include "params.h"
+#include "pdblock.h"
+
+#include <allheaders.h>
+
+namespace tesseract {
+
+class ScanEdgesTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+  }
+  void TearDown() override {
+    SetThreads(1);
+  }
+
+  static void SetThreads(int num_threads) {
+    EXPECT_TRUE(ParamUtils::SetParam("edges_threads", std::to_string(num_threads).c_str(),
+                                     SET_PARAM_CONSTRAINT_NONE, GlobalParams()));
+  }
+
+  // Makes a tall binary image of outlines that cross many strips: nested
+  // rings, whose holes have blobs in them, diagonal strokes that only touch
+  // at corners, and speckle.
+  static Image MakeImage(int width, int height) {
+    Image pix = pixCreate(width, height, 1);
+    TRand randomizer;
+    randomizer.set_seed(17);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        bool black = false;
+        // Rings of 8 pixels thick, 24 apart, around a tall centre.
+        int dx = std::abs(x - width / 3);
+        int dy = std::abs(y - height / 2);
+        int ring = std::max(dx * height / width, dy / 2);
+        if (ring < height / 4 && ring % 24 < 8) {
+          black = true;
+        }
+        // Diagonal strokes that touch their neighbours only at corners.
+        if (x > 2 * width / 3 && (x + y) % 7 == 0) {
+          black = true;
+        }
+        // Speckle everywhere.
+        if (randomizer.IntRand() % 100 < 8) {
+          black = !black;
+        }
+        if (black) {
+          pixSetPixel(pix, x, y, 1);
+        }
+      }
+    }
+    return pix;
+  }
+
+  static void ExpectSameOutlines(C_OUTLINE_LIST *expected, C_OUTLINE_LIST *outlines,
+                                 int num_threads) {
+    int num_outlines = expected->length();
+    ASSERT_EQ(num_outlines, outlines->length()) << num_threads << " threads";
+    C_OUTLINE_IT e_it(expected);
+    C_OUTLINE_IT it(outlines);
+    for (int i = 0; i < num_outlines; ++i, e_it.forward(), it.forward()) {
+      const C_OUTLINE *e_outline = e_it.data();
+      const C_OUTLINE *outline = it.data();
+      EXPECT_EQ(e_outline->start_pos(), outline->start_pos())
+          << num_threads << " threads, outline " << i;
+      EXPECT_EQ(e_outline->bounding_box(), outline->bounding_box())
+          << num_threads << " threads, outline " << i;
+      ASSERT_EQ(e_outline->pathlength(), outline->pathlength())
+          << num_threads << " threads, outline " << i;
+      for (int s = 0; s < outline->pathlength(); ++s) {
+        ASSERT_EQ(e_outline->step(s), outline->step(s))
+            << num_threads << " threads, outline " << i << ", step " << s;
+      }
+    }
+  }
+};
+
+// Tests that scanning a block in strips on several threads finds exactly the
+// outlines, in the same order, as scanning it on one. The strips and the
+// joins between them are the same on any machine; only the number of threads
+// that scan them is limited to the number of cores.
+TEST_F(ScanEdgesTest, ThreadsMatchSingleThread) {
+  const int kWidth = 333;
+  const int kHeight = 1001;
+  Image pix = MakeImage(kWidth, kHeight);
+  // The whole image, and a block whose edges are not on word boundaries.
+  PDBLK whole(0, 0, kWidth, kHeight);
+  PDBLK inner(5, 3, kWidth - 7, kHeight - 2);
+  for (PDBLK *block : {&whole, &inner}) {
+    SetThreads(1);
+    C_OUTLINE_LIST expected;
+    C_OUTLINE_IT expected_it(&expected);
+    block_edges(pix, block, &expected_it);
+    EXPECT_GT(expected.length(), 100);
+    for (int num_threads : {2, 3, 4, 7, 15}) {
+      SetThreads(num_threads);
+      C_OUTLINE_LIST outlines;
+      C_OUTLINE_IT outline_it(&outlines);
+      block_edges(pix, block, &outline_it);
+      ExpectSameOutlines(&expected, &outlines, num_threads);
+    }
+  }
+  pix.destroy();
+}
+
+} // namespace tesseract
@@ -12,6 +12,7 @@
 #include "serialis.h"
 
 #include "include_gunit.h"
+#include "tessdatamanager.h"
 
 namespace tesseract {
 
@@ -22,6 +23,7 @@ class TfileTest : public ::testing::Test {
 protected:
   void SetUp() override {
     std::locale::global(std::locale(""));
+    file::MakeTmpdir();
   }
 
   TfileTest() = default;
@@ -212,4 +214,77 @@ TEST_F(TfileTest, BigEndian) {
   m3.ExpectEq(m2);
 }
 
+TEST_F(TfileTest, View) {
+  // This test verifies that a TFile opened as a view of shared data can give
+  // out pointers into the data, only if they are aligned and not swapped.
+  auto *buffer = new int64_t[4];
+  for (int i = 0; i < 4; ++i) {
+    buffer[i] = i * i;
+  }
+  std::shared_ptr<const char> owner(reinterpret_cast<const char *>(buffer),
+                                    [](const char *data) {
+                                      delete[] reinterpret_cast<const int64_t *>(data);
+                                    });
+  TFile fpr;
+  EXPECT_TRUE(fpr.OpenView(owner.get(), 4 * sizeof(int64_t), owner));
+  std::shared_ptr<const char> view_owner;
+  const char *view = fpr.View(sizeof(int64_t), alignof(int64_t), &view_owner);
+  EXPECT_EQ(owner.get(), view);
+  EXPECT_EQ(owner, view_owner);
+  // Misaligned data is not viewed, or read.
+  char c;
+  EXPECT_TRUE(fpr.DeSerialize(&c));
+  EXPECT_EQ(nullptr, fpr.View(sizeof(int64_t), alignof(int64_t), &view_owner));
+  EXPECT_TRUE(fpr.Skip(sizeof(int64_t) - 1));
+  // Too much data is not viewed.
+  EXPECT_EQ(nullptr, fpr.View(3 * sizeof(int64_t), alignof(int64_t), &view_owner));
+  int64_t value;
+  EXPECT_TRUE(fpr.DeSerialize(&value));
+  EXPECT_EQ(4, value);
+  // Data that needs swapping is not viewed.
+  fpr.set_swap(true);
+  EXPECT_EQ(nullptr, fpr.View(sizeof(int64_t), alignof(int64_t), &view_owner));
+  fpr.set_swap(false);
+  view = fpr.View(sizeof(int64_t), alignof(int64_t), &view_owner);
+  EXPECT_EQ(owner.get() + 3 * sizeof(int64_t), view);
+  // Data that isn't owned is not viewed.
+  TFile unowned;
+  EXPECT_TRUE(unowned.OpenView(owner.get(), 4 * sizeof(int64_t), nullptr));
+  EXPECT_EQ(nullptr, unowned.View(sizeof(int64_t), alignof(int64_t), &view_owner));
+}
+
+TEST_F(TfileTest, MappedTessdata) {
+  // This test verifies that a traineddata file mapped into memory gives the
+  // same components as when it is read.
+  TessdataManager original;
+  const std::string config = "tessedit_ocr_engine_mode 1\n";
+  const std::vector<char> lstm(1000, 'x');
+  original.OverwriteEntry(TESSDATA_LANG_CONFIG, config.data(), config.size());
+  original.OverwriteEntry(TESSDATA_LSTM, &lstm[0], lstm.size());
+  std::string filename = file::JoinPath(FLAGS_test_tmpdir, "mapped.traineddata");
+  EXPECT_TRUE(original.SaveFile(filename.c_str(), nullptr));
+  TessdataManager mapped;
+  EXPECT_TRUE(mapped.Init(filename.c_str()));
+  EXPECT_EQ(original.VersionString(), mapped.VersionString());
+  EXPECT_TRUE(mapped.IsLSTMAvailable());
+  EXPECT_FALSE(mapped.IsBaseAvailable());
+  TFile fp;
+  EXPECT_TRUE(mapped.GetComponent(TESSDATA_LSTM, &fp));
+  std::vector<char> read_lstm(lstm.size());
+  EXPECT_EQ(lstm.size(), fp.FRead(&read_lstm[0], 1, lstm.size()));
+  EXPECT_EQ(lstm, read_lstm);
+  EXPECT_EQ(0, fp.FRead(&read_lstm[0], 1, 1));
+  char line[100];
+  EXPECT_TRUE(mapped.GetComponent(TESSDATA_LANG_CONFIG, &fp));
+  EXPECT_STREQ(config.c_str(), fp.FGets(line, sizeof(line)));
+  std::vector<char> original_data, mapped_data;
+  original.Serialize(&original_data);
+  mapped.Serialize(&mapped_data);
+  EXPECT_EQ(original_data, mapped_data);
+  // Overwritten components replace the mapped ones.
+  mapped.OverwriteEntry(TESSDATA_LSTM, config.data(), config.size());
+  EXPECT_TRUE(mapped.GetComponent(TESSDATA_LSTM, &fp));
+  EXPECT_STREQ(config.c_str(), fp.FGets(line, sizeof(line)));
+}
+
 } // namespace tesseract
@@ -0,0 +1,188 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "threadteam.h"
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cycletimer.h"
+#include "helpers.h"
+#include "include_gunit.h"
+#include "lstm.h"
+#include "networkio.h"
+#include "networkscratch.h"
+#include "stridemap.h"
+
+namespace tesseract {
+
+class ThreadTeamTest : public ::testing::Test {
+protected:
+  // Runs all the tasks of many jobs on a team of the given size, and checks
+  // that each task of each job runs exactly once.
+  void RunJobs(int num_threads, int num_tasks) {
+    ThreadTeam team(num_threads);
+    EXPECT_EQ(team.size(), num_threads);
+    std::vector<std::atomic<int>> counts(num_tasks);
+    const int kNumJobs = 1000;
+    for (int job = 0; job < kNumJobs; ++job) {
+      team.Run(num_tasks, [&counts](int i) { ++counts[i]; });
+    }
+    for (auto &count : counts) {
+      EXPECT_EQ(count, kNumJobs);
+    }
+  }
+
+  // Runs a 1-D int LSTM with ns states on a random line of width timesteps
+  // num_lines times, using the given number of lstm_gate_threads, and
+  // returns the time taken. The last output is returned in output.
+  int64_t RunLSTM(int ns, int width, int num_lines, int num_threads, NetworkIO *output) {
+    int saved_threads = lstm_gate_threads;
+    lstm_gate_threads = num_threads;
+    TRand randomizer;
+    randomizer.set_seed(ns);
+    LSTM lstm("lstm", ns, ns, ns, false, NT_LSTM);
+    lstm.InitWeights(0.1f, &randomizer);
+    lstm.ConvertToInt();
+    lstm.SetEnableTraining(TS_DISABLED);
+    StrideMap stride_map;
+    stride_map.SetStride({std::make_pair(1, width)});
+    NetworkIO input;
+    input.ResizeToMap(true, stride_map, ns);
+    for (int t = 0; t < width; ++t) {
+      input.Randomize(t, 0, ns, &randomizer);
+    }
+    NetworkScratch scratch;
+    scratch.set_int_mode(true);
+    CycleTimer timer;
+    timer.Restart();
+    for (int line = 0; line < num_lines; ++line) {
+      lstm.Forward(false, input, nullptr, &scratch, output);
+    }
+    timer.Stop();
+    lstm_gate_threads = saved_threads;
+    return timer.GetInMs();
+  }
+};
+
+TEST_F(ThreadTeamTest, SingleThread) {
+  RunJobs(1, 4);
+}
+
+TEST_F(ThreadTeamTest, FewerThreadsThanTasks) {
+  RunJobs(3, 5);
+}
+
+TEST_F(ThreadTeamTest, MoreThreadsThanTasks) {
+  RunJobs(4, 2);
+}
+
+// Checks that the gates computed on a thread team give exactly the same
+// results as a single thread, and reports the speedup of the thread team over
+// a single thread and over the default mode, which uses OpenMP sections if
+// built with OpenMP. The speedups are also recorded as properties of the test
+// for the XML output. They are only logged, as timings depend on the load of
+// the machine.
+TEST_F(ThreadTeamTest, LSTMGateThreads) {
+  if (IntSimdMatrix::intSimdMatrix == nullptr) {
+    GTEST_SKIP();
+  }
+  const int kWidth = 200;
+  const int kNumLines = 20;
+  const int kTeamThreads = 4;
+#ifdef _OPENMP
+  const char *kDefaultMode = "OpenMP sections";
+#else
+  const char *kDefaultMode = "default (single thread without OpenMP)";
+#endif
+  int64_t total_single_ms = 0;
+  int64_t total_default_ms = 0;
+  int64_t total_team_ms = 0;
+  for (int ns : {96, 192, 256, 384, 512}) {
+    NetworkIO single_output, default_output, team_output;
+    int64_t single_ms = RunLSTM(ns, kWidth, kNumLines, 1, &single_output);
+    int64_t default_ms = RunLSTM(ns, kWidth, kNumLines, 0, &default_output);
+    int64_t team_ms = RunLSTM(ns, kWidth, kNumLines, kTeamThreads, &team_output);
+    double single_speedup = static_cast<double>(single_ms) / std::max<int64_t>(team_ms, 1);
+    double default_speedup = static_cast<double>(default_ms) / std::max<int64_t>(team_ms, 1);
+    LOG(INFO) << "ns=" << ns << ": single thread " << single_ms << "ms, " << kDefaultMode << " "
+              << default_ms << "ms, thread team " << team_ms << "ms, speedup " << single_speedup
+              << "x over single thread, " << default_speedup << "x over " << kDefaultMode
+              << "\n";
+    std::string key = "ns" + std::to_string(ns);
+    RecordProperty(key + "_speedup_over_single", std::to_string(single_speedup));
+    RecordProperty(key + "_speedup_over_default", std::to_string(default_speedup));
+    total_single_ms += single_ms;
+    total_default_ms += default_ms;
+    total_team_ms += team_ms;
+    for (int t = 0; t < kWidth; ++t) {
+      for (int i = 0; i < ns; ++i) {
+        EXPECT_EQ(single_output.i(t)[i], default_output.i(t)[i]);
+        EXPECT_EQ(single_output.i(t)[i], team_output.i(t)[i]);
+      }
+    }
+  }
+  LOG(INFO) << "All sizes: single thread " << total_single_ms << "ms, " << kDefaultMode << " "
+            << total_default_ms << "ms, thread team " << total_team_ms << "ms on "
+            << std::thread::hardware_concurrency() << " CPUs\n";
+}
+
+// Checks that Forward on one network, run concurrently on separate scratch
+// spaces, as LSTMRecognizer::RecognizeLinesInParallel does, gives exactly the
+// same results as running the lines one at a time.
+TEST_F(ThreadTeamTest, ConcurrentForward) {
+  const int kNumThreads = 4;
+  const int kNumLines = 8;
+  const int kNs = 64;
+  TRand randomizer;
+  randomizer.set_seed(kNs);
+  LSTM lstm("lstm", kNs, kNs, kNs, false, NT_LSTM);
+  lstm.InitWeights(0.1f, &randomizer);
+  lstm.ConvertToInt();
+  lstm.SetEnableTraining(TS_DISABLED);
+  std::vector<NetworkIO> inputs(kNumLines);
+  for (int line = 0; line < kNumLines; ++line) {
+    StrideMap stride_map;
+    stride_map.SetStride({std::make_pair(1, 50 + 10 * line)});
+    inputs[line].ResizeToMap(true, stride_map, kNs);
+    for (int t = 0; t < inputs[line].Width(); ++t) {
+      inputs[line].Randomize(t, 0, kNs, &randomizer);
+    }
+  }
+  std::vector<NetworkIO> serial_outputs(kNumLines);
+  NetworkScratch serial_scratch;
+  serial_scratch.set_int_mode(true);
+  for (int line = 0; line < kNumLines; ++line) {
+    lstm.Forward(false, inputs[line], nullptr, &serial_scratch, &serial_outputs[line]);
+  }
+  std::vector<NetworkIO> parallel_outputs(kNumLines);
+  std::vector<NetworkScratch> scratches(kNumThreads);
+  for (auto &scratch : scratches) {
+    scratch.set_int_mode(true);
+  }
+  std::atomic<int> next_line(0);
+  ThreadTeam team(kNumThreads);
+  team.Run(kNumThreads, [&](int w) {
+    for (int line = next_line++; line < kNumLines; line = next_line++) {
+      lstm.Forward(false, inputs[line], nullptr, &scratches[w], &parallel_outputs[line]);
+    }
+  });
+  for (int line = 0; line < kNumLines; ++line) {
+    ASSERT_EQ(serial_outputs[line].Width(), parallel_outputs[line].Width());
+    for (int t = 0; t < serial_outputs[line].Width(); ++t) {
+      for (int i = 0; i < kNs; ++i) {
+        EXPECT_EQ(serial_outputs[line].i(t)[i], parallel_outputs[line].i(t)[i]);
+      }
+    }
+  }
+}
+
+} // namespace tesseract
@@ -0,0 +1,228 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thresholder.h"
+#include <memory>
+#include <vector>
+#include "helpers.h"
+#include "include_gunit.h"
+#include "otsuthr.h"
+#include "threadteam.h"
+
+#include <allheaders.h>
+
+namespace tesseract {
+
+// A thresholder that runs its legacy Otsu on any number of threads, as
+// SetThresholdThreads would on a machine with enough CPUs for them.
+class TeamThresholder : public ImageThresholder {
+public:
+  void SetTeam(int num_threads) {
+    if (num_threads > 1) {
+      threshold_team_ = std::make_unique<ThreadTeam>(num_threads);
+    } else {
+      threshold_team_.reset();
+    }
+  }
+};
+
+struct Rect {
+  int left, top, width, height;
+};
+
+class ThresholderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+  }
+
+  // Makes an image of dark strokes on a noisy light background. In the 32 bit
+  // image, each channel has its own contrast, and the blue and alpha channels
+  // are flat, so they have no threshold.
+  static Image MakeImage(int width, int height, int depth) {
+    Image pix = pixCreate(width, height, depth);
+    TRand randomizer;
+    randomizer.set_seed(3);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        bool stroke = (x / 5 + y / 7) % 6 == 0 || (x * x + y) % 97 < 3;
+        int noise = randomizer.IntRand() % 40;
+        int grey = stroke ? 30 + noise : 190 + noise;
+        if (depth == 8) {
+          pixSetPixel(pix, x, y, grey);
+        } else {
+          int red = stroke ? 100 + noise : 120 + noise;
+          uint32_t value = (static_cast<uint32_t>(red) << 24) |
+                           (static_cast<uint32_t>(grey) << 16) | (255u << 8);
+          pixSetPixel(pix, x, y, value);
+        }
+      }
+    }
+    return pix;
+  }
+
+  // Computes the thresholds of the rectangle as OtsuThreshold did before it
+  // counted the channels together: one pass over the image per channel.
+  static void BaselineThresholds(Image pix, const Rect &rect, std::vector<int> &thresholds,
+                                 std::vector<int> &hi_values) {
+    int num_channels = pixGetDepth(pix) / 8;
+    int best_hi_value = 1;
+    int best_hi_index = 0;
+    bool any_good_hivalue = false;
+    double best_hi_dist = 0.0;
+    thresholds.assign(num_channels, -1);
+    hi_values.assign(num_channels, -1);
+    for (int ch = 0; ch < num_channels; ++ch) {
+      int histogram[kHistogramSize];
+      HistogramRect(pix, ch, rect.left, rect.top, rect.width, rect.height, histogram);
+      int H;
+      int best_omega_0;
+      int best_t = OtsuStats(histogram, &H, &best_omega_0);
+      if (best_omega_0 == 0 || best_omega_0 == H) {
+        continue;
+      }
+      int hi_value = best_omega_0 < H * 0.5;
+      thresholds[ch] = best_t;
+      if (best_omega_0 > H * 0.75) {
+        any_good_hivalue = true;
+        hi_values[ch] = 0;
+      } else if (best_omega_0 < H * 0.25) {
+        any_good_hivalue = true;
+        hi_values[ch] = 1;
+      } else {
+        double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
+        if (hi_dist > best_hi_dist) {
+          best_hi_dist = hi_dist;
+          best_hi_value = hi_value;
+          best_hi_index = ch;
+        }
+      }
+    }
+    if (!any_good_hivalue) {
+      hi_values[best_hi_index] = best_hi_value;
+    }
+  }
+
+  // Thresholds the rectangle pixel by pixel, as ThresholdRectToPix did
+  // before it looked the values up in a table.
+  static Image BaselineOtsu(Image pix, const Rect &rect) {
+    std::vector<int> thresholds;
+    std::vector<int> hi_values;
+    BaselineThresholds(pix, rect, thresholds, hi_values);
+    int num_channels = thresholds.size();
+    Image binary = pixCreate(rect.width, rect.height, 1);
+    int wpl = pixGetWpl(binary);
+    int src_wpl = pixGetWpl(pix);
+    const uint32_t *srcdata = pixGetData(pix);
+    uint32_t *pixdata = pixGetData(binary);
+    for (int y = 0; y < rect.height; ++y) {
+      const uint32_t *linedata = srcdata + (y + rect.top) * src_wpl;
+      uint32_t *pixline = pixdata + y * wpl;
+      for (int x = 0; x < rect.width; ++x) {
+        bool white_result = true;
+        for (int ch = 0; ch < num_channels; ++ch) {
+          int pixel = GET_DATA_BYTE(linedata, (x + rect.left) * num_channels + ch);
+          if (hi_values[ch] >= 0 && (pixel > thresholds[ch]) == (hi_values[ch] == 0)) {
+            white_result = false;
+            break;
+          }
+        }
+        if (white_result) {
+          CLEAR_DATA_BIT(pixline, x);
+        } else {
+          SET_DATA_BIT(pixline, x);
+        }
+      }
+    }
+    return binary;
+  }
+
+  // Tests that the legacy Otsu thresholds and binary image of each rectangle
+  // of an image of the given depth are the same as the baseline, on any
+  // number of threads.
+  static void ExpectSameAsBaseline(int depth) {
+    const int kWidth = 131;
+    const int kHeight = 83;
+    Image pix = MakeImage(kWidth, kHeight, depth);
+    // The whole image, rectangles whose edges are not on word boundaries,
+    // one narrower than a word, and single columns and pixels.
+    const Rect kRects[] = {{0, 0, kWidth, kHeight},     {3, 5, 97, 61},
+                           {33, 1, 31, 80},             {kWidth - 1, 0, 1, kHeight},
+                           {7, 40, 64, 1},              {kWidth - 1, kHeight - 1, 1, 1}};
+    for (const auto &rect : kRects) {
+      std::vector<int> expected_thresholds;
+      std::vector<int> expected_hi_values;
+      BaselineThresholds(pix, rect, expected_thresholds, expected_hi_values);
+      Image expected = BaselineOtsu(pix, rect);
+      for (int num_threads : {1, 2, 7}) {
+        std::unique_ptr<ThreadTeam> team;
+        if (num_threads > 1) {
+          team = std::make_unique<ThreadTeam>(num_threads);
+        }
+        std::vector<int> thresholds;
+        std::vector<int> hi_values;
+        EXPECT_EQ(depth / 8, OtsuThreshold(pix, rect.left, rect.top, rect.width, rect.height,
+                                           thresholds, hi_values, team.get()));
+        EXPECT_EQ(expected_thresholds, thresholds) << num_threads << " threads";
+        EXPECT_EQ(expected_hi_values, hi_values) << num_threads << " threads";
+
+        TeamThresholder thresholder;
+        thresholder.SetImage(pix);
+        thresholder.SetRectangle(rect.left, rect.top, rect.width, rect.height);
+        thresholder.SetTeam(num_threads);
+        Image binary = nullptr;
+        ASSERT_TRUE(thresholder.ThresholdToPix(&binary));
+        l_int32 same = 0;
+        EXPECT_EQ(0, pixEqual(expected, binary, &same));
+        EXPECT_TRUE(same) << depth << " bit, " << num_threads << " threads, rect "
+                          << rect.left << "," << rect.top << " " << rect.width << "x"
+                          << rect.height;
+        binary.destroy();
+      }
+      expected.destroy();
+    }
+    pix.destroy();
+  }
+};
+
+TEST_F(ThresholderTest, GreyOtsuMatchesBaseline) {
+  ExpectSameAsBaseline(8);
+}
+
+TEST_F(ThresholderTest, ColorOtsuMatchesBaseline) {
+  ExpectSameAsBaseline(32);
+}
+
+// Tests that SetThresholdThreads, as used by TiledOtsu, gives the same binary
+// image for any number of threads, however many CPUs there are.
+TEST_F(ThresholderTest, ThresholdThreadsMatch) {
+  Image pix = MakeImage(201, 77, 32);
+  Image expected = nullptr;
+  for (int num_threads : {1, 2, 0, 16}) {
+    ImageThresholder thresholder;
+    thresholder.SetImage(pix);
+    thresholder.SetRectangle(9, 2, 181, 70);
+    thresholder.SetThresholdThreads(num_threads);
+    Image binary = nullptr;
+    ASSERT_TRUE(thresholder.ThresholdToPix(&binary));
+    if (expected == nullptr) {
+      expected = binary;
+      continue;
+    }
+    l_int32 same = 0;
+    EXPECT_EQ(0, pixEqual(expected, binary, &same));
+    EXPECT_TRUE(same) << num_threads << " threads";
+    binary.destroy();
+  }
+  expected.destroy();
+  pix.destroy();
+}
+
+} // namespace tesseract
@@ -0,0 +1,83 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vectorsearch.h"
+#include <vector>
+#include "include_gunit.h"
+#include "simddetect.h"
+
+namespace tesseract {
+
+class VectorSearchTest : public ::testing::Test {
+protected:
+  // Checks the given search against a scalar loop, for a range of lengths
+  // and positions of the first value above the threshold, to cover the
+  // elements that don't fill a register too.
+  void ExpectFirstAbove(FirstAboveFunction first_above) {
+    for (int n : {0, 1, 3, 7, 15, 17, 33, 64, 65, 127, 200}) {
+      for (int above = 0; above <= n; ++above) {
+        std::vector<float> values(n);
+        for (int i = 0; i < n; ++i) {
+          values[i] = 0.25f * (i % 4);
+        }
+        if (above < n) {
+          values[above] = 1.0f;
+        }
+        EXPECT_EQ(above, first_above(values.data(), n, 0.75f)) << "n=" << n;
+        // Equal is not above.
+        if (above < n) {
+          values[above] = 0.75f;
+          EXPECT_EQ(n, first_above(values.data(), n, 0.75f)) << "n=" << n;
+        }
+      }
+    }
+  }
+};
+
+TEST_F(VectorSearchTest, Native) {
+  ExpectFirstAbove(FirstAbove);
+}
+
+TEST_F(VectorSearchTest, AVX2) {
+#if defined(HAVE_AVX2)
+  if (!SIMDDetect::IsAVX2Available()) {
+    GTEST_LOG_(INFO) << "No AVX2 found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectFirstAbove(FirstAboveAVX2);
+#else
+  GTEST_LOG_(INFO) << "AVX2 unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+TEST_F(VectorSearchTest, AVX512F) {
+#if defined(HAVE_AVX512F)
+  if (!SIMDDetect::IsAVX512FAvailable()) {
+    GTEST_LOG_(INFO) << "No AVX512F found! Not tested!";
+    GTEST_SKIP();
+  }
+  ExpectFirstAbove(FirstAboveAVX512F);
+#else
+  GTEST_LOG_(INFO) << "AVX512F unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+TEST_F(VectorSearchTest, NEON) {
+#if defined(__aarch64__)
+  ExpectFirstAbove(FirstAboveNEON);
+#else
+  GTEST_LOG_(INFO) << "NEON unsupported! Not tested!";
+  GTEST_SKIP();
+#endif
+}
+
+} // namespace tesseract